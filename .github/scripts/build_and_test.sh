@@ -1,7 +1,7 @@
 #!/usr/bin/env bash
 
 echo "Trying to build..."
-g++ test.cc -std=c++17 -o test.out && ./test.out
+g++ test.cc -std=c++17 -pthread -o test.out && ./test.out
 
 if [ $? -ne 0 ]; then
     echo "Test 1 failed"
@@ -0,0 +1,11 @@
+#!/usr/bin/env bash
+
+echo "Building benchmarks..."
+g++ bench.cc -std=c++17 -O2 -o bench.out && ./bench.out
+
+if [ $? -ne 0 ]; then
+    echo "Benchmarks failed"
+    exit -1
+fi
+
+echo "Done benchmarking!"
@@ -0,0 +1,11 @@
+#!/usr/bin/env bash
+
+echo "Building fuzzer..."
+g++ fuzz.cc -std=c++17 -O2 -pthread -o fuzz.out && ./fuzz.out --seed $RANDOM --rounds 32
+
+if [ $? -ne 0 ]; then
+    echo "Fuzzing failed"
+    exit -1
+fi
+
+echo "Done fuzzing!"
@@ -0,0 +1,164 @@
+// Throughput benchmarks for the instruction encoders and the buffer write path
+// Build with: g++ bench.cc -std=c++17 -O2 -o bench.out
+#include <chrono>
+#include <cstdio>
+#include "luma.hpp"
+using namespace Luma;
+
+static constexpr int rounds = 5; // Every benchmark is run this many times and the fastest run is reported
+static constexpr int iterations = 64 * 1024; // How many times each benchmark body is expanded per run
+static constexpr uintptr_t fixedBufferSize = 64 * 1024 * 1024; // Big enough for the largest body in FixedSize mode
+static constexpr uintptr_t growBufferSize = 64 * 1024; // AutoGrow starts small so that the growth path is part of the measurement
+
+static volatile uint32_t sink; // Keeps the compiler from throwing the emitted code away
+
+template <GrowingMode mode, typename Func>
+static void bench (const char* name, Func&& body) {
+    double best = 1e30;
+    uint32_t words = 0;
+
+    for (int round = 0; round < rounds; round++) {
+        PPCEmitter <mode> gen (mode == AutoGrow ? growBufferSize : fixedBufferSize);
+        const auto start = std::chrono::steady_clock::now();
+
+        for (int i = 0; i < iterations; i++)
+            body (gen, i);
+
+        const auto end = std::chrono::steady_clock::now();
+        const double ns = std::chrono::duration <double, std::nano> (end - start).count();
+        words = gen.getCodeSize() / 4;
+        best = std::min (best, ns);
+        sink = sink + gen.getBuffer()[words / 2];
+    }
+
+    printf ("%-20s %-10s %10u words %10.2f Mwords/s %8.3f ns/word\n", name, mode == AutoGrow ? "AutoGrow" : "FixedSize",
+            words, words / best * 1000.0, best / words);
+}
+
+// Six integer instructions, run both with a capacity check per instruction and inside an EmitScope
+template <typename Emitter>
+static void emitIntegerALU (Emitter& gen, int i) {
+    const auto reg = (GPR) (i & 31);
+    gen.add (reg, r4, r5);
+    gen.template subf <true> (r6, reg, r7);
+    gen.andi (reg, r8, 0xFF);
+    gen.rlwinm (r9, reg, 3, 0, 28);
+    gen.mullw (r10, reg, r11);
+    gen.cmpi (cr0, reg, -1);
+}
+
+template <GrowingMode mode>
+static void benchAll() {
+    bench <mode> ("Integer ALU", [] (auto& gen, int i) {
+        emitIntegerALU (gen, i);
+    });
+
+    bench <mode> ("Integer ALU x16", [] (auto& gen, int i) {
+        for (int j = 0; j < 16; j++)
+            emitIntegerALU (gen, i + j);
+    });
+
+    bench <mode> ("Integer ALU scoped", [] (auto& gen, int i) {
+        EmitScope scope (gen, 16 * 6); // One capacity check for all 96 words
+        for (int j = 0; j < 16; j++)
+            emitIntegerALU (gen, i + j);
+    });
+
+    bench <mode> ("liw (1-2 words)", [] (auto& gen, int i) {
+        gen.liw (r3, (uint32_t) i); // Fits in li
+        gen.liw (r4, (uint32_t) i << 16); // Fits in lis
+        gen.liw (r5, 0x12340000 | (uint32_t) i); // Needs lis + ori
+    });
+
+    bench <mode> ("Loads/stores", [] (auto& gen, int i) {
+        gen.lwz (r3, r1, (int16_t) (i & 0x7FFC));
+        gen.lhz (r4, r1, 2);
+        gen.lbzx (r5, r6, r7);
+        gen.stw (r3, r1, 8);
+        gen.sthu (r4, r1, -2);
+        gen.stbx (r5, r6, r7);
+    });
+
+    bench <mode> ("FPU", [] (auto& gen, int i) {
+        const auto reg = (FPR) (i & 31);
+        gen.fadd (reg, f1, f2);
+        gen.fmuls (f3, reg, f4);
+        gen.fmadd (f5, f6, reg, f7);
+        gen.lfs (f8, r3, 0);
+        gen.stfd (reg, r3, 8);
+    });
+
+    bench <mode> ("Paired singles", [] (auto& gen, int i) {
+        const auto reg = (FPR) (i & 31);
+        gen.ps_add (reg, f1, f2);
+        gen.ps_mul (f3, reg, f4);
+        gen.ps_madd (f5, f6, reg, f7);
+        gen.ps_merge00 (f8, reg, f9);
+    });
+
+    bench <mode> ("AltiVec", [] (auto& gen, int i) {
+        const auto reg = (VR) (i & 31);
+        gen.vaddfp (reg, v1, v2);
+        gen.vmaddfp (v3, reg, v4, v5);
+        gen.vperm (v6, v7, reg, v8);
+        gen.lvx (v9, r3, r4);
+        gen.stvx (reg, r3, r4);
+    });
+
+    bench <mode> ("Branches+setLabel", [] (auto& gen, int) {
+        const auto forward = gen.beq();
+        gen.nop();
+        gen.setLabel (forward);
+        const auto backward = gen.getAnchor();
+        gen.nop();
+        gen.setLabel (gen.bne(), backward);
+    });
+
+    bench <mode> ("align/ds", [] (auto& gen, int) {
+        gen.ds ("Luma");
+        gen.align (16);
+    });
+
+    bench <mode> ("nops (bulk)", [] (auto& gen, int) {
+        gen.nops (16);
+    });
+
+    bench <mode> ("dw array (bulk)", [] (auto& gen, int) {
+        static const uint32_t table[64] = {};
+        gen.dw (table, 64);
+    });
+}
+
+// Decode a buffer of every kind of instruction the benchmarks above emit
+static void benchDecoder() {
+    PPCEmitter <FixedSize> gen (fixedBufferSize);
+    for (int i = 0; i < iterations; i++) {
+        gen.add (r3, r4, r5);
+        gen.lwz (r3, r1, 8);
+        gen.fmadd (f1, f2, f3, f4);
+        gen.ps_add (f1, f2, f3);
+        gen.rlwinm (r9, r3, 3, 0, 28);
+        gen.setLabel (gen.bne(), gen.getAnchor());
+    }
+
+    const Decoder decoder;
+    const uint32_t words = gen.getCodeSize() / 4;
+    double best = 1e30;
+    for (int round = 0; round < rounds; round++) {
+        uint32_t valid = 0;
+        const auto start = std::chrono::steady_clock::now();
+        decoder.forEach (gen.getBuffer(), gen.getCurr(), [&] (const Decoder::Instruction& instruction) { valid += instruction.isValid(); });
+        const auto end = std::chrono::steady_clock::now();
+
+        best = std::min (best, std::chrono::duration <double, std::nano> (end - start).count());
+        sink = sink + valid;
+    }
+
+    printf ("%-20s %-10s %10u words %10.2f Mwords/s %8.3f ns/word\n", "Decoder", "-", words, words / best * 1000.0, best / words);
+}
+
+int main() {
+    benchAll <FixedSize>();
+    benchAll <AutoGrow>();
+    benchDecoder();
+}
@@ -0,0 +1,1069 @@
+// Property-based checks for the encoders and the emitter
+// Every encoder in InstructionSet is run over its operand space and checked against the table-driven Decoder, and against the words an outside
+// assembler makes for a few fixed operands (fuzz_reference.inc), as the Decoder shares its opcode bits with the encoders. liw, the peephole
+// optimizer, branch relaxation, branch hints, cross-endian emission and the vector kernels are checked against small reference models on random programs
+// Build with: g++ fuzz.cc -std=c++17 -O2 -pthread -o fuzz.out
+// Run with: ./fuzz.out [--seed N] [--rounds N] [--threads N]. Runs are reproducible from their seed, whatever the thread count
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <random>
+#include <thread>
+#include "luma.hpp"
+using namespace Luma;
+
+using Emitter = PPCEmitter <FixedSize>;
+using Rng = std::mt19937_64;
+static constexpr auto foreignOrder = hostByteOrder == LittleEndian ? BigEndian : LittleEndian;
+
+static uint64_t seed = 1;
+static int rounds = 16; // Scales how many random samples and programs every check goes through
+static std::atomic <uint64_t> checks { 0 };
+static std::atomic <uint64_t> failures { 0 };
+static std::mutex printMutex;
+static constexpr uint64_t maxPrinted = 64; // Past this, failures are only counted
+
+static void fail (const char* property, const char* format, ...) {
+    if (failures++ >= maxPrinted)
+        return;
+
+    std::lock_guard <std::mutex> lock (printMutex);
+    std::va_list args;
+    va_start (args, format);
+    printf ("FAIL [%s] ", property);
+    std::vprintf (format, args);
+    printf ("\n");
+    va_end (args);
+}
+
+// The values an encoder argument can take. Registers and other small fields are enumerated, wide immediates are sampled
+struct Operand {
+    int64_t min, max;
+    const char* prefix; // How the decoder prints it, eg "r" for r3. nullptr for plain numbers
+};
+
+template <typename T>
+static constexpr Operand operandFor() {
+    if constexpr (std::is_same_v <T, GPR>) return { 0, 31, "r" };
+    else if constexpr (std::is_same_v <T, FPR>) return { 0, 31, "f" };
+    else if constexpr (std::is_same_v <T, VR>) return { 0, 31, "v" };
+    else if constexpr (std::is_same_v <T, CR>) return { 0, 7, "cr" };
+    else if constexpr (std::is_same_v <T, GQR>) return { 0, 7, nullptr };
+    else if constexpr (std::is_same_v <T, SR>) return { 0, 15, nullptr };
+    else if constexpr (std::is_same_v <T, bool>) return { 0, 1, nullptr };
+    else if constexpr (std::is_same_v <T, int16_t>) return { INT16_MIN, INT16_MAX, nullptr };
+    else if constexpr (std::is_same_v <T, uint16_t>) return { 0, UINT16_MAX, nullptr };
+    else if constexpr (std::is_same_v <T, int8_t>) return { -16, 15, nullptr }; // 5-bit vector splat immediates
+    else if constexpr (std::is_same_v <T, uint32_t>) return { 0, 1023, nullptr }; // SPR numbers
+    else if constexpr (std::is_same_v <T, uint8_t> || std::is_same_v <T, int>) return { 0, 31, nullptr }; // Shifts, masks, CR bits
+    else static_assert (!sizeof (T), "No operand space for this argument type");
+}
+
+static int64_t sample (const Operand& operand, Rng& rng) {
+    if (operand.max - operand.min > 1024 && (rng() & 1)) { // Sign and carry bugs live at the edges of wide immediates
+        const int64_t edges[] = { operand.min, operand.min + 1, -2, -1, 0, 1, 2, operand.max / 2, operand.max / 2 + 1, operand.max - 1, operand.max };
+        const auto value = edges[rng() % std::size (edges)];
+        if (value >= operand.min && value <= operand.max)
+            return value;
+    }
+
+    return operand.min + (int64_t) (rng() % (uint64_t) (operand.max - operand.min + 1));
+}
+
+// Every value of a small field, or a sample of a wide one
+static std::vector <int64_t> domain (const Operand& operand, Rng& rng) {
+    std::vector <int64_t> values;
+    if (operand.max - operand.min <= 1024) {
+        for (auto value = operand.min; value <= operand.max; value++)
+            values.push_back (value);
+    } else {
+        for (int i = 0; i < 64; i++)
+            values.push_back (sample (operand, rng));
+        std::sort (values.begin(), values.end());
+        values.erase (std::unique (values.begin(), values.end()), values.end());
+    }
+
+    return values;
+}
+
+static constexpr size_t maxOperands = 6;
+using Arguments = std::array <int64_t, maxOperands>;
+
+// One encoder, with its setFlags = true version if it has one, and the same encoder going through an emitter's write path
+struct Case {
+    const char* name = nullptr;
+    std::vector <Operand> operands = {};
+    std::function <uint32_t (const Arguments&)> encode = nullptr;
+    std::function <uint32_t (const Arguments&)> encodeFlagged = nullptr; // Set only for instructions with an Rc/OE bit
+    std::function <void (Emitter&, const Arguments&)> emit = nullptr;
+    bool disjoint = true;
+    bool unassembled = false; // For encoders of opcodes no assembler knows, which can't have a reference encoding
+
+    // Restrict an argument to [min, max], for fields narrower than the argument's type
+    Case& range (size_t operand, int64_t min, int64_t max) {
+        operands[operand].min = min;
+        operands[operand].max = max;
+        return *this;
+    }
+
+    Case& withoutReference() {
+        unassembled = true;
+        return *this;
+    }
+
+    // For pseudo-ops that compute one field out of several arguments (eg both mb and me out of n and b), so fields overlap
+    Case& overlapping() {
+        disjoint = false;
+        return *this;
+    }
+
+    std::string format (const Arguments& args) const {
+        std::string result = std::string (name) + " (";
+        for (size_t i = 0; i < operands.size(); i++)
+            result += (i ? ", " : "") + std::to_string (args[i]);
+        return result + ")";
+    }
+};
+
+template <typename... Args, typename Call, typename Target, typename Flag, size_t... I>
+static auto callEncoder (const Call& call, Target& target, Flag flag, const Arguments& args, std::index_sequence <I...>) {
+    return call (target, flag, (Args) args[I]...);
+}
+
+// "call" runs the encoder on any InstructionSet, with setFlags given as a std::bool_constant. The member pointer is only there for the argument types
+template <typename... Args, typename Call>
+static Case makeCase (const char* name, uint32_t (InstructionSet <Encoder>::*) (Args...), bool flagged, Call call) {
+    static_assert (sizeof... (Args) <= maxOperands);
+    const auto indices = std::index_sequence_for <Args...>();
+    Case result { name, { operandFor <Args>()... } };
+    result.encode = [=] (const Arguments& args) { return callEncoder <Args...> (call, enc, std::false_type(), args, indices); };
+    result.emit = [=] (Emitter& gen, const Arguments& args) { callEncoder <Args...> (call, gen, std::false_type(), args, indices); };
+    if (flagged)
+        result.encodeFlagged = [=] (const Arguments& args) { return callEncoder <Args...> (call, enc, std::true_type(), args, indices); };
+    return result;
+}
+
+// Encoders are called qualified, so that emitter methods with the same name don't hide them
+#define ENCODER(name) makeCase (#name, &Encoder::name, false, [] (auto& target, auto, auto... args) { \
+    return target.InstructionSet <std::decay_t <decltype (target)>>::name (args...); })
+#define FLAGGED(name) makeCase (#name, &Encoder::name <false>, true, [] (auto& target, auto flag, auto... args) { \
+    return target.InstructionSet <std::decay_t <decltype (target)>>::template name <decltype (flag)::value> (args...); })
+
+// Every encoder in InstructionSet except ud(), which emits an illegal word on purpose
+static std::vector <Case> buildCases() {
+    std::vector <Case> cases = {
+    ENCODER (nop), ENCODER (blr), ENCODER (bctr), ENCODER (bctrl), ENCODER (li), ENCODER (lis), FLAGGED (nand), FLAGGED (and_),
+    FLAGGED (andc), ENCODER (andi), ENCODER (andis), FLAGGED (nor), FLAGGED (or_), FLAGGED (orc), ENCODER (ori), ENCODER (oris),
+    FLAGGED (xor_), ENCODER (xori), ENCODER (xoris), FLAGGED (add), FLAGGED (addo), FLAGGED (addc), FLAGGED (addco), FLAGGED (adde),
+    FLAGGED (addeo), FLAGGED (addze), FLAGGED (addzeo), ENCODER (addi), ENCODER (addis), FLAGGED (addic), FLAGGED (addme), FLAGGED (addmeo),
+    FLAGGED (subf), FLAGGED (sub), FLAGGED (subfo), FLAGGED (subo), FLAGGED (subfc), FLAGGED (subc), FLAGGED (subfco), FLAGGED (subco),
+    FLAGGED (subfe), FLAGGED (sube), FLAGGED (subfeo), FLAGGED (subeo), ENCODER (subfic), FLAGGED (subfme), FLAGGED (subfmeo),
+    FLAGGED (subfze), FLAGGED (subfzeo), ENCODER (cmpli), ENCODER (cmpi), ENCODER (cmpl), ENCODER (cmp), ENCODER (mulli), FLAGGED (mullw),
+    FLAGGED (mullwo), FLAGGED (mulhw), FLAGGED (mulhwu), FLAGGED (divwu), FLAGGED (divwuo), FLAGGED (divw), FLAGGED (divwo), FLAGGED (mr),
+    FLAGGED (slw), FLAGGED (srw), FLAGGED (sraw), FLAGGED (srawi), FLAGGED (rlwinm), FLAGGED (slwi), FLAGGED (srwi), FLAGGED (clrlwi),
+    FLAGGED (clrrwi), FLAGGED (rotlwi), FLAGGED (rotrwi), FLAGGED (extlwi), FLAGGED (extrwi), FLAGGED (rlwnm), FLAGGED (rlwimi),
+    FLAGGED (cntlzw), ENCODER (stb), ENCODER (stbx), ENCODER (stbu), ENCODER (stbux), ENCODER (sth), ENCODER (sthx), ENCODER (sthu),
+    ENCODER (sthux), ENCODER (stw), ENCODER (stwx), ENCODER (stwu), ENCODER (stwux), ENCODER (lbz), ENCODER (lbzx), ENCODER (lbzu),
+    ENCODER (lbzux), ENCODER (lhz), ENCODER (lhzx), ENCODER (lhzu), ENCODER (lhzux), ENCODER (lhax), ENCODER (lhaux), ENCODER (lhbrx),
+    ENCODER (lwz), ENCODER (lwzx), ENCODER (lwzu), ENCODER (lwzux), ENCODER (lwarx), ENCODER (stwcx), ENCODER (lwbrx), ENCODER (lmw),
+    ENCODER (stmw), ENCODER (crand), ENCODER (crandc), ENCODER (creqv), ENCODER (crnand), ENCODER (crnor), ENCODER (cror), ENCODER (crorc),
+    ENCODER (crxor), ENCODER (mtcrf), ENCODER (mtcr), ENCODER (mfcr), ENCODER (mtsr), ENCODER (mfsr), ENCODER (mtsrin), ENCODER (mfsrin),
+    ENCODER (mfmsr), ENCODER (mtmsr), ENCODER (mtctr), ENCODER (mfctr), ENCODER (mflr), ENCODER (mtlr), ENCODER (mtspr), ENCODER (mfspr),
+    ENCODER (lfs), ENCODER (lfd), ENCODER (stfs), ENCODER (stfd), FLAGGED (fmr), FLAGGED (fadd), FLAGGED (fadds), FLAGGED (fdiv),
+    FLAGGED (fdivs), FLAGGED (fmadd), FLAGGED (fmadds), FLAGGED (fmsub), FLAGGED (fmsubs), FLAGGED (fmul), FLAGGED (fmuls), FLAGGED (fnabs),
+    FLAGGED (fneg), FLAGGED (fnmadd), FLAGGED (fnmadds), FLAGGED (fnmsub), FLAGGED (fnmsubs), FLAGGED (fres), FLAGGED (frsp),
+    FLAGGED (frsqrte), FLAGGED (fsel), FLAGGED (fsub), FLAGGED (fsubs), ENCODER (icbi), ENCODER (dcbf), ENCODER (dcbi), ENCODER (dcbst),
+    ENCODER (dcbt), ENCODER (dcbtst), ENCODER (dcbz), ENCODER (dcbz_l), ENCODER (tlbie), ENCODER (tlbsync), ENCODER (eieio),
+    ENCODER (isync), ENCODER (sync), ENCODER (lwsync), ENCODER (rfi), ENCODER (sc), FLAGGED (ps_abs), FLAGGED (ps_add), ENCODER (ps_cmpo0),
+    ENCODER (ps_cmpo1), ENCODER (ps_cmpu0), ENCODER (ps_cmpu1), FLAGGED (ps_div), FLAGGED (ps_madd), FLAGGED (ps_madds0),
+    FLAGGED (ps_madds1), FLAGGED (ps_merge00), FLAGGED (ps_merge01), FLAGGED (ps_merge10), FLAGGED (ps_merge11), FLAGGED (ps_mr),
+    FLAGGED (ps_msub), FLAGGED (ps_mul), FLAGGED (ps_muls0), FLAGGED (ps_muls1), FLAGGED (ps_nabs), FLAGGED (ps_neg), FLAGGED (ps_nmadd),
+    FLAGGED (ps_nmsub), FLAGGED (ps_res), FLAGGED (ps_rsqrte), FLAGGED (ps_sel), FLAGGED (ps_sub), FLAGGED (ps_sum0), FLAGGED (ps_sum1),
+    ENCODER (psq_l), ENCODER (psq_lu), ENCODER (psq_lx), ENCODER (psq_lux), ENCODER (psq_st), ENCODER (psq_stu), ENCODER (psq_stx),
+    ENCODER (psq_stux), ENCODER (mtgqr), ENCODER (mfgqr), ENCODER (vmhaddshs), ENCODER (vmhraddshs), ENCODER (vmladdshs),
+    ENCODER (vmsumubm), ENCODER (vmsummbm), ENCODER (vmsumuhm), ENCODER (vmsumuhs), ENCODER (vmsumshm), ENCODER (vmsumshs), ENCODER (vsel),
+    ENCODER (vperm), ENCODER (vsldoi), ENCODER (vmaddfp), ENCODER (vnmsubfp), ENCODER (vaddubm), ENCODER (vadduhm), ENCODER (vadduwm),
+    ENCODER (vaddcuw), ENCODER (vaddubs), ENCODER (vadduhs), ENCODER (vadduws), ENCODER (vaddsbs), ENCODER (vaddshs), ENCODER (vaddsws),
+    ENCODER (vsububm), ENCODER (vsubuhm), ENCODER (vsubuwm), ENCODER (vsubcuw), ENCODER (vsububs), ENCODER (vsubuhs), ENCODER (vsubuws),
+    ENCODER (vsubsbs), ENCODER (vsubshs), ENCODER (vsubsws), ENCODER (vmaxub), ENCODER (vmaxuh), ENCODER (vmaxuw), ENCODER (vmaxsb),
+    ENCODER (vmaxsh), ENCODER (vmaxsw), ENCODER (vminub), ENCODER (vminuh), ENCODER (vminuw), ENCODER (vminsb), ENCODER (vminsh),
+    ENCODER (vminsw), ENCODER (vavgub), ENCODER (vavguh), ENCODER (vavguw), ENCODER (vavgsb), ENCODER (vavgsh), ENCODER (vavgsw),
+    ENCODER (vrlb), ENCODER (vrlh), ENCODER (vrlw), ENCODER (vslb), ENCODER (vslh), ENCODER (vslw), ENCODER (vsl), ENCODER (vsrb),
+    ENCODER (vsrh), ENCODER (vsrw), ENCODER (vsr), ENCODER (vsrab), ENCODER (vsrah), ENCODER (vsraw), ENCODER (vand), ENCODER (vandc),
+    ENCODER (vor), ENCODER (vxor), ENCODER (vnor), ENCODER (mfvscr), ENCODER (mtvscr), FLAGGED (vcmpequb), FLAGGED (vcmpequh),
+    FLAGGED (vcmpequw), FLAGGED (vcmpeqfp), FLAGGED (vcmpgeub), FLAGGED (vcmpgeuh), FLAGGED (vcmpgeuw), FLAGGED (vcmpgefp),
+    FLAGGED (vcmpgtub), FLAGGED (vcmpgtuh), FLAGGED (vcmpgtuw), FLAGGED (vcmpgtfp), FLAGGED (vcmpgtsb), FLAGGED (vcmpgtsh),
+    FLAGGED (vcmpgtsw), FLAGGED (vcmpbfp), ENCODER (vmuloub), ENCODER (vmulouh), ENCODER (vmulosb), ENCODER (vmulosh), ENCODER (vmuleub),
+    ENCODER (vmuleuh), ENCODER (vmulesb), ENCODER (vmulesh), ENCODER (vsum4ubs), ENCODER (vsum4sbs), ENCODER (vsum4shs), ENCODER (vsum2sws),
+    ENCODER (vsumsws), ENCODER (vaddfp), ENCODER (vsubfp), ENCODER (vrefp), ENCODER (vrsqrtefp), ENCODER (vexptefp), ENCODER (vlogefp),
+    ENCODER (vrfin), ENCODER (vrfiz), ENCODER (vrfip), ENCODER (vrfim), ENCODER (vcfux), ENCODER (vcfsx), ENCODER (vctuxs),
+    ENCODER (vctsxs), ENCODER (vmaxfp), ENCODER (vminfp), ENCODER (vmrghb), ENCODER (vmrghh), ENCODER (vmrghw), ENCODER (vmrglb),
+    ENCODER (vmrglh), ENCODER (vmrglw), ENCODER (vspltb), ENCODER (vsplth), ENCODER (vspltw), ENCODER (vspltisb), ENCODER (vspltish),
+    ENCODER (vspltisw), ENCODER (vslo), ENCODER (vsro), ENCODER (vpkuhum), ENCODER (vpkuwum), ENCODER (vpkuhus), ENCODER (vpkuwus),
+    ENCODER (vpkshus), ENCODER (vpkswus), ENCODER (vpkshss), ENCODER (vpkswss), ENCODER (vupkhsb), ENCODER (vupkhsh), ENCODER (vupklsb),
+    ENCODER (vupklsh), ENCODER (vpkpx), ENCODER (vupkhpx), ENCODER (vupklpx), ENCODER (lvsl), ENCODER (lvsr), ENCODER (dst), ENCODER (dstt),
+    ENCODER (dstst), ENCODER (dststt), ENCODER (dss), ENCODER (dssall), ENCODER (lvebx), ENCODER (lvehx), ENCODER (lvewx), ENCODER (lvx),
+    ENCODER (lvxl), ENCODER (stvebx), ENCODER (stvehx), ENCODER (stvewx), ENCODER (stvx), ENCODER (stvxl)
+    };
+
+    const auto find = [&] (const char* name) -> Case& {
+        return *std::find_if (cases.begin(), cases.end(), [name] (const Case& c) { return std::strcmp (c.name, name) == 0; });
+    };
+
+    find ("extlwi").range (2, 1, 31);
+    find ("extrwi").range (2, 1, 31).overlapping(); // The shift is b + n
+    find ("mtcrf").range (0, 0, 255);
+    for (const auto name : { "psq_l", "psq_lu", "psq_st", "psq_stu" })
+        find (name).range (2, -2048, 2047);
+    for (const auto name : { "dst", "dstt", "dstst", "dststt", "dss" })
+        find (name).range (0, 0, 3);
+    for (const auto name : { "vcmpgeub", "vcmpgeuh", "vcmpgeuw" })
+        find (name).withoutReference();
+
+    return cases;
+}
+
+struct ReferenceWord {
+    const char* name;
+    bool flagged;
+    Arguments args;
+    uint32_t word;
+};
+
+static const ReferenceWord referenceWords[] = {
+#include "fuzz_reference.inc"
+};
+
+// Every encoder makes the same words as an outside assembler, so that a field both the encoder and the Decoder get wrong still shows up
+static void checkReference (const std::vector <Case>& cases) {
+    for (const auto& c : cases) {
+        const bool covered = std::any_of (std::begin (referenceWords), std::end (referenceWords), [&c] (const ReferenceWord& reference) {
+            return std::strcmp (reference.name, c.name) == 0;
+        });
+        if (!covered && !c.unassembled)
+            fail ("reference", "%s has no reference encoding", c.name);
+    }
+
+    for (const auto& reference : referenceWords) {
+        const auto c = std::find_if (cases.begin(), cases.end(), [&reference] (const Case& c) { return std::strcmp (c.name, reference.name) == 0; });
+        checks++;
+        if (c == cases.end() || (reference.flagged && !c->encodeFlagged)) {
+            fail ("reference", "%s%s has a reference encoding, but no encoder", reference.name, reference.flagged ? " <true>" : "");
+            continue;
+        }
+
+        const auto word = reference.flagged ? c->encodeFlagged (reference.args) : c->encode (reference.args);
+        if (word != reference.word)
+            fail ("reference", "%s%s = %08X, but assembles as %08X", c->format (reference.args).c_str(), reference.flagged ? " <true>" : "", word, reference.word);
+    }
+}
+
+// Whether "text" has "prefix" followed by "value" as one of its space/comma/parenthesis separated tokens
+static bool hasToken (const std::string& text, const char* prefix, int64_t value) {
+    const auto token = prefix + std::to_string (value);
+    for (size_t start = 0; (start = text.find (token, start)) != std::string::npos; start++) {
+        const auto end = start + token.size();
+        const bool leftEdge = start == 0 || std::strchr (" ,(", text[start - 1]);
+        const bool rightEdge = end == text.size() || std::strchr (" ,)", text[end]);
+        if (leftEdge && rightEdge)
+            return true;
+    }
+    return false;
+}
+
+// Properties every encoder has to satisfy:
+// - Every word decodes, always to the same opcode table entry, so arguments never leak into the opcode bits
+// - Arguments are in disjoint fields: the word is the one with all arguments at their origin, with each argument's bits flipped in separately
+// - Register arguments show up in the disassembly
+// - setFlags = true flips a single bit, and makes a "." form
+// - Different values of an argument give different words, so no field is truncated
+// - The emitter writes exactly the word the encoder returns
+static void checkEncoder (const Case& c, Rng& rng) {
+    // Opcode 4 is shared by paired singles and AltiVec, so vector encoders are decoded in AltiVec mode first
+    const bool vector = std::any_of (c.operands.begin(), c.operands.end(), [] (const Operand& operand) {
+        return operand.prefix && std::strcmp (operand.prefix, "v") == 0;
+    });
+    const Decoder decoders[] = { Decoder (vector ? DecodeMode::AltiVec : DecodeMode::PairedSingles),
+                                 Decoder (vector ? DecodeMode::PairedSingles : DecodeMode::AltiVec) };
+    const size_t count = c.operands.size();
+    Arguments origin {};
+    for (size_t i = 0; i < count; i++)
+        origin[i] = std::max (c.operands[i].min, std::min <int64_t> (0, c.operands[i].max));
+
+    const uint32_t base = c.encode (origin);
+    const Decoder* decoder = nullptr;
+    for (const auto& candidate : decoders)
+        if (!decoder && candidate.decode (base).isValid())
+            decoder = &candidate;
+
+    if (!decoder) {
+        fail ("decodes", "%s: %08X is not decoded as anything", c.format (origin).c_str(), base);
+        return;
+    }
+
+    const auto opcode = decoder->decode (base).opcode;
+    const int samples = rounds * 64;
+    Emitter gen (samples * 4);
+    std::vector <uint32_t> words;
+
+    for (int i = 0; i < samples; i++) {
+        Arguments args {};
+        for (size_t j = 0; j < count; j++)
+            args[j] = sample (c.operands[j], rng);
+
+        const uint32_t word = c.encode (args);
+        const auto instruction = decoder->decode (word);
+        words.push_back (word);
+        c.emit (gen, args);
+        checks++;
+
+        if (instruction.opcode != opcode) {
+            fail ("decodes", "%s = %08X decodes as %s instead of %s", c.format (args).c_str(), word, instruction.getMnemonic(), opcode->mnemonic);
+            continue;
+        }
+
+        if (c.disjoint) {
+            uint32_t expected = base;
+            for (size_t j = 0; j < count; j++) {
+                auto single = origin;
+                single[j] = args[j];
+                expected ^= c.encode (single) ^ base;
+            }
+
+            if (word != expected)
+                fail ("fields", "%s = %08X, but its arguments on their own make %08X", c.format (args).c_str(), word, expected);
+        }
+
+        const auto text = decoder->toString (instruction);
+        for (size_t j = 0; j < count; j++) {
+            const auto prefix = c.operands[j].prefix;
+            if (prefix && args[j] != 0 && !hasToken (text, prefix, args[j])) // r0 can read as 0, and cr0 is left out
+                fail ("operands", "%s = %08X disassembles as \"%s\", without %s%lld", c.format (args).c_str(), word, text.c_str(), prefix, (long long) args[j]);
+        }
+
+        if (c.encodeFlagged) {
+            const uint32_t flagged = c.encodeFlagged (args);
+            const auto flaggedText = decoder->toString (decoder->decode (flagged));
+            const uint32_t changed = flagged ^ word;
+            if (!changed || (changed & (changed - 1))) // Bit 0, bit 10 for AltiVec compares, or the opcode for addic.
+                fail ("setFlags", "%s: setFlags changes %08X to %08X", c.format (args).c_str(), word, flagged);
+            else if (flaggedText.find ('.') == std::string::npos || flaggedText.find ('.') > flaggedText.find (' '))
+                fail ("setFlags", "%s <true> disassembles as \"%s\"", c.name, flaggedText.c_str());
+        }
+    }
+
+    if (gen.getCodeSize() != words.size() * 4 || std::memcmp (gen.getBuffer(), words.data(), gen.getCodeSize()) != 0)
+        fail ("emitter", "%s: the emitter wrote different words than the encoder returned", c.name);
+
+    for (size_t j = 0; j < count; j++) {
+        std::unordered_map <uint32_t, int64_t> seen;
+        for (const auto value : domain (c.operands[j], rng)) {
+            auto args = origin;
+            args[j] = value;
+            const uint32_t word = c.encode (args);
+            checks++;
+
+            const auto previous = seen.find (word);
+            if (previous != seen.end())
+                fail ("truncation", "%s: argument %zu encodes %lld and %lld both as %08X", c.name, j, (long long) previous->second, (long long) value, word);
+            seen[word] = value;
+        }
+    }
+}
+
+// Reference model for the integer instructions the liw and peephole checks produce
+struct Machine {
+    uint32_t gpr[32];
+
+    bool step (uint32_t word) {
+        const uint32_t opcode = word >> 26;
+        const uint32_t d = (word >> 21) & 31, a = (word >> 16) & 31, b = (word >> 11) & 31;
+        const uint32_t imm = word & 0xFFFF;
+
+        switch (opcode) {
+            case 14: gpr[d] = (a ? gpr[a] : 0) + (uint32_t) (int32_t) (int16_t) imm; return true; // addi
+            case 15: gpr[d] = (a ? gpr[a] : 0) + (imm << 16); return true; // addis
+            case 24: gpr[a] = gpr[d] | imm; return true; // ori
+            case 25: gpr[a] = gpr[d] | (imm << 16); return true; // oris
+            case 26: gpr[a] = gpr[d] ^ imm; return true; // xori
+            case 31:
+                if (((word >> 1) & 0x3FF) != 444 || (word & 1)) // or
+                    return false;
+                gpr[a] = gpr[d] | gpr[b];
+                return true;
+            default: return false;
+        }
+    }
+
+    bool run (const uint32_t* code, uint32_t size) {
+        for (uint32_t i = 0; i < size / 4; i++)
+            if (!step (code[i]))
+                return false;
+        return true;
+    }
+};
+
+static Machine randomMachine (Rng& rng) {
+    Machine machine;
+    for (auto& reg : machine.gpr)
+        reg = (uint32_t) rng();
+    return machine;
+}
+
+// liw loads exactly its value, in one instruction whenever li or lis can do it
+static void checkLiw (Rng& rng) {
+    const uint32_t halves[] = { 0, 1, 0x7FFF, 0x8000, 0x8001, 0xFFFF, 0xFFFE };
+    for (int i = 0; i < rounds * 256; i++) {
+        const uint32_t value = (rng() & 1) ? (halves[rng() % 7] << 16) | halves[rng() % 7] : (uint32_t) rng();
+        const auto reg = (GPR) (rng() % 32);
+        Emitter gen (64);
+        gen.liw (reg, value);
+
+        auto machine = randomMachine (rng);
+        const bool single = (int32_t) value == (int16_t) value || (value & 0xFFFF) == 0;
+        checks++;
+        if (!machine.run (gen.getBuffer(), gen.getCodeSize()) || machine.gpr[reg] != value)
+            fail ("liw", "liw (r%d, 0x%08X) loads 0x%08X", (int) reg, value, machine.gpr[reg]);
+        else if (gen.getCodeSize() != (single ? 4u : 8u))
+            fail ("liw", "liw (r%d, 0x%08X) takes %u instructions", (int) reg, value, gen.getCodeSize() / 4);
+    }
+}
+
+// A random run of immediate loads, adds, ors and moves on a few registers, so that the peephole optimizer has plenty to fold
+template <typename Gen>
+static void emitArithmetic (Gen& gen, Rng rng) {
+    const GPR regs[] = { r0, r3, r4, r5 };
+    const int length = 1 + (int) (rng() % 24);
+    for (int i = 0; i < length; i++) {
+        const auto dest = regs[rng() % 4];
+        const auto src = (rng() % 4) ? dest : regs[rng() % 4]; // Mostly the same register, which is what gets folded
+        const auto imm = (uint16_t) ((rng() & 1) ? rng() : (rng() % 5) - 2);
+        switch (rng() % 9) {
+            case 0: gen.li (dest, (int16_t) imm); break;
+            case 1: gen.lis (dest, imm); break;
+            case 2: gen.addi (dest, src, (int16_t) imm); break;
+            case 3: gen.addis (dest, src, imm); break;
+            case 4: gen.ori (dest, src, imm); break;
+            case 5: gen.oris (dest, src, imm); break;
+            case 6: gen.mr (dest, src); break;
+            case 7: gen.nop(); break;
+            case 8: gen.getAnchor(); break; // Pins the position, like a label would
+        }
+    }
+}
+
+// The peephole optimizer never changes what code computes or makes it longer, and cross-endian emitters fold it the same way
+static void checkPeephole (Rng& rng) {
+    for (int i = 0; i < rounds * 64; i++) {
+        Emitter plain (1024), optimized (1024);
+        PPCEmitter <FixedSize, foreignOrder> cross (1024);
+        optimized.setPeephole (true);
+        cross.setPeephole (true);
+        const Rng program = rng;
+        rng.discard (64);
+        emitArithmetic (plain, program);
+        emitArithmetic (optimized, program);
+        emitArithmetic (cross, program);
+
+        const auto start = randomMachine (rng);
+        auto expected = start, actual = start;
+        checks++;
+        if (!expected.run (plain.getBuffer(), plain.getCodeSize()) || !actual.run (optimized.getBuffer(), optimized.getCodeSize())) {
+            fail ("peephole", "program %d uses an instruction the reference model doesn't know", i);
+            continue;
+        }
+
+        if (std::memcmp (expected.gpr, actual.gpr, sizeof (expected.gpr)) != 0) {
+            fail ("peephole", "program %d computes something else once optimized:\n%s---\n%s", i, plain.disassemble().c_str(), optimized.disassemble().c_str());
+            continue;
+        }
+
+        if (optimized.getCodeSize() > plain.getCodeSize())
+            fail ("peephole", "program %d grows from %u to %u bytes", i, plain.getCodeSize(), optimized.getCodeSize());
+
+        bool swapped = cross.getCodeSize() == optimized.getCodeSize();
+        for (uint32_t word = 0; swapped && word < optimized.getCodeSize() / 4; word++)
+            swapped = cross.getBuffer()[word] == byteswap (optimized.getBuffer()[word]);
+        if (!swapped)
+            fail ("byteOrder", "program %d isn't the byteswapped native code when emitted big/little endian", i);
+    }
+}
+
+struct EmittedBranch {
+    uint32_t offset;
+    uint32_t label;
+    uint32_t bits; // The word the branch was emitted as, minus its displacement and y bit
+    BranchHint hint;
+};
+
+// Long stretches of code with conditional branches forward and back to random labels, well past the +-32KB a bc can reach
+template <typename Gen>
+static std::vector <EmittedBranch> emitBranches (Gen& gen, Rng rng, std::vector <Label>& labels) {
+    std::vector <EmittedBranch> branches;
+    for (int i = 0; i < 8; i++)
+        labels.push_back (gen.newLabel());
+
+    const BranchHint hints[] = { BranchHint::None, BranchHint::Likely, BranchHint::Unlikely };
+    for (int event = 0; event < 48; event++) {
+        const auto label = labels[rng() % labels.size()];
+        switch (rng() % 8) {
+            case 0: case 1: case 2:
+                gen.nops (1 + rng() % ((rng() & 1) ? 3000 : 16)); // Sometimes far enough to need veneers
+                break;
+
+            case 3: case 4: case 5: {
+                const auto field = (CR) (rng() % 8);
+                const auto hint = hints[rng() % 3];
+                BranchLabel branch;
+                switch (rng() % 5) {
+                    case 0: branch = gen.beq (field, hint); break;
+                    case 1: branch = gen.bne (field, hint); break;
+                    case 2: branch = gen.bge (field, hint); break;
+                    case 3: branch = gen.bdnz (hint); break;
+                    default: branch = gen.bdz (hint); break;
+                }
+
+                uint32_t word = gen.getBuffer()[branch.offset / 4];
+                if constexpr (!std::is_same_v <Gen, PPCEmitter <AutoGrow>>)
+                    word = byteswap (word);
+                branches.push_back ({ branch.offset, label.id, word & 0xFFDF0000, hint });
+                gen.setLabel (branch, label);
+                break;
+            }
+
+            case 6:
+                if (!gen.isBound (label))
+                    gen.bind (label);
+                break;
+
+            default: gen.nop(); break;
+        }
+    }
+
+    for (const auto label : labels)
+        if (!gen.isBound (label))
+            gen.bind (label);
+    gen.finalize();
+    return branches;
+}
+
+// With relaxation on every conditional branch reaches its label, directly or through one veneer, keeps its condition, and has the
+// y bit its hint asks for in the direction it ended up going. The same program emitted in the other byte order is the same code, swapped
+static void checkRelaxation (Rng& rng) {
+    const Decoder decoder;
+    for (int i = 0; i < std::max (1, rounds / 4); i++) {
+        PPCEmitter <AutoGrow> gen (4096);
+        PPCEmitter <AutoGrow, foreignOrder> cross (4096);
+        gen.setBranchRelaxation (true);
+        cross.setBranchRelaxation (true);
+        std::vector <Label> labels, crossLabels;
+        const Rng program = rng;
+        rng.discard (256);
+
+        const auto branches = emitBranches (gen, program, labels);
+        emitBranches (cross, program, crossLabels);
+        const auto code = gen.getBuffer();
+
+        for (const auto& branch : branches) {
+            const auto target = (uint32_t) ((uintptr_t) gen.getPointer (Label { branch.label }) - (uintptr_t) code);
+            const uint32_t word = code[branch.offset / 4];
+            const auto instruction = decoder.decode (word, branch.offset);
+            auto reached = (uint32_t) instruction.getBranchTarget();
+            checks++;
+
+            if ((word & 0xFFDF0000) != branch.bits || (word & 3)) {
+                fail ("relaxation", "program %d: the branch at 0x%X changed from %08X to %08X", i, branch.offset, branch.bits, word);
+                continue;
+            }
+
+            const bool backward = (int16_t) (word & 0xFFFC) < 0;
+            const bool y = word & (1 << 21);
+            if (y != (branch.hint != BranchHint::None && (branch.hint == BranchHint::Likely) != backward))
+                fail ("hints", "program %d: the branch at 0x%X has the wrong y bit for its hint (%08X)", i, branch.offset, word);
+
+            const uint32_t veneer = code[reached / 4];
+            if (reached != target && (veneer & 0xFC000003) == 0x48000000) // Through a veneer
+                reached = (uint32_t) decoder.decode (veneer, reached).getBranchTarget();
+            if (reached != target)
+                fail ("relaxation", "program %d: the branch at 0x%X goes to 0x%X instead of 0x%X", i, branch.offset, reached, target);
+        }
+
+        bool swapped = cross.getCodeSize() == gen.getCodeSize();
+        for (uint32_t word = 0; swapped && word < gen.getCodeSize() / 4; word++)
+            swapped = cross.getBuffer()[word] == byteswap (code[word]);
+        if (!swapped)
+            fail ("byteOrder", "program %d isn't the byteswapped native code when emitted big/little endian", i);
+    }
+}
+
+// Code built at compile time is the code the emitter builds at runtime
+static void checkTemplates (Rng&) {
+    static constexpr auto stub = makeTemplate <8> ([] (auto& c) {
+        c.liw (r3, 0x12345678);
+        c.template addic <true> (r3, r3, -1);
+        c.rlwinm (r4, r3, 3, 0, 28);
+        c.ps_madd (f1, f2, f3, f4);
+        c.vperm (v1, v2, v3, v4);
+        c.blr();
+    });
+
+    Emitter gen (64);
+    gen.liw (r3, 0x12345678);
+    gen.addic <true> (r3, r3, -1);
+    gen.rlwinm (r4, r3, 3, 0, 28);
+    gen.ps_madd (f1, f2, f3, f4);
+    gen.vperm (v1, v2, v3, v4);
+    gen.blr();
+    checks++;
+    if (gen.getCodeSize() != stub.size() * 4 || std::memcmp (gen.getBuffer(), stub.data(), gen.getCodeSize()) != 0)
+        fail ("constexpr", "a CodeTemplate built at compile time differs from the same code emitted at runtime");
+}
+
+// Reference model for what the kernel builder emits: integer, branch, FPU, paired single and AltiVec instructions on a small big endian memory
+struct KernelMachine {
+    static constexpr uint32_t memorySize = 64 * 1024;
+    static constexpr uint32_t stackTop = memorySize - 256;
+
+    uint32_t gpr[32];
+    float ps[32][2]; // ps0/ps1. Single precision scalar results go in both, like on the Gekko
+    uint64_t fprBits[32]; // What lfd/stfd move, which never goes through arithmetic
+    uint8_t vr[32][16]; // Byte 0 is the most significant, like in memory
+    uint32_t cr = 0, ctr = 0;
+    uint32_t gqr[8] = {};
+    std::vector <uint8_t> memory;
+    bool pairedSingles;
+    uint32_t lowest[3] = {}, highest[3] = {}; // Address ranges loads are allowed from: the source, the destination if it's read, and the stack
+    const char* error = nullptr;
+
+    KernelMachine (bool paired, Rng& rng) : memory (memorySize), pairedSingles (paired) {
+        for (auto& reg : gpr)
+            reg = (uint32_t) rng();
+        for (auto& reg : ps)
+            reg[0] = reg[1] = std::nanf ("");
+        for (auto& reg : vr)
+            for (auto& byte : reg)
+                byte = (uint8_t) rng();
+        for (auto& byte : memory)
+            byte = (uint8_t) rng();
+        gpr[1] = stackTop;
+    }
+
+    bool check (uint32_t address, uint32_t size, bool load) {
+        if (address + size > memorySize || address + size < address)
+            error = "access outside of memory";
+        else if (load) {
+            bool allowed = false;
+            for (int i = 0; i < 3; i++)
+                allowed |= address >= lowest[i] && address + size <= highest[i];
+            if (!allowed)
+                error = "load outside of the quadwords holding the data";
+        }
+        return !error;
+    }
+
+    uint32_t load (uint32_t address, uint32_t size) {
+        uint32_t value = 0;
+        if (check (address, size, true))
+            for (uint32_t i = 0; i < size; i++)
+                value = (value << 8) | memory[address + i];
+        return value;
+    }
+
+    void store (uint32_t address, uint32_t size, uint32_t value) {
+        if (check (address, size, false))
+            for (uint32_t i = 0; i < size; i++)
+                memory[address + i] = (uint8_t) (value >> (8 * (size - 1 - i)));
+    }
+
+    static float toFloat (uint32_t bits) { float value; std::memcpy (&value, &bits, 4); return value; }
+    static uint32_t toBits (float value) { uint32_t bits; std::memcpy (&bits, &value, 4); return bits; }
+
+    void setCR0 (int64_t difference) {
+        const uint32_t field = difference < 0 ? 8 : difference > 0 ? 4 : 2;
+        cr = (cr & 0x0FFFFFFF) | (field << 28);
+    }
+
+    void compare (uint32_t field, uint32_t a, uint32_t b) {
+        const uint32_t bits = a < b ? 8 : a > b ? 4 : 2;
+        cr = (cr & ~(0xF0000000 >> (field * 4))) | ((bits << 28) >> (field * 4));
+    }
+
+    float dequantize (uint32_t address, uint32_t type) {
+        switch (type) {
+            case 4: return (float) load (address, 1);
+            case 7: return (float) (int16_t) load (address, 2);
+            default: return toFloat (load (address, 4));
+        }
+    }
+
+    void quantize (uint32_t address, uint32_t type, float value) {
+        switch (type) {
+            case 4: store (address, 1, (uint32_t) std::min (255.0f, std::max (0.0f, value))); break;
+            case 7: store (address, 2, (uint32_t) (int32_t) std::min (32767.0f, std::max (-32768.0f, value))); break;
+            default: store (address, 4, toBits (value)); break;
+        }
+    }
+
+    static uint32_t rotate (uint32_t value, uint32_t amount) { return amount ? (value << amount) | (value >> (32 - amount)) : value; }
+
+    static uint32_t mask (uint32_t mb, uint32_t me) {
+        const uint32_t begin = 0xFFFFFFFFu >> mb, end = 0xFFFFFFFFu << (31 - me);
+        return mb <= me ? begin & end : begin | end;
+    }
+
+    // Returns the number of words to advance by (0 = blr)
+    int32_t step (uint32_t word) {
+        const uint32_t opcode = word >> 26;
+        const uint32_t d = (word >> 21) & 31, a = (word >> 16) & 31, b = (word >> 11) & 31, c = (word >> 6) & 31;
+        const uint32_t imm = word & 0xFFFF;
+        const auto simm = (uint32_t) (int32_t) (int16_t) imm;
+        const uint32_t base = a ? gpr[a] : 0;
+        const uint32_t indexed = base + gpr[b];
+
+        switch (opcode) {
+            case 4:
+                if (pairedSingles) {
+                    switch ((word >> 1) & 31) {
+                        case 10: ps[d][0] = ps[a][0] + ps[b][1]; ps[d][1] = ps[c][1]; return 1; // ps_sum0
+                        case 21: for (int i = 0; i < 2; i++) ps[d][i] = ps[a][i] + ps[b][i]; return 1; // ps_add
+                        case 29: for (int i = 0; i < 2; i++) ps[d][i] = std::fma (ps[a][i], ps[c][i], ps[b][i]); return 1; // ps_madd
+                    }
+                    if (((word >> 1) & 0x3FF) == 528) { // ps_merge00
+                        const float high = ps[a][0], low = ps[b][0];
+                        ps[d][0] = high;
+                        ps[d][1] = low;
+                        return 1;
+                    }
+                    break;
+                }
+
+                switch (word & 0x3F) {
+                    case 43: { // vperm
+                        uint8_t both[32], result[16];
+                        std::memcpy (both, vr[a], 16);
+                        std::memcpy (both + 16, vr[b], 16);
+                        for (int i = 0; i < 16; i++)
+                            result[i] = both[vr[c][i] & 31];
+                        std::memcpy (vr[d], result, 16);
+                        return 1;
+                    }
+                    case 44: { // vsldoi
+                        uint8_t both[32];
+                        std::memcpy (both, vr[a], 16);
+                        std::memcpy (both + 16, vr[b], 16);
+                        std::memcpy (vr[d], both + (c & 15), 16);
+                        return 1;
+                    }
+                    case 46: // vmaddfp
+                        for (int i = 0; i < 4; i++)
+                            setLane (d, i, std::fma (lane (a, i), lane (c, i), lane (b, i)));
+                        return 1;
+                }
+
+                switch (word & 0x7FF) {
+                    case 0: for (int i = 0; i < 16; i++) vr[d][i] = vr[a][i] + vr[b][i]; return 1; // vaddubm
+                    case 10: for (int i = 0; i < 4; i++) setLane (d, i, lane (a, i) + lane (b, i)); return 1; // vaddfp
+                    case 12: case 268: { // vmrghb, vmrglb
+                        uint8_t result[16];
+                        const int half = (word & 0x7FF) == 12 ? 0 : 8;
+                        for (int i = 0; i < 8; i++) {
+                            result[2 * i] = vr[a][half + i];
+                            result[2 * i + 1] = vr[b][half + i];
+                        }
+                        std::memcpy (vr[d], result, 16);
+                        return 1;
+                    }
+                    case 270: { // vpkshus
+                        uint8_t result[16];
+                        for (int i = 0; i < 16; i++) {
+                            const auto source = i < 8 ? vr[a] : vr[b];
+                            const auto value = (int16_t) ((source[(i & 7) * 2] << 8) | source[(i & 7) * 2 + 1]);
+                            result[i] = (uint8_t) std::min <int> (255, std::max <int> (0, value));
+                        }
+                        std::memcpy (vr[d], result, 16);
+                        return 1;
+                    }
+                    case 652: { // vspltw
+                        uint8_t word[4];
+                        std::memcpy (word, vr[b] + (a & 3) * 4, 4);
+                        for (int i = 0; i < 16; i++)
+                            vr[d][i] = word[i & 3];
+                        return 1;
+                    }
+                    case 780: std::memset (vr[d], (int) ((int8_t) (a << 3) >> 3), 16); return 1; // vspltisb
+                    case 1156: for (int i = 0; i < 16; i++) vr[d][i] = vr[a][i] | vr[b][i]; return 1; // vor
+                    case 1220: for (int i = 0; i < 16; i++) vr[d][i] = vr[a][i] ^ vr[b][i]; return 1; // vxor
+                }
+                break;
+
+            case 8: gpr[d] = simm - gpr[a]; return 1; // subfic
+            case 10: compare (d >> 2, gpr[a], imm); return 1; // cmpli
+            case 14: gpr[d] = base + simm; return 1; // addi
+            case 15: gpr[d] = base + (imm << 16); return 1; // addis
+            case 16: { // bc
+                if (!(d & 4))
+                    ctr--;
+                const bool ctrOk = (d & 4) || ((ctr != 0) != bool (d & 2));
+                const bool condOk = (d & 16) || (bool ((cr << a) & 0x80000000) == bool (d & 8));
+                return ctrOk && condOk ? (int32_t) (int16_t) (imm & 0xFFFC) / 4 : 1;
+            }
+            case 18: return ((int32_t) (word << 6) >> 6 & ~3) / 4; // b
+            case 19: if (word == 0x4E800020) return 0; break; // blr
+            case 21: gpr[a] = rotate (gpr[d], b) & mask (c, (word >> 1) & 31); return 1; // rlwinm
+            case 24: gpr[a] = gpr[d] | imm; return 1; // ori
+            case 28: gpr[a] = gpr[d] & imm; setCR0 ((int32_t) gpr[a]); return 1; // andi.
+            case 31:
+                switch ((word >> 1) & 0x3FF) {
+                    case 6: for (int i = 0; i < 16; i++) vr[d][i] = (uint8_t) ((indexed & 15) + i); return 1; // lvsl
+                    case 32: compare (d >> 2, gpr[a], gpr[b]); return 1; // cmpl
+                    case 40: gpr[d] = gpr[b] - gpr[a]; return 1; // subf
+                    case 60: gpr[a] = gpr[d] & ~gpr[b]; return 1; // andc
+                    case 71: { // lvewx. The other elements are left undefined
+                        const uint32_t address = indexed & ~3u;
+                        for (int i = 0; i < 4; i++)
+                            vr[d][((address >> 2) & 3) * 4 + i] = (uint8_t) load (address + i, 1);
+                        return 1;
+                    }
+                    case 103: for (int i = 0; i < 16; i++) vr[d][i] = (uint8_t) load ((indexed & ~15u) + i, 1); return 1; // lvx
+                    case 199: { // stvewx
+                        const uint32_t address = indexed & ~3u;
+                        for (int i = 0; i < 4; i++)
+                            store (address + i, 1, vr[d][((address >> 2) & 3) * 4 + i]);
+                        return 1;
+                    }
+                    case 231: for (int i = 0; i < 16; i++) store ((indexed & ~15u) + i, 1, vr[d][i]); return 1; // stvx
+                    case 246: case 278: case 342: case 374: case 822: return 1; // dcbtst, dcbt, dst, dstst, dss
+                    case 316: gpr[a] = gpr[d] ^ gpr[b]; return 1; // xor
+                    case 444: gpr[a] = gpr[d] | gpr[b]; return 1; // or
+                    case 467: { // mtspr
+                        const uint32_t spr = a | (b << 5);
+                        if (spr == 9)
+                            ctr = gpr[d];
+                        else if (spr >= 912 && spr < 920)
+                            gqr[spr - 912] = gpr[d];
+                        else
+                            break;
+                        return 1;
+                    }
+                    case 824: gpr[a] = (uint32_t) ((int32_t) gpr[d] >> b); return 1; // srawi
+                }
+                break;
+
+            case 34: gpr[d] = load (base + simm, 1); return 1; // lbz
+            case 36: store (base + simm, 4, gpr[d]); return 1; // stw
+            case 37: store (gpr[a] + simm, 4, gpr[d]); gpr[a] += simm; return 1; // stwu
+            case 38: store (base + simm, 1, gpr[d]); return 1; // stb
+            case 40: gpr[d] = load (base + simm, 2); return 1; // lhz
+            case 44: store (base + simm, 2, gpr[d]); return 1; // sth
+            case 48: ps[d][0] = ps[d][1] = toFloat (load (base + simm, 4)); return 1; // lfs
+            case 50: fprBits[d] = ((uint64_t) load (base + simm, 4) << 32) | load (base + simm + 4, 4); return 1; // lfd
+            case 52: store (base + simm, 4, toBits (ps[d][0])); return 1; // stfs
+            case 54: store (base + simm, 4, (uint32_t) (fprBits[d] >> 32)); store (base + simm + 4, 4, (uint32_t) fprBits[d]); return 1; // stfd
+            case 56: case 60: { // psq_l, psq_st
+                const uint32_t address = base + (uint32_t) ((int32_t) (word << 20) >> 20);
+                const uint32_t config = gqr[(word >> 12) & 7];
+                const bool single = word & 0x8000;
+                const uint32_t size = (opcode == 56 ? config >> 16 : config) & 7;
+                const uint32_t bytes = size == 4 ? 1 : size == 7 ? 2 : 4;
+                if (opcode == 56) {
+                    ps[d][0] = dequantize (address, size);
+                    ps[d][1] = single ? 1.0f : dequantize (address + bytes, size);
+                } else {
+                    quantize (address, size, ps[d][0]);
+                    if (!single)
+                        quantize (address + bytes, size, ps[d][1]);
+                }
+                return 1;
+            }
+            case 59:
+                switch ((word >> 1) & 31) {
+                    case 21: ps[d][0] = ps[d][1] = ps[a][0] + ps[b][0]; return 1; // fadds
+                    case 29: ps[d][0] = ps[d][1] = std::fma (ps[a][0], ps[c][0], ps[b][0]); return 1; // fmadds
+                }
+                break;
+        }
+
+        error = "instruction the model doesn't know";
+        return 0;
+    }
+
+    float lane (uint32_t reg, int i) { return toFloat ((vr[reg][i * 4] << 24) | (vr[reg][i * 4 + 1] << 16) | (vr[reg][i * 4 + 2] << 8) | vr[reg][i * 4 + 3]); }
+
+    void setLane (uint32_t reg, int i, float value) {
+        const uint32_t bits = toBits (value);
+        for (int j = 0; j < 4; j++)
+            vr[reg][i * 4 + j] = (uint8_t) (bits >> (24 - 8 * j));
+    }
+
+    // Run until blr. Returns false on an error, or if the code doesn't finish in "budget" instructions
+    bool run (const uint32_t* code, uint32_t words, uint64_t budget) {
+        for (uint32_t pc = 0; pc < words && budget--;) {
+            const auto advance = step (code[pc]);
+            if (error)
+                return false;
+            if (!advance)
+                return true;
+            pc += advance;
+        }
+
+        error = "code ran off its end or didn't finish";
+        return false;
+    }
+};
+
+enum class KernelKind { Copy, Saxpy, DotProduct, U8ToS16, S16ToU8 };
+
+// Every kernel, for every unit, unroll factor, alignment and count, computes what its scalar definition does, never touches memory
+// outside of its destination (and the stack), and never loads from a quadword that holds none of its data
+static void checkKernels (Rng& rng) {
+    static constexpr uint32_t srcBase = 0x1000, destBase = 0x5000;
+    for (int i = 0; i < rounds * 4; i++) {
+        const auto kind = (KernelKind) (rng() % 5);
+        const bool paired = rng() & 1;
+        const uint32_t unroll = 1 << (rng() % 3);
+        const bool prefetch = rng() & 1;
+        const uint32_t count = rng() % 4 ? rng() % 80 : rng() % 2000;
+
+        const uint32_t destSize = kind == KernelKind::Saxpy || kind == KernelKind::DotProduct ? 4 : kind == KernelKind::U8ToS16 ? 2 : 1;
+        const uint32_t srcSize = kind == KernelKind::Saxpy || kind == KernelKind::DotProduct ? 4 : kind == KernelKind::S16ToU8 ? 2 : 1;
+        const uint32_t src = srcBase + (uint32_t) (rng() % 16) / srcSize * srcSize;
+        const uint32_t dest = destBase + (uint32_t) (rng() % 16) / destSize * destSize;
+
+        KernelMachine machine (paired, rng);
+        const float scale = (float) (int) (rng() % 17) / 4.0f - 2.0f;
+        for (uint32_t j = 0; j + 4 <= count * 4 && (srcSize == 4); j += 4) { // Small floats, so the results are exact enough to compare
+            machine.store (src + j, 4, KernelMachine::toBits ((float) (int) (rng() % 64) / 8.0f - 4.0f));
+            machine.store (dest + j, 4, KernelMachine::toBits ((float) (int) (rng() % 64) / 8.0f - 4.0f));
+        }
+
+        const auto before = machine.memory;
+        machine.gpr[3] = dest;
+        machine.gpr[4] = src;
+        machine.gpr[5] = count;
+        machine.ps[1][0] = machine.ps[1][1] = scale;
+        machine.lowest[0] = src & ~15u;
+        machine.highest[0] = count ? ((src + count * srcSize - 1) | 15) + 1 : 0;
+        if (kind == KernelKind::Saxpy || kind == KernelKind::DotProduct) {
+            machine.lowest[1] = dest & ~15u;
+            machine.highest[1] = count ? ((dest + count * destSize - 1) | 15) + 1 : 0;
+        }
+        machine.lowest[2] = KernelMachine::stackTop - 64;
+        machine.highest[2] = KernelMachine::stackTop;
+
+        Emitter gen (64 * 1024);
+        KernelBuilder <Emitter> kernels (gen, paired ? VectorUnit::PairedSingles : VectorUnit::AltiVec);
+        kernels.setUnroll (unroll);
+        kernels.setPrefetch (prefetch);
+        switch (kind) {
+            case KernelKind::Copy: kernels.copy (r3, r4, r5); break;
+            case KernelKind::Saxpy: kernels.saxpy (r3, r4, f1, r5); break;
+            case KernelKind::DotProduct: kernels.dotProduct (f1, r4, r3, r5); break;
+            case KernelKind::U8ToS16: kernels.u8ToS16 (r3, r4, r5); break;
+            case KernelKind::S16ToU8: kernels.s16ToU8 (r3, r4, r5); break;
+        }
+        gen.blr();
+        gen.finalize();
+
+        static const char* names[] = { "copy", "saxpy", "dotProduct", "u8ToS16", "s16ToU8" };
+        char what[128];
+        snprintf (what, sizeof (what), "%s (%s, unroll %u, src %04X, dest %04X, count %u)", names[(int) kind], paired ? "paired singles" : "AltiVec",
+                  unroll, src, dest, count);
+        checks++;
+
+        if (!machine.run (gen.getBuffer(), gen.getCodeSize() / 4, 64 + count * 64ull)) {
+            fail ("kernels", "%s: %s", what, machine.error);
+            continue;
+        }
+
+        auto expected = before;
+        double dot = 0, magnitude = 0;
+        for (uint32_t j = 0; j < count; j++) {
+            const auto read = [&] (uint32_t address, uint32_t size) {
+                uint32_t value = 0;
+                for (uint32_t k = 0; k < size; k++)
+                    value = (value << 8) | before[address + k];
+                return value;
+            };
+            const auto write = [&] (uint32_t address, uint32_t size, uint32_t value) {
+                for (uint32_t k = 0; k < size; k++)
+                    expected[address + k] = (uint8_t) (value >> (8 * (size - 1 - k)));
+            };
+
+            const uint32_t from = src + j * srcSize, to = dest + j * destSize;
+            switch (kind) {
+                case KernelKind::Copy: write (to, 1, read (from, 1)); break;
+                case KernelKind::U8ToS16: write (to, 2, read (from, 1)); break;
+                case KernelKind::S16ToU8: write (to, 1, (uint32_t) std::min (255, std::max (0, (int) (int16_t) read (from, 2)))); break;
+                case KernelKind::Saxpy:
+                    write (to, 4, KernelMachine::toBits (std::fma (scale, KernelMachine::toFloat (read (from, 4)), KernelMachine::toFloat (read (to, 4)))));
+                    break;
+                case KernelKind::DotProduct: {
+                    const double product = (double) KernelMachine::toFloat (read (from, 4)) * KernelMachine::toFloat (read (to, 4));
+                    dot += product;
+                    magnitude += std::fabs (product);
+                    break;
+                }
+            }
+        }
+
+        if (machine.gpr[1] != KernelMachine::stackTop)
+            fail ("kernels", "%s: the stack pointer isn't restored", what);
+        if (kind == KernelKind::DotProduct && std::fabs (machine.ps[1][0] - dot) > 1e-5 * magnitude + 1e-6)
+            fail ("kernels", "%s: computes %f instead of %f", what, machine.ps[1][0], dot);
+
+        for (uint32_t address = 0; address < KernelMachine::memorySize; address++) {
+            const bool scratch = address >= machine.lowest[2] && address < machine.highest[2];
+            if (machine.memory[address] != expected[address] && !scratch) {
+                fail ("kernels", "%s: byte %04X is %02X instead of %02X", what, address, machine.memory[address], expected[address]);
+                break;
+            }
+        }
+    }
+}
+
+int main (int argc, char** argv) {
+    unsigned threads = std::max (1u, std::thread::hardware_concurrency());
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (!std::strcmp (argv[i], "--seed"))
+            seed = std::strtoull (argv[i + 1], nullptr, 0);
+        else if (!std::strcmp (argv[i], "--rounds"))
+            rounds = std::max (1, std::atoi (argv[i + 1]));
+        else if (!std::strcmp (argv[i], "--threads"))
+            threads = std::max (1, std::atoi (argv[i + 1]));
+    }
+
+    // Every task gets its own generator seeded from its index, so results don't depend on which thread runs it
+    const auto cases = buildCases();
+    std::vector <std::function <void (Rng&)>> tasks;
+    for (const auto& c : cases)
+        tasks.push_back ([&c] (Rng& rng) { checkEncoder (c, rng); });
+    tasks.push_back ([&cases] (Rng&) { checkReference (cases); });
+    for (int i = 0; i < 16; i++) {
+        tasks.push_back (checkLiw);
+        tasks.push_back (checkPeephole);
+        tasks.push_back (checkRelaxation);
+        tasks.push_back (checkKernels);
+    }
+    tasks.push_back (checkTemplates);
+
+    std::atomic <size_t> next { 0 };
+    std::vector <std::thread> workers;
+    for (unsigned i = 0; i < threads; i++) {
+        workers.emplace_back ([&] {
+            for (size_t task; (task = next++) < tasks.size();) {
+                Rng rng (seed * 0x9E3779B97F4A7C15 + task);
+                tasks[task] (rng);
+            }
+        });
+    }
+    for (auto& worker : workers)
+        worker.join();
+
+    printf ("%zu encoders, %llu checks, %llu failures (seed %llu, %u threads)\n", cases.size(), (unsigned long long) checks.load(),
+            (unsigned long long) failures.load(), (unsigned long long) seed, threads);
+    return failures ? 1 : 0;
+}
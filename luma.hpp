@@ -3,8 +3,49 @@
 #include <cstdint> // For fixed-sized types
 #include <cassert> // for assert
 #include <utility> // For std::pair
+#include <vector> // For std::vector
+#include <algorithm> // For std::lower_bound
 #include <cstdarg> // For std::va_list
 #include <fstream> // For making binary dumps
+#include <array> // For std::array
+#include <cstddef> // For size_t
+#include <initializer_list> // For stamping stencils
+#include <atomic> // For the lock-free arena bump pointer
+#include <unordered_map> // For the block cache
+#include <string> // For disassembly listings
+#include <cstdio> // For vsnprintf and perf maps
+#include <map> // For the symbol registry
+#include <mutex> // For the symbol registry and literal pools
+#include <functional> // For deferred cold paths
+#include <type_traits> // For std::conditional_t
+
+#if defined(_WIN32)
+#include <windows.h> // For VirtualAlloc/VirtualProtect and file mappings
+#define LUMA_HAS_VIRTUAL_MEMORY 1
+#elif (defined(__unix__) || defined(__APPLE__)) && !defined(GEKKO) && !defined(__wiiu__)
+#include <sys/mman.h> // For mmap/mprotect
+#include <fcntl.h> // For shm_open
+#include <unistd.h> // For sysconf, ftruncate, lseek and close
+#define LUMA_HAS_VIRTUAL_MEMORY 1
+#else // Consoles like the Wii have no MMU-backed permissions, so plain heap memory is already executable
+#define LUMA_HAS_VIRTUAL_MEMORY 0
+#endif
+
+// Define this to 1 to make FixedSize emitters panic on buffer overflow instead of silently corrupting memory
+// AutoGrow emitters always check, as they need to know when to grow
+#ifndef LUMA_CHECK_OVERFLOW
+#define LUMA_CHECK_OVERFLOW 0
+#endif
+
+// Define this to 1 to make emitters count what they emit (see EmitterStats and PPCEmitter::getStats). Off by default, as it costs a few increments per instruction
+#ifndef LUMA_STATS
+#define LUMA_STATS 0
+#endif
+
+// Cache line size used when flushing freshly emitted code. 32 bytes on Gekko/Broadway/Espresso, override it for other cores
+#ifndef LUMA_CACHE_LINE_SIZE
+#define LUMA_CACHE_LINE_SIZE 32
+#endif
 
 namespace Luma {
 
@@ -81,6 +122,27 @@ enum SR {
     sr9, sr10, sr11, sr12, sr13, sr14, sr15
 };
 
+// Graphics quantization registers (Gekko/Broadway), used by the quantized paired single loads and stores
+enum GQR {
+    gqr0 = 0, gqr1, gqr2, gqr3, gqr4, gqr5, gqr6, gqr7 // gqr0 is usually left at 0 (plain floats)
+};
+
+// Data types a GQR can convert from/to
+enum class QuantType : uint32_t {
+    Float = 0, U8 = 4, U16 = 5, S8 = 6, S16 = 7
+};
+
+// Build a GQR value. Loads multiply by 2^-loadScale after converting, stores multiply by 2^storeScale before converting
+// Scales are 6-bit signed values (-32 to 31)
+constexpr uint32_t makeGQR (QuantType loadType, int loadScale, QuantType storeType, int storeScale) {
+    return (((uint32_t) loadScale & 0x3F) << 24) | ((uint32_t) loadType << 16) | (((uint32_t) storeScale & 0x3F) << 8) | (uint32_t) storeType;
+}
+
+// Ordering for the atomic pseudo-ops, modelled after std::memory_order
+enum class MemoryOrder {
+    Relaxed, Acquire, Release, AcqRel, SeqCst
+};
+
 enum class Cond {
     Lt = 0,
     Gt,
@@ -96,200 +158,405 @@ enum class BranchType {
     Branch14, Branch24
 };
 
-enum GrowingMode {
-    FixedSize,
-    AutoGrow
+// Static prediction for conditional branches. By default backward branches are predicted taken and forward ones not taken, so the
+// y bit that flips this is picked once the branch's direction is known. Gekko/Broadway only have the y bit, not the newer "at" hints
+enum class BranchHint {
+    None,
+    Likely,
+    Unlikely
 };
 
-template <GrowingMode growMode = FixedSize>
-class PPCEmitter {
-    uint32_t* code = nullptr; // Pointer to the code buffer
-    uint32_t* currentPointer = nullptr; // Pointer to the current address in the code buffer
-    uintptr_t reservedSize = 0; // The size reserved by the code buffer
-    uintptr_t autoGrowSize = 64 * 1024; // How much the code buffer will be grown if AutoGrow is on and it overflows (default = 64KB)
-
-    using BranchLabel = std::pair <uint32_t*, BranchType>;
-    
-    // Generic write function.
-    // Used to implement write8, write16, write32, write64 and subsequently, db, dh, dw, and dd
-    template <typename T>
-    constexpr void write (T val) {
-        if constexpr (growMode == AutoGrow) {
-            const auto currentSize = getCodeSize();
-
-            if (currentSize + sizeof(T) >= reservedSize) { // if buffer will overflow, automatically grow it by 64KB
-                const auto newSize = reservedSize + autoGrowSize; // The new reserved size for the code buffer
-                const auto newBuffer = new uint32_t [newSize / 4]; // The new buffer
-                std::memcpy (newBuffer, code, currentSize); // copy over the code into the new buffer
-                printf ("Code buffer exceeded max size (Using: %X bytes. Allocated: %X bytes)\nResizing to %X\n", currentSize + 4, reservedSize, newSize);
-                
-                delete code; // delete old code buffer
-                code = newBuffer; // set code to point to new buffer
-                currentPointer = (uint32_t*) ((uintptr_t) newBuffer + currentSize); // Restore currentPointer's relative position
-                reservedSize = newSize;
-            }
-        }
+// A branch waiting for its target. Stored as an offset into the code buffer, so it survives the buffer being moved by AutoGrow
+struct BranchLabel {
+    uint32_t offset; // Offset of the branch instruction from the start of the code buffer
+    BranchType type;
+    BranchHint hint = BranchHint::None;
+};
 
-        auto tmp = (T*) currentPointer;
-        *tmp++ = val;
-        currentPointer = (uint32_t*) tmp;
-    }
+// A position in the code buffer that stays valid when AutoGrow moves the buffer (unlike the pointers returned by getCurr())
+struct Anchor {
+    uint32_t offset;
+};
 
-    constexpr void write8 (uint8_t val) { write <uint8_t> (val); }
-    constexpr void write16 (uint16_t val) { write <uint16_t> (val); }
-    constexpr void write32 (uint32_t val) { write <uint32_t> (val); }
-    constexpr void write64 (uint64_t val) { write <uint64_t> (val); }
+// A symbolic branch target. Any number of branches can reference a label before it is bound with bind()
+// They all get patched in a single pass by resolveLabels(), which finalize() calls for you
+struct Label {
+    uint32_t id;
+};
 
-    template <typename T>
-    void write (T* array, int size) {
-        while (size--)
-            write <T> (*array++);
-    }
+// One case of a switch: jump to "target" when the value is "value"
+struct SwitchCase {
+    int32_t value;
+    Label target;
+};
 
-    constexpr BranchLabel emitBranch14 (uint32_t opcode) {
-        const auto cia = currentPointer;
-        write32 (opcode);
-        return std::make_pair (cia, BranchType::Branch14);
-    }
+// A symbol of a relocatable object (see writeObject). Either imported from another object, or exported from this buffer
+struct SymbolRef {
+    uint32_t id;
+};
 
-    static constexpr uint32_t signExtend32 (uint32_t value, uint32_t startingSize) {
-        auto bitsToShift = 32 - startingSize;
-        return (uint32_t) ((int32_t)value << bitsToShift >> bitsToShift);
-    }
+// Relocation types, numbered as in the ELF32 PowerPC ABI
+enum class RelocationType : uint8_t {
+    Addr32 = 1, // A whole word holding S + A
+    Addr16Lo = 4, // Low half of S + A, for the addi of lis/addi
+    Addr16Ha = 6, // High half of S + A, adjusted for the sign of the low half, for the lis of lis/addi
+    Rel24 = 10, // b/bl displacement to S + A
+    Rel14 = 11 // bc displacement to S + A
+};
 
-    [[noreturn]] static void panic(const char* fmt, ...) {
-        std::va_list args;
-        va_start(args, fmt);
-        std::vprintf (fmt, args);
-        va_end(args);
+struct Relocation {
+    static constexpr uint32_t absolute = UINT32_MAX; // No symbol: the addend is the target address itself
+    static constexpr uint32_t section = UINT32_MAX - 1; // The start of the buffer the relocation is in: the addend is an offset into it
 
-        while (1);
-    }
+    uint32_t offset; // Offset of the instruction (or data word) in the code buffer
+    RelocationType type;
+    uint32_t symbol; // ID of the symbol, or absolute
+    int64_t addend; // Wide enough for absolute addresses on 64-bit hosts. ELF32 objects keep the low 32 bits
+};
 
-    // Metaprogramming helpers for making a compile-time loop, used to implement the "repeat" directive
-    // Many thanks to https://github.com/fleroviux
-    template <typename T, T Begin,  class Func, T ...Is>
-    constexpr void static_for_impl( Func &&f, std::integer_sequence<T, Is...> ) {
-        ( f( std::integral_constant<T, Begin + Is>{ } ),... );
-    }
+struct ObjectSymbol {
+    std::string name;
+    uint32_t offset; // Offset in the code buffer, for exported symbols
+    uint32_t size;
+    bool defined; // False for imports, which the linker resolves
+};
 
-    template <typename T, T Begin, T End, class Func >
-    constexpr void static_for( Func &&f ) {
-        static_for_impl <T, Begin>( std::forward<Func>(f), std::make_integer_sequence<T, End - Begin>{ } );
-    }
+enum GrowingMode {
+    FixedSize,
+    AutoGrow
+};
 
-public:
-    PPCEmitter (uintptr_t bufferSize = 64 * 1024) { // Make an emitter object with "bufferSize" bytes of executable memory
-        reservedSize = bufferSize;
-        if (bufferSize == 0) // If bufferSize = 0 then skip allocating memory, because the user (hopefully) wants to allocate it themselves
-            return;
+// Byte order of the code in the buffer. NativeEndian code can be run right away, the other two let a host generate code for a machine
+// of the opposite byte order, eg big endian Wii/Wii U code on a little endian x86 or ARM build machine
+enum ByteOrder {
+    NativeEndian,
+    BigEndian,
+    LittleEndian
+};
 
-        if (bufferSize & 3)
-            panic ("[Emitter] Fatal: Buffer size is not word-aligned");
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+static constexpr ByteOrder hostByteOrder = BigEndian;
+#else
+static constexpr ByteOrder hostByteOrder = LittleEndian; // MSVC only targets little endian hosts
+#endif
+
+// Reverse the bytes of a value. Compilers turn these into a single bswap/rev, and into vector shuffles in loops
+static constexpr uint16_t byteswap (uint16_t value) {
+    return (uint16_t) ((value >> 8) | (value << 8));
+}
+
+static constexpr uint32_t byteswap (uint32_t value) {
+    return (value >> 24) | ((value >> 8) & 0xFF00) | ((value << 8) & 0xFF0000) | (value << 24);
+}
+
+static constexpr uint64_t byteswap (uint64_t value) {
+    return ((uint64_t) byteswap ((uint32_t) value) << 32) | byteswap ((uint32_t) (value >> 32));
+}
+
+[[noreturn]] static void panic(const char* fmt, ...) {
+    std::va_list args;
+    va_start(args, fmt);
+    std::vprintf (fmt, args);
+    va_end(args);
+
+    while (1);
+}
+
+// Make the code in [begin, end) visible to instruction fetch
+// "execOffset" is the distance from the written copy to the executed copy, for dual-mapped code
+// On PowerPC hosts all data cache stores are batched before a single sync, then all invalidates before a single isync
+static void flushICache (const void* begin, const void* end, intptr_t execOffset = 0, [[maybe_unused]] uintptr_t lineSize = LUMA_CACHE_LINE_SIZE) {
+    if (begin >= end)
+        return;
+
+#if defined(__powerpc__) || defined(__ppc__) || defined(__POWERPC__) || defined(GEKKO)
+    const auto first = (uintptr_t) begin & ~(lineSize - 1);
+    const auto last = (uintptr_t) end;
+
+    for (auto addr = first; addr < last; addr += lineSize) // Write the new code back from the data cache
+        asm volatile ("dcbst 0, %0" :: "r" (addr) : "memory");
+    asm volatile ("sync" ::: "memory");
+
+    for (auto addr = first; addr < last; addr += lineSize) // Throw away stale lines from the instruction cache
+        asm volatile ("icbi 0, %0" :: "r" (addr + execOffset) : "memory");
+    asm volatile ("sync\n\tisync" ::: "memory");
+#elif defined(_WIN32)
+    FlushInstructionCache (GetCurrentProcess(), (const void*) ((uintptr_t) begin + execOffset), (uintptr_t) end - (uintptr_t) begin);
+#elif defined(__GNUC__) || defined(__clang__)
+    __builtin___clear_cache ((char*) ((uintptr_t) begin + execOffset), (char*) ((uintptr_t) end + execOffset));
+#endif
+}
+
+// How a CodeArena keeps its memory W^X
+enum class ArenaMode {
+    ToggleProtection, // A single RW mapping that gets flipped to RX when an emitter finalizes its code
+    DualView          // Two views of the same pages, one RW and one RX. Finalizing never needs a syscall
+};
 
-        code = new uint32_t [bufferSize / 4]; // TODO: This works on Wii but not on platforms where executable perms matter!!
-        currentPointer = code;
-        
-        if (!code)
-            panic ("[Emitter] Fatal: Failed to allocate memory\n");
-    }
+// One big executable memory reservation that many emitters carve their code buffers out of
+// Keeping all blocks in one region saves a mapping per block and keeps them within range of a direct bx (+-32MB)
+class CodeArena {
+    uint8_t* writeBase = nullptr; // Base of the RW view
+    uint8_t* execBase = nullptr; // Base of the RX view (Same as writeBase, unless we're using a DualView arena)
+    uintptr_t capacity = 0; // Size of the reservation in bytes
+    std::atomic <uintptr_t> used { 0 }; // Bump pointer, as an offset from the base of the reservation. Atomic, so threads can allocate concurrently
+    uintptr_t pageSize = 4096;
+    uintptr_t granularity = 32; // Allocations are rounded up to this. Page size when toggling protection, a cache line otherwise
+    ArenaMode mode;
+
+#ifdef _WIN32
+    HANDLE mapping = nullptr; // File mapping backing both views of a DualView arena
+#endif
+
+    static uintptr_t alignUp (uintptr_t value, uintptr_t alignment) {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+
+    void mapMemory() {
+#if defined(_WIN32)
+        SYSTEM_INFO info;
+        GetSystemInfo (&info);
+        pageSize = info.dwAllocationGranularity;
+        capacity = alignUp (capacity, pageSize);
+
+        if (mode == ArenaMode::DualView) {
+            mapping = CreateFileMappingW (INVALID_HANDLE_VALUE, nullptr, PAGE_EXECUTE_READWRITE, (DWORD) ((uint64_t) capacity >> 32), (DWORD) capacity, nullptr);
+            if (!mapping)
+                panic ("[Arena] Fatal: Failed to create file mapping\n");
+
+            writeBase = (uint8_t*) MapViewOfFile (mapping, FILE_MAP_WRITE, 0, 0, capacity);
+            execBase = (uint8_t*) MapViewOfFile (mapping, FILE_MAP_READ | FILE_MAP_EXECUTE, 0, 0, capacity);
+        } else {
+            writeBase = (uint8_t*) VirtualAlloc (nullptr, capacity, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+            execBase = writeBase;
+        }
+#elif LUMA_HAS_VIRTUAL_MEMORY
+        pageSize = (uintptr_t) sysconf (_SC_PAGESIZE);
+        capacity = alignUp (capacity, pageSize);
+
+        if (mode == ArenaMode::DualView) {
+#if defined(__linux__)
+            const int fd = memfd_create ("luma-code-arena", 0);
+#else
+            char name[64];
+            std::snprintf (name, sizeof(name), "/luma-code-arena-%ld-%p", (long) getpid(), (void*) this);
+            const int fd = shm_open (name, O_RDWR | O_CREAT | O_EXCL, 0600);
+            shm_unlink (name); // We only need the descriptor, let the name disappear immediately
+#endif
+            if (fd < 0 || ftruncate (fd, capacity) != 0)
+                panic ("[Arena] Fatal: Failed to create shared memory for dual-mapped arena\n");
+
+            void* rw = mmap (nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            void* rx = mmap (nullptr, capacity, PROT_READ | PROT_EXEC, MAP_SHARED, fd, 0);
+            close (fd); // The mappings keep the memory alive
+
+            writeBase = rw == MAP_FAILED ? nullptr : (uint8_t*) rw;
+            execBase = rx == MAP_FAILED ? nullptr : (uint8_t*) rx;
+        } else {
+            void* mem = mmap (nullptr, capacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            writeBase = mem == MAP_FAILED ? nullptr : (uint8_t*) mem;
+            execBase = writeBase;
+        }
+#else
+        writeBase = (uint8_t*) new uint32_t [alignUp (capacity, 4) / 4];
+        execBase = writeBase;
+#endif
 
-    uint32_t* getBuffer() { 
-        return code; 
+        if (!writeBase || !execBase)
+            panic ("[Arena] Fatal: Failed to map %zu bytes of code memory\n", (size_t) capacity);
     }
 
-    void setBuffer (uint32_t* pointer, uintptr_t bufferSize) { // Note: This completely wrecks the JIT cache and should only be used before actually emitting code
-        code = pointer;
-        currentPointer = pointer;
-        reservedSize = bufferSize;
+    void protect (void* start, uintptr_t size, bool executable) {
+        if (mode == ArenaMode::DualView || size == 0) // Nothing to do: The RX view is always executable and the RW view always writeable
+            return;
 
-        if (bufferSize & 3)
-            panic ("[Emitter] Fatal: Buffer size is not word-aligned");
+#if LUMA_HAS_VIRTUAL_MEMORY
+        const auto first = (uintptr_t) start & ~(pageSize - 1); // Protection works on whole pages
+        const auto last = alignUp ((uintptr_t) start + size, pageSize);
+#if defined(_WIN32)
+        DWORD oldProtection;
+        if (!VirtualProtect ((void*) first, last - first, executable ? PAGE_EXECUTE_READ : PAGE_READWRITE, &oldProtection))
+#else
+        if (mprotect ((void*) first, last - first, executable ? (PROT_READ | PROT_EXEC) : (PROT_READ | PROT_WRITE)) != 0)
+#endif
+            panic ("[Arena] Fatal: Failed to change memory protection\n");
+#endif
     }
 
-    constexpr uint32_t* getCurr() { 
-        return currentPointer; 
+public:
+    CodeArena (uintptr_t size = 32 * 1024 * 1024, ArenaMode arenaMode = ArenaMode::ToggleProtection) : capacity (size), mode (arenaMode) {
+        if (size == 0)
+            panic ("[Arena] Fatal: Tried to create an empty code arena\n");
+
+        mapMemory();
+        if (mode == ArenaMode::ToggleProtection && LUMA_HAS_VIRTUAL_MEMORY) // Every emitter needs its own pages, otherwise finalizing one would lock out the others
+            granularity = pageSize;
+    }
+
+    ~CodeArena() {
+#if defined(_WIN32)
+        if (mode == ArenaMode::DualView) {
+            UnmapViewOfFile (writeBase);
+            UnmapViewOfFile (execBase);
+            CloseHandle (mapping);
+        } else
+            VirtualFree (writeBase, 0, MEM_RELEASE);
+#elif LUMA_HAS_VIRTUAL_MEMORY
+        munmap (writeBase, capacity);
+        if (execBase != writeBase)
+            munmap (execBase, capacity);
+#else
+        delete[] (uint32_t*) writeBase;
+#endif
+    }
+
+    CodeArena (const CodeArena&) = delete;
+    CodeArena& operator= (const CodeArena&) = delete;
+
+    // Carve out "size" bytes of writeable code memory. Returns a pointer into the RW view, or nullptr if the arena is full
+    // Safe to call from several threads at once
+    uint32_t* allocate (uintptr_t size) {
+        const auto bytes = alignUp (size, granularity);
+        auto offset = used.load (std::memory_order_relaxed);
+
+        do {
+            if (bytes > capacity - offset)
+                return nullptr;
+        } while (!used.compare_exchange_weak (offset, offset + bytes, std::memory_order_relaxed));
+
+        return (uint32_t*) (writeBase + offset);
+    }
+
+    // Make a range of emitted code executable. With DualView arenas this is free
+    void makeExecutable (void* start, uintptr_t size) { protect (start, size, true); }
+    // Make a range of code writeable again, for patching or re-emitting
+    void makeWritable (void* start, uintptr_t size) { protect (start, size, false); }
+
+    // Translate a pointer from the RW view to the address the code will actually run at
+    template <typename T>
+    T* toExecutable (T* pointer) {
+        return (T*) ((uintptr_t) pointer + getExecOffset());
     }
 
-    uintptr_t getCodeSize() {
-        return (uintptr_t) currentPointer - (uintptr_t) code;
-    }
+    // Distance between the RX and RW views (0 unless this is a DualView arena)
+    intptr_t getExecOffset() { return (intptr_t) execBase - (intptr_t) writeBase; }
+    bool contains (const void* pointer) { return (uintptr_t) pointer - (uintptr_t) writeBase < capacity; }
 
-    // Sets how much the buffer will be grown if autogrow is on and the buffer overflows
-    void setAutoGrowSize (uintptr_t size) {
-        autoGrowSize = size;
-    
-        if (size & 3)
-            panic ("[Emitter] Fatal: AutoGrow size is not word-aligned");
+    uint8_t* getBase() { return writeBase; }
+    uintptr_t getCapacity() { return capacity; }
+    uintptr_t getUsed() { return used.load (std::memory_order_relaxed); }
+    uintptr_t getPageSize() { return pageSize; }
+    ArenaMode getMode() { return mode; }
+};
+
+// Encode an unconditional branch at "cia" (an executable address) to "target", relative if possible and absolute otherwise
+// Returns 0 if the target can't be reached with a single branch
+static uint32_t encodeBranch24 (uintptr_t cia, uintptr_t target, bool link = false) {
+    constexpr intptr_t INT26_MIN = -0x2000000;
+    constexpr intptr_t INT26_MAX = 0x1FFFFFF;
+    const intptr_t disp = (intptr_t) target - (intptr_t) cia;
+
+    if (target & 3)
+        return 0;
+    else if (disp >= INT26_MIN && disp <= INT26_MAX)
+        return 0x48000000 | (disp & 0x3FFFFFC) | link;
+    else if ((intptr_t) target >= INT26_MIN && (intptr_t) target <= INT26_MAX)
+        return 0x48000000 | (target & 0x3FFFFFC) | 2 | link;
+    else
+        return 0;
+}
+
+// Patch a relocated field at "pc" (an executable address) to point to "value"
+static bool applyRelocation (uint32_t* word, uintptr_t pc, uintptr_t value, RelocationType type) {
+    const intptr_t disp = (intptr_t) value - (intptr_t) pc;
+    switch (type) {
+        case RelocationType::Addr32: *word = (uint32_t) value; return true;
+        case RelocationType::Addr16Lo: *word = (*word & 0xFFFF0000) | (value & 0xFFFF); return true;
+        case RelocationType::Addr16Ha: *word = (*word & 0xFFFF0000) | (((value + 0x8000) >> 16) & 0xFFFF); return true;
+        case RelocationType::Rel24: {
+            const auto branch = encodeBranch24 (pc, value, *word & 1);
+            *word = branch;
+            return branch != 0;
+        }
+        case RelocationType::Rel14:
+            if (disp > INT16_MAX || disp < INT16_MIN || (disp & 3))
+                return false;
+            *word = (*word & ~0xFFFC) | (disp & 0xFFFC); // Keep AA and LK
+            return true;
     }
 
-    constexpr void db   (uint8_t val)  { write8 (val); } // Data byte
-    constexpr void dh   (uint16_t val) { write16 (val); } // Data halfword
-    constexpr void dw   (uint32_t val) { write32 (val); } // Data word
-    constexpr void dd   (uint64_t val) { write64 (val); } // Data doubleword
-    constexpr void df32 (float val )   { write <float> (val); } // Data float 32 (Single)
-    constexpr void df64 (double val)   { write <double> (val); } // Data float 64 (Double)
+    return false;
+}
 
-    constexpr void db   (uint8_t* arr, int size)  { write <uint8_t> (arr, size); } //  Data byte array
-    constexpr void dh   (uint16_t* arr, int size) { write <uint16_t> (arr, size); } //  Data halfword array
-    constexpr void dw   (uint32_t* arr, int size) { write <uint32_t> (arr, size); } //  Data word array
-    constexpr void dd   (uint64_t* arr, int size) { write <uint64_t> (arr, size); } //  Data doubleword array
-    constexpr void df32 (float* arr, int size)    { write <float> (arr, size); } //  Data float array
-    constexpr void df64 (double* arr, int size)   { write <double> (arr, size); } //  Data double array
+// A patchable block exit, for chaining JIT blocks together
+// It starts out jumping to the dispatcher. link() rewrites it into a direct branch to another block, unlink() restores the dispatcher jump
+class ExitStub {
+    uint32_t* location = nullptr; // The first word of the exit, in the writeable view of the code
+    intptr_t execOffset = 0; // Distance from the writeable view to the executable one
+    uint32_t original = 0; // The first word of the dispatcher jump
+    CodeArena* arena = nullptr; // Needed to unprotect the code while patching, if it came from a ToggleProtection arena
+    void* linkedTo = nullptr;
 
-    constexpr void ds (const char* str) { // Data string (null-terminated)
-        while (*str != '\0') {// copy characters until null terminator
-            db (*str++);
-        }
+    void patch (uint32_t word) {
+        if (arena)
+            arena -> makeWritable (location, 4);
 
-        db ('\0'); // copy null terminator
-    }
+        *location = word;
+        if (arena)
+            arena -> makeExecutable (location, 4);
 
-    void ds (std::string str) {
-        ds (str.c_str());
+        flushICache (location, location + 1, execOffset); // Only the line containing the exit changed
     }
 
-    void align (int bytes) {
-        if (bytes == 1) 
-            return;
-        
-        else if (bytes < 1)
-            panic ("[Emitter] Fatal: Tried to align to a %d byte boundary", bytes);
+public:
+    ExitStub() = default;
+    ExitStub (uint32_t* where, intptr_t offset, CodeArena* codeArena) : location (where), execOffset (offset), original (*where), arena (codeArena) {}
 
-        auto remainder = (uintptr_t) getCurr() % bytes;
-        while (remainder--) 
-            write8 (0);
-    }
+    // Make the exit jump straight to "target" (an executable address). Returns false if the target is out of range of a direct branch
+    bool link (void* target) {
+        const auto word = encodeBranch24 ((uintptr_t) location + execOffset, (uintptr_t) target);
+        if (word == 0)
+            return false;
 
-    template <size_t end, class Func>
-    constexpr void repeat (Func&& f) {
-        static_for_impl <size_t, 0>( std::forward<Func>(f), std::make_integer_sequence<size_t, end>{ } );
+        patch (word);
+        linkedTo = target;
+        return true;
     }
 
-    template <class Func>
-    constexpr void loop (GPR counter, size_t iterations, Func&& f) {
-        if (iterations == 0) return;         // Do nothing if 0 iterations
+    // Go back to jumping to the dispatcher, eg when the block we were linked to gets invalidated
+    void unlink() {
+        if (!linkedTo)
+            return;
 
-        liw (counter, iterations);           // load iterations into counter register
-        const auto label = getCurr();        // Label for loop
-        f();
-        addic <true> (counter, counter, -1); // Decrement counter (need addic. because addi doesn't affect CR)
-        const auto slot = bne();             // Loop if not 0
-        setLabel (slot, label);
+        patch (original);
+        linkedTo = nullptr;
     }
 
-    constexpr void ud() { write32 (0); } // Undefined opcode (use for debugging)
-    void nop() { ori (r0, r0, 0); } // No operation
+    bool isLinked() { return linkedTo != nullptr; }
+    void* getTarget() { return linkedTo; }
+    uint32_t* getLocation() { return location; }
+};
+
+// Instruction encoders, shared by the emitter and by compile-time encoding
+// Every encoder hands its word to Derived::emitInstruction, which writes it to a buffer in PPCEmitter, or simply returns it in Encoder
+template <typename Derived>
+class InstructionSet {
+protected:
+    constexpr auto emit (uint32_t instruction) { return static_cast <Derived*> (this)->emitInstruction (instruction); }
+
+public:
+    constexpr auto ud() { return emit (0); } // Undefined opcode (use for debugging)
+    constexpr auto nop() { return ori (r0, r0, 0); } // No operation
 
-    void blr() { write32 (0x4E800020); } // Branch to link register
-    void bctr() { write32 (0x4E800420); } // Branch to counter register
-    void bctrl() { write32 (0x4E800421); } // Branch to counter register and link
+    constexpr auto blr() { return emit (0x4E800020); } // Branch to link register
+    constexpr auto bctr() { return emit (0x4E800420); } // Branch to counter register
+    constexpr auto bctrl() { return emit (0x4E800421); } // Branch to counter register and link
 
-    void li (GPR reg, int16_t imm) { // Load immediate (signed)
-        addi (reg, r0, imm);
+    constexpr auto li (GPR reg, int16_t imm) { // Load immediate (signed)
+        return addi (reg, r0, imm);
     }
 
-    void liu (GPR reg, uint16_t imm) { // Load immediate (unsigned)
+    constexpr void liu (GPR reg, uint16_t imm) { // Load immediate (unsigned)
         if (imm < 0x8000) // For immediates < 0x8000, we can use a single addi
             li (reg, imm);
         else {
@@ -298,286 +565,290 @@ public:
         }
     }
 
-    void setz (GPR dest, GPR src) { // Set dest to 1 if src is 0, otherwise set dest to 0
+    constexpr void setz (GPR dest, GPR src) { // Set dest to 1 if src is 0, otherwise set dest to 0
         cntlzw (dest, src); // cntlzw returns 0-31 normally, but it returns 32 for 0. This means we can use bit 5 to check whether or not src is 0
         srwi (dest, dest, 5); // Shift bit 5 to LSB
     }
 
-    void lis (GPR reg, uint16_t imm) {
-        addis (reg, r0, imm);
+    constexpr auto lis (GPR reg, uint16_t imm) {
+        return addis (reg, r0, imm);
     }
 
     template <bool setFlags = false>
-    void nand (GPR dest, GPR src1, GPR src2) {
-        write32 (0x7C0003B8 | (src1 << 21) | (dest << 16) | (src2 << 11) | setFlags);
+    constexpr auto nand (GPR dest, GPR src1, GPR src2) {
+        return emit (0x7C0003B8 | (src1 << 21) | (dest << 16) | (src2 << 11) | setFlags);
     }
 
     template <bool setFlags = false>
-    void and_ (GPR dest, GPR src1, GPR src2) {
-        write32 (0x7C000038 | (src1 << 21) | (dest << 16) | (src2 << 11) | setFlags);
+    constexpr auto and_ (GPR dest, GPR src1, GPR src2) {
+        return emit (0x7C000038 | (src1 << 21) | (dest << 16) | (src2 << 11) | setFlags);
     }
 
     template <bool setFlags = false>
-    void andc (GPR dest, GPR src1, GPR src2) {
-        write32 (0x7C000078 | (src1 << 21) | (dest << 16) | (src2 << 11) | setFlags);
+    constexpr auto andc (GPR dest, GPR src1, GPR src2) {
+        return emit (0x7C000078 | (src1 << 21) | (dest << 16) | (src2 << 11) | setFlags);
     }
 
-    void andi (GPR dest, GPR src, uint16_t imm) {
-        write32 (0x70000000 | (src << 21) | (dest << 16) | imm);
+    constexpr auto andi (GPR dest, GPR src, uint16_t imm) {
+        return emit (0x70000000 | (src << 21) | (dest << 16) | imm);
     }
 
-    void andis (GPR dest, GPR src, uint16_t imm) {
-        write32 (0x74000000 | (src << 21) | (dest << 16) | imm);
+    constexpr auto andis (GPR dest, GPR src, uint16_t imm) {
+        return emit (0x74000000 | (src << 21) | (dest << 16) | imm);
     }
 
     template <bool setFlags = false>
-    void nor (GPR dest, GPR src1, GPR src2) {
-        write32 (0x7C0000F8 | (src1 << 21) | (dest << 16) | (src2 << 11) | setFlags);
+    constexpr auto nor (GPR dest, GPR src1, GPR src2) {
+        return emit (0x7C0000F8 | (src1 << 21) | (dest << 16) | (src2 << 11) | setFlags);
     }
 
     template <bool setFlags = false>
-    void or_ (GPR dest, GPR src1, GPR src2) {
-        write32 (0x7C000378 | (src1 << 21) | (dest << 16) | (src2 << 11) | setFlags);
+    constexpr auto or_ (GPR dest, GPR src1, GPR src2) {
+        return emit (0x7C000378 | (src1 << 21) | (dest << 16) | (src2 << 11) | setFlags);
     }
 
     template <bool setFlags = false>
-    void orc (GPR dest, GPR src1, GPR src2) {
-        write32 (0x7C000338 | (src1 << 21) | (dest << 16) | (src2 << 11) | setFlags);
+    constexpr auto orc (GPR dest, GPR src1, GPR src2) {
+        return emit (0x7C000338 | (src1 << 21) | (dest << 16) | (src2 << 11) | setFlags);
     }
 
-    void ori (GPR dest, GPR src, uint16_t imm) {
-        write32 (0x60000000 | (src << 21) | (dest << 16) | imm);
+    constexpr auto ori (GPR dest, GPR src, uint16_t imm) {
+        return emit (0x60000000 | (src << 21) | (dest << 16) | imm);
     }
 
-    void oris (GPR dest, GPR src, uint16_t imm) {
-        write32 (0x64000000 | (src << 21) | (dest << 16) | imm);
+    constexpr auto oris (GPR dest, GPR src, uint16_t imm) {
+        return emit (0x64000000 | (src << 21) | (dest << 16) | imm);
     }
 
     template <bool setFlags = false>
-    void xor_ (GPR dest, GPR src1, GPR src2) {
-        write32 (0x7C000278 | (src1 << 21) | (dest << 16) | (src2 << 11) | setFlags);
+    constexpr auto xor_ (GPR dest, GPR src1, GPR src2) {
+        return emit (0x7C000278 | (src1 << 21) | (dest << 16) | (src2 << 11) | setFlags);
     }
 
-    void xori (GPR dest, GPR src, uint16_t imm) {
-        write32 (0x68000000 | (src << 21) | (dest << 16) | imm);
+    constexpr auto xori (GPR dest, GPR src, uint16_t imm) {
+        return emit (0x68000000 | (src << 21) | (dest << 16) | imm);
     }
 
-    void xoris (GPR dest, GPR src, uint16_t imm) {
-        write32 (0x6C000000 | (src << 21) | (dest << 16) | imm);
+    constexpr auto xoris (GPR dest, GPR src, uint16_t imm) {
+        return emit (0x6C000000 | (src << 21) | (dest << 16) | imm);
     }
 
     template <bool setFlags = false>
-    void add (GPR dest, GPR src1, GPR src2) {
-        write32 (0x7C000214 | (dest << 21) | (src1 << 16) | (src2 << 11) | setFlags);
+    constexpr auto add (GPR dest, GPR src1, GPR src2) {
+        return emit (0x7C000214 | (dest << 21) | (src1 << 16) | (src2 << 11) | setFlags);
     }
 
     template <bool setFlags = false>
-    void addo (GPR dest, GPR src1, GPR src2) {
-        write32 (0x7C000614 | (dest << 21) | (src1 << 16) | (src2 << 11) | setFlags);
+    constexpr auto addo (GPR dest, GPR src1, GPR src2) {
+        return emit (0x7C000614 | (dest << 21) | (src1 << 16) | (src2 << 11) | setFlags);
     }
 
     template <bool setFlags = false>
-    void addc (GPR dest, GPR src1, GPR src2) {
-        write32 (0x7C000014 | (dest << 21) | (src1 << 16) | (src2 << 11) | setFlags);
+    constexpr auto addc (GPR dest, GPR src1, GPR src2) {
+        return emit (0x7C000014 | (dest << 21) | (src1 << 16) | (src2 << 11) | setFlags);
     }
 
     template <bool setFlags = false>
-    void addco (GPR dest, GPR src1, GPR src2) {
-        write32 (0x7C000414 | (dest << 21) | (src1 << 16) | (src2 << 11) | setFlags);
+    constexpr auto addco (GPR dest, GPR src1, GPR src2) {
+        return emit (0x7C000414 | (dest << 21) | (src1 << 16) | (src2 << 11) | setFlags);
     }
 
     template <bool setFlags = false>
-    void adde (GPR dest, GPR src1, GPR src2) {
-        write32 (0x7C000114 | (dest << 21) | (src1 << 16) | (src2 << 11) | setFlags);
+    constexpr auto adde (GPR dest, GPR src1, GPR src2) {
+        return emit (0x7C000114 | (dest << 21) | (src1 << 16) | (src2 << 11) | setFlags);
     }
 
     template <bool setFlags = false>
-    void addeo (GPR dest, GPR src1, GPR src2) {
-        write32 (0x7C000514 | (dest << 21) | (src1 << 16) | (src2 << 11) | setFlags);
+    constexpr auto addeo (GPR dest, GPR src1, GPR src2) {
+        return emit (0x7C000514 | (dest << 21) | (src1 << 16) | (src2 << 11) | setFlags);
     }
 
     template <bool setFlags = false>
-    void addze (GPR dest, GPR src) {
-        write32 (0x7C000194 | (dest << 21) | (src << 16) | setFlags);
+    constexpr auto addze (GPR dest, GPR src) {
+        return emit (0x7C000194 | (dest << 21) | (src << 16) | setFlags);
     }
 
     template <bool setFlags = false>
-    void addzeo (GPR dest, GPR src) {
-        write32 (0x7C000594 | (dest << 21) | (src << 16) | setFlags);
+    constexpr auto addzeo (GPR dest, GPR src) {
+        return emit (0x7C000594 | (dest << 21) | (src << 16) | setFlags);
     }
 
-    void addi (GPR dest, GPR src, int16_t imm) {
-        write32 (0x38000000 | (dest << 21) | (src << 16) | (uint16_t) imm);
+    constexpr auto addi (GPR dest, GPR src, int16_t imm) {
+        return emit (0x38000000 | (dest << 21) | (src << 16) | (uint16_t) imm);
     }
 
-    void addis (GPR dest, GPR src, int16_t imm) {
-        write32 (0x3C000000 | (dest << 21) | (src << 16) | (uint16_t) imm);
+    constexpr auto addis (GPR dest, GPR src, int16_t imm) {
+        return emit (0x3C000000 | (dest << 21) | (src << 16) | (uint16_t) imm);
     }
 
     template <bool setFlags = false>
-    void addic (GPR dest, GPR src, int16_t imm) {
+    constexpr auto addic (GPR dest, GPR src, int16_t imm) {
         if (!setFlags) // addic
-            write32 (0x30000000 | (dest << 21) | (src << 16) | (uint16_t) imm);
+            return emit (0x30000000 | (dest << 21) | (src << 16) | (uint16_t) imm);
         else // addic.
-            write32 (0x34000000 | (dest << 21) | (src << 16) | (uint16_t) imm);
+            return emit (0x34000000 | (dest << 21) | (src << 16) | (uint16_t) imm);
     }
 
     template <bool setFlags = false>
-    void addme (GPR dest, GPR src) {
-        write32 (0x7C0001D4 | (dest << 21) | (src << 16) | setFlags);
+    constexpr auto addme (GPR dest, GPR src) {
+        return emit (0x7C0001D4 | (dest << 21) | (src << 16) | setFlags);
     }
 
     template <bool setFlags = false>
-    void addmeo (GPR dest, GPR src) {
-        write32 (0x7C0005D4 | (dest << 21) | (src << 16) | setFlags);
+    constexpr auto addmeo (GPR dest, GPR src) {
+        return emit (0x7C0005D4 | (dest << 21) | (src << 16) | setFlags);
     }
 
     template <bool setFlags = false>
-    void subf (GPR dest, GPR src1, GPR src2) {
-        write32 (0x7C000050 | (dest << 21) | (src1 << 16) | (src2 << 11) | setFlags);
+    constexpr auto subf (GPR dest, GPR src1, GPR src2) {
+        return emit (0x7C000050 | (dest << 21) | (src1 << 16) | (src2 << 11) | setFlags);
     }
 
     template <bool setFlags = false>
-    void sub (GPR dest, GPR src1, GPR src2) { // subf except without reversed operands
-        subf <setFlags> (dest, src2, src1);
+    constexpr auto sub (GPR dest, GPR src1, GPR src2) { // subf except without reversed operands
+        return subf <setFlags> (dest, src2, src1);
     }
 
     template <bool setFlags = false>
-    void subfo (GPR dest, GPR src1, GPR src2) {
-        write32 (0x7C000450 | (dest << 21) | (src1 << 16) | (src2 << 11) | setFlags);
+    constexpr auto subfo (GPR dest, GPR src1, GPR src2) {
+        return emit (0x7C000450 | (dest << 21) | (src1 << 16) | (src2 << 11) | setFlags);
     }
 
     template <bool setFlags = false>
-    void subo (GPR dest, GPR src1, GPR src2) { // subfo except without reversed operands
-        subfo <setFlags> (dest, src2, src1);
+    constexpr auto subo (GPR dest, GPR src1, GPR src2) { // subfo except without reversed operands
+        return subfo <setFlags> (dest, src2, src1);
     }
 
     template <bool setFlags = false>
-    void subfc (GPR dest, GPR src1, GPR src2) {
-        write32 (0x7C000010 | (dest << 21) | (src1 << 16) | (src2 << 11) | setFlags);
+    constexpr auto subfc (GPR dest, GPR src1, GPR src2) {
+        return emit (0x7C000010 | (dest << 21) | (src1 << 16) | (src2 << 11) | setFlags);
     }
 
     template <bool setFlags = false>
-    void subc (GPR dest, GPR src1, GPR src2) { // subfc without reversed operands
-        subfc <setFlags> (dest, src2, src1);
+    constexpr auto subc (GPR dest, GPR src1, GPR src2) { // subfc without reversed operands
+        return subfc <setFlags> (dest, src2, src1);
     }
 
     template <bool setFlags = false>
-    void subfco (GPR dest, GPR src1, GPR src2) {
-        write32 (0x7C000410 | (dest << 21) | (src1 << 16) | (src2 << 11) | setFlags);
+    constexpr auto subfco (GPR dest, GPR src1, GPR src2) {
+        return emit (0x7C000410 | (dest << 21) | (src1 << 16) | (src2 << 11) | setFlags);
     }
 
     template <bool setFlags = false>
-    void subco (GPR dest, GPR src1, GPR src2) { // subco without reversed operands
-        subfco <setFlags> (dest, src2, src1);
+    constexpr auto subco (GPR dest, GPR src1, GPR src2) { // subco without reversed operands
+        return subfco <setFlags> (dest, src2, src1);
     }
 
     template <bool setFlags = false>
-    void subfe (GPR dest, GPR src1, GPR src2) {
-        write32 (0x7C000110 | (dest << 21) | (src1 << 16) | (src2 << 11) | setFlags);
+    constexpr auto subfe (GPR dest, GPR src1, GPR src2) {
+        return emit (0x7C000110 | (dest << 21) | (src1 << 16) | (src2 << 11) | setFlags);
     }
 
     template <bool setFlags = false>
-    void sube (GPR dest, GPR src1, GPR src2) { // subfe without reversed operands
-        subfe <setFlags> (dest, src2, src1);
+    constexpr auto sube (GPR dest, GPR src1, GPR src2) { // subfe without reversed operands
+        return subfe <setFlags> (dest, src2, src1);
     }
 
     template <bool setFlags = false>
-    void subfeo (GPR dest, GPR src1, GPR src2) {
-        write32 (0x7C000510 | (dest << 21) | (src1 << 16) | (src2 << 11) | setFlags);
+    constexpr auto subfeo (GPR dest, GPR src1, GPR src2) {
+        return emit (0x7C000510 | (dest << 21) | (src1 << 16) | (src2 << 11) | setFlags);
     }
 
     template <bool setFlags = false>
-    void subeo (GPR dest, GPR src1, GPR src2) { // subfeo without reversed operands
-        subfeo <setFlags> (dest, src2, src1);
+    constexpr auto subeo (GPR dest, GPR src1, GPR src2) { // subfeo without reversed operands
+        return subfeo <setFlags> (dest, src2, src1);
     }
 
-    void subfic (GPR dest, GPR src, int16_t imm) {
-        write32 (0x20000000 | (dest << 21) | (src << 16) | (uint16_t) imm);
+    constexpr auto subfic (GPR dest, GPR src, int16_t imm) {
+        return emit (0x20000000 | (dest << 21) | (src << 16) | (uint16_t) imm);
     }
 
     template <bool setFlags = false>
-    void subfme (GPR dest, GPR src) {
-        write32 (0x7C0001D0 | (dest << 21) | (src << 16) | setFlags);   
+    constexpr auto subfme (GPR dest, GPR src) {
+        return emit (0x7C0001D0 | (dest << 21) | (src << 16) | setFlags);   
     }
 
     template <bool setFlags = false>
-    void subfmeo (GPR dest, GPR src) {
-        write32 (0x7C0005D0 | (dest << 21) | (src << 16) | setFlags);   
+    constexpr auto subfmeo (GPR dest, GPR src) {
+        return emit (0x7C0005D0 | (dest << 21) | (src << 16) | setFlags);   
     }
 
     template <bool setFlags = false>
-    void subfze (GPR dest, GPR src) {
-        write32 (0x7C000190 | (dest << 21) | (src << 16) | setFlags);   
+    constexpr auto subfze (GPR dest, GPR src) {
+        return emit (0x7C000190 | (dest << 21) | (src << 16) | setFlags);   
     }
 
     template <bool setFlags = false>
-    void subfzeo (GPR dest, GPR src) {
-        write32 (0x7C000590 | (dest << 21) | (src << 16) | setFlags);   
+    constexpr auto subfzeo (GPR dest, GPR src) {
+        return emit (0x7C000590 | (dest << 21) | (src << 16) | setFlags);   
     }
     
-    void cmpli (CR dest, GPR src, uint16_t imm) {
-        write32 (0x28000000 | (dest << 23) | (src << 16) | imm);
+    constexpr auto cmpli (CR dest, GPR src, uint16_t imm) {
+        return emit (0x28000000 | (dest << 23) | (src << 16) | imm);
+    }
+
+    constexpr auto cmpi (CR dest, GPR src, int16_t imm) {
+        return emit (0x2C000000 | (dest << 23) | (src << 16) | (uint16_t) imm);
     }
 
-    void cmpi (CR dest, GPR src, int16_t imm) {
-        write32 (0x2C000000 | (dest << 23) | (src << 16) | (uint16_t) imm);
+    constexpr auto cmpl (CR dest, GPR src1, GPR src2) {
+        return emit (0x7C000040 | (dest << 23) | (src1 << 16) | (src2 << 11));
     }
 
-    void cmpl (CR dest, GPR src1, GPR src2) {
-        write32 (0x7C000040 | (dest << 23) | (src1 << 16) | (src2 << 11));
+    constexpr auto cmp (CR dest, GPR src1, GPR src2) {
+        return emit (0x7C000000 | (dest << 23) | (src1 << 16) | (src2 << 11));
     }
     
-    void mulli (GPR dest, GPR src, int16_t imm) {
-        write32 (0x1C000000 | (dest << 21) | (src << 16) | (uint16_t) imm);
+    constexpr auto mulli (GPR dest, GPR src, int16_t imm) {
+        return emit (0x1C000000 | (dest << 21) | (src << 16) | (uint16_t) imm);
     }
 
     template <bool setFlags = false>
-    void mullw (GPR dest, GPR src1, GPR src2) {
-        write32 (0x7C0001D6 | (dest << 21) | (src1 << 16) | (src2 << 11) | setFlags);
+    constexpr auto mullw (GPR dest, GPR src1, GPR src2) {
+        return emit (0x7C0001D6 | (dest << 21) | (src1 << 16) | (src2 << 11) | setFlags);
     }
 
     template <bool setFlags = false>
-    void mullwo (GPR dest, GPR src1, GPR src2) {
-        write32 (0x7C0005D6 | (dest << 21) | (src1 << 16) | (src2 << 11) | setFlags);
+    constexpr auto mullwo (GPR dest, GPR src1, GPR src2) {
+        return emit (0x7C0005D6 | (dest << 21) | (src1 << 16) | (src2 << 11) | setFlags);
     }
 
     template <bool setFlags = false>
-    void mulhw (GPR dest, GPR src1, GPR src2) {
-        write32 (0x7C000096 | (dest << 21) | (src1 << 16) | (src2 << 11) | setFlags);
+    constexpr auto mulhw (GPR dest, GPR src1, GPR src2) {
+        return emit (0x7C000096 | (dest << 21) | (src1 << 16) | (src2 << 11) | setFlags);
     }
 
     template <bool setFlags = false>
-    void mulhwu (GPR dest, GPR src1, GPR src2) {
-        write32 (0x7C000016 | (dest << 21) | (src1 << 16) | (src2 << 11) | setFlags);
+    constexpr auto mulhwu (GPR dest, GPR src1, GPR src2) {
+        return emit (0x7C000016 | (dest << 21) | (src1 << 16) | (src2 << 11) | setFlags);
     }
 
     template <bool setFlags = false>
-    void divwu (GPR dest, GPR dividend, GPR divisor) {
-        write32 (0x7C000396 | (dest << 21) | (dividend << 16) | (divisor << 11) | setFlags);
+    constexpr auto divwu (GPR dest, GPR dividend, GPR divisor) {
+        return emit (0x7C000396 | (dest << 21) | (dividend << 16) | (divisor << 11) | setFlags);
     }
 
     template <bool setFlags = false>
-    void divwuo (GPR dest, GPR dividend, GPR divisor) {
-        write32 (0x7C000796 | (dest << 21) | (dividend << 16) | (divisor << 11) | setFlags);
+    constexpr auto divwuo (GPR dest, GPR dividend, GPR divisor) {
+        return emit (0x7C000796 | (dest << 21) | (dividend << 16) | (divisor << 11) | setFlags);
     }
 
     template <bool setFlags = false>
-    void divw (GPR dest, GPR dividend, GPR divisor) {
-        write32 (0x7C0003D6 | (dest << 21) | (dividend << 16) | (divisor << 11) | setFlags);
+    constexpr auto divw (GPR dest, GPR dividend, GPR divisor) {
+        return emit (0x7C0003D6 | (dest << 21) | (dividend << 16) | (divisor << 11) | setFlags);
     }
 
     template <bool setFlags = false>
-    void divwo (GPR dest, GPR dividend, GPR divisor) {
-        write32 (0x7C0007D6 | (dest << 21) | (dividend << 16) | (divisor << 11) | setFlags);
+    constexpr auto divwo (GPR dest, GPR dividend, GPR divisor) {
+        return emit (0x7C0007D6 | (dest << 21) | (dividend << 16) | (divisor << 11) | setFlags);
     }
     
     template <bool setFlags = false>
-    void mr (GPR dest, GPR src) { // Move register
-        or_ <setFlags> (dest, src, src);
+    constexpr auto mr (GPR dest, GPR src) { // Move register
+        return or_ <setFlags> (dest, src, src);
     }
 
-    void liw (GPR reg, uint32_t imm) {
+    constexpr void liw (GPR reg, uint32_t imm) {
         if (imm <= 0x7FFF || imm >= 0xFFFF8000) // use li if possible
             li (reg, imm);
 
@@ -591,1403 +862,5888 @@ public:
     }
 
     template <bool setFlags = false>
-    void slw (GPR dest, GPR src1, GPR src2) { // Shift left word
-        write32 (0x7C000030 | (src1 << 21) | (dest << 16) | (src2 << 11) | setFlags);
+    constexpr auto slw (GPR dest, GPR src1, GPR src2) { // Shift left word
+        return emit (0x7C000030 | (src1 << 21) | (dest << 16) | (src2 << 11) | setFlags);
     }
 
     template <bool setFlags = false>
-    void srw (GPR dest, GPR src1, GPR src2) { // Shift right word
-        write32 (0x7C000430 | (src1 << 21) | (dest << 16) | (src2 << 11) | setFlags);
+    constexpr auto srw (GPR dest, GPR src1, GPR src2) { // Shift right word
+        return emit (0x7C000430 | (src1 << 21) | (dest << 16) | (src2 << 11) | setFlags);
     }
 
     template <bool setFlags = false>
-    void sraw (GPR dest, GPR src1, GPR src2) { // Shift right algebraic word
-        write32 (0x7C000630 | (src1 << 21) | (dest << 16) | (src2 << 11) | setFlags);
+    constexpr auto sraw (GPR dest, GPR src1, GPR src2) { // Shift right algebraic word
+        return emit (0x7C000630 | (src1 << 21) | (dest << 16) | (src2 << 11) | setFlags);
     }
 
     template <bool setFlags = false>
-    void srawi (GPR dest, GPR src, uint8_t amount) { // Shift left right algebraic word immediate
-        write32 (0x7C000670 | (src << 21) | (dest << 16) | (amount << 11) | setFlags);
+    constexpr auto srawi (GPR dest, GPR src, uint8_t amount) { // Shift left right algebraic word immediate
+        return emit (0x7C000670 | (src << 21) | (dest << 16) | (amount << 11) | setFlags);
     }
     
     template <bool setFlags = false>
-    void rlwinm (GPR dest, GPR src, uint8_t shift, uint8_t mb, uint8_t me) { // Rotate left word then and 
-        write32 (0x54000000 | (src << 21) | (dest << 16) | ((shift & 31) << 11) | (mb << 6) | (me << 1) | setFlags);
+    constexpr auto rlwinm (GPR dest, GPR src, uint8_t shift, uint8_t mb, uint8_t me) { // Rotate left word then and 
+        return emit (0x54000000 | (src << 21) | (dest << 16) | ((shift & 31) << 11) | (mb << 6) | (me << 1) | setFlags);
     }
 
     template <bool setFlags = false>
-    void slwi (GPR dest, GPR src, uint8_t shift) { // shift left word by immediate
-        rlwinm <setFlags> (dest, src, shift, 0, 31 - shift); // SLWI is actually just an alias for an rlwinm configuration
+    constexpr auto slwi (GPR dest, GPR src, uint8_t shift) { // shift left word by immediate
+        return rlwinm <setFlags> (dest, src, shift, 0, 31 - shift); // SLWI is actually just an alias for an rlwinm configuration
     }
 
     template <bool setFlags = false>
-    void srwi (GPR dest, GPR src, uint8_t shift) { // shift right word by immediate
-        rlwinm <setFlags> (dest, src, 32 - shift, shift, 31); // SRWI is actually just an alias for an rlwinm configuration
+    constexpr auto srwi (GPR dest, GPR src, uint8_t shift) { // shift right word by immediate
+        return rlwinm <setFlags> (dest, src, 32 - shift, shift, 31); // SRWI is actually just an alias for an rlwinm configuration
     }
 
     template <bool setFlags = false>
-    void clrlwi (GPR dest, GPR src, uint8_t len) { // Bit clear left
-        rlwinm <setFlags> (dest, src, 0, len, 31); // Very intuitively, this is also a rlwinm alias
+    constexpr auto clrlwi (GPR dest, GPR src, uint8_t len) { // Bit clear left
+        return rlwinm <setFlags> (dest, src, 0, len, 31); // Very intuitively, this is also a rlwinm alias
     }
 
     template <bool setFlags = false>
-    void clrrwi (GPR dest, GPR src, uint8_t len) { // Bit clear right
-        rlwinm <setFlags> (dest, src, 0, 0, 31 - len); // Very intuitively, this is also a rlwinm alias
+    constexpr auto clrrwi (GPR dest, GPR src, uint8_t len) { // Bit clear right
+        return rlwinm <setFlags> (dest, src, 0, 0, 31 - len); // Very intuitively, this is also a rlwinm alias
     }
 
     template <bool setFlags = false>
-    void rotlwi (GPR dest, GPR src, uint8_t amount) { // Rotate left word immediate
-        rlwinm <setFlags> (dest, src, amount, 0, 31); // This architecture has a lot of rlwinm aliases
+    constexpr auto rotlwi (GPR dest, GPR src, uint8_t amount) { // Rotate left word immediate
+        return rlwinm <setFlags> (dest, src, amount, 0, 31); // This architecture has a lot of rlwinm aliases
     }
 
     template <bool setFlags = false>
-    void rotrwi (GPR dest, GPR src, uint8_t amount) { // Rotate left right immediate
-        rlwinm <setFlags> (dest, src, 32 - amount, 0, 31); // This architecture has a lot of rlwinm aliases
+    constexpr auto rotrwi (GPR dest, GPR src, uint8_t amount) { // Rotate left right immediate
+        return rlwinm <setFlags> (dest, src, 32 - amount, 0, 31); // This architecture has a lot of rlwinm aliases
     }
 
     template <bool setFlags = false>
-    void extlwi (GPR dest, GPR src, uint8_t n, uint8_t b) { // Extract and left justify immediate
-        rlwinm <setFlags> (dest, src, b, 0, n - 1); // Yet another rlwinm alias
+    constexpr auto extlwi (GPR dest, GPR src, uint8_t n, uint8_t b) { // Extract and left justify immediate
+        return rlwinm <setFlags> (dest, src, b, 0, n - 1); // Yet another rlwinm alias
     }
 
     template <bool setFlags = false>
-    void extrwi (GPR dest, GPR src, uint8_t n, uint8_t b) { // Extract and left justify immediate
-        rlwinm <setFlags> (dest, src, b + n, 32 - n, 31); // Did you know rlwinm is useful?
+    constexpr auto extrwi (GPR dest, GPR src, uint8_t n, uint8_t b) { // Extract and left justify immediate
+        return rlwinm <setFlags> (dest, src, b + n, 32 - n, 31); // Did you know rlwinm is useful?
     }
 
     template <bool setFlags = false>
-    void rlwnm (GPR dest, GPR src, GPR amount, uint8_t mb, uint8_t me) { // Rotate left word then AND with mask
-        write32 (0x5C000000 | (src << 21) | (dest << 16) | (amount << 11) | (mb << 6) | (me << 1) | setFlags);
+    constexpr auto rlwnm (GPR dest, GPR src, GPR amount, uint8_t mb, uint8_t me) { // Rotate left word then AND with mask
+        return emit (0x5C000000 | (src << 21) | (dest << 16) | (amount << 11) | (mb << 6) | (me << 1) | setFlags);
     }
 
     template <bool setFlags = false>
-    void rlwimi (GPR dest, GPR src, uint8_t shift, int mb, int me) { // Rotate left word immediate then mask insert
-        write32 (0x50000000 | (src << 21) | (dest << 16) | (shift << 11) | (mb << 6) | (me << 1) | setFlags);
+    constexpr auto rlwimi (GPR dest, GPR src, uint8_t shift, int mb, int me) { // Rotate left word immediate then mask insert
+        return emit (0x50000000 | (src << 21) | (dest << 16) | (shift << 11) | (mb << 6) | (me << 1) | setFlags);
     }
 
     template <bool setFlags = false>
-    void cntlzw (GPR dest, GPR src) { // Count Leading Zeroes Word
-        write32 (0x7C000034 | (src << 21) | (dest << 16));
-    }
-
-    void stb (GPR src, GPR base, int16_t offset) { // Store byte    Note: Source first!
-        write32 (0x98000000 | (src << 21) | (base << 16) | (uint16_t) offset);
+    constexpr auto cntlzw (GPR dest, GPR src) { // Count Leading Zeroes Word
+        return emit (0x7C000034 | (src << 21) | (dest << 16) | setFlags);
     }
 
-    void stbx (GPR src, GPR index, GPR base) { // Store byte indexed   Note: Source first!
-        write32 (0x7C0001AE | (src << 21) | (index << 16) | (base << 11));
+    constexpr auto stb (GPR src, GPR base, int16_t offset) { // Store byte    Note: Source first!
+        return emit (0x98000000 | (src << 21) | (base << 16) | (uint16_t) offset);
     }
 
-    void stbu (GPR src, GPR base, int16_t offset) { // Store byte with update (writeback)    Note: Source first!
-        write32 (0x9C000000 | (src << 21) | (base << 16) | (uint16_t) offset);
+    constexpr auto stbx (GPR src, GPR index, GPR base) { // Store byte indexed   Note: Source first!
+        return emit (0x7C0001AE | (src << 21) | (index << 16) | (base << 11));
     }
 
-    void stbux (GPR src, GPR index, GPR base) { // Store byte with update (writeback) indexed   Note: Source first!
-        write32 (0x7C0001EE | (src << 21) | (index << 16) | (base << 11));
+    constexpr auto stbu (GPR src, GPR base, int16_t offset) { // Store byte with update (writeback)    Note: Source first!
+        return emit (0x9C000000 | (src << 21) | (base << 16) | (uint16_t) offset);
     }
 
-    void sth (GPR src, GPR base, int16_t offset) { // Store halfword    Note: Source first!
-        write32 (0xB0000000 | (src << 21) | (base << 16) | (uint16_t) offset);
+    constexpr auto stbux (GPR src, GPR index, GPR base) { // Store byte with update (writeback) indexed   Note: Source first!
+        return emit (0x7C0001EE | (src << 21) | (index << 16) | (base << 11));
     }
 
-    void sthx (GPR src, GPR index, GPR base) { // Store halfword indexed   Note: Source first!
-        write32 (0x7C00032E | (src << 21) | (index << 16) | (base << 11));
+    constexpr auto sth (GPR src, GPR base, int16_t offset) { // Store halfword    Note: Source first!
+        return emit (0xB0000000 | (src << 21) | (base << 16) | (uint16_t) offset);
     }
 
-    void sthu (GPR src, GPR base, int16_t offset) { // Store halfword with update (writeback)    Note: Source first!
-        write32 (0xB4000000 | (src << 21) | (base << 16) | (uint16_t) offset);
+    constexpr auto sthx (GPR src, GPR index, GPR base) { // Store halfword indexed   Note: Source first!
+        return emit (0x7C00032E | (src << 21) | (index << 16) | (base << 11));
     }
 
-    void sthux (GPR src, GPR index, GPR base) { // Store halfword with update (writeback) indexed   Note: Source first!
-        write32 (0x7C00036E | (src << 21) | (index << 16) | (base << 11));
+    constexpr auto sthu (GPR src, GPR base, int16_t offset) { // Store halfword with update (writeback)    Note: Source first!
+        return emit (0xB4000000 | (src << 21) | (base << 16) | (uint16_t) offset);
     }
 
-    void stw (GPR src, GPR base, int16_t offset) { // Store word    Note: Source first!
-        write32 (0x90000000 | (src << 21) | (base << 16) | (uint16_t) offset);
+    constexpr auto sthux (GPR src, GPR index, GPR base) { // Store halfword with update (writeback) indexed   Note: Source first!
+        return emit (0x7C00036E | (src << 21) | (index << 16) | (base << 11));
     }
 
-    void stwx (GPR src, GPR index, GPR base) { // Store word indexed   Note: Source first!
-        write32 (0x7C00012E | (src << 21) | (index << 16) | (base << 11));
+    constexpr auto stw (GPR src, GPR base, int16_t offset) { // Store word    Note: Source first!
+        return emit (0x90000000 | (src << 21) | (base << 16) | (uint16_t) offset);
     }
 
-    void stwu (GPR src, GPR base, int16_t offset) { // Store word with update (writeback)   Note: Source first!
-        write32 (0x94000000 | (src << 21) | (base << 16) | (uint16_t) offset);
+    constexpr auto stwx (GPR src, GPR index, GPR base) { // Store word indexed   Note: Source first!
+        return emit (0x7C00012E | (src << 21) | (index << 16) | (base << 11));
     }
 
-    void stwux (GPR src, GPR index, GPR base) { // Store word with update indexed   Note: Source first!
-        write32 (0x7C00016E | (src << 21) | (index << 16) | (base << 11));
+    constexpr auto stwu (GPR src, GPR base, int16_t offset) { // Store word with update (writeback)   Note: Source first!
+        return emit (0x94000000 | (src << 21) | (base << 16) | (uint16_t) offset);
     }
 
-    void lbz (GPR dest, GPR base, int16_t offset) { // Load byte and zero
-        write32 (0x88000000 | (dest << 21) | (base << 16) | (uint16_t) offset);
+    constexpr auto stwux (GPR src, GPR index, GPR base) { // Store word with update indexed   Note: Source first!
+        return emit (0x7C00016E | (src << 21) | (index << 16) | (base << 11));
     }
 
-    void lbzx (GPR dest, GPR index, GPR base) { // Load byte and zero indexed
-        write32 (0x7C0000AE | (dest << 21) | (index << 16) | (base << 11));
+    constexpr auto lbz (GPR dest, GPR base, int16_t offset) { // Load byte and zero
+        return emit (0x88000000 | (dest << 21) | (base << 16) | (uint16_t) offset);
     }
 
-    void lbzu (GPR dest, GPR base, int16_t offset) { // Load byte and zero with update (writeback)
-        write32 (0x8C000000 | (dest << 21) | (base << 16) | (uint16_t) offset);
+    constexpr auto lbzx (GPR dest, GPR index, GPR base) { // Load byte and zero indexed
+        return emit (0x7C0000AE | (dest << 21) | (index << 16) | (base << 11));
     }
 
-    void lbzux (GPR dest, GPR index, GPR base) { // Load byte and zero with update indexed
-        write32 (0x7C0000EE | (dest << 21) | (index << 16) | (base << 11));
+    constexpr auto lbzu (GPR dest, GPR base, int16_t offset) { // Load byte and zero with update (writeback)
+        return emit (0x8C000000 | (dest << 21) | (base << 16) | (uint16_t) offset);
     }
 
-    void lhz (GPR dest, GPR base, int16_t offset) { // Load halfword and zero
-        write32 (0xA0000000 | (dest << 21) | (base << 16) | (uint16_t) offset);
+    constexpr auto lbzux (GPR dest, GPR index, GPR base) { // Load byte and zero with update indexed
+        return emit (0x7C0000EE | (dest << 21) | (index << 16) | (base << 11));
     }
 
-    void lhzx (GPR dest, GPR index, GPR base) { // Load halfword and zero indexed
-        write32 (0x7C00022E | (dest << 21) | (index << 16) | (base << 11));
+    constexpr auto lhz (GPR dest, GPR base, int16_t offset) { // Load halfword and zero
+        return emit (0xA0000000 | (dest << 21) | (base << 16) | (uint16_t) offset);
     }
 
-    void lhzu (GPR dest, GPR base, int16_t offset) { // Load halfword and zero with update (writeback)
-        write32 (0xA4000000 | (dest << 21) | (base << 16) | (uint16_t) offset);
+    constexpr auto lhzx (GPR dest, GPR index, GPR base) { // Load halfword and zero indexed
+        return emit (0x7C00022E | (dest << 21) | (index << 16) | (base << 11));
     }
 
-    void lhzux (GPR dest, GPR index, GPR base) { // Load halfword and zero with update indexed
-        write32 (0x7C00026E | (dest << 21) | (index << 16) | (base << 11));
+    constexpr auto lhzu (GPR dest, GPR base, int16_t offset) { // Load halfword and zero with update (writeback)
+        return emit (0xA4000000 | (dest << 21) | (base << 16) | (uint16_t) offset);
     }
 
-    void lhax (GPR dest, GPR index, GPR base) { // Load halfword algebraic indexed
-        write32 (0x7C0002AE | (dest << 21) | (index << 16) | (base << 11));
+    constexpr auto lhzux (GPR dest, GPR index, GPR base) { // Load halfword and zero with update indexed
+        return emit (0x7C00026E | (dest << 21) | (index << 16) | (base << 11));
     }
 
-    void lhaux (GPR dest, GPR index, GPR base) { // Load halfword algebraic with update indexed
-        write32 (0x7C0002EE | (dest << 21) | (index << 16) | (base << 11));
+    constexpr auto lhax (GPR dest, GPR index, GPR base) { // Load halfword algebraic indexed
+        return emit (0x7C0002AE | (dest << 21) | (index << 16) | (base << 11));
     }
 
-    void lhbrx (GPR dest, GPR index, GPR base) { // Load halfword byte-reverse indexed
-        write32 (0x7C00062C | (dest << 21) | (index << 16) | (base << 11));
+    constexpr auto lhaux (GPR dest, GPR index, GPR base) { // Load halfword algebraic with update indexed
+        return emit (0x7C0002EE | (dest << 21) | (index << 16) | (base << 11));
     }
 
-    void lwz (GPR dest, GPR base, int16_t offset) { // Load word and zero
-        write32 (0x80000000 | (dest << 21) | (base << 16) | (uint16_t) offset);
+    constexpr auto lhbrx (GPR dest, GPR index, GPR base) { // Load halfword byte-reverse indexed
+        return emit (0x7C00062C | (dest << 21) | (index << 16) | (base << 11));
     }
 
-    void lwzx (GPR dest, GPR index, GPR base) { // Load word and zero with update indexed
-        write32 (0x7C00002E | (dest << 21) | (index << 16) | (base << 11));
+    constexpr auto lwz (GPR dest, GPR base, int16_t offset) { // Load word and zero
+        return emit (0x80000000 | (dest << 21) | (base << 16) | (uint16_t) offset);
     }
 
-    void lwzu (GPR dest, GPR base, int16_t offset) { // Load word and zero with update (writeback)
-        write32 (0x84000000 | (dest << 21) | (base << 16) | (uint16_t) offset);
+    constexpr auto lwzx (GPR dest, GPR index, GPR base) { // Load word and zero with update indexed
+        return emit (0x7C00002E | (dest << 21) | (index << 16) | (base << 11));
     }
 
-    void lwzux (GPR dest, GPR index, GPR base) { // Load word and zero with update indexed
-        write32 (0x7C00006E | (dest << 21) | (index << 16) | (base << 11));
+    constexpr auto lwzu (GPR dest, GPR base, int16_t offset) { // Load word and zero with update (writeback)
+        return emit (0x84000000 | (dest << 21) | (base << 16) | (uint16_t) offset);
     }
 
-    void lwarx (GPR dest, GPR index, GPR base) { // Load word and Reserve indexed
-        write32 (0x7C000028 | (dest << 21) | (index << 16) | (base << 11));
+    constexpr auto lwzux (GPR dest, GPR index, GPR base) { // Load word and zero with update indexed
+        return emit (0x7C00006E | (dest << 21) | (index << 16) | (base << 11));
     }
 
-    void lwbrx (GPR dest, GPR index, GPR base) { // Load word byte-reverse indexed
-        write32 (0x7C00042C | (dest << 21) | (index << 16) | (base << 11));
+    constexpr auto lwarx (GPR dest, GPR index, GPR base) { // Load word and Reserve indexed
+        return emit (0x7C000028 | (dest << 21) | (index << 16) | (base << 11));
     }
 
-    void lmw (GPR dest, GPR base, int16_t offset) { // Load multiple words
-        write32 (0xB8000000 | (dest << 21) | (base << 16) | (uint16_t) offset);
+    constexpr auto stwcx (GPR src, GPR index, GPR base) { // Store word conditional indexed (stwcx.), sets cr0.eq if the store went through
+        return emit (0x7C00012D | (src << 21) | (index << 16) | (base << 11));
     }
 
-    void stmw (GPR src, GPR base, int16_t offset) { // Store multiple words
-        write32 (0xBC000000 | (src << 21) | (base << 16) | (uint16_t) offset);
+    constexpr auto lwbrx (GPR dest, GPR index, GPR base) { // Load word byte-reverse indexed
+        return emit (0x7C00042C | (dest << 21) | (index << 16) | (base << 11));
     }
 
-    template <bool link>
-    BranchLabel bx() {
-        const auto cia = currentPointer;
-        write32 (0x48000000 | link);
-        return std::make_pair (cia, BranchType::Branch24);
+    constexpr auto lmw (GPR dest, GPR base, int16_t offset) { // Load multiple words
+        return emit (0xB8000000 | (dest << 21) | (base << 16) | (uint16_t) offset);
     }
 
-    BranchLabel b() {
-        return bx <false> ();
+    constexpr auto stmw (GPR src, GPR base, int16_t offset) { // Store multiple words
+        return emit (0xBC000000 | (src << 21) | (base << 16) | (uint16_t) offset);
     }
 
-    BranchLabel bl() {
-        return bx <true> ();
-    } 
-
-    template <bool link>
-    void bx (void* address) {
-        const auto cia = (uintptr_t)currentPointer; // Load CIA
-        const intptr_t disp = (intptr_t) address - (intptr_t) cia; // Displacement of the jump in bytes
-                
-        constexpr int32_t INT26_MIN = -0x2000000; // Bx uses an INT26_t displacement, so we define a ceiling and a floor
-        constexpr int32_t INT26_MAX = 0x1FFFFFF;
-
-        if ((uintptr_t) address & 3) // Check that address is aligned to a word boundary
-            panic ("[Emitter] Fatal: Unaligned branch displacement");
-        
-        if (disp >= INT26_MIN && disp <= INT26_MAX) // Check if the displacement in words can be encoded in 24 bits in a relative branch
-            write32 (0x48000000 | (disp & 0x3FFFFFC) | link);
-        else if ((intptr_t) address >= INT26_MIN && (intptr_t) address <= INT26_MAX) // Check if the target address can be encoded in 24 bits in an absolute branch instead
-            write32 (0x48000000 | ((uintptr_t) address & 0x3FFFFFC) | 2 | link);
-        else
-            panic ("[Emitter] Fatal: Invalid label for 24-bit branch, displacement of %08X words exceeds possible range\n", disp >> 2);
-    }
+    // CR/MSR/SPR/FPSCR/SR operations
 
-    void b (void* address) {
-        bx <false> (address);
+    constexpr auto crand (uint8_t dest_bit, uint8_t src1_bit, uint8_t src2_bit) { // Condition register AND
+        return emit (0x4C000202 | (dest_bit << 21) | (src1_bit << 16) | (src2_bit << 11));
     }
     
-    void bl (void* address) {
-        bx <true> (address);
+    constexpr auto crandc (uint8_t dest_bit, uint8_t src1_bit, uint8_t src2_bit) { // Condition register AND with complement
+        return emit (0x4C000102 | (dest_bit << 21) | (src1_bit << 16) | (src2_bit << 11));
     }
 
-    // TODO: Perhaps handle conditional branches targetting CR1-7
-    template <Cond cond, bool link>
-    BranchLabel bcx () {
-        constexpr bool shouldBitBeSet = (uint32_t) cond <= 3; // For conditions 0 (Lt), 1 (Gt), 2 (Eq) and 3 (SO), the bit in CR should be set. Otherwise it should be cleared
-        constexpr int bit = (uint32_t) cond & 3;
-
-        return emitBranch14 (0x40800000 | (shouldBitBeSet << 24) | (bit << 16) | link);
-    }
-
-    BranchLabel beq() { return bcx <Cond::Eq, false> (); } // Branch if equal
-    BranchLabel bne() { return bcx <Cond::Ne, false> (); } // Branch if not equal
-    BranchLabel blt() { return bcx <Cond::Lt, false> (); } // Branch if less than
-    BranchLabel bge() { return bcx <Cond::Ge, false> (); } // Branch if greater than or equal
-    BranchLabel ble() { return bcx <Cond::Le, false> (); } // Branch if less than or equal
-    BranchLabel bgt() { return bcx <Cond::Gt, false> (); } // Branch if greater than
-    BranchLabel bso() { return bcx <Cond::Os, false> (); } // Branch if overflow
-    BranchLabel bns() { return bcx <Cond::Oc, false> (); } // Branch if no overflow
-
-    BranchLabel beql() { return bcx <Cond::Eq, true> (); } // Branch if equal and link
-    BranchLabel bnel() { return bcx <Cond::Ne, true> (); } // Branch if not equal and link
-    BranchLabel bltl() { return bcx <Cond::Lt, true> (); } // Branch if less than and link
-    BranchLabel bgel() { return bcx <Cond::Ge, true> (); } // Branch if greater than or equal and link
-    BranchLabel blel() { return bcx <Cond::Le, true> (); } // Branch if less than or equal and link
-    BranchLabel bgtl() { return bcx <Cond::Gt, true> (); } // Branch if greater than and link
-    BranchLabel bsol() { return bcx <Cond::Os, true> (); } // Branch if overflow and link
-    BranchLabel bnsl() { return bcx <Cond::Oc, true> (); } // Branch if no overflow and link
-
-    void setLabel (BranchLabel label) {
-        setLabel (label, currentPointer);
+    constexpr auto creqv (uint8_t dest_bit, uint8_t src1_bit, uint8_t src2_bit) { // Condition register XNOR
+        return emit (0x4C000242 | (dest_bit << 21) | (src1_bit << 16) | (src2_bit << 11));
     }
 
-    void setLabel (BranchLabel label, void* address) {
-        const auto instrAddress = label.first; // Load the address of the instruction to patch
-        const auto type = label.second; // Type of branch
-        const intptr_t disp = (intptr_t) address - (intptr_t) instrAddress; // Displacement of the jump in bytes
-
-        constexpr int32_t INT26_MIN = -0x2000000;
-        constexpr int32_t INT26_MAX = 0x1FFFFFF;
-
-        if (disp & 3)
-            panic ("[Fatal] Unaligned branch displacement\n");
-
-        switch (type) {
-            case BranchType::Branch14: {
-                if (disp <= INT16_MAX && disp >= INT16_MIN) // Check if the displacement in words can be encoded in 14 bits in a relative branch
-                    *instrAddress = (*instrAddress & ~0xFFFE) | (disp & 0xFFFC);
-                else if ((intptr_t) address <= INT16_MAX && (intptr_t) address >= INT16_MIN) // Check if the target address can be encoded in 14 bits in an absolute branch instead
-                    *instrAddress = (*instrAddress & ~0xFFFE) | ((uintptr_t)address & 0xFFFC) | 2;
-                else
-                    panic ("Invalid label for 14-bit branch, displacement of %08X words exceeds possible range\n", disp >> 2);
-                break;
-            }
-            
-            case BranchType::Branch24: {
-                if (disp >= INT26_MIN && disp <= INT26_MAX) // Check if the displacement in words can be encoded in 24 bits in a relative branch
-                    *instrAddress = (*instrAddress & ~0x3FFFFFE) | (disp & 0x3FFFFFC);
-                else if ((intptr_t) address >= INT26_MIN && (intptr_t) address <= INT26_MAX) // Check if the target address can be encoded in 24 bits in an absolute branch instead
-                    *instrAddress = (*instrAddress & ~0x3FFFFFE) | ((uintptr_t)address & 0x3FFFFFC) | 2;
-                else
-                    panic ("Invalid label for 24-bit branch, displacement of %08X words exceeds possible range\n", disp >> 2);
-                break;
-            }
-        }
+    constexpr auto crnand (uint8_t dest_bit, uint8_t src1_bit, uint8_t src2_bit) { // Condition register NAND
+        return emit (0x4C0001C2 | (dest_bit << 21) | (src1_bit << 16) | (src2_bit << 11));
     }
 
-    // CR/MSR/SPR/FPSCR/SR operations
-
-    void crand (uint8_t dest_bit, uint8_t src1_bit, uint8_t src2_bit) { // Condition register AND
-        write32 (0x4C000202 | (dest_bit << 21) | (src1_bit << 16) | (src2_bit << 11));
-    }
-    
-    void crandc (uint8_t dest_bit, uint8_t src1_bit, uint8_t src2_bit) { // Condition register AND with complement
-        write32 (0x4C000102 | (dest_bit << 21) | (src1_bit << 16) | (src2_bit << 11));
+    constexpr auto crnor (uint8_t dest_bit, uint8_t src1_bit, uint8_t src2_bit) { // Condition register NOR
+        return emit (0x4C000042 | (dest_bit << 21) | (src1_bit << 16) | (src2_bit << 11));
     }
 
-    void creqv (uint8_t dest_bit, uint8_t src1_bit, uint8_t src2_bit) { // Condition register XNOR
-        write32 (0x4C000242 | (dest_bit << 21) | (src1_bit << 16) | (src2_bit << 11));
+    constexpr auto cror (uint8_t dest_bit, uint8_t src1_bit, uint8_t src2_bit) { // Condition register OR
+        return emit (0x4C000382 | (dest_bit << 21) | (src1_bit << 16) | (src2_bit << 11));
     }
 
-    void crnand (uint8_t dest_bit, uint8_t src1_bit, uint8_t src2_bit) { // Condition register NAND
-        write32 (0x4C0001C2 | (dest_bit << 21) | (src1_bit << 16) | (src2_bit << 11));
+    constexpr auto crorc (uint8_t dest_bit, uint8_t src1_bit, uint8_t src2_bit) { // Condition register OR with complement
+        return emit (0x4C000342 | (dest_bit << 21) | (src1_bit << 16) | (src2_bit << 11));
     }
 
-    void crnor (uint8_t dest_bit, uint8_t src1_bit, uint8_t src2_bit) { // Condition register NOR
-        write32 (0x4C000042 | (dest_bit << 21) | (src1_bit << 16) | (src2_bit << 11));
+    constexpr auto crxor (uint8_t dest_bit, uint8_t src1_bit, uint8_t src2_bit) { // Condition register xor
+        return emit (0x4C000182 | (dest_bit << 21) | (src1_bit << 16) | (src2_bit << 11));
     }
 
-    void cror (uint8_t dest_bit, uint8_t src1_bit, uint8_t src2_bit) { // Condition register OR
-        write32 (0x4C000382 | (dest_bit << 21) | (src1_bit << 16) | (src2_bit << 11));
+    constexpr auto mtcrf (uint8_t mask, GPR src) { // Move to condition register fields
+        return emit (0x7C000120 | (src << 21) | (mask << 12));
     }
 
-    void crorc (uint8_t dest_bit, uint8_t src1_bit, uint8_t src2_bit) { // Condition register OR with complement
-        write32 (0x4C000342 | (dest_bit << 21) | (src1_bit << 16) | (src2_bit << 11));
-    }
+    constexpr auto mtcr (GPR src) { return mtcrf (0xFF, src); } // Move to condition register
 
-    void crxor (uint8_t dest_bit, uint8_t src1_bit, uint8_t src2_bit) { // Condition register xor
-        write32 (0x4C000182 | (dest_bit << 21) | (src1_bit << 16) | (src2_bit << 11));
+    constexpr auto mfcr (GPR dest) {
+        return emit (0x7C000026 | (dest << 21));
     }
 
-    void mtcrf (uint8_t mask, GPR src) { // Move to condition register fields
-        write32 (0x7C000120 | (src << 21) | (mask << 12));
+    constexpr auto mtsr (SR dest, GPR src) { // Move to segment register
+        return emit (0x7C0001A4 | (src << 21) | (dest << 16));
     }
 
-    void mtcr (GPR src) { mtcrf (0xFF, src); } // Move to condition register
-
-    void mfcr (GPR dest) {
-        write32 (0x7C000026 | (dest << 21));
+    constexpr auto mfsr (GPR dest, SR src) { // Move from segment register
+        return emit (0x7C0004A6 | (dest << 21) | (src << 16));
     }
 
-    void mtsr (SR dest, GPR src) { // Move to segment register
-        write32 (0x7C0001A4 | (src << 21) | (dest << 16));
+    constexpr auto mtsrin (GPR src, GPR base) { // Move to segment register indirect
+        return emit (0x7C0001E4 | (src << 21) | (base << 11));
     }
 
-    void mfsr (GPR dest, SR src) { // Move from segment register
-        write32 (0x7C0004A6 | (dest << 21) | (src << 16));
+    constexpr auto mfsrin (GPR dest, GPR base) { // Move to segment register indirect
+        return emit (0x7C000526 | (dest << 21) | (base << 11));
     }
 
-    void mtsrin (GPR src, GPR base) { // Move to segment register indirect
-        write32 (0x7C0001E4 | (src << 21) | (base << 11));
+    constexpr auto mfmsr (GPR dest) { // Move from machine state register
+        return emit (0x7C0000A6 | (dest << 21));
     }
 
-    void mfsrin (GPR dest, GPR base) { // Move to segment register indirect
-        write32 (0x7C000526 | (dest << 21) | (base << 11));
+    constexpr auto mtmsr (GPR src) { // Move to machine state register
+        return emit (0x7C000124 | (src << 21));
     }
 
-    void mfmsr (GPR dest) { // Move from machine state register
-        write32 (0x7C0000A6 | (dest << 21));
+    constexpr auto mtctr (GPR reg) { // Move to counter register
+        return emit (0x7C0903A6 | (reg << 21));
     }
 
-    void mtmsr (GPR src) { // Move to machine state register
-        write32 (0x7C000124 | (src << 21));
+    constexpr auto mfctr (GPR reg) { // Move from counter register
+        return emit (0x7C0902A6 | (reg << 21));
     }
 
-    void mtctr (GPR reg) { // Move to counter register
-        write32 (0x7C0903A6 | (reg << 21));
+    constexpr auto mflr (GPR dest) { // Move from link register
+        return emit (0x7C0802A6 | (dest << 21));
     }
 
-    void mfctr (GPR reg) { // Move from counter register
-        write32 (0x7C0902A6 | (reg << 21));
+    constexpr auto mtlr (GPR src) { // Move to link register
+        return emit (0x7C0803A6 | (src << 21));
     }
 
-    void mflr (GPR dest) { // Move from link register
-        write32 (0x7C0802A6 | (dest << 21));
+    constexpr auto mtspr (uint32_t spr, GPR src) { // Move to special purpose register (the 2 halves of the SPR number are swapped in the encoding)
+        return emit (0x7C0003A6 | (src << 21) | ((spr & 31) << 16) | ((spr >> 5) << 11));
     }
 
-    void mtlr (GPR src) { // Move to link register
-        write32 (0x7C0803A6 | (src << 21));
+    constexpr auto mfspr (GPR dest, uint32_t spr) { // Move from special purpose register
+        return emit (0x7C0002A6 | (dest << 21) | ((spr & 31) << 16) | ((spr >> 5) << 11));
     }
 
     // FPU operations
 
-    void lfs (FPR dest, GPR base, int16_t offset) { // Load floating point single
-        write32 (0xC0000000 | (dest << 21) | (base << 16) | (uint16_t) offset);
+    constexpr auto lfs (FPR dest, GPR base, int16_t offset) { // Load floating point single
+        return emit (0xC0000000 | (dest << 21) | (base << 16) | (uint16_t) offset);
     }
 
-    void lfd (FPR dest, GPR base, int16_t offset) { // Load floating point double
-        write32 (0xC8000000 | (dest << 21) | (base << 16) | (uint16_t) offset);
+    constexpr auto lfd (FPR dest, GPR base, int16_t offset) { // Load floating point double
+        return emit (0xC8000000 | (dest << 21) | (base << 16) | (uint16_t) offset);
     }
 
-    void stfs (FPR src, GPR base, int16_t offset) { // Store floating point single
-        write32 (0xD0000000 | (src << 21) | (base << 16) | (uint16_t) offset);
+    constexpr auto stfs (FPR src, GPR base, int16_t offset) { // Store floating point single
+        return emit (0xD0000000 | (src << 21) | (base << 16) | (uint16_t) offset);
     }
 
-    void stfd (FPR src, GPR base, int16_t offset) { // Store floating point double
-        write32 (0xD8000000 | (src << 21) | (base << 16) | (uint16_t) offset);
+    constexpr auto stfd (FPR src, GPR base, int16_t offset) { // Store floating point double
+        return emit (0xD8000000 | (src << 21) | (base << 16) | (uint16_t) offset);
     }
 
     template <bool setFlags = false>
-    void fmr (FPR dest, FPR src) { // Floating point move register
-        write32 (0xFC000090 | (dest << 21) | (src << 11) | setFlags);
+    constexpr auto fmr (FPR dest, FPR src) { // Floating point move register
+        return emit (0xFC000090 | (dest << 21) | (src << 11) | setFlags);
     }
 
     template <bool setFlags = false>
-    void fadd (FPR dest, FPR src1, FPR src2) { // Floating Add Double
-        write32 (0xFC00002A | (dest << 21) | (src1 << 16) | (src2 << 11) | setFlags);
+    constexpr auto fadd (FPR dest, FPR src1, FPR src2) { // Floating Add Double
+        return emit (0xFC00002A | (dest << 21) | (src1 << 16) | (src2 << 11) | setFlags);
     }
 
     template <bool setFlags = false>
-    void fadds (FPR dest, FPR src1, FPR src2) { // Floating Add Single
-        write32 (0xEC00002A | (dest << 21) | (src1 << 16) | (src2 << 11) | setFlags);
+    constexpr auto fadds (FPR dest, FPR src1, FPR src2) { // Floating Add Single
+        return emit (0xEC00002A | (dest << 21) | (src1 << 16) | (src2 << 11) | setFlags);
     }
 
     template <bool setFlags = false>
-    void fdiv (FPR dest, FPR src1, FPR src2) { // Floating Add Double
-        write32 (0xFC000024 | (dest << 21) | (src1 << 16) | (src2 << 11) | setFlags);
+    constexpr auto fdiv (FPR dest, FPR src1, FPR src2) { // Floating Add Double
+        return emit (0xFC000024 | (dest << 21) | (src1 << 16) | (src2 << 11) | setFlags);
     }
 
     template <bool setFlags = false>
-    void fdivs (FPR dest, FPR src1, FPR src2) { // Floating Add Double
-        write32 (0xEC000024 | (dest << 21) | (src1 << 16) | (src2 << 11) | setFlags);
+    constexpr auto fdivs (FPR dest, FPR src1, FPR src2) { // Floating Add Double
+        return emit (0xEC000024 | (dest << 21) | (src1 << 16) | (src2 << 11) | setFlags);
     }
 
     template <bool setFlags = false>
-    void fmadd (FPR dest, FPR src1, FPR src2, FPR src3) { // Floating multiply-add double (dest = src 1 * src2 + src3)
-        write32 (0xFC00003A | (dest << 21) | (src1 << 16) | (src3 << 11) | (src2 << 6) | setFlags);
+    constexpr auto fmadd (FPR dest, FPR src1, FPR src2, FPR src3) { // Floating multiply-add double (dest = src 1 * src2 + src3)
+        return emit (0xFC00003A | (dest << 21) | (src1 << 16) | (src3 << 11) | (src2 << 6) | setFlags);
     }
 
     template <bool setFlags = false>
-    void fmadds (FPR dest, FPR src1, FPR src2, FPR src3) { // Floating multiply-add single (dest = src 1 * src2 + src3)
-        write32 (0xEC00003A | (dest << 21) | (src1 << 16) | (src3 << 11) | (src2 << 6) | setFlags);
+    constexpr auto fmadds (FPR dest, FPR src1, FPR src2, FPR src3) { // Floating multiply-add single (dest = src 1 * src2 + src3)
+        return emit (0xEC00003A | (dest << 21) | (src1 << 16) | (src3 << 11) | (src2 << 6) | setFlags);
     }
 
     template <bool setFlags = false>
-    void fmsub (FPR dest, FPR src1, FPR src2, FPR src3) { // Floating multiply-sub double (dest = src 1 * src2 - src3)
-        write32 (0xFC000038 | (dest << 21) | (src1 << 16) | (src3 << 11) | (src2 << 6) | setFlags);
+    constexpr auto fmsub (FPR dest, FPR src1, FPR src2, FPR src3) { // Floating multiply-sub double (dest = src 1 * src2 - src3)
+        return emit (0xFC000038 | (dest << 21) | (src1 << 16) | (src3 << 11) | (src2 << 6) | setFlags);
     }
 
     template <bool setFlags = false>
-    void fmsubs (FPR dest, FPR src1, FPR src2, FPR src3) { // Floating multiply-sub single (dest = src 1 * src2 - src3)
-        write32 (0xEC000038 | (dest << 21) | (src1 << 16) | (src3 << 11) | (src2 << 6) | setFlags);
+    constexpr auto fmsubs (FPR dest, FPR src1, FPR src2, FPR src3) { // Floating multiply-sub single (dest = src 1 * src2 - src3)
+        return emit (0xEC000038 | (dest << 21) | (src1 << 16) | (src3 << 11) | (src2 << 6) | setFlags);
     }
 
     template <bool setFlags = false>
-    void fmul (FPR dest, FPR src1, FPR src2) { // Floating point multiply double
-        write32 (0xFC000032 | (dest << 21) | (src1 << 16) | (src2 << 6) | setFlags);
+    constexpr auto fmul (FPR dest, FPR src1, FPR src2) { // Floating point multiply double
+        return emit (0xFC000032 | (dest << 21) | (src1 << 16) | (src2 << 6) | setFlags);
     }
 
     template <bool setFlags = false>
-    void fmuls (FPR dest, FPR src1, FPR src2) { // Floating point multiply single
-        write32 (0xEC000032 | (dest << 21) | (src1 << 16) | (src2 << 6) | setFlags);
+    constexpr auto fmuls (FPR dest, FPR src1, FPR src2) { // Floating point multiply single
+        return emit (0xEC000032 | (dest << 21) | (src1 << 16) | (src2 << 6) | setFlags);
     }
 
     template <bool setFlags = false>
-    void fnabs (FPR dest, FPR src) { // Floating point negative absolute value
-        write32 (0xFC000110 | (dest << 21) | (src << 11) | setFlags);
+    constexpr auto fnabs (FPR dest, FPR src) { // Floating point negative absolute value
+        return emit (0xFC000110 | (dest << 21) | (src << 11) | setFlags);
     }
 
     template <bool setFlags = false> 
-    void fneg (FPR dest, FPR src) { // Floating point negate
-        write32 (0xFC000050 | (dest << 21) | (src << 11) | setFlags);
+    constexpr auto fneg (FPR dest, FPR src) { // Floating point negate
+        return emit (0xFC000050 | (dest << 21) | (src << 11) | setFlags);
     }
 
     template <bool setFlags = false>
-    void fnmadd (FPR dest, FPR src1, FPR src2, FPR src3) { // Floating negative multiply-add double (dest = -(src 1 * src2 + src3))
-        write32 (0xFC00003E | (dest << 21) | (src1 << 16) | (src3 << 11) | (src2 << 6) | setFlags);
+    constexpr auto fnmadd (FPR dest, FPR src1, FPR src2, FPR src3) { // Floating negative multiply-add double (dest = -(src 1 * src2 + src3))
+        return emit (0xFC00003E | (dest << 21) | (src1 << 16) | (src3 << 11) | (src2 << 6) | setFlags);
     }
 
     template <bool setFlags = false>
-    void fnmadds (FPR dest, FPR src1, FPR src2, FPR src3) { // Floating negative multiply-add single (dest = -(src 1 * src2 + src3))
-        write32 (0xEC00003E | (dest << 21) | (src1 << 16) | (src3 << 11) | (src2 << 6) | setFlags);
+    constexpr auto fnmadds (FPR dest, FPR src1, FPR src2, FPR src3) { // Floating negative multiply-add single (dest = -(src 1 * src2 + src3))
+        return emit (0xEC00003E | (dest << 21) | (src1 << 16) | (src3 << 11) | (src2 << 6) | setFlags);
     }
 
     template <bool setFlags = false>
-    void fnmsub (FPR dest, FPR src1, FPR src2, FPR src3) { // Floating negative multiply-subtract double (dest = -(src 1 * src2 - src3))
-        write32 (0xFC00003C | (dest << 21) | (src1 << 16) | (src3 << 11) | (src2 << 6) | setFlags);
+    constexpr auto fnmsub (FPR dest, FPR src1, FPR src2, FPR src3) { // Floating negative multiply-subtract double (dest = -(src 1 * src2 - src3))
+        return emit (0xFC00003C | (dest << 21) | (src1 << 16) | (src3 << 11) | (src2 << 6) | setFlags);
     }
 
     template <bool setFlags = false>
-    void fnmsubs (FPR dest, FPR src1, FPR src2, FPR src3) { // Floating negative multiply-subtract single (dest = -(src 1 * src2 - src3))
-        write32 (0xEC00003C | (dest << 21) | (src1 << 16) | (src3 << 11) | (src2 << 6) | setFlags);
+    constexpr auto fnmsubs (FPR dest, FPR src1, FPR src2, FPR src3) { // Floating negative multiply-subtract single (dest = -(src 1 * src2 - src3))
+        return emit (0xEC00003C | (dest << 21) | (src1 << 16) | (src3 << 11) | (src2 << 6) | setFlags);
     }
 
     template <bool setFlags = false> 
-    void fres (FPR dest, FPR src) { // Floating reciprocal estimate single
-        write32 (0xEC000030 | (dest << 21) | (src << 11) | setFlags);
+    constexpr auto fres (FPR dest, FPR src) { // Floating reciprocal estimate single
+        return emit (0xEC000030 | (dest << 21) | (src << 11) | setFlags);
     }
 
     template <bool setFlags = false> 
-    void frsp (FPR dest, FPR src) { // Floating round to single
-        write32 (0xFC000018 | (dest << 21) | (src << 11) | setFlags);
+    constexpr auto frsp (FPR dest, FPR src) { // Floating round to single
+        return emit (0xFC000018 | (dest << 21) | (src << 11) | setFlags);
     }
 
     template <bool setFlags = false> 
-    void frsqrte (FPR dest, FPR src) { // Floating reciprocal square root estimate
-        write32 (0xFC000034 | (dest << 21) | (src << 11) | setFlags);
+    constexpr auto frsqrte (FPR dest, FPR src) { // Floating reciprocal square root estimate
+        return emit (0xFC000034 | (dest << 21) | (src << 11) | setFlags);
     }
 
     template <bool setFlags = false>
-    void fsel (FPR dest, FPR src1, FPR src2, FPR src3) { // Floating select
-        write32 (0xFC00002E | (dest << 21) | (src1 << 16) | (src3 << 11) | (src2 << 6) | setFlags);
+    constexpr auto fsel (FPR dest, FPR src1, FPR src2, FPR src3) { // Floating select
+        return emit (0xFC00002E | (dest << 21) | (src1 << 16) | (src3 << 11) | (src2 << 6) | setFlags);
     }
 
     template <bool setFlags = false>
-    void fsub (FPR dest, FPR src1, FPR src2) { // Floating Subtract Double
-        write32 (0xFC000028 | (dest << 21) | (src1 << 16) | (src2 << 11) | setFlags);
+    constexpr auto fsub (FPR dest, FPR src1, FPR src2) { // Floating Subtract Double
+        return emit (0xFC000028 | (dest << 21) | (src1 << 16) | (src2 << 11) | setFlags);
     }
 
     template <bool setFlags = false>
-    void fsubs (FPR dest, FPR src1, FPR src2) { // Floating Subtract Single
-        write32 (0xEC000028 | (dest << 21) | (src1 << 16) | (src2 << 11) | setFlags);
+    constexpr auto fsubs (FPR dest, FPR src1, FPR src2) { // Floating Subtract Single
+        return emit (0xEC000028 | (dest << 21) | (src1 << 16) | (src2 << 11) | setFlags);
     }
 
     // Useless shit
-    void icbi (GPR rA, GPR rB) { // Instruction cache block invalidate
-        write32 (0x7C0007AC | (rA << 16) | (rB << 11));
+    constexpr auto icbi (GPR rA, GPR rB) { // Instruction cache block invalidate
+        return emit (0x7C0007AC | (rA << 16) | (rB << 11));
     }
 
-    void dcbf (GPR rA, GPR rB) { // Data cache block flush
-        write32 (0x7C0000AC | (rA << 16) | (rB << 11));
+    constexpr auto dcbf (GPR rA, GPR rB) { // Data cache block flush
+        return emit (0x7C0000AC | (rA << 16) | (rB << 11));
     }
 
-    void dcbi (GPR rA, GPR rB) { // Data cache block invalidate
-        write32 (0x7C0003AC | (rA << 16) | (rB << 11));
+    constexpr auto dcbi (GPR rA, GPR rB) { // Data cache block invalidate
+        return emit (0x7C0003AC | (rA << 16) | (rB << 11));
     }
 
-    void dcbst (GPR rA, GPR rB) { // Data cache block store
-        write32 (0x7C00006C | (rA << 16) | (rB << 11));
+    constexpr auto dcbst (GPR rA, GPR rB) { // Data cache block store
+        return emit (0x7C00006C | (rA << 16) | (rB << 11));
     }
 
-    void dcbt (GPR rA, GPR rB) { // Data cache block touch
-        write32 (0x7C00022C | (rA << 16) | (rB << 11));
+    constexpr auto dcbt (GPR rA, GPR rB) { // Data cache block touch
+        return emit (0x7C00022C | (rA << 16) | (rB << 11));
     }
 
-    void dcbtst (GPR rA, GPR rB) { // Data cache block touch for store
-        write32 (0x7C0001EC | (rA << 16) | (rB << 11));
+    constexpr auto dcbtst (GPR rA, GPR rB) { // Data cache block touch for store
+        return emit (0x7C0001EC | (rA << 16) | (rB << 11));
     }
 
-    void dcbz (GPR rA, GPR rB) { // Data cache block clear to zero (Also known as: Thanos snap)
-        write32 (0x7C0007EC | (rA << 16) | (rB << 11));
+    constexpr auto dcbz (GPR rA, GPR rB) { // Data cache block clear to zero (Also known as: Thanos snap)
+        return emit (0x7C0007EC | (rA << 16) | (rB << 11));
     }
 
-    void dcbz_l (GPR rA, GPR rB) { // Data cache block clear to zero locked
-        write32 (0x100007EC | (rA << 16) | (rB << 11));
+    constexpr auto dcbz_l (GPR rA, GPR rB) { // Data cache block clear to zero locked
+        return emit (0x100007EC | (rA << 16) | (rB << 11));
     }
 
-    void tlbie (GPR base) { // TLB invalidate entry
-        write32 (0x7C000264 | (base << 11));
+    constexpr auto tlbie (GPR base) { // TLB invalidate entry
+        return emit (0x7C000264 | (base << 11));
     }
 
-    void tlbsync() { write32 (0x7C00046C); } // TLB synchronize
-    void eieio() { write32 (0x7C0006AC); } // Enforce in-order execution of I/O
-    void isync() { write32 (0x4C00012C); } // Instruction synchronize
-    void sync()  { write32 (0x7C0004AC); } // Synchronize
-    void rfi()   { write32 (0x4C000064); } // Return from interrupt
-    void sc()    { write32 (0x44000002); } // System call
-
-    void dump (std::string path) {
-        const uint32_t size = getCodeSize();
-        std::ofstream file (path, std::ios::binary);
-        file.write ((const char*) code, size);
-        printf ("Dumped %u bytes\n", size);
-    }
+    constexpr auto tlbsync() { return emit (0x7C00046C); } // TLB synchronize
+    constexpr auto eieio() { return emit (0x7C0006AC); } // Enforce in-order execution of I/O
+    constexpr auto isync() { return emit (0x4C00012C); } // Instruction synchronize
+    constexpr auto sync()  { return emit (0x7C0004AC); } // Synchronize
+    constexpr auto lwsync() { return emit (0x7C2004AC); } // Lightweight synchronize (executes as a full sync on cores that lack it, like the 750 family)
+    constexpr auto rfi()   { return emit (0x4C000064); } // Return from interrupt
+    constexpr auto sc()    { return emit (0x44000002); } // System call
 
     // System-specific extensions
     // IBM Gekko/Broadway SIMD instruction set (Paired Singles)
     template <bool setFlags = false>
-    void ps_abs (FPR dest, FPR src) { // Paired single absolute value
-        write32 (0x10000210 | (dest << 21) | (src << 11) | setFlags);
+    constexpr auto ps_abs (FPR dest, FPR src) { // Paired single absolute value
+        return emit (0x10000210 | (dest << 21) | (src << 11) | setFlags);
     }
 
     template <bool setFlags = false>
-    void ps_add (FPR dest, FPR src1, FPR src2) { // Paired single add
-        write32 (0x1000002A | (dest << 21) | (src1 << 16) | (src2 << 11) | setFlags);
+    constexpr auto ps_add (FPR dest, FPR src1, FPR src2) { // Paired single add
+        return emit (0x1000002A | (dest << 21) | (src1 << 16) | (src2 << 11) | setFlags);
     }
 
-    void ps_cmpo0 (CR dest, FPR src1, FPR src2) { // Paired single compare ordered high
-        write32 (0x10000040 | (dest << 23) | (src1 << 16) | (src2 << 11));
+    constexpr auto ps_cmpo0 (CR dest, FPR src1, FPR src2) { // Paired single compare ordered high
+        return emit (0x10000040 | (dest << 23) | (src1 << 16) | (src2 << 11));
     }
 
-    void ps_cmpo1 (CR dest, FPR src1, FPR src2) { // Paired single compare ordered low
-        write32 (0x100000C0 | (dest << 23) | (src1 << 16) | (src2 << 11));
+    constexpr auto ps_cmpo1 (CR dest, FPR src1, FPR src2) { // Paired single compare ordered low
+        return emit (0x100000C0 | (dest << 23) | (src1 << 16) | (src2 << 11));
     }
 
-    void ps_cmpu0 (CR dest, FPR src1, FPR src2) { // Paired single compare unordered high
-        write32 (0x10000000 | (dest << 23) | (src1 << 16) | (src2 << 11));
+    constexpr auto ps_cmpu0 (CR dest, FPR src1, FPR src2) { // Paired single compare unordered high
+        return emit (0x10000000 | (dest << 23) | (src1 << 16) | (src2 << 11));
     }
 
-    void ps_cmpu1 (CR dest, FPR src1, FPR src2) { // Paired single compare unordered low
-        write32 (0x10000080 | (dest << 23) | (src1 << 16) | (src2 << 11));
+    constexpr auto ps_cmpu1 (CR dest, FPR src1, FPR src2) { // Paired single compare unordered low
+        return emit (0x10000080 | (dest << 23) | (src1 << 16) | (src2 << 11));
     }
 
     template <bool setFlags = false>
-    void ps_div (FPR dest, FPR dividend, FPR divisor) { // Paired single divide
-        write32 (0x10000024 | (dest << 21) | (dividend << 16) | (divisor << 11) | setFlags);
+    constexpr auto ps_div (FPR dest, FPR dividend, FPR divisor) { // Paired single divide
+        return emit (0x10000024 | (dest << 21) | (dividend << 16) | (divisor << 11) | setFlags);
     }
 
     template <bool setFlags = false>
-    void ps_madd (FPR dest, FPR op1, FPR op2, FPR op3) { // Paired single multiply-add scalar high
-        write32 (0x1000003A | (dest << 21) | (op1 << 16) | (op3 << 11) | (op2 << 6) | setFlags);
+    constexpr auto ps_madd (FPR dest, FPR op1, FPR op2, FPR op3) { // Paired single multiply-add scalar high
+        return emit (0x1000003A | (dest << 21) | (op1 << 16) | (op3 << 11) | (op2 << 6) | setFlags);
     }
 
     template <bool setFlags = false>
-    void ps_madds0 (FPR dest, FPR op1, FPR op2, FPR op3) { // Paired single multiply-add scalar high
-        write32 (0x1000001C | (dest << 21) | (op1 << 16) | (op3 << 11) | (op2 << 6) | setFlags);
+    constexpr auto ps_madds0 (FPR dest, FPR op1, FPR op2, FPR op3) { // Paired single multiply-add scalar high
+        return emit (0x1000001C | (dest << 21) | (op1 << 16) | (op3 << 11) | (op2 << 6) | setFlags);
     }
 
     template <bool setFlags = false>
-    void ps_madds1 (FPR dest, FPR op1, FPR op2, FPR op3) { // Paired single multiply-add scalar low
-        write32 (0x1000001E | (dest << 21) | (op1 << 16) | (op3 << 11) | (op2 << 6) | setFlags);
+    constexpr auto ps_madds1 (FPR dest, FPR op1, FPR op2, FPR op3) { // Paired single multiply-add scalar low
+        return emit (0x1000001E | (dest << 21) | (op1 << 16) | (op3 << 11) | (op2 << 6) | setFlags);
     }
 
     template <bool setFlags = false>
-    void ps_merge00 (FPR dest, FPR src1, FPR src2) { // Paired single merge high
-        write32 (0x10000420 | (dest << 21) | (src1 << 16) | (src2 << 11) | setFlags);
+    constexpr auto ps_merge00 (FPR dest, FPR src1, FPR src2) { // Paired single merge high
+        return emit (0x10000420 | (dest << 21) | (src1 << 16) | (src2 << 11) | setFlags);
     }
 
     template <bool setFlags = false>
-    void ps_merge01 (FPR dest, FPR src1, FPR src2) { // Paired single merge direct
-        write32 (0x10000460 | (dest << 21) | (src1 << 16) | (src2 << 11) | setFlags);
+    constexpr auto ps_merge01 (FPR dest, FPR src1, FPR src2) { // Paired single merge direct
+        return emit (0x10000460 | (dest << 21) | (src1 << 16) | (src2 << 11) | setFlags);
     }
 
     template <bool setFlags = false>
-    void ps_merge10 (FPR dest, FPR src1, FPR src2) { // Paired single merge swapped
-        write32 (0x100004A0 | (dest << 21) | (src1 << 16) | (src2 << 11) | setFlags);
+    constexpr auto ps_merge10 (FPR dest, FPR src1, FPR src2) { // Paired single merge swapped
+        return emit (0x100004A0 | (dest << 21) | (src1 << 16) | (src2 << 11) | setFlags);
     }
 
     template <bool setFlags = false>
-    void ps_merge11 (FPR dest, FPR src1, FPR src2) { // Paired single merge low
-        write32 (0x100004E0 | (dest << 21) | (src1 << 16) | (src2 << 11) | setFlags);
+    constexpr auto ps_merge11 (FPR dest, FPR src1, FPR src2) { // Paired single merge low
+        return emit (0x100004E0 | (dest << 21) | (src1 << 16) | (src2 << 11) | setFlags);
     }
 
     template <bool setFlags = false>
-    void ps_mr (FPR dest, FPR src) { // Paired snigle move register
-        write32 (0x10000090 | (dest << 21) | (src << 11) | setFlags);
+    constexpr auto ps_mr (FPR dest, FPR src) { // Paired snigle move register
+        return emit (0x10000090 | (dest << 21) | (src << 11) | setFlags);
     }
 
     template <bool setFlags = false>
-    void ps_msub (FPR dest, FPR op1, FPR op2, FPR op3) { // Paired single multiply-subtract
-        write32 (0x10000038 | (dest << 21) | (op1 << 16) | (op3 << 11) | (op2 << 6) | setFlags);
+    constexpr auto ps_msub (FPR dest, FPR op1, FPR op2, FPR op3) { // Paired single multiply-subtract
+        return emit (0x10000038 | (dest << 21) | (op1 << 16) | (op3 << 11) | (op2 << 6) | setFlags);
     }
 
     template <bool setFlags = false>
-    void ps_mul (FPR dest, FPR src1, FPR src2) { // Paired single add
-        write32 (0x10000032 | (dest << 21) | (src1 << 16) | (src2 << 6) | setFlags);
+    constexpr auto ps_mul (FPR dest, FPR src1, FPR src2) { // Paired single add
+        return emit (0x10000032 | (dest << 21) | (src1 << 16) | (src2 << 6) | setFlags);
     }
 
     template <bool setFlags = false>
-    void ps_muls0 (FPR dest, FPR src1, FPR src2) { // Paired single multiply scalar high
-        write32 (0x10000018 | (dest << 21) | (src1 << 16) | (src2 << 6) | setFlags);
+    constexpr auto ps_muls0 (FPR dest, FPR src1, FPR src2) { // Paired single multiply scalar high
+        return emit (0x10000018 | (dest << 21) | (src1 << 16) | (src2 << 6) | setFlags);
     }
 
     template <bool setFlags = false>
-    void ps_muls1 (FPR dest, FPR src1, FPR src2) { // Paired single multiply scalar high
-        write32 (0x1000001A | (dest << 21) | (src1 << 16) | (src2 << 6) | setFlags);
+    constexpr auto ps_muls1 (FPR dest, FPR src1, FPR src2) { // Paired single multiply scalar high
+        return emit (0x1000001A | (dest << 21) | (src1 << 16) | (src2 << 6) | setFlags);
     }
 
     template <bool setFlags = false>
-    void ps_nabs (FPR dest, FPR src) { // Paired single negative absolute value
-        write32 (0x10000110 | (dest << 21) | (src << 11) | setFlags);
+    constexpr auto ps_nabs (FPR dest, FPR src) { // Paired single negative absolute value
+        return emit (0x10000110 | (dest << 21) | (src << 11) | setFlags);
     }
 
     template <bool setFlags = false>
-    void ps_neg (FPR dest, FPR src) { // Paired single negative
-        write32 (0x10000050 | (dest << 21) | (src << 11) | setFlags);
+    constexpr auto ps_neg (FPR dest, FPR src) { // Paired single negative
+        return emit (0x10000050 | (dest << 21) | (src << 11) | setFlags);
     }
 
     template <bool setFlags = false>
-    void ps_nmadd (FPR dest, FPR op1, FPR op2, FPR op3) { // Paired single negative multiply add
-        write32 (0x1000003E | (dest << 21) | (op1 << 16) | (op3 << 11) | (op2 << 6) | setFlags);
+    constexpr auto ps_nmadd (FPR dest, FPR op1, FPR op2, FPR op3) { // Paired single negative multiply add
+        return emit (0x1000003E | (dest << 21) | (op1 << 16) | (op3 << 11) | (op2 << 6) | setFlags);
     }
 
     template <bool setFlags = false>
-    void ps_nmsub (FPR dest, FPR op1, FPR op2, FPR op3) { // Paired single negative multiply add
-        write32 (0x1000003C | (dest << 21) | (op1 << 16) | (op3 << 11) | (op2 << 6) | setFlags);
+    constexpr auto ps_nmsub (FPR dest, FPR op1, FPR op2, FPR op3) { // Paired single negative multiply add
+        return emit (0x1000003C | (dest << 21) | (op1 << 16) | (op3 << 11) | (op2 << 6) | setFlags);
     }
     
     template <bool setFlags = false>
-    void ps_res (FPR dest, FPR src) { // Paired single reciprocal estimate
-        write32 (0x10000030 | (dest << 21) | (src << 11) | setFlags);
+    constexpr auto ps_res (FPR dest, FPR src) { // Paired single reciprocal estimate
+        return emit (0x10000030 | (dest << 21) | (src << 11) | setFlags);
     }
 
     template <bool setFlags = false>
-    void ps_rsqrte (FPR dest, FPR src) { // Paired single reciprocal square root estimate
-        write32 (0x10000034 | (dest << 21) | (src << 11) | setFlags);
+    constexpr auto ps_rsqrte (FPR dest, FPR src) { // Paired single reciprocal square root estimate
+        return emit (0x10000034 | (dest << 21) | (src << 11) | setFlags);
     }
 
     template <bool setFlags = false>
-    void ps_sel (FPR dest, FPR op1, FPR op2, FPR op3) { // Paired single select
-        write32 (0x1000002E | (dest << 21) | (op1 << 16) | (op3 << 11) | (op2 << 6) | setFlags);
+    constexpr auto ps_sel (FPR dest, FPR op1, FPR op2, FPR op3) { // Paired single select
+        return emit (0x1000002E | (dest << 21) | (op1 << 16) | (op3 << 11) | (op2 << 6) | setFlags);
     }
 
     template <bool setFlags = false>
-    void ps_sub (FPR dest, FPR src1, FPR src2) { // Paired single subtract
-        write32 (0x10000028 | (dest << 21) | (src1 << 16) | (src2 << 11) | setFlags);
+    constexpr auto ps_sub (FPR dest, FPR src1, FPR src2) { // Paired single subtract
+        return emit (0x10000028 | (dest << 21) | (src1 << 16) | (src2 << 11) | setFlags);
     }
 
     template <bool setFlags = false>
-    void ps_sum0 (FPR dest, FPR op1, FPR op2, FPR op3) { // Paired single vector sum high
-        write32 (0x10000014 | (dest << 21) | (op1 << 16) | (op3 << 11) | (op2 << 6) | setFlags);
+    constexpr auto ps_sum0 (FPR dest, FPR op1, FPR op2, FPR op3) { // Paired single vector sum high
+        return emit (0x10000014 | (dest << 21) | (op1 << 16) | (op3 << 11) | (op2 << 6) | setFlags);
     }
 
     template <bool setFlags = false>
-    void ps_sum1 (FPR dest, FPR op1, FPR op2, FPR op3) { // Paired single vector sum low
-        write32 (0x10000016 | (dest << 21) | (op1 << 16) | (op3 << 11) | (op2 << 6) | setFlags);
+    constexpr auto ps_sum1 (FPR dest, FPR op1, FPR op2, FPR op3) { // Paired single vector sum low
+        return emit (0x10000016 | (dest << 21) | (op1 << 16) | (op3 << 11) | (op2 << 6) | setFlags);
+    }
+
+    // Quantized loads/stores. "w" = 1 only transfers ps0 (ps1 is loaded as 1.0), "gqr" picks the conversion
+    // The offset of the D-form variants is a 12-bit signed value
+    // Quantized loads and stores only have a 12-bit displacement, so anything outside of -2048..2047 would silently wrap around
+    static constexpr uint32_t quantizedOffset (int16_t offset) {
+        if (offset < -2048 || offset > 2047)
+            panic ("[Emitter] Fatal: Quantized load/store offset %d doesn't fit in 12 bits\n", offset);
+        return offset & 0xFFF;
+    }
+
+    constexpr auto psq_l (FPR dest, GPR base, int16_t offset, bool w, GQR gqr) { // Paired single quantized load
+        return emit (0xE0000000 | (dest << 21) | (base << 16) | (w << 15) | (gqr << 12) | quantizedOffset (offset));
+    }
+
+    constexpr auto psq_lu (FPR dest, GPR base, int16_t offset, bool w, GQR gqr) { // Paired single quantized load with update
+        return emit (0xE4000000 | (dest << 21) | (base << 16) | (w << 15) | (gqr << 12) | quantizedOffset (offset));
+    }
+
+    constexpr auto psq_lx (FPR dest, GPR base, GPR index, bool w, GQR gqr) { // Paired single quantized load indexed
+        return emit (0x1000000C | (dest << 21) | (base << 16) | (index << 11) | (w << 10) | (gqr << 7));
+    }
+
+    constexpr auto psq_lux (FPR dest, GPR base, GPR index, bool w, GQR gqr) { // Paired single quantized load with update indexed
+        return emit (0x1000004C | (dest << 21) | (base << 16) | (index << 11) | (w << 10) | (gqr << 7));
+    }
+
+    constexpr auto psq_st (FPR src, GPR base, int16_t offset, bool w, GQR gqr) { // Paired single quantized store
+        return emit (0xF0000000 | (src << 21) | (base << 16) | (w << 15) | (gqr << 12) | quantizedOffset (offset));
+    }
+
+    constexpr auto psq_stu (FPR src, GPR base, int16_t offset, bool w, GQR gqr) { // Paired single quantized store with update
+        return emit (0xF4000000 | (src << 21) | (base << 16) | (w << 15) | (gqr << 12) | quantizedOffset (offset));
+    }
+
+    constexpr auto psq_stx (FPR src, GPR base, GPR index, bool w, GQR gqr) { // Paired single quantized store indexed
+        return emit (0x1000000E | (src << 21) | (base << 16) | (index << 11) | (w << 10) | (gqr << 7));
+    }
+
+    constexpr auto psq_stux (FPR src, GPR base, GPR index, bool w, GQR gqr) { // Paired single quantized store with update indexed
+        return emit (0x1000004E | (src << 21) | (base << 16) | (index << 11) | (w << 10) | (gqr << 7));
+    }
+
+    constexpr auto mtgqr (GQR gqr, GPR src) { // Move to graphics quantization register (SPRs 912-919)
+        return mtspr (912 + gqr, src);
+    }
+
+    constexpr auto mfgqr (GPR dest, GQR gqr) { // Move from graphics quantization register
+        return mfspr (dest, 912 + gqr);
+    }
+
+    constexpr void setGQR (GQR gqr, uint32_t value, GPR scratch) { // Program a GQR, eg setGQR (gqr2, makeGQR (QuantType::U8, 0, QuantType::U8, 0), r3)
+        liw (scratch, value);
+        mtgqr (gqr, scratch);
     }
 
     // AltiVec SIMD ISA
 
-    void vmhaddshs (VR dest, VR op1, VR op2, VR op3) { // Vector Multiply High and Add Signed Half Word Saturate
-        write32 (0x10000020 | (dest << 21) | (op1 << 16) | (op2 << 11) | (op3 << 6));
+    constexpr auto vmhaddshs (VR dest, VR op1, VR op2, VR op3) { // Vector Multiply High and Add Signed Half Word Saturate
+        return emit (0x10000020 | (dest << 21) | (op1 << 16) | (op2 << 11) | (op3 << 6));
     }
     
-    void vmhraddshs (VR dest, VR op1, VR op2, VR op3) { // Vector Multiply High Round and Add Signed Half Word Saturate
-        write32 (0x10000021 | (dest << 21) | (op1 << 16) | (op2 << 11) | (op3 << 6));
+    constexpr auto vmhraddshs (VR dest, VR op1, VR op2, VR op3) { // Vector Multiply High Round and Add Signed Half Word Saturate
+        return emit (0x10000021 | (dest << 21) | (op1 << 16) | (op2 << 11) | (op3 << 6));
     }
     
-    void vmladdshs (VR dest, VR op1, VR op2, VR op3) { // Vector Multiply Low and Add Signed Half Word Saturate
-        write32 (0x10000022 | (dest << 21) | (op1 << 16) | (op2 << 11) | (op3 << 6));
+    constexpr auto vmladdshs (VR dest, VR op1, VR op2, VR op3) { // Vector Multiply Low and Add Signed Half Word Saturate
+        return emit (0x10000022 | (dest << 21) | (op1 << 16) | (op2 << 11) | (op3 << 6));
     }
     
-    void vmsumubm (VR dest, VR op1, VR op2, VR op3) { // Vector Multiply Sum Unsigned Byte Modulo
-        write32 (0x10000024 | (dest << 21) | (op1 << 16) | (op2 << 11) | (op3 << 6));
+    constexpr auto vmsumubm (VR dest, VR op1, VR op2, VR op3) { // Vector Multiply Sum Unsigned Byte Modulo
+        return emit (0x10000024 | (dest << 21) | (op1 << 16) | (op2 << 11) | (op3 << 6));
     }
     
-    void vmsummbm (VR dest, VR op1, VR op2, VR op3) { // Vector Multiply Sum Mixed-Sign Byte Modulo
-        write32 (0x10000025 | (dest << 21) | (op1 << 16) | (op2 << 11) | (op3 << 6));
+    constexpr auto vmsummbm (VR dest, VR op1, VR op2, VR op3) { // Vector Multiply Sum Mixed-Sign Byte Modulo
+        return emit (0x10000025 | (dest << 21) | (op1 << 16) | (op2 << 11) | (op3 << 6));
     }
     
-    void vmsumuhm (VR dest, VR op1, VR op2, VR op3) { // Vector Multiply Sum Unsigned Half Word Modulo
-        write32 (0x10000026 | (dest << 21) | (op1 << 16) | (op2 << 11) | (op3 << 6));
+    constexpr auto vmsumuhm (VR dest, VR op1, VR op2, VR op3) { // Vector Multiply Sum Unsigned Half Word Modulo
+        return emit (0x10000026 | (dest << 21) | (op1 << 16) | (op2 << 11) | (op3 << 6));
     }
     
-    void vmsumuhs (VR dest, VR op1, VR op2, VR op3) { // Vector Multiply Sum unsigned Half Word Saturate
-        write32 (0x10000027 | (dest << 21) | (op1 << 16) | (op2 << 11) | (op3 << 6));
+    constexpr auto vmsumuhs (VR dest, VR op1, VR op2, VR op3) { // Vector Multiply Sum unsigned Half Word Saturate
+        return emit (0x10000027 | (dest << 21) | (op1 << 16) | (op2 << 11) | (op3 << 6));
     }
     
-    void vmsumshm (VR dest, VR op1, VR op2, VR op3) { // Vector Multiply Sum Signed Half Word Modulo
-        write32 (0x10000028 | (dest << 21) | (op1 << 16) | (op2 << 11) | (op3 << 6));
+    constexpr auto vmsumshm (VR dest, VR op1, VR op2, VR op3) { // Vector Multiply Sum Signed Half Word Modulo
+        return emit (0x10000028 | (dest << 21) | (op1 << 16) | (op2 << 11) | (op3 << 6));
     }
     
-    void vmsumshs (VR dest, VR op1, VR op2, VR op3) { // Vector Multiply Sum Signed Half Word Saturate
-        write32 (0x10000029 | (dest << 21) | (op1 << 16) | (op2 << 11) | (op3 << 6));
+    constexpr auto vmsumshs (VR dest, VR op1, VR op2, VR op3) { // Vector Multiply Sum Signed Half Word Saturate
+        return emit (0x10000029 | (dest << 21) | (op1 << 16) | (op2 << 11) | (op3 << 6));
     }
     
-    void vsel (VR dest, VR op1, VR op2, VR op3) { // Vector Conditional Select
-        write32 (0x1000002A | (dest << 21) | (op1 << 16) | (op2 << 11) | (op3 << 6));
+    constexpr auto vsel (VR dest, VR op1, VR op2, VR op3) { // Vector Conditional Select
+        return emit (0x1000002A | (dest << 21) | (op1 << 16) | (op2 << 11) | (op3 << 6));
     }
 
-    void vperm (VR dest, VR op1, VR op2, VR op3) { // Vector Permute
-        write32 (0x1000002B | (dest << 21) | (op1 << 16) | (op2 << 11) | (op3 << 6));
+    constexpr auto vperm (VR dest, VR op1, VR op2, VR op3) { // Vector Permute
+        return emit (0x1000002B | (dest << 21) | (op1 << 16) | (op2 << 11) | (op3 << 6));
     }
 
-    void vsldoi (VR dest, VR op1, VR op2, uint8_t shift) { // Vector Shift Left Double by Octet Immediate
-        write32 (0x1000002C | (dest << 21) | (op1 << 16) | (op2 << 11) | (shift << 6));
+    constexpr auto vsldoi (VR dest, VR op1, VR op2, uint8_t shift) { // Vector Shift Left Double by Octet Immediate
+        return emit (0x1000002C | (dest << 21) | (op1 << 16) | (op2 << 11) | (shift << 6));
     }
 
-    void vmaddfp (VR dest, VR op1, VR op2, VR op3) { // Vector Multiply Add Floating-Point
-        write32 (0x1000002E | (dest << 21) | (op1 << 16) | (op2 << 11) | (op3 << 6));
+    constexpr auto vmaddfp (VR dest, VR op1, VR op2, VR op3) { // Vector Multiply Add Floating-Point
+        return emit (0x1000002E | (dest << 21) | (op1 << 16) | (op2 << 11) | (op3 << 6));
     }
 
-    void vnmsubfp (VR dest, VR op1, VR op2, VR op3) { // Vector Negative Multiply-Subtract Floating-Point
-        write32 (0x1000002F | (dest << 21) | (op1 << 16) | (op2 << 11) | (op3 << 6));
+    constexpr auto vnmsubfp (VR dest, VR op1, VR op2, VR op3) { // Vector Negative Multiply-Subtract Floating-Point
+        return emit (0x1000002F | (dest << 21) | (op1 << 16) | (op2 << 11) | (op3 << 6));
     }
 
-    void vaddubm (VR dest, VR op1, VR op2) { // Vector Add Unsigned Byte Modulo
-        write32 (0x10000000 | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vaddubm (VR dest, VR op1, VR op2) { // Vector Add Unsigned Byte Modulo
+        return emit (0x10000000 | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vadduhm (VR dest, VR op1, VR op2) { // Vector Add Unsigned Half Word Modulo
-        write32 (0x10000040 | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vadduhm (VR dest, VR op1, VR op2) { // Vector Add Unsigned Half Word Modulo
+        return emit (0x10000040 | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vadduwm (VR dest, VR op1, VR op2) { // Vector Add Unsigned Word Modulo
-        write32 (0x10000080 | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vadduwm (VR dest, VR op1, VR op2) { // Vector Add Unsigned Word Modulo
+        return emit (0x10000080 | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vaddcuw (VR dest, VR op1, VR op2) { // Vector Add Carryout Unsigned Word
-        write32 (0x10000180 | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vaddcuw (VR dest, VR op1, VR op2) { // Vector Add Carryout Unsigned Word
+        return emit (0x10000180 | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vaddubs (VR dest, VR op1, VR op2) { // Vector Add Unsigned Byte Saturate
-        write32 (0x10000200 | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vaddubs (VR dest, VR op1, VR op2) { // Vector Add Unsigned Byte Saturate
+        return emit (0x10000200 | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vadduhs (VR dest, VR op1, VR op2) { // Vector Add Unsigned Half Word Saturate
-        write32 (0x10000240 | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vadduhs (VR dest, VR op1, VR op2) { // Vector Add Unsigned Half Word Saturate
+        return emit (0x10000240 | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vadduws (VR dest, VR op1, VR op2) { // Vector Add Unsigned Word Saturate
-        write32 (0x10000280 | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vadduws (VR dest, VR op1, VR op2) { // Vector Add Unsigned Word Saturate
+        return emit (0x10000280 | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vaddsbs (VR dest, VR op1, VR op2) { // Vector Add Signed Byte Saturate
-        write32 (0x10000300 | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vaddsbs (VR dest, VR op1, VR op2) { // Vector Add Signed Byte Saturate
+        return emit (0x10000300 | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vaddshs (VR dest, VR op1, VR op2) { // Vector Add Signed Half Word Saturate
-        write32 (0x10000340 | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vaddshs (VR dest, VR op1, VR op2) { // Vector Add Signed Half Word Saturate
+        return emit (0x10000340 | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vaddsws (VR dest, VR op1, VR op2) { // Vector Add Signed Word Saturate
-        write32 (0x10000380 | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vaddsws (VR dest, VR op1, VR op2) { // Vector Add Signed Word Saturate
+        return emit (0x10000380 | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vsububm (VR dest, VR op1, VR op2) { // Vector Subtract Unsigned Byte Modulo
-        write32 (0x10000400 | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vsububm (VR dest, VR op1, VR op2) { // Vector Subtract Unsigned Byte Modulo
+        return emit (0x10000400 | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vsubuhm (VR dest, VR op1, VR op2) { // Vector Subtract Unsigned Half Word Modulo
-        write32 (0x10000440 | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vsubuhm (VR dest, VR op1, VR op2) { // Vector Subtract Unsigned Half Word Modulo
+        return emit (0x10000440 | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vsubuwm (VR dest, VR op1, VR op2) { // Vector Subtract Unsigned Word Modulo
-        write32 (0x10000480 | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vsubuwm (VR dest, VR op1, VR op2) { // Vector Subtract Unsigned Word Modulo
+        return emit (0x10000480 | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vsubcuw (VR dest, VR op1, VR op2) { // Vector Subtract Carryout Unsigned Word
-        write32 (0x10000580 | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vsubcuw (VR dest, VR op1, VR op2) { // Vector Subtract Carryout Unsigned Word
+        return emit (0x10000580 | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vsububs (VR dest, VR op1, VR op2) { // Vector Subtract Unsigned Byte Saturate
-        write32 (0x10000600 | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vsububs (VR dest, VR op1, VR op2) { // Vector Subtract Unsigned Byte Saturate
+        return emit (0x10000600 | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vsubuhs (VR dest, VR op1, VR op2) { // Vector Subtract Unsigned Half Word Saturate
-        write32 (0x10000640 | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vsubuhs (VR dest, VR op1, VR op2) { // Vector Subtract Unsigned Half Word Saturate
+        return emit (0x10000640 | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vsubuws (VR dest, VR op1, VR op2) { // Vector Subtract Unsigned Word Saturate
-        write32 (0x10000680 | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vsubuws (VR dest, VR op1, VR op2) { // Vector Subtract Unsigned Word Saturate
+        return emit (0x10000680 | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vsubsbs (VR dest, VR op1, VR op2) { // Vector Subtract Signed Byte Saturate
-        write32 (0x10000700 | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vsubsbs (VR dest, VR op1, VR op2) { // Vector Subtract Signed Byte Saturate
+        return emit (0x10000700 | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vsubshs (VR dest, VR op1, VR op2) { // Vector Subtract Signed Half Word Saturate
-        write32 (0x10000740 | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vsubshs (VR dest, VR op1, VR op2) { // Vector Subtract Signed Half Word Saturate
+        return emit (0x10000740 | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vsubsws (VR dest, VR op1, VR op2) { // Vector Subtract Signed Word Saturate
-        write32 (0x10000780 | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vsubsws (VR dest, VR op1, VR op2) { // Vector Subtract Signed Word Saturate
+        return emit (0x10000780 | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vmaxub (VR dest, VR op1, VR op2) { // Vector Maximum Unsigned Byte
-        write32 (0x10000002 | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vmaxub (VR dest, VR op1, VR op2) { // Vector Maximum Unsigned Byte
+        return emit (0x10000002 | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vmaxuh (VR dest, VR op1, VR op2) { // Vector Maximum Unsigned Half Word
-        write32 (0x10000042 | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vmaxuh (VR dest, VR op1, VR op2) { // Vector Maximum Unsigned Half Word
+        return emit (0x10000042 | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vmaxuw (VR dest, VR op1, VR op2) { // Vector Maximum Unsigned Word
-        write32 (0x10000082 | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vmaxuw (VR dest, VR op1, VR op2) { // Vector Maximum Unsigned Word
+        return emit (0x10000082 | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vmaxsb (VR dest, VR op1, VR op2) { // Vector Maximum Signed Byte
-        write32 (0x10000102 | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vmaxsb (VR dest, VR op1, VR op2) { // Vector Maximum Signed Byte
+        return emit (0x10000102 | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vmaxsh (VR dest, VR op1, VR op2) { // Vector Maximum Signed Half Word
-        write32 (0x10000142 | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vmaxsh (VR dest, VR op1, VR op2) { // Vector Maximum Signed Half Word
+        return emit (0x10000142 | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vmaxsw (VR dest, VR op1, VR op2) { // Vector Maximum Signed Word
-        write32 (0x10000182 | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vmaxsw (VR dest, VR op1, VR op2) { // Vector Maximum Signed Word
+        return emit (0x10000182 | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vminub (VR dest, VR op1, VR op2) { // Vector Minimum Unsigned Byte
-        write32 (0x10000202 | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vminub (VR dest, VR op1, VR op2) { // Vector Minimum Unsigned Byte
+        return emit (0x10000202 | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vminuh (VR dest, VR op1, VR op2) { // Vector Minimum Unsigned Half Word
-        write32 (0x10000242 | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vminuh (VR dest, VR op1, VR op2) { // Vector Minimum Unsigned Half Word
+        return emit (0x10000242 | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vminuw (VR dest, VR op1, VR op2) { // Vector Minimum Unsigned Word
-        write32 (0x10000282 | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vminuw (VR dest, VR op1, VR op2) { // Vector Minimum Unsigned Word
+        return emit (0x10000282 | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vminsb (VR dest, VR op1, VR op2) { // Vector Minimum Signed Byte
-        write32 (0x10000302 | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vminsb (VR dest, VR op1, VR op2) { // Vector Minimum Signed Byte
+        return emit (0x10000302 | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vminsh (VR dest, VR op1, VR op2) { // Vector Minimum Signed Half Word
-        write32 (0x10000342 | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vminsh (VR dest, VR op1, VR op2) { // Vector Minimum Signed Half Word
+        return emit (0x10000342 | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vminsw (VR dest, VR op1, VR op2) { // Vector Minimum Signed Word
-        write32 (0x10000382 | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vminsw (VR dest, VR op1, VR op2) { // Vector Minimum Signed Word
+        return emit (0x10000382 | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vavgub (VR dest, VR op1, VR op2) { // Vector Average Unsigned Byte
-        write32 (0x10000402 | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vavgub (VR dest, VR op1, VR op2) { // Vector Average Unsigned Byte
+        return emit (0x10000402 | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vavguh (VR dest, VR op1, VR op2) { // Vector Average Unsigned Half Word
-        write32 (0x10000442 | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vavguh (VR dest, VR op1, VR op2) { // Vector Average Unsigned Half Word
+        return emit (0x10000442 | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vavguw (VR dest, VR op1, VR op2) { // Vector Average Unsigned Word
-        write32 (0x10000482 | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vavguw (VR dest, VR op1, VR op2) { // Vector Average Unsigned Word
+        return emit (0x10000482 | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vavgsb (VR dest, VR op1, VR op2) { // Vector Average Signed Byte
-        write32 (0x10000502 | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vavgsb (VR dest, VR op1, VR op2) { // Vector Average Signed Byte
+        return emit (0x10000502 | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vavgsh (VR dest, VR op1, VR op2) { // Vector Average Signed Half Word
-        write32 (0x10000542 | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vavgsh (VR dest, VR op1, VR op2) { // Vector Average Signed Half Word
+        return emit (0x10000542 | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vavgsw (VR dest, VR op1, VR op2) { // Vector Average Signed Word
-        write32 (0x10000582 | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vavgsw (VR dest, VR op1, VR op2) { // Vector Average Signed Word
+        return emit (0x10000582 | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vrlb (VR dest, VR op1, VR op2) { // Vector Rotate Left Integer Byte
-        write32 (0x10000004 | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vrlb (VR dest, VR op1, VR op2) { // Vector Rotate Left Integer Byte
+        return emit (0x10000004 | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vrlh (VR dest, VR op1, VR op2) { // Vector Rotate Left Integer Half Word
-        write32 (0x10000044 | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vrlh (VR dest, VR op1, VR op2) { // Vector Rotate Left Integer Half Word
+        return emit (0x10000044 | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vrlw (VR dest, VR op1, VR op2) { // Vector Rotate Left Integer Word
-        write32 (0x10000084 | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vrlw (VR dest, VR op1, VR op2) { // Vector Rotate Left Integer Word
+        return emit (0x10000084 | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vslb (VR dest, VR op1, VR op2) { // Vector Shift Left Integer Byte
-        write32 (0x10000104 | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vslb (VR dest, VR op1, VR op2) { // Vector Shift Left Integer Byte
+        return emit (0x10000104 | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vslh (VR dest, VR op1, VR op2) { // Vector Shift Left Integer Half Word
-        write32 (0x10000144 | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vslh (VR dest, VR op1, VR op2) { // Vector Shift Left Integer Half Word
+        return emit (0x10000144 | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vslw (VR dest, VR op1, VR op2) { // Vector Shift Left Integer Word
-        write32 (0x10000184 | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vslw (VR dest, VR op1, VR op2) { // Vector Shift Left Integer Word
+        return emit (0x10000184 | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vsl (VR dest, VR op1, VR op2) { // Vector Shift Left
-        write32 (0x100001C4 | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vsl (VR dest, VR op1, VR op2) { // Vector Shift Left
+        return emit (0x100001C4 | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vsrb (VR dest, VR op1, VR op2) { // Vector Shift Right Integer Byte
-        write32 (0x10000204 | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vsrb (VR dest, VR op1, VR op2) { // Vector Shift Right Integer Byte
+        return emit (0x10000204 | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vsrh (VR dest, VR op1, VR op2) { // Vector Shift Right Integer Half Word
-        write32 (0x10000244 | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vsrh (VR dest, VR op1, VR op2) { // Vector Shift Right Integer Half Word
+        return emit (0x10000244 | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vsrw (VR dest, VR op1, VR op2) { // Vector Shift Right Integer Word
-        write32 (0x10000284 | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vsrw (VR dest, VR op1, VR op2) { // Vector Shift Right Integer Word
+        return emit (0x10000284 | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vsr (VR dest, VR op1, VR op2) { // Vector Shift Right
-        write32 (0x100002C4 | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vsr (VR dest, VR op1, VR op2) { // Vector Shift Right
+        return emit (0x100002C4 | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vsrab (VR dest, VR op1, VR op2) { // Vector Shift Right Algebraic Integer Byte
-        write32 (0x10000304 | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vsrab (VR dest, VR op1, VR op2) { // Vector Shift Right Algebraic Integer Byte
+        return emit (0x10000304 | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vsrah (VR dest, VR op1, VR op2) { // Vector Shift Right Algebraic Integer Half Word
-        write32 (0x10000344 | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vsrah (VR dest, VR op1, VR op2) { // Vector Shift Right Algebraic Integer Half Word
+        return emit (0x10000344 | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vsraw (VR dest, VR op1, VR op2) { // Vector Shift Right Algebraic Integer Word
-        write32 (0x10000384 | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vsraw (VR dest, VR op1, VR op2) { // Vector Shift Right Algebraic Integer Word
+        return emit (0x10000384 | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vand (VR dest, VR op1, VR op2) { // Vector Logical AND
-        write32 (0x10000404 | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vand (VR dest, VR op1, VR op2) { // Vector Logical AND
+        return emit (0x10000404 | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vandc (VR dest, VR op1, VR op2) { // Vector Logical AND with Complement
-        write32 (0x10000444 | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vandc (VR dest, VR op1, VR op2) { // Vector Logical AND with Complement
+        return emit (0x10000444 | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vor (VR dest, VR op1, VR op2) { // Vector Logical OR
-        write32 (0x10000484 | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vor (VR dest, VR op1, VR op2) { // Vector Logical OR
+        return emit (0x10000484 | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vxor (VR dest, VR op1, VR op2) { // Vector Logical XOR
-        write32 (0x100004C4 | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vxor (VR dest, VR op1, VR op2) { // Vector Logical XOR
+        return emit (0x100004C4 | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vnor (VR dest, VR op1, VR op2) { // Vector Logical NOR
-        write32 (0x10000504 | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vnor (VR dest, VR op1, VR op2) { // Vector Logical NOR
+        return emit (0x10000504 | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void mfvscr (VR dest) { // Move from Vector Status and Control Register
-        write32 (0x10000604 | (dest << 21));
+    constexpr auto mfvscr (VR dest) { // Move from Vector Status and Control Register
+        return emit (0x10000604 | (dest << 21));
     }
 
-    void mtvscr (VR dest) { // Move to Vector Status and Control Register
-        write32 (0x10000644 | (dest << 21));
+    constexpr auto mtvscr (VR src) { // Move to Vector Status and Control Register
+        return emit (0x10000644 | (src << 11));
     }
 
     template <bool setFlags = false>
-    void vcmpequb (VR dest, VR op1, VR op2) { // Vector Compare Equal-to Unsigned Byte
-        write32 (0x10000006 | (dest << 21) | (op1 << 16) | (op2 << 11) | (setFlags << 10));
+    constexpr auto vcmpequb (VR dest, VR op1, VR op2) { // Vector Compare Equal-to Unsigned Byte
+        return emit (0x10000006 | (dest << 21) | (op1 << 16) | (op2 << 11) | (setFlags << 10));
     }
 
     template <bool setFlags = false>
-    void vcmpequh (VR dest, VR op1, VR op2) { // Vector Compare Equal-to Unsigned Half Word
-        write32 (0x10000046 | (dest << 21) | (op1 << 16) | (op2 << 11) | (setFlags << 10));
+    constexpr auto vcmpequh (VR dest, VR op1, VR op2) { // Vector Compare Equal-to Unsigned Half Word
+        return emit (0x10000046 | (dest << 21) | (op1 << 16) | (op2 << 11) | (setFlags << 10));
     }
 
     template <bool setFlags = false>
-    void vcmpequw (VR dest, VR op1, VR op2) { // Vector Compare Equal-to Unsigned Word
-        write32 (0x10000086 | (dest << 21) | (op1 << 16) | (op2 << 11) | (setFlags << 10));
+    constexpr auto vcmpequw (VR dest, VR op1, VR op2) { // Vector Compare Equal-to Unsigned Word
+        return emit (0x10000086 | (dest << 21) | (op1 << 16) | (op2 << 11) | (setFlags << 10));
     }
 
     template <bool setFlags = false>
-    void vcmpeqfp (VR dest, VR op1, VR op2) { // Vector Compare Equal-to Floating-point
-        write32 (0x100000C6 | (dest << 21) | (op1 << 16) | (op2 << 11) | (setFlags << 10));
+    constexpr auto vcmpeqfp (VR dest, VR op1, VR op2) { // Vector Compare Equal-to Floating-point
+        return emit (0x100000C6 | (dest << 21) | (op1 << 16) | (op2 << 11) | (setFlags << 10));
     }
 
     template <bool setFlags = false>
-    void vcmpgeub (VR dest, VR op1, VR op2) { // Vector Compare Greater-Than-or-Equal-to Unsigned Byte
-        write32 (0x10000106 | (dest << 21) | (op1 << 16) | (op2 << 11) | (setFlags << 10));
+    constexpr auto vcmpgeub (VR dest, VR op1, VR op2) { // Vector Compare Greater-Than-or-Equal-to Unsigned Byte
+        return emit (0x10000106 | (dest << 21) | (op1 << 16) | (op2 << 11) | (setFlags << 10));
     }
 
     template <bool setFlags = false>
-    void vcmpgeuh (VR dest, VR op1, VR op2) { // Vector Compare Greater-Than-or-Equal-to Unsigned Half Word
-        write32 (0x10000146 | (dest << 21) | (op1 << 16) | (op2 << 11) | (setFlags << 10));
+    constexpr auto vcmpgeuh (VR dest, VR op1, VR op2) { // Vector Compare Greater-Than-or-Equal-to Unsigned Half Word
+        return emit (0x10000146 | (dest << 21) | (op1 << 16) | (op2 << 11) | (setFlags << 10));
     }
 
     template <bool setFlags = false>
-    void vcmpgeuw (VR dest, VR op1, VR op2) { // Vector Compare Greater-Than-or-Equal-to Unsigned Word
-        write32 (0x10000186 | (dest << 21) | (op1 << 16) | (op2 << 11) | (setFlags << 10));
+    constexpr auto vcmpgeuw (VR dest, VR op1, VR op2) { // Vector Compare Greater-Than-or-Equal-to Unsigned Word
+        return emit (0x10000186 | (dest << 21) | (op1 << 16) | (op2 << 11) | (setFlags << 10));
     }
 
     template <bool setFlags = false>
-    void vcmpgefp (VR dest, VR op1, VR op2) { // Vector Compare Greater-Than-or-Equal-to Floating-point
-        write32 (0x100001C6 | (dest << 21) | (op1 << 16) | (op2 << 11) | (setFlags << 10));
+    constexpr auto vcmpgefp (VR dest, VR op1, VR op2) { // Vector Compare Greater-Than-or-Equal-to Floating-point
+        return emit (0x100001C6 | (dest << 21) | (op1 << 16) | (op2 << 11) | (setFlags << 10));
     }
 
     template <bool setFlags = false>
-    void vcmpgtub (VR dest, VR op1, VR op2) { // Vector Compare Greater-Than Unsigned Byte
-        write32 (0x10000206 | (dest << 21) | (op1 << 16) | (op2 << 11) | (setFlags << 10));
+    constexpr auto vcmpgtub (VR dest, VR op1, VR op2) { // Vector Compare Greater-Than Unsigned Byte
+        return emit (0x10000206 | (dest << 21) | (op1 << 16) | (op2 << 11) | (setFlags << 10));
     }
 
     template <bool setFlags = false>
-    void vcmpgtuh (VR dest, VR op1, VR op2) { // Vector Compare Greater-Than Unsigned Half Word
-        write32 (0x10000246 | (dest << 21) | (op1 << 16) | (op2 << 11) | (setFlags << 10));
+    constexpr auto vcmpgtuh (VR dest, VR op1, VR op2) { // Vector Compare Greater-Than Unsigned Half Word
+        return emit (0x10000246 | (dest << 21) | (op1 << 16) | (op2 << 11) | (setFlags << 10));
     }
 
     template <bool setFlags = false>
-    void vcmpgtuw (VR dest, VR op1, VR op2) { // Vector Compare Greater-Than Unsigned Word
-        write32 (0x10000286 | (dest << 21) | (op1 << 16) | (op2 << 11) | (setFlags << 10));
+    constexpr auto vcmpgtuw (VR dest, VR op1, VR op2) { // Vector Compare Greater-Than Unsigned Word
+        return emit (0x10000286 | (dest << 21) | (op1 << 16) | (op2 << 11) | (setFlags << 10));
     }
 
     template <bool setFlags = false>
-    void vcmpgtfp (VR dest, VR op1, VR op2) { // Vector Compare Greater-Than Floating-point
-        write32 (0x100002C6 | (dest << 21) | (op1 << 16) | (op2 << 11) | (setFlags << 10));
+    constexpr auto vcmpgtfp (VR dest, VR op1, VR op2) { // Vector Compare Greater-Than Floating-point
+        return emit (0x100002C6 | (dest << 21) | (op1 << 16) | (op2 << 11) | (setFlags << 10));
     }
 
     template <bool setFlags = false>
-    void vcmpgtsb (VR dest, VR op1, VR op2) { // Vector Compare Greater-Than Signed Byte
-        write32 (0x10000306 | (dest << 21) | (op1 << 16) | (op2 << 11) | (setFlags << 10));
+    constexpr auto vcmpgtsb (VR dest, VR op1, VR op2) { // Vector Compare Greater-Than Signed Byte
+        return emit (0x10000306 | (dest << 21) | (op1 << 16) | (op2 << 11) | (setFlags << 10));
     }
 
     template <bool setFlags = false>
-    void vcmpgtsh (VR dest, VR op1, VR op2) { // Vector Compare Greater-Than Signed Half Word
-        write32 (0x10000346 | (dest << 21) | (op1 << 16) | (op2 << 11) | (setFlags << 10));
+    constexpr auto vcmpgtsh (VR dest, VR op1, VR op2) { // Vector Compare Greater-Than Signed Half Word
+        return emit (0x10000346 | (dest << 21) | (op1 << 16) | (op2 << 11) | (setFlags << 10));
     }
 
     template <bool setFlags = false>
-    void vcmpgtsw (VR dest, VR op1, VR op2) { // Vector Compare Greater-Than Signed Word
-        write32 (0x10000386 | (dest << 21) | (op1 << 16) | (op2 << 11) | (setFlags << 10));
+    constexpr auto vcmpgtsw (VR dest, VR op1, VR op2) { // Vector Compare Greater-Than Signed Word
+        return emit (0x10000386 | (dest << 21) | (op1 << 16) | (op2 << 11) | (setFlags << 10));
     }
 
     template <bool setFlags = false>
-    void vcmpbfp (VR dest, VR op1, VR op2) { // Vector Compare Bounds Floating=point
-        write32 (0x100003C6 | (dest << 21) | (op1 << 16) | (op2 << 11) | (setFlags << 10));
+    constexpr auto vcmpbfp (VR dest, VR op1, VR op2) { // Vector Compare Bounds Floating=point
+        return emit (0x100003C6 | (dest << 21) | (op1 << 16) | (op2 << 11) | (setFlags << 10));
     }
 
-    void vmuloub (VR dest, VR op1, VR op2) { // Vector Multiply Odd Unsigned Byte
-        write32 (0x10000008 | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vmuloub (VR dest, VR op1, VR op2) { // Vector Multiply Odd Unsigned Byte
+        return emit (0x10000008 | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vmulouh (VR dest, VR op1, VR op2) { // Vector Multiply Odd Unsigned Half Word
-        write32 (0x10000048 | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vmulouh (VR dest, VR op1, VR op2) { // Vector Multiply Odd Unsigned Half Word
+        return emit (0x10000048 | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vmulosb (VR dest, VR op1, VR op2) { // Vector Multiply Odd Signed Byte
-        write32 (0x10000108 | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vmulosb (VR dest, VR op1, VR op2) { // Vector Multiply Odd Signed Byte
+        return emit (0x10000108 | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vmulosh (VR dest, VR op1, VR op2) { // Vector Multiply Odd Signed Half Word
-        write32 (0x10000148 | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vmulosh (VR dest, VR op1, VR op2) { // Vector Multiply Odd Signed Half Word
+        return emit (0x10000148 | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vmuleub (VR dest, VR op1, VR op2) { // Vector Multiply Even Unsigned Byte
-        write32 (0x10000208 | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vmuleub (VR dest, VR op1, VR op2) { // Vector Multiply Even Unsigned Byte
+        return emit (0x10000208 | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vmuleuh (VR dest, VR op1, VR op2) { // Vector Multiply Even Unsigned Half Word
-        write32 (0x10000248 | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vmuleuh (VR dest, VR op1, VR op2) { // Vector Multiply Even Unsigned Half Word
+        return emit (0x10000248 | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vmulesb (VR dest, VR op1, VR op2) { // Vector Multiply Even Signed Byte
-        write32 (0x10000308 | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vmulesb (VR dest, VR op1, VR op2) { // Vector Multiply Even Signed Byte
+        return emit (0x10000308 | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vmulesh (VR dest, VR op1, VR op2) { // Vector Multiply Even Signed Half Word
-        write32 (0x10000348 | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vmulesh (VR dest, VR op1, VR op2) { // Vector Multiply Even Signed Half Word
+        return emit (0x10000348 | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vsum4ubs (VR dest, VR op1, VR op2) { // Vector Sum Across Partial (1/4) Unsigned Byte Saturate
-        write32 (0x10000608 | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vsum4ubs (VR dest, VR op1, VR op2) { // Vector Sum Across Partial (1/4) Unsigned Byte Saturate
+        return emit (0x10000608 | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vsum4sbs (VR dest, VR op1, VR op2) { // Vector Sum Across Partial (1/4) Signed Byte Saturate
-        write32 (0x10000708 | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vsum4sbs (VR dest, VR op1, VR op2) { // Vector Sum Across Partial (1/4) Signed Byte Saturate
+        return emit (0x10000708 | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vsum4shs (VR dest, VR op1, VR op2) { // Vector Sum Across Partial (1/4) Signed Half Word Saturate
-        write32 (0x10000648 | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vsum4shs (VR dest, VR op1, VR op2) { // Vector Sum Across Partial (1/4) Signed Half Word Saturate
+        return emit (0x10000648 | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vsum2sws (VR dest, VR op1, VR op2) { // Vector Sum Across Partial (1/2) Signed Word Saturate
-        write32 (0x10000688 | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vsum2sws (VR dest, VR op1, VR op2) { // Vector Sum Across Partial (1/2) Signed Word Saturate
+        return emit (0x10000688 | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vsumsws (VR dest, VR op1, VR op2) { // Vector Sum Across Signed Word Saturate
-        write32 (0x10000788 | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vsumsws (VR dest, VR op1, VR op2) { // Vector Sum Across Signed Word Saturate
+        return emit (0x10000788 | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vaddfp (VR dest, VR op1, VR op2) { // Vector Add Floating-point
-        write32 (0x1000000A | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vaddfp (VR dest, VR op1, VR op2) { // Vector Add Floating-point
+        return emit (0x1000000A | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vsubfp (VR dest, VR op1, VR op2) { // Vector Subtract Floating-point
-        write32 (0x1000004A | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vsubfp (VR dest, VR op1, VR op2) { // Vector Subtract Floating-point
+        return emit (0x1000004A | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vrefp (VR dest, VR src) { // Vector Reciprocal Estimate Floating-point
-        write32 (0x1000010A | (dest << 21) | (src << 11));
+    constexpr auto vrefp (VR dest, VR src) { // Vector Reciprocal Estimate Floating-point
+        return emit (0x1000010A | (dest << 21) | (src << 11));
     }
 
-    void vrsqrtefp (VR dest, VR src) { // Vector Reciprocal Square Root Estimate Floating-point
-        write32 (0x1000014A | (dest << 21) | (src << 11));
+    constexpr auto vrsqrtefp (VR dest, VR src) { // Vector Reciprocal Square Root Estimate Floating-point
+        return emit (0x1000014A | (dest << 21) | (src << 11));
     }
 
-    void vexptefp (VR dest, VR src) { // Vector 2 Raised to the Exponent Estimate Floating-point
-        write32 (0x1000018A | (dest << 21) | (src << 11));
+    constexpr auto vexptefp (VR dest, VR src) { // Vector 2 Raised to the Exponent Estimate Floating-point
+        return emit (0x1000018A | (dest << 21) | (src << 11));
     }
 
-    void vlogefp (VR dest, VR src) { // Vector Log2 Estimate Floating-point
-        write32 (0x100001CA | (dest << 21) | (src << 11));
+    constexpr auto vlogefp (VR dest, VR src) { // Vector Log2 Estimate Floating-point
+        return emit (0x100001CA | (dest << 21) | (src << 11));
     }
 
-    void vrfin (VR dest, VR src) { // Vector Round to Floating-point Integer Nearest
-        write32 (0x1000020A | (dest << 21) | (src << 11));
+    constexpr auto vrfin (VR dest, VR src) { // Vector Round to Floating-point Integer Nearest
+        return emit (0x1000020A | (dest << 21) | (src << 11));
     }
 
-    void vrfiz (VR dest, VR src) { // Vector Round to Floating-point Integer Toward Zero
-        write32 (0x1000024A | (dest << 21) | (src << 11));
+    constexpr auto vrfiz (VR dest, VR src) { // Vector Round to Floating-point Integer Toward Zero
+        return emit (0x1000024A | (dest << 21) | (src << 11));
     }
 
-    void vrfip (VR dest, VR src) { // Vector Round to Floating-point Integer Toward Plus Infinity
-        write32 (0x1000028A | (dest << 21) | (src << 11));
+    constexpr auto vrfip (VR dest, VR src) { // Vector Round to Floating-point Integer Toward Plus Infinity
+        return emit (0x1000028A | (dest << 21) | (src << 11));
     }
 
-    void vrfim (VR dest, VR src) { // Vector Round to Floating-point Integer Toward Minus Infinity
-        write32 (0x100002CA | (dest << 21) | (src << 11));
+    constexpr auto vrfim (VR dest, VR src) { // Vector Round to Floating-point Integer Toward Minus Infinity
+        return emit (0x100002CA | (dest << 21) | (src << 11));
     }
 
-    void vcfux (VR dest, uint8_t exponent, VR src) { // Vector Convert from Unsigned Fixed-Point Word
-        write32 (0x1000030A | (dest << 21) | (exponent << 16) | (src << 11));
+    constexpr auto vcfux (VR dest, uint8_t exponent, VR src) { // Vector Convert from Unsigned Fixed-Point Word
+        return emit (0x1000030A | (dest << 21) | (exponent << 16) | (src << 11));
     }
 
-    void vcfsx (VR dest, uint8_t exponent, VR src) { // Vector Convert from Signed Fixed-Point Word
-        write32 (0x1000034A | (dest << 21) | (exponent << 16) | (src << 11));
+    constexpr auto vcfsx (VR dest, uint8_t exponent, VR src) { // Vector Convert from Signed Fixed-Point Word
+        return emit (0x1000034A | (dest << 21) | (exponent << 16) | (src << 11));
     }
 
-    void vctuxs (VR dest, uint8_t exponent, VR src) { // Vector Convert to Unsigned Fixed-Point Word Saturate
-        write32 (0x1000038A | (dest << 21) | (exponent << 16) | (src << 11));
+    constexpr auto vctuxs (VR dest, uint8_t exponent, VR src) { // Vector Convert to Unsigned Fixed-Point Word Saturate
+        return emit (0x1000038A | (dest << 21) | (exponent << 16) | (src << 11));
     }
 
-    void vctsxs (VR dest, uint8_t exponent, VR src) { // Vector Convert to Signed Fixed-Point Word Saturate
-        write32 (0x100003CA | (dest << 21) | (exponent << 16) | (src << 11));
+    constexpr auto vctsxs (VR dest, uint8_t exponent, VR src) { // Vector Convert to Signed Fixed-Point Word Saturate
+        return emit (0x100003CA | (dest << 21) | (exponent << 16) | (src << 11));
     }
 
-    void vmaxfp (VR dest, VR op1, VR op2) { // Vector Maximum Floating-point
-        write32 (0x1000040A | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vmaxfp (VR dest, VR op1, VR op2) { // Vector Maximum Floating-point
+        return emit (0x1000040A | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vminfp (VR dest, VR op1, VR op2) { // Vector Minimum Floating-point
-        write32 (0x1000044A | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vminfp (VR dest, VR op1, VR op2) { // Vector Minimum Floating-point
+        return emit (0x1000044A | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vmrghb (VR dest, VR op1, VR op2) { // Vector Merge High Byte
-        write32 (0x1000000C | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vmrghb (VR dest, VR op1, VR op2) { // Vector Merge High Byte
+        return emit (0x1000000C | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vmrghh (VR dest, VR op1, VR op2) { // Vector Merge High Half Word
-        write32 (0x1000004C | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vmrghh (VR dest, VR op1, VR op2) { // Vector Merge High Half Word
+        return emit (0x1000004C | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vmrghw (VR dest, VR op1, VR op2) { // Vector Merge High Word
-        write32 (0x1000008C | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vmrghw (VR dest, VR op1, VR op2) { // Vector Merge High Word
+        return emit (0x1000008C | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vmrglb (VR dest, VR op1, VR op2) { // Vector Merge Low Byte
-        write32 (0x1000010C | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vmrglb (VR dest, VR op1, VR op2) { // Vector Merge Low Byte
+        return emit (0x1000010C | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vmrglh (VR dest, VR op1, VR op2) { // Vector Merge Low Half Word
-        write32 (0x1000014C | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vmrglh (VR dest, VR op1, VR op2) { // Vector Merge Low Half Word
+        return emit (0x1000014C | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vmrglw (VR dest, VR op1, VR op2) { // Vector Merge Low Word
-        write32 (0x1000018C | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vmrglw (VR dest, VR op1, VR op2) { // Vector Merge Low Word
+        return emit (0x1000018C | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vspltb (VR dest, VR src, uint8_t element) { // Vector Splat Byte
-        write32 (0x1000020C | (dest << 21) | (element << 16) | (src << 11));
+    constexpr auto vspltb (VR dest, VR src, uint8_t element) { // Vector Splat Byte
+        return emit (0x1000020C | (dest << 21) | (element << 16) | (src << 11));
     }
 
-    void vsplth (VR dest, VR src, uint8_t element) { // Vector Splat Half Word
-        write32 (0x1000024C | (dest << 21) | (element << 16) | (src << 11));
+    constexpr auto vsplth (VR dest, VR src, uint8_t element) { // Vector Splat Half Word
+        return emit (0x1000024C | (dest << 21) | (element << 16) | (src << 11));
     }
 
-    void vspltw (VR dest, VR src, uint8_t element) { // Vector Splat Word
-        write32 (0x1000028C | (dest << 21) | (element << 16) | (src << 11));
+    constexpr auto vspltw (VR dest, VR src, uint8_t element) { // Vector Splat Word
+        return emit (0x1000028C | (dest << 21) | (element << 16) | (src << 11));
     }
 
-    void vspltisb (VR dest, int8_t imm) { // Vector Splat Immediate Signed Byte
-        write32 (0x1000030C | (dest << 21) | (((uint8_t)imm & 0x1F) << 16));
+    constexpr auto vspltisb (VR dest, int8_t imm) { // Vector Splat Immediate Signed Byte
+        return emit (0x1000030C | (dest << 21) | (((uint8_t)imm & 0x1F) << 16));
     }
 
-    void vspltish (VR dest, int8_t imm) { // Vector Splat Immediate Signed Half Word
-        write32 (0x1000034C | (dest << 21) | (((uint8_t)imm & 0x1F) << 16));
+    constexpr auto vspltish (VR dest, int8_t imm) { // Vector Splat Immediate Signed Half Word
+        return emit (0x1000034C | (dest << 21) | (((uint8_t)imm & 0x1F) << 16));
     }
 
-    void vspltisw (VR dest, int8_t imm) { // Vector Splat Immediate Signed Word
-        write32 (0x1000038C | (dest << 21) | (((uint8_t)imm & 0x1F) << 16));
+    constexpr auto vspltisw (VR dest, int8_t imm) { // Vector Splat Immediate Signed Word
+        return emit (0x1000038C | (dest << 21) | (((uint8_t)imm & 0x1F) << 16));
     }
 
-    void vslo (VR dest, VR op1, VR op2) { // Vector Shift Left by Octet
-        write32 (0x1000040C | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vslo (VR dest, VR op1, VR op2) { // Vector Shift Left by Octet
+        return emit (0x1000040C | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vsro (VR dest, VR op1, VR op2) { // Vector Shift Right by Octet
-        write32 (0x1000044C | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vsro (VR dest, VR op1, VR op2) { // Vector Shift Right by Octet
+        return emit (0x1000044C | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vpkuhum (VR dest, VR op1, VR op2) { // Vector Pack Unsigned Half Word Unsigned Modulo
-        write32 (0x1000000E | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vpkuhum (VR dest, VR op1, VR op2) { // Vector Pack Unsigned Half Word Unsigned Modulo
+        return emit (0x1000000E | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vpkuwum (VR dest, VR op1, VR op2) { // Vector Pack Unsigned Word Unsigned Modulo
-        write32 (0x1000004E | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vpkuwum (VR dest, VR op1, VR op2) { // Vector Pack Unsigned Word Unsigned Modulo
+        return emit (0x1000004E | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vpkuhus (VR dest, VR op1, VR op2) { // Vector Pack Unsigned Half Word Unsigned Saturate
-        write32 (0x1000008E | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vpkuhus (VR dest, VR op1, VR op2) { // Vector Pack Unsigned Half Word Unsigned Saturate
+        return emit (0x1000008E | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vpkuwus (VR dest, VR op1, VR op2) { // Vector Pack Unsigned Word Unsigned Saturate
-        write32 (0x100000CE | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vpkuwus (VR dest, VR op1, VR op2) { // Vector Pack Unsigned Word Unsigned Saturate
+        return emit (0x100000CE | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vpkshus (VR dest, VR op1, VR op2) { // Vector Pack Signed Half Word Unsigned Saturate
-        write32 (0x1000010E | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vpkshus (VR dest, VR op1, VR op2) { // Vector Pack Signed Half Word Unsigned Saturate
+        return emit (0x1000010E | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vpkswus (VR dest, VR op1, VR op2) { // Vector Pack Signed Word Unsigned Saturate
-        write32 (0x1000014E | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vpkswus (VR dest, VR op1, VR op2) { // Vector Pack Signed Word Unsigned Saturate
+        return emit (0x1000014E | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vpkshss (VR dest, VR op1, VR op2) { // Vector Pack Signed Half Word Signed Saturate
-        write32 (0x1000018E | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vpkshss (VR dest, VR op1, VR op2) { // Vector Pack Signed Half Word Signed Saturate
+        return emit (0x1000018E | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vpkswss (VR dest, VR op1, VR op2) { // Vector Pack Signed Word Signed Saturate
-        write32 (0x100001CE | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vpkswss (VR dest, VR op1, VR op2) { // Vector Pack Signed Word Signed Saturate
+        return emit (0x100001CE | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vupkhsb (VR dest, VR src) { // Vector Pack Signed Half Word Unsigned Saturate
-        write32 (0x1000020E | (dest << 21) | (src << 11));
+    constexpr auto vupkhsb (VR dest, VR src) { // Vector Pack Signed Half Word Unsigned Saturate
+        return emit (0x1000020E | (dest << 21) | (src << 11));
     }
 
-    void vupkhsh (VR dest, VR src) { // Vector Pack Signed Word Unsigned Saturate
-        write32 (0x1000024E | (dest << 21) | (src << 11));
+    constexpr auto vupkhsh (VR dest, VR src) { // Vector Pack Signed Word Unsigned Saturate
+        return emit (0x1000024E | (dest << 21) | (src << 11));
     }
 
-    void vupklsb (VR dest, VR src) { // Vector Unpack Low Signed Byte
-        write32 (0x1000028E | (dest << 21) | (src << 11));
+    constexpr auto vupklsb (VR dest, VR src) { // Vector Unpack Low Signed Byte
+        return emit (0x1000028E | (dest << 21) | (src << 11));
     }
 
-    void vupklsh (VR dest, VR src) { // Vector Unpack Low Signed Half Word
-        write32 (0x100002CE | (dest << 21) | (src << 11));
+    constexpr auto vupklsh (VR dest, VR src) { // Vector Unpack Low Signed Half Word
+        return emit (0x100002CE | (dest << 21) | (src << 11));
     }
 
-    void vpkpx (VR dest, VR op1, VR op2) { // Vector Pack Pixel32
-        write32 (0x1000030E | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto vpkpx (VR dest, VR op1, VR op2) { // Vector Pack Pixel32
+        return emit (0x1000030E | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void vupkhpx (VR dest, VR src) { // Vector Unpack High Pixel16
-        write32 (0x1000034E | (dest << 21) | (src << 11));
+    constexpr auto vupkhpx (VR dest, VR src) { // Vector Unpack High Pixel16
+        return emit (0x1000034E | (dest << 21) | (src << 11));
     }
 
-    void vupklpx (VR dest, VR src) { // Vector Unpack Low Pixel16
-        write32 (0x100003CE | (dest << 21) | (src << 11));
+    constexpr auto vupklpx (VR dest, VR src) { // Vector Unpack Low Pixel16
+        return emit (0x100003CE | (dest << 21) | (src << 11));
     }
 
-    void lvsl (VR dest, GPR op1, GPR op2) { // Load Vector for Shift Left
-        write32 (0x7C00000C | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto lvsl (VR dest, GPR op1, GPR op2) { // Load Vector for Shift Left
+        return emit (0x7C00000C | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void lvsr (VR dest, GPR op1, GPR op2) { // Load Vector for Shift Right
-        write32 (0x7C00004C | (dest << 21) | (op1 << 16) | (op2 << 11));
+    constexpr auto lvsr (VR dest, GPR op1, GPR op2) { // Load Vector for Shift Right
+        return emit (0x7C00004C | (dest << 21) | (op1 << 16) | (op2 << 11));
     }
 
-    void dst (uint8_t stream, GPR base, GPR prefetchControl) { // Data Stream Touch
-        write32 (0x7C0002AC | (stream << 21) | (base << 16) | (prefetchControl << 11));
+    constexpr auto dst (uint8_t stream, GPR base, GPR prefetchControl) { // Data Stream Touch
+        return emit (0x7C0002AC | (stream << 21) | (base << 16) | (prefetchControl << 11));
     }
 
-    void dstt (uint8_t stream, GPR base, GPR prefetchControl) { // Data Stream Touch (Transient)
-        write32 (0x7E0002AC | (stream << 21) | (base << 16) | (prefetchControl << 11));
+    constexpr auto dstt (uint8_t stream, GPR base, GPR prefetchControl) { // Data Stream Touch (Transient)
+        return emit (0x7E0002AC | (stream << 21) | (base << 16) | (prefetchControl << 11));
     }
 
-    void dstst (uint8_t stream, GPR base, GPR prefetchControl) { // Data Stream Touch for Store
-        write32 (0x7C0002EC | (stream << 21) | (base << 16) | (prefetchControl << 11));
+    constexpr auto dstst (uint8_t stream, GPR base, GPR prefetchControl) { // Data Stream Touch for Store
+        return emit (0x7C0002EC | (stream << 21) | (base << 16) | (prefetchControl << 11));
     }
 
-    void dststt (uint8_t stream, GPR base, GPR prefetchControl) { // Data Stream Touch for Store (Transient)
-        write32 (0x7E0002EC | (stream << 21) | (base << 16) | (prefetchControl << 11));
+    constexpr auto dststt (uint8_t stream, GPR base, GPR prefetchControl) { // Data Stream Touch for Store (Transient)
+        return emit (0x7E0002EC | (stream << 21) | (base << 16) | (prefetchControl << 11));
     }
 
-    void dss (uint8_t stream) { // Data Stream Stop
-        write32 (0x7C00066C | (stream << 21));
+    constexpr auto dss (uint8_t stream) { // Data Stream Stop
+        return emit (0x7C00066C | (stream << 21));
     }
 
-    void dssall() { // Data Stream Stop All
-        write32 (0x7E00066C);
+    constexpr auto dssall() { // Data Stream Stop All
+        return emit (0x7E00066C);
     }
 
-    void lvebx (VR dest, GPR base, GPR offset) { // Load Vector Element Byte Indexed
-        write32 (0x7C00000E | (dest << 21) | (base << 16) | (offset << 11));
+    constexpr auto lvebx (VR dest, GPR base, GPR offset) { // Load Vector Element Byte Indexed
+        return emit (0x7C00000E | (dest << 21) | (base << 16) | (offset << 11));
     }
 
-    void lvehx (VR dest, GPR base, GPR offset) { // Load Vector Element Half Word Indexed
-        write32 (0x7C00004E | (dest << 21) | (base << 16) | (offset << 11));
+    constexpr auto lvehx (VR dest, GPR base, GPR offset) { // Load Vector Element Half Word Indexed
+        return emit (0x7C00004E | (dest << 21) | (base << 16) | (offset << 11));
     }
 
-    void lvewx (VR dest, GPR base, GPR offset) { // Load Vector Element Word Indexed
-        write32 (0x7C00008E | (dest << 21) | (base << 16) | (offset << 11));
+    constexpr auto lvewx (VR dest, GPR base, GPR offset) { // Load Vector Element Word Indexed
+        return emit (0x7C00008E | (dest << 21) | (base << 16) | (offset << 11));
     }
 
-    void lvx (VR dest, GPR base, GPR offset) { // Load Vector Indexed
-        write32 (0x7C0000CE | (dest << 21) | (base << 16) | (offset << 11));
+    constexpr auto lvx (VR dest, GPR base, GPR offset) { // Load Vector Indexed
+        return emit (0x7C0000CE | (dest << 21) | (base << 16) | (offset << 11));
     }
 
-    void lvxl (VR dest, GPR base, GPR offset) { // Load Vector Indexed LRU
-        write32 (0x7C0002CE | (dest << 21) | (base << 16) | (offset << 11));
+    constexpr auto lvxl (VR dest, GPR base, GPR offset) { // Load Vector Indexed LRU
+        return emit (0x7C0002CE | (dest << 21) | (base << 16) | (offset << 11));
     }
 
-    void stvebx (VR dest, GPR base, GPR offset) { // Store Vector Element Byte Indexed
-        write32 (0x7C00010E | (dest << 21) | (base << 16) | (offset << 11));
+    constexpr auto stvebx (VR dest, GPR base, GPR offset) { // Store Vector Element Byte Indexed
+        return emit (0x7C00010E | (dest << 21) | (base << 16) | (offset << 11));
     }
 
-    void stvehx (VR dest, GPR base, GPR offset) { // Store Vector Element Half Word Indexed
-        write32 (0x7C00014E | (dest << 21) | (base << 16) | (offset << 11));
+    constexpr auto stvehx (VR dest, GPR base, GPR offset) { // Store Vector Element Half Word Indexed
+        return emit (0x7C00014E | (dest << 21) | (base << 16) | (offset << 11));
     }
 
-    void stvewx (VR dest, GPR base, GPR offset) { // Store Vector Element Word Indexed
-        write32 (0x7C00018E | (dest << 21) | (base << 16) | (offset << 11));
+    constexpr auto stvewx (VR dest, GPR base, GPR offset) { // Store Vector Element Word Indexed
+        return emit (0x7C00018E | (dest << 21) | (base << 16) | (offset << 11));
     }
 
-    void stvx (VR dest, GPR base, GPR offset) { // Store Vector Indexed
-        write32 (0x7C0001CE | (dest << 21) | (base << 16) | (offset << 11));
+    constexpr auto stvx (VR dest, GPR base, GPR offset) { // Store Vector Indexed
+        return emit (0x7C0001CE | (dest << 21) | (base << 16) | (offset << 11));
     }
 
-    void stvxl (VR dest, GPR base, GPR offset) { // Store Vector Indexed LRU
-        write32 (0x7C0003CE | (dest << 21) | (base << 16) | (offset << 11));
+    constexpr auto stvxl (VR dest, GPR base, GPR offset) { // Store Vector Indexed LRU
+        return emit (0x7C0003CE | (dest << 21) | (base << 16) | (offset << 11));
     }
 };
+
+// Stateless encoder: every single-instruction encoder returns its word instead of writing it, and can be used in constant expressions
+// eg constexpr uint32_t word = Luma::enc.addi (r3, r1, 4);
+// Pseudo-ops that expand to more than one instruction (liw, liu, setz) return nothing here, use a CodeTemplate for those
+struct Encoder : public InstructionSet <Encoder> {
+    friend class InstructionSet <Encoder>;
+
+private:
+    constexpr uint32_t emitInstruction (uint32_t instruction) { return instruction; }
+};
+
+inline Encoder enc;
+
+// A fixed block of up to N instructions, built at compile time and copied into an emitter with one memcpy via dw()
+template <size_t N>
+class CodeTemplate : public InstructionSet <CodeTemplate <N>> {
+    friend class InstructionSet <CodeTemplate>;
+
+    std::array <uint32_t, N> words {};
+    size_t count = 0; // How many of the words have been filled in
+
+    constexpr void emitInstruction (uint32_t instruction) {
+        if (count >= N)
+            panic ("[Emitter] Fatal: CodeTemplate overflow (capacity: %zu instructions)\n", N);
+        words[count++] = instruction;
+    }
+
+public:
+    constexpr const uint32_t* data() const { return words.data(); }
+    constexpr size_t size() const { return count; } // Size in instructions
+    constexpr const std::array <uint32_t, N>& array() const { return words; }
+    constexpr uint32_t operator[] (size_t index) const { return words[index]; }
+};
+
+// Build a CodeTemplate from a generator, eg
+// constexpr auto thunk = Luma::makeTemplate <2> ([] (auto& c) { c.li (r3, 0); c.blr(); });
+template <size_t N, typename Func>
+constexpr CodeTemplate <N> makeTemplate (Func&& f) {
+    CodeTemplate <N> code;
+    f (code);
+    return code;
+}
+
+// A pre-assembled sequence of instructions with holes: operand fields that get filled in every time the stencil is stamped
+// Assemble it once with placeholder operands, mark the fields that vary with hole(), then stamp it with PPCEmitter::stamp
+// eg stencil.lwz (r0, r0, 0); stencil.hole (0, Stencil::RD); stencil.hole (1, Stencil::RA); stencil.hole (2, Stencil::Imm16);
+class Stencil : public InstructionSet <Stencil> {
+    friend class InstructionSet <Stencil>;
+
+public:
+    // Instruction fields a hole can cover, packed as (shift << 8) | width
+    enum Field : uint16_t {
+        RD = (21 << 8) | 5, // Destination register (also the source register of stores, and crfD << 2)
+        RA = (16 << 8) | 5, // First source/base register
+        RB = (11 << 8) | 5, // Second source/index register
+        Imm16 = 16, // 16-bit immediate or displacement
+        SH = (11 << 8) | 5, // rlwinm & co shift amount
+        MB = (6 << 8) | 5, // rlwinm & co mask begin
+        ME = (1 << 8) | 5 // rlwinm & co mask end
+    };
+
+    struct Hole {
+        uint32_t word; // Index of the instruction the hole is in
+        uint32_t id; // Which value passed to stamp goes into the hole
+        uint32_t shift;
+        uint32_t mask;
+    };
+
+private:
+    std::vector <uint32_t> words;
+    std::vector <Hole> holes;
+    uint32_t holeCount = 0; // Number of distinct values a stamp needs (highest hole id + 1)
+
+    void emitInstruction (uint32_t instruction) { words.push_back (instruction); }
+
+public:
+    // Turn a field of the most recently assembled instruction into hole number "id". Several holes can share an id
+    void hole (uint32_t id, Field field) {
+        if (words.empty())
+            panic ("[Emitter] Fatal: Tried to add a hole to an empty stencil\n");
+
+        const uint32_t shift = field >> 8;
+        const uint32_t mask = (1u << (field & 0xFF)) - 1;
+        words.back() &= ~(mask << shift); // Clear the placeholder, so stamping only needs to OR the value in
+        holes.push_back ({ (uint32_t) words.size() - 1, id, shift, mask });
+        holeCount = std::max (holeCount, id + 1);
+    }
+
+    // Write the stencil to "dest" and fill in its holes
+    void instantiate (uint32_t* dest, std::initializer_list <uint32_t> values) const {
+        if (values.size() < holeCount)
+            panic ("[Emitter] Fatal: Stencil needs %u values, got %zu\n", holeCount, values.size());
+
+        std::memcpy (dest, words.data(), words.size() * sizeof (uint32_t));
+        const auto args = values.begin();
+        for (const auto& h : holes)
+            dest[h.word] |= (args[h.id] & h.mask) << h.shift;
+    }
+
+    const uint32_t* data() const { return words.data(); }
+    size_t size() const { return words.size(); } // Size in instructions
+    uint32_t getHoleCount() const { return holeCount; }
+    const std::vector <Hole>& getHoles() const { return holes; }
+};
+
+// Primary opcode 4 holds both the paired single and the AltiVec instructions, so code that reads instructions back has to be told which one it uses
+enum class DecodeMode {
+    PairedSingles, // Gekko/Broadway/Espresso
+    AltiVec
+};
+
+// Table-driven decoder for every encoding the emitter produces. Decoding a word is 2 table lookups; turning it into text is done separately, only when asked for
+class Decoder {
+public:
+    // How an instruction's operands are laid out, which is all that's needed to print them
+    enum class Form : uint8_t {
+        None, Branch, BranchConditional, BranchToLR, BranchToCTR, Sync,
+        RD_RA_SIMM, RA_RS_UIMM, CRF_RA_SIMM, CRF_RA_UIMM, GPR_MEM, FPR_MEM, PSQ_MEM,
+        RD_RA_RB, RA_RS_RB, RD_RA, RA_RS, RA_RS_SH, RD_RB, RA_RB, RB, GPR_D, CRF_RA_RB,
+        ROTATE_IMM, ROTATE, CRB3, MTCRF, MTSR, MFSR, MTSPR, MFSPR, DST, DSS,
+        FD_FA_FB, FD_FA_FC, FD_FA_FC_FB, FD_FB, CRF_FA_FB, PSQ_INDEXED,
+        VD_VA_VB_VC, VSLDOI, VD_VA_VB, VD_VB, VD_VB_UIMM, VD_SIMM, VD, VB, VD_RA_RB
+    };
+
+    // The bits of a word that identify each instruction format
+    enum Mask : uint32_t {
+        Primary = 0xFC000000, // Primary opcode only (D, I, B and M forms)
+        X = 0xFC0007FE, // 10-bit extended opcode (and the OE bit of XO forms), ignoring Rc/LK
+        XRc = 0xFC0007FF, // Same, for instructions that only exist with Rc set (stwcx.)
+        A = 0xFC00003E, // 5-bit extended opcode of floating point and paired single arithmetic
+        PSQX = 0xFC00007E, // 6-bit extended opcode of indexed quantized loads/stores
+        VA = 0xFC00003F, // 6-bit extended opcode of 4-operand AltiVec instructions
+        VX = 0xFC0007FF, // 11-bit extended opcode of the other AltiVec instructions
+        VC = 0xFC0003FF // 10-bit extended opcode of AltiVec compares, which keep Rc in bit 10
+    };
+
+    enum Flags : uint8_t {
+        Rc = 1, // Bit 0 is the record bit, which adds a "." to the mnemonic
+        VectorRc = 2, // Same, for AltiVec compares
+        PairedSingles = 4, // Opcode 4 instruction that only exists in DecodeMode::PairedSingles
+        AltiVec = 8 // Opcode 4 instruction that only exists in DecodeMode::AltiVec
+    };
+
+    struct Opcode {
+        uint32_t match; // The word the emitter produces with every operand at 0
+        uint32_t mask;
+        const char* mnemonic;
+        Form form;
+        uint8_t flags;
+    };
+
+    struct Instruction {
+        uint32_t word;
+        uintptr_t address; // Where the instruction runs from, used to resolve branch targets
+        const Opcode* opcode; // nullptr if this is not something the emitter produces
+
+        bool isValid() const { return opcode != nullptr; }
+        const char* getMnemonic() const { return opcode ? opcode->mnemonic : ".long"; } // Base mnemonic, without "." or simplified names
+
+        bool isBranch() const {
+            return opcode && (opcode->form == Form::Branch || opcode->form == Form::BranchConditional ||
+                              opcode->form == Form::BranchToLR || opcode->form == Form::BranchToCTR);
+        }
+
+        // Where a b or bc goes. Branches to LR or CTR return 0, since their target isn't part of the instruction
+        uintptr_t getBranchTarget() const {
+            if (!opcode || (opcode->form != Form::Branch && opcode->form != Form::BranchConditional))
+                return 0;
+
+            const intptr_t displacement = opcode->form == Form::Branch ? ((int32_t) (word << 6) >> 6) & ~3 : (int16_t) (word & 0xFFFC);
+            return (word & 2 ? 0 : address) + displacement; // AA bit: absolute target
+        }
+    };
+
+    // Everything the emitter can encode, keyed by the same base words as the encoders in InstructionSet
+    static constexpr Opcode opcodes[] = {
+        { 0x48000000, Primary, "b", Form::Branch, 0 },
+        { 0x40000000, Primary, "bc", Form::BranchConditional, 0 },
+        { 0x4C000020, X, "bclr", Form::BranchToLR, 0 },
+        { 0x4C000420, X, "bcctr", Form::BranchToCTR, 0 },
+        { 0x44000002, Primary, "sc", Form::None, 0 },
+        { 0x4C000064, X, "rfi", Form::None, 0 },
+        { 0x4C00012C, X, "isync", Form::None, 0 },
+        { 0x7C0004AC, X, "sync", Form::Sync, 0 },
+        { 0x7C0006AC, X, "eieio", Form::None, 0 },
+        { 0x7C00046C, X, "tlbsync", Form::None, 0 },
+        { 0x7C0003B8, X, "nand", Form::RA_RS_RB, Rc },
+        { 0x7C000038, X, "and", Form::RA_RS_RB, Rc },
+        { 0x7C000078, X, "andc", Form::RA_RS_RB, Rc },
+        { 0x70000000, Primary, "andi.", Form::RA_RS_UIMM, 0 },
+        { 0x74000000, Primary, "andis.", Form::RA_RS_UIMM, 0 },
+        { 0x7C0000F8, X, "nor", Form::RA_RS_RB, Rc },
+        { 0x7C000378, X, "or", Form::RA_RS_RB, Rc },
+        { 0x7C000338, X, "orc", Form::RA_RS_RB, Rc },
+        { 0x60000000, Primary, "ori", Form::RA_RS_UIMM, 0 },
+        { 0x64000000, Primary, "oris", Form::RA_RS_UIMM, 0 },
+        { 0x7C000278, X, "xor", Form::RA_RS_RB, Rc },
+        { 0x68000000, Primary, "xori", Form::RA_RS_UIMM, 0 },
+        { 0x6C000000, Primary, "xoris", Form::RA_RS_UIMM, 0 },
+        { 0x7C000214, X, "add", Form::RD_RA_RB, Rc },
+        { 0x7C000614, X, "addo", Form::RD_RA_RB, Rc },
+        { 0x7C000014, X, "addc", Form::RD_RA_RB, Rc },
+        { 0x7C000414, X, "addco", Form::RD_RA_RB, Rc },
+        { 0x7C000114, X, "adde", Form::RD_RA_RB, Rc },
+        { 0x7C000514, X, "addeo", Form::RD_RA_RB, Rc },
+        { 0x7C000194, X, "addze", Form::RD_RA, Rc },
+        { 0x7C000594, X, "addzeo", Form::RD_RA, Rc },
+        { 0x38000000, Primary, "addi", Form::RD_RA_SIMM, 0 },
+        { 0x3C000000, Primary, "addis", Form::RD_RA_SIMM, 0 },
+        { 0x30000000, Primary, "addic", Form::RD_RA_SIMM, 0 },
+        { 0x34000000, Primary, "addic.", Form::RD_RA_SIMM, 0 },
+        { 0x7C0001D4, X, "addme", Form::RD_RA, Rc },
+        { 0x7C0005D4, X, "addmeo", Form::RD_RA, Rc },
+        { 0x7C000050, X, "subf", Form::RD_RA_RB, Rc },
+        { 0x7C000450, X, "subfo", Form::RD_RA_RB, Rc },
+        { 0x7C000010, X, "subfc", Form::RD_RA_RB, Rc },
+        { 0x7C000410, X, "subfco", Form::RD_RA_RB, Rc },
+        { 0x7C000110, X, "subfe", Form::RD_RA_RB, Rc },
+        { 0x7C000510, X, "subfeo", Form::RD_RA_RB, Rc },
+        { 0x20000000, Primary, "subfic", Form::RD_RA_SIMM, 0 },
+        { 0x7C0001D0, X, "subfme", Form::RD_RA, Rc },
+        { 0x7C0005D0, X, "subfmeo", Form::RD_RA, Rc },
+        { 0x7C000190, X, "subfze", Form::RD_RA, Rc },
+        { 0x7C000590, X, "subfzeo", Form::RD_RA, Rc },
+        { 0x28000000, Primary, "cmpli", Form::CRF_RA_UIMM, 0 },
+        { 0x2C000000, Primary, "cmpi", Form::CRF_RA_SIMM, 0 },
+        { 0x7C000040, X, "cmpl", Form::CRF_RA_RB, 0 },
+        { 0x7C000000, X, "cmp", Form::CRF_RA_RB, 0 },
+        { 0x1C000000, Primary, "mulli", Form::RD_RA_SIMM, 0 },
+        { 0x7C0001D6, X, "mullw", Form::RD_RA_RB, Rc },
+        { 0x7C0005D6, X, "mullwo", Form::RD_RA_RB, Rc },
+        { 0x7C000096, X, "mulhw", Form::RD_RA_RB, Rc },
+        { 0x7C000016, X, "mulhwu", Form::RD_RA_RB, Rc },
+        { 0x7C000396, X, "divwu", Form::RD_RA_RB, Rc },
+        { 0x7C000796, X, "divwuo", Form::RD_RA_RB, Rc },
+        { 0x7C0003D6, X, "divw", Form::RD_RA_RB, Rc },
+        { 0x7C0007D6, X, "divwo", Form::RD_RA_RB, Rc },
+        { 0x7C000030, X, "slw", Form::RA_RS_RB, Rc },
+        { 0x7C000430, X, "srw", Form::RA_RS_RB, Rc },
+        { 0x7C000630, X, "sraw", Form::RA_RS_RB, Rc },
+        { 0x7C000670, X, "srawi", Form::RA_RS_SH, Rc },
+        { 0x54000000, Primary, "rlwinm", Form::ROTATE_IMM, Rc },
+        { 0x5C000000, Primary, "rlwnm", Form::ROTATE, Rc },
+        { 0x50000000, Primary, "rlwimi", Form::ROTATE_IMM, Rc },
+        { 0x7C000034, X, "cntlzw", Form::RA_RS, Rc },
+        { 0x98000000, Primary, "stb", Form::GPR_MEM, 0 },
+        { 0x7C0001AE, X, "stbx", Form::RD_RA_RB, 0 },
+        { 0x9C000000, Primary, "stbu", Form::GPR_MEM, 0 },
+        { 0x7C0001EE, X, "stbux", Form::RD_RA_RB, 0 },
+        { 0xB0000000, Primary, "sth", Form::GPR_MEM, 0 },
+        { 0x7C00032E, X, "sthx", Form::RD_RA_RB, 0 },
+        { 0xB4000000, Primary, "sthu", Form::GPR_MEM, 0 },
+        { 0x7C00036E, X, "sthux", Form::RD_RA_RB, 0 },
+        { 0x90000000, Primary, "stw", Form::GPR_MEM, 0 },
+        { 0x7C00012E, X, "stwx", Form::RD_RA_RB, 0 },
+        { 0x94000000, Primary, "stwu", Form::GPR_MEM, 0 },
+        { 0x7C00016E, X, "stwux", Form::RD_RA_RB, 0 },
+        { 0x88000000, Primary, "lbz", Form::GPR_MEM, 0 },
+        { 0x7C0000AE, X, "lbzx", Form::RD_RA_RB, 0 },
+        { 0x8C000000, Primary, "lbzu", Form::GPR_MEM, 0 },
+        { 0x7C0000EE, X, "lbzux", Form::RD_RA_RB, 0 },
+        { 0xA0000000, Primary, "lhz", Form::GPR_MEM, 0 },
+        { 0x7C00022E, X, "lhzx", Form::RD_RA_RB, 0 },
+        { 0xA4000000, Primary, "lhzu", Form::GPR_MEM, 0 },
+        { 0x7C00026E, X, "lhzux", Form::RD_RA_RB, 0 },
+        { 0x7C0002AE, X, "lhax", Form::RD_RA_RB, 0 },
+        { 0x7C0002EE, X, "lhaux", Form::RD_RA_RB, 0 },
+        { 0x7C00062C, X, "lhbrx", Form::RD_RA_RB, 0 },
+        { 0x80000000, Primary, "lwz", Form::GPR_MEM, 0 },
+        { 0x7C00002E, X, "lwzx", Form::RD_RA_RB, 0 },
+        { 0x84000000, Primary, "lwzu", Form::GPR_MEM, 0 },
+        { 0x7C00006E, X, "lwzux", Form::RD_RA_RB, 0 },
+        { 0x7C000028, X, "lwarx", Form::RD_RA_RB, 0 },
+        { 0x7C00012D, XRc, "stwcx.", Form::RD_RA_RB, 0 },
+        { 0x7C00042C, X, "lwbrx", Form::RD_RA_RB, 0 },
+        { 0xB8000000, Primary, "lmw", Form::GPR_MEM, 0 },
+        { 0xBC000000, Primary, "stmw", Form::GPR_MEM, 0 },
+        { 0x4C000202, X, "crand", Form::CRB3, 0 },
+        { 0x4C000102, X, "crandc", Form::CRB3, 0 },
+        { 0x4C000242, X, "creqv", Form::CRB3, 0 },
+        { 0x4C0001C2, X, "crnand", Form::CRB3, 0 },
+        { 0x4C000042, X, "crnor", Form::CRB3, 0 },
+        { 0x4C000382, X, "cror", Form::CRB3, 0 },
+        { 0x4C000342, X, "crorc", Form::CRB3, 0 },
+        { 0x4C000182, X, "crxor", Form::CRB3, 0 },
+        { 0x7C000120, X, "mtcrf", Form::MTCRF, 0 },
+        { 0x7C000026, X, "mfcr", Form::GPR_D, 0 },
+        { 0x7C0001A4, X, "mtsr", Form::MTSR, 0 },
+        { 0x7C0004A6, X, "mfsr", Form::MFSR, 0 },
+        { 0x7C0001E4, X, "mtsrin", Form::RD_RB, 0 },
+        { 0x7C000526, X, "mfsrin", Form::RD_RB, 0 },
+        { 0x7C0000A6, X, "mfmsr", Form::GPR_D, 0 },
+        { 0x7C000124, X, "mtmsr", Form::GPR_D, 0 },
+        { 0x7C0003A6, X, "mtspr", Form::MTSPR, 0 },
+        { 0x7C0002A6, X, "mfspr", Form::MFSPR, 0 },
+        { 0xC0000000, Primary, "lfs", Form::FPR_MEM, 0 },
+        { 0xC8000000, Primary, "lfd", Form::FPR_MEM, 0 },
+        { 0xD0000000, Primary, "stfs", Form::FPR_MEM, 0 },
+        { 0xD8000000, Primary, "stfd", Form::FPR_MEM, 0 },
+        { 0xFC000090, X, "fmr", Form::FD_FB, Rc },
+        { 0xFC00002A, A, "fadd", Form::FD_FA_FB, Rc },
+        { 0xEC00002A, A, "fadds", Form::FD_FA_FB, Rc },
+        { 0xFC000024, A, "fdiv", Form::FD_FA_FB, Rc },
+        { 0xEC000024, A, "fdivs", Form::FD_FA_FB, Rc },
+        { 0xFC00003A, A, "fmadd", Form::FD_FA_FC_FB, Rc },
+        { 0xEC00003A, A, "fmadds", Form::FD_FA_FC_FB, Rc },
+        { 0xFC000038, A, "fmsub", Form::FD_FA_FC_FB, Rc },
+        { 0xEC000038, A, "fmsubs", Form::FD_FA_FC_FB, Rc },
+        { 0xFC000032, A, "fmul", Form::FD_FA_FC, Rc },
+        { 0xEC000032, A, "fmuls", Form::FD_FA_FC, Rc },
+        { 0xFC000110, X, "fnabs", Form::FD_FB, Rc },
+        { 0xFC000050, X, "fneg", Form::FD_FB, Rc },
+        { 0xFC00003E, A, "fnmadd", Form::FD_FA_FC_FB, Rc },
+        { 0xEC00003E, A, "fnmadds", Form::FD_FA_FC_FB, Rc },
+        { 0xFC00003C, A, "fnmsub", Form::FD_FA_FC_FB, Rc },
+        { 0xEC00003C, A, "fnmsubs", Form::FD_FA_FC_FB, Rc },
+        { 0xEC000030, A, "fres", Form::FD_FB, Rc },
+        { 0xFC000018, X, "frsp", Form::FD_FB, Rc },
+        { 0xFC000034, A, "frsqrte", Form::FD_FB, Rc },
+        { 0xFC00002E, A, "fsel", Form::FD_FA_FC_FB, Rc },
+        { 0xFC000028, A, "fsub", Form::FD_FA_FB, Rc },
+        { 0xEC000028, A, "fsubs", Form::FD_FA_FB, Rc },
+        { 0x7C0007AC, X, "icbi", Form::RA_RB, 0 },
+        { 0x7C0000AC, X, "dcbf", Form::RA_RB, 0 },
+        { 0x7C0003AC, X, "dcbi", Form::RA_RB, 0 },
+        { 0x7C00006C, X, "dcbst", Form::RA_RB, 0 },
+        { 0x7C00022C, X, "dcbt", Form::RA_RB, 0 },
+        { 0x7C0001EC, X, "dcbtst", Form::RA_RB, 0 },
+        { 0x7C0007EC, X, "dcbz", Form::RA_RB, 0 },
+        { 0x100007EC, X, "dcbz_l", Form::RA_RB, PairedSingles },
+        { 0x7C000264, X, "tlbie", Form::RB, 0 },
+        { 0x10000210, X, "ps_abs", Form::FD_FB, Rc | PairedSingles },
+        { 0x1000002A, A, "ps_add", Form::FD_FA_FB, Rc | PairedSingles },
+        { 0x10000040, X, "ps_cmpo0", Form::CRF_FA_FB, PairedSingles },
+        { 0x100000C0, X, "ps_cmpo1", Form::CRF_FA_FB, PairedSingles },
+        { 0x10000000, X, "ps_cmpu0", Form::CRF_FA_FB, PairedSingles },
+        { 0x10000080, X, "ps_cmpu1", Form::CRF_FA_FB, PairedSingles },
+        { 0x10000024, A, "ps_div", Form::FD_FA_FB, Rc | PairedSingles },
+        { 0x1000003A, A, "ps_madd", Form::FD_FA_FC_FB, Rc | PairedSingles },
+        { 0x1000001C, A, "ps_madds0", Form::FD_FA_FC_FB, Rc | PairedSingles },
+        { 0x1000001E, A, "ps_madds1", Form::FD_FA_FC_FB, Rc | PairedSingles },
+        { 0x10000420, X, "ps_merge00", Form::FD_FA_FB, Rc | PairedSingles },
+        { 0x10000460, X, "ps_merge01", Form::FD_FA_FB, Rc | PairedSingles },
+        { 0x100004A0, X, "ps_merge10", Form::FD_FA_FB, Rc | PairedSingles },
+        { 0x100004E0, X, "ps_merge11", Form::FD_FA_FB, Rc | PairedSingles },
+        { 0x10000090, X, "ps_mr", Form::FD_FB, Rc | PairedSingles },
+        { 0x10000038, A, "ps_msub", Form::FD_FA_FC_FB, Rc | PairedSingles },
+        { 0x10000032, A, "ps_mul", Form::FD_FA_FC, Rc | PairedSingles },
+        { 0x10000018, A, "ps_muls0", Form::FD_FA_FC, Rc | PairedSingles },
+        { 0x1000001A, A, "ps_muls1", Form::FD_FA_FC, Rc | PairedSingles },
+        { 0x10000110, X, "ps_nabs", Form::FD_FB, Rc | PairedSingles },
+        { 0x10000050, X, "ps_neg", Form::FD_FB, Rc | PairedSingles },
+        { 0x1000003E, A, "ps_nmadd", Form::FD_FA_FC_FB, Rc | PairedSingles },
+        { 0x1000003C, A, "ps_nmsub", Form::FD_FA_FC_FB, Rc | PairedSingles },
+        { 0x10000030, A, "ps_res", Form::FD_FB, Rc | PairedSingles },
+        { 0x10000034, A, "ps_rsqrte", Form::FD_FB, Rc | PairedSingles },
+        { 0x1000002E, A, "ps_sel", Form::FD_FA_FC_FB, Rc | PairedSingles },
+        { 0x10000028, A, "ps_sub", Form::FD_FA_FB, Rc | PairedSingles },
+        { 0x10000014, A, "ps_sum0", Form::FD_FA_FC_FB, Rc | PairedSingles },
+        { 0x10000016, A, "ps_sum1", Form::FD_FA_FC_FB, Rc | PairedSingles },
+        { 0xE0000000, Primary, "psq_l", Form::PSQ_MEM, PairedSingles },
+        { 0xE4000000, Primary, "psq_lu", Form::PSQ_MEM, PairedSingles },
+        { 0x1000000C, PSQX, "psq_lx", Form::PSQ_INDEXED, PairedSingles },
+        { 0x1000004C, PSQX, "psq_lux", Form::PSQ_INDEXED, PairedSingles },
+        { 0xF0000000, Primary, "psq_st", Form::PSQ_MEM, PairedSingles },
+        { 0xF4000000, Primary, "psq_stu", Form::PSQ_MEM, PairedSingles },
+        { 0x1000000E, PSQX, "psq_stx", Form::PSQ_INDEXED, PairedSingles },
+        { 0x1000004E, PSQX, "psq_stux", Form::PSQ_INDEXED, PairedSingles },
+        { 0x10000020, VA, "vmhaddshs", Form::VD_VA_VB_VC, AltiVec },
+        { 0x10000021, VA, "vmhraddshs", Form::VD_VA_VB_VC, AltiVec },
+        { 0x10000022, VA, "vmladdshs", Form::VD_VA_VB_VC, AltiVec },
+        { 0x10000024, VA, "vmsumubm", Form::VD_VA_VB_VC, AltiVec },
+        { 0x10000025, VA, "vmsummbm", Form::VD_VA_VB_VC, AltiVec },
+        { 0x10000026, VA, "vmsumuhm", Form::VD_VA_VB_VC, AltiVec },
+        { 0x10000027, VA, "vmsumuhs", Form::VD_VA_VB_VC, AltiVec },
+        { 0x10000028, VA, "vmsumshm", Form::VD_VA_VB_VC, AltiVec },
+        { 0x10000029, VA, "vmsumshs", Form::VD_VA_VB_VC, AltiVec },
+        { 0x1000002A, VA, "vsel", Form::VD_VA_VB_VC, AltiVec },
+        { 0x1000002B, VA, "vperm", Form::VD_VA_VB_VC, AltiVec },
+        { 0x1000002C, VA, "vsldoi", Form::VSLDOI, AltiVec },
+        { 0x1000002E, VA, "vmaddfp", Form::VD_VA_VB_VC, AltiVec },
+        { 0x1000002F, VA, "vnmsubfp", Form::VD_VA_VB_VC, AltiVec },
+        { 0x10000000, VX, "vaddubm", Form::VD_VA_VB, AltiVec },
+        { 0x10000040, VX, "vadduhm", Form::VD_VA_VB, AltiVec },
+        { 0x10000080, VX, "vadduwm", Form::VD_VA_VB, AltiVec },
+        { 0x10000180, VX, "vaddcuw", Form::VD_VA_VB, AltiVec },
+        { 0x10000200, VX, "vaddubs", Form::VD_VA_VB, AltiVec },
+        { 0x10000240, VX, "vadduhs", Form::VD_VA_VB, AltiVec },
+        { 0x10000280, VX, "vadduws", Form::VD_VA_VB, AltiVec },
+        { 0x10000300, VX, "vaddsbs", Form::VD_VA_VB, AltiVec },
+        { 0x10000340, VX, "vaddshs", Form::VD_VA_VB, AltiVec },
+        { 0x10000380, VX, "vaddsws", Form::VD_VA_VB, AltiVec },
+        { 0x10000400, VX, "vsububm", Form::VD_VA_VB, AltiVec },
+        { 0x10000440, VX, "vsubuhm", Form::VD_VA_VB, AltiVec },
+        { 0x10000480, VX, "vsubuwm", Form::VD_VA_VB, AltiVec },
+        { 0x10000580, VX, "vsubcuw", Form::VD_VA_VB, AltiVec },
+        { 0x10000600, VX, "vsububs", Form::VD_VA_VB, AltiVec },
+        { 0x10000640, VX, "vsubuhs", Form::VD_VA_VB, AltiVec },
+        { 0x10000680, VX, "vsubuws", Form::VD_VA_VB, AltiVec },
+        { 0x10000700, VX, "vsubsbs", Form::VD_VA_VB, AltiVec },
+        { 0x10000740, VX, "vsubshs", Form::VD_VA_VB, AltiVec },
+        { 0x10000780, VX, "vsubsws", Form::VD_VA_VB, AltiVec },
+        { 0x10000002, VX, "vmaxub", Form::VD_VA_VB, AltiVec },
+        { 0x10000042, VX, "vmaxuh", Form::VD_VA_VB, AltiVec },
+        { 0x10000082, VX, "vmaxuw", Form::VD_VA_VB, AltiVec },
+        { 0x10000102, VX, "vmaxsb", Form::VD_VA_VB, AltiVec },
+        { 0x10000142, VX, "vmaxsh", Form::VD_VA_VB, AltiVec },
+        { 0x10000182, VX, "vmaxsw", Form::VD_VA_VB, AltiVec },
+        { 0x10000202, VX, "vminub", Form::VD_VA_VB, AltiVec },
+        { 0x10000242, VX, "vminuh", Form::VD_VA_VB, AltiVec },
+        { 0x10000282, VX, "vminuw", Form::VD_VA_VB, AltiVec },
+        { 0x10000302, VX, "vminsb", Form::VD_VA_VB, AltiVec },
+        { 0x10000342, VX, "vminsh", Form::VD_VA_VB, AltiVec },
+        { 0x10000382, VX, "vminsw", Form::VD_VA_VB, AltiVec },
+        { 0x10000402, VX, "vavgub", Form::VD_VA_VB, AltiVec },
+        { 0x10000442, VX, "vavguh", Form::VD_VA_VB, AltiVec },
+        { 0x10000482, VX, "vavguw", Form::VD_VA_VB, AltiVec },
+        { 0x10000502, VX, "vavgsb", Form::VD_VA_VB, AltiVec },
+        { 0x10000542, VX, "vavgsh", Form::VD_VA_VB, AltiVec },
+        { 0x10000582, VX, "vavgsw", Form::VD_VA_VB, AltiVec },
+        { 0x10000004, VX, "vrlb", Form::VD_VA_VB, AltiVec },
+        { 0x10000044, VX, "vrlh", Form::VD_VA_VB, AltiVec },
+        { 0x10000084, VX, "vrlw", Form::VD_VA_VB, AltiVec },
+        { 0x10000104, VX, "vslb", Form::VD_VA_VB, AltiVec },
+        { 0x10000144, VX, "vslh", Form::VD_VA_VB, AltiVec },
+        { 0x10000184, VX, "vslw", Form::VD_VA_VB, AltiVec },
+        { 0x100001C4, VX, "vsl", Form::VD_VA_VB, AltiVec },
+        { 0x10000204, VX, "vsrb", Form::VD_VA_VB, AltiVec },
+        { 0x10000244, VX, "vsrh", Form::VD_VA_VB, AltiVec },
+        { 0x10000284, VX, "vsrw", Form::VD_VA_VB, AltiVec },
+        { 0x100002C4, VX, "vsr", Form::VD_VA_VB, AltiVec },
+        { 0x10000304, VX, "vsrab", Form::VD_VA_VB, AltiVec },
+        { 0x10000344, VX, "vsrah", Form::VD_VA_VB, AltiVec },
+        { 0x10000384, VX, "vsraw", Form::VD_VA_VB, AltiVec },
+        { 0x10000404, VX, "vand", Form::VD_VA_VB, AltiVec },
+        { 0x10000444, VX, "vandc", Form::VD_VA_VB, AltiVec },
+        { 0x10000484, VX, "vor", Form::VD_VA_VB, AltiVec },
+        { 0x100004C4, VX, "vxor", Form::VD_VA_VB, AltiVec },
+        { 0x10000504, VX, "vnor", Form::VD_VA_VB, AltiVec },
+        { 0x10000604, VX, "mfvscr", Form::VD, AltiVec },
+        { 0x10000644, VX, "mtvscr", Form::VB, AltiVec },
+        { 0x10000006, VC, "vcmpequb", Form::VD_VA_VB, AltiVec | VectorRc },
+        { 0x10000046, VC, "vcmpequh", Form::VD_VA_VB, AltiVec | VectorRc },
+        { 0x10000086, VC, "vcmpequw", Form::VD_VA_VB, AltiVec | VectorRc },
+        { 0x100000C6, VC, "vcmpeqfp", Form::VD_VA_VB, AltiVec | VectorRc },
+        { 0x10000106, VC, "vcmpgeub", Form::VD_VA_VB, AltiVec | VectorRc },
+        { 0x10000146, VC, "vcmpgeuh", Form::VD_VA_VB, AltiVec | VectorRc },
+        { 0x10000186, VC, "vcmpgeuw", Form::VD_VA_VB, AltiVec | VectorRc },
+        { 0x100001C6, VC, "vcmpgefp", Form::VD_VA_VB, AltiVec | VectorRc },
+        { 0x10000206, VC, "vcmpgtub", Form::VD_VA_VB, AltiVec | VectorRc },
+        { 0x10000246, VC, "vcmpgtuh", Form::VD_VA_VB, AltiVec | VectorRc },
+        { 0x10000286, VC, "vcmpgtuw", Form::VD_VA_VB, AltiVec | VectorRc },
+        { 0x100002C6, VC, "vcmpgtfp", Form::VD_VA_VB, AltiVec | VectorRc },
+        { 0x10000306, VC, "vcmpgtsb", Form::VD_VA_VB, AltiVec | VectorRc },
+        { 0x10000346, VC, "vcmpgtsh", Form::VD_VA_VB, AltiVec | VectorRc },
+        { 0x10000386, VC, "vcmpgtsw", Form::VD_VA_VB, AltiVec | VectorRc },
+        { 0x100003C6, VC, "vcmpbfp", Form::VD_VA_VB, AltiVec | VectorRc },
+        { 0x10000008, VX, "vmuloub", Form::VD_VA_VB, AltiVec },
+        { 0x10000048, VX, "vmulouh", Form::VD_VA_VB, AltiVec },
+        { 0x10000108, VX, "vmulosb", Form::VD_VA_VB, AltiVec },
+        { 0x10000148, VX, "vmulosh", Form::VD_VA_VB, AltiVec },
+        { 0x10000208, VX, "vmuleub", Form::VD_VA_VB, AltiVec },
+        { 0x10000248, VX, "vmuleuh", Form::VD_VA_VB, AltiVec },
+        { 0x10000308, VX, "vmulesb", Form::VD_VA_VB, AltiVec },
+        { 0x10000348, VX, "vmulesh", Form::VD_VA_VB, AltiVec },
+        { 0x10000608, VX, "vsum4ubs", Form::VD_VA_VB, AltiVec },
+        { 0x10000708, VX, "vsum4sbs", Form::VD_VA_VB, AltiVec },
+        { 0x10000648, VX, "vsum4shs", Form::VD_VA_VB, AltiVec },
+        { 0x10000688, VX, "vsum2sws", Form::VD_VA_VB, AltiVec },
+        { 0x10000788, VX, "vsumsws", Form::VD_VA_VB, AltiVec },
+        { 0x1000000A, VX, "vaddfp", Form::VD_VA_VB, AltiVec },
+        { 0x1000004A, VX, "vsubfp", Form::VD_VA_VB, AltiVec },
+        { 0x1000010A, VX, "vrefp", Form::VD_VB, AltiVec },
+        { 0x1000014A, VX, "vrsqrtefp", Form::VD_VB, AltiVec },
+        { 0x1000018A, VX, "vexptefp", Form::VD_VB, AltiVec },
+        { 0x100001CA, VX, "vlogefp", Form::VD_VB, AltiVec },
+        { 0x1000020A, VX, "vrfin", Form::VD_VB, AltiVec },
+        { 0x1000024A, VX, "vrfiz", Form::VD_VB, AltiVec },
+        { 0x1000028A, VX, "vrfip", Form::VD_VB, AltiVec },
+        { 0x100002CA, VX, "vrfim", Form::VD_VB, AltiVec },
+        { 0x1000030A, VX, "vcfux", Form::VD_VB_UIMM, AltiVec },
+        { 0x1000034A, VX, "vcfsx", Form::VD_VB_UIMM, AltiVec },
+        { 0x1000038A, VX, "vctuxs", Form::VD_VB_UIMM, AltiVec },
+        { 0x100003CA, VX, "vctsxs", Form::VD_VB_UIMM, AltiVec },
+        { 0x1000040A, VX, "vmaxfp", Form::VD_VA_VB, AltiVec },
+        { 0x1000044A, VX, "vminfp", Form::VD_VA_VB, AltiVec },
+        { 0x1000000C, VX, "vmrghb", Form::VD_VA_VB, AltiVec },
+        { 0x1000004C, VX, "vmrghh", Form::VD_VA_VB, AltiVec },
+        { 0x1000008C, VX, "vmrghw", Form::VD_VA_VB, AltiVec },
+        { 0x1000010C, VX, "vmrglb", Form::VD_VA_VB, AltiVec },
+        { 0x1000014C, VX, "vmrglh", Form::VD_VA_VB, AltiVec },
+        { 0x1000018C, VX, "vmrglw", Form::VD_VA_VB, AltiVec },
+        { 0x1000020C, VX, "vspltb", Form::VD_VB_UIMM, AltiVec },
+        { 0x1000024C, VX, "vsplth", Form::VD_VB_UIMM, AltiVec },
+        { 0x1000028C, VX, "vspltw", Form::VD_VB_UIMM, AltiVec },
+        { 0x1000030C, VX, "vspltisb", Form::VD_SIMM, AltiVec },
+        { 0x1000034C, VX, "vspltish", Form::VD_SIMM, AltiVec },
+        { 0x1000038C, VX, "vspltisw", Form::VD_SIMM, AltiVec },
+        { 0x1000040C, VX, "vslo", Form::VD_VA_VB, AltiVec },
+        { 0x1000044C, VX, "vsro", Form::VD_VA_VB, AltiVec },
+        { 0x1000000E, VX, "vpkuhum", Form::VD_VA_VB, AltiVec },
+        { 0x1000004E, VX, "vpkuwum", Form::VD_VA_VB, AltiVec },
+        { 0x1000008E, VX, "vpkuhus", Form::VD_VA_VB, AltiVec },
+        { 0x100000CE, VX, "vpkuwus", Form::VD_VA_VB, AltiVec },
+        { 0x1000010E, VX, "vpkshus", Form::VD_VA_VB, AltiVec },
+        { 0x1000014E, VX, "vpkswus", Form::VD_VA_VB, AltiVec },
+        { 0x1000018E, VX, "vpkshss", Form::VD_VA_VB, AltiVec },
+        { 0x100001CE, VX, "vpkswss", Form::VD_VA_VB, AltiVec },
+        { 0x1000020E, VX, "vupkhsb", Form::VD_VB, AltiVec },
+        { 0x1000024E, VX, "vupkhsh", Form::VD_VB, AltiVec },
+        { 0x1000028E, VX, "vupklsb", Form::VD_VB, AltiVec },
+        { 0x100002CE, VX, "vupklsh", Form::VD_VB, AltiVec },
+        { 0x1000030E, VX, "vpkpx", Form::VD_VA_VB, AltiVec },
+        { 0x1000034E, VX, "vupkhpx", Form::VD_VB, AltiVec },
+        { 0x100003CE, VX, "vupklpx", Form::VD_VB, AltiVec },
+        { 0x7C00000C, X, "lvsl", Form::VD_RA_RB, 0 },
+        { 0x7C00004C, X, "lvsr", Form::VD_RA_RB, 0 },
+        { 0x7C0002AC, X, "dst", Form::DST, 0 },
+        { 0x7C0002EC, X, "dstst", Form::DST, 0 },
+        { 0x7C00066C, X, "dss", Form::DSS, 0 },
+        { 0x7C00000E, X, "lvebx", Form::VD_RA_RB, 0 },
+        { 0x7C00004E, X, "lvehx", Form::VD_RA_RB, 0 },
+        { 0x7C00008E, X, "lvewx", Form::VD_RA_RB, 0 },
+        { 0x7C0000CE, X, "lvx", Form::VD_RA_RB, 0 },
+        { 0x7C0002CE, X, "lvxl", Form::VD_RA_RB, 0 },
+        { 0x7C00010E, X, "stvebx", Form::VD_RA_RB, 0 },
+        { 0x7C00014E, X, "stvehx", Form::VD_RA_RB, 0 },
+        { 0x7C00018E, X, "stvewx", Form::VD_RA_RB, 0 },
+        { 0x7C0001CE, X, "stvx", Form::VD_RA_RB, 0 },
+        { 0x7C0003CE, X, "stvxl", Form::VD_RA_RB, 0 },
+    };
+
+private:
+    static constexpr size_t opcodeCount = sizeof (opcodes) / sizeof (opcodes[0]);
+    static constexpr uint16_t extendedTable = 0x8000; // Set in a primary table entry if the instruction is picked by its extended opcode
+
+    struct Tables {
+        uint16_t primary[2][64]; // Per DecodeMode. 0 = unknown, extendedTable | n = look in extended[n], otherwise index into opcodes + 1
+        uint16_t extended[6][2048]; // Indexed by the low 11 bits of the word: opcode 4 (paired singles), opcode 4 (AltiVec), 19, 31, 59, 63
+    };
+
+    static int getExtendedTable (uint32_t primary, uint8_t flags) {
+        switch (primary) {
+            case 4: return (flags & AltiVec) ? 1 : 0;
+            case 19: return 2;
+            case 31: return 3;
+            case 59: return 4;
+            case 63: return 5;
+            default: return -1;
+        }
+    }
+
+    static const Tables& getTables() {
+        static const Tables* tables = [] {
+            auto t = new Tables {}; // Never freed, this lives for the whole program
+            for (uint32_t primary = 0; primary < 64; primary++) {
+                const int table = getExtendedTable (primary, 0);
+                if (table >= 0) {
+                    t->primary[0][primary] = extendedTable | table;
+                    t->primary[1][primary] = extendedTable | (primary == 4 ? 1 : table);
+                }
+            }
+
+            // Fill in the less specific encodings first, so that more specific ones sharing their slots overwrite them
+            std::vector <uint16_t> order (opcodeCount);
+            for (size_t i = 0; i < opcodeCount; i++)
+                order[i] = (uint16_t) i;
+
+            const auto bitCount = [] (uint32_t value) { int count = 0; for (; value; value &= value - 1) count++; return count; };
+            std::stable_sort (order.begin(), order.end(), [&] (uint16_t lhs, uint16_t rhs) {
+                return bitCount (opcodes[lhs].mask) < bitCount (opcodes[rhs].mask);
+            });
+
+            for (const auto index : order) {
+                const auto& opcode = opcodes[index];
+                const uint32_t primary = opcode.match >> 26;
+
+                if (opcode.mask == Primary) {
+                    t->primary[0][primary] = index + 1;
+                    t->primary[1][primary] = index + 1;
+                    continue;
+                }
+
+                const uint32_t mask = opcode.mask & 0x7FF;
+                auto& table = t->extended[getExtendedTable (primary, opcode.flags)];
+                for (uint32_t low = 0; low < 2048; low++)
+                    if ((low & mask) == (opcode.match & mask))
+                        table[low] = index + 1;
+            }
+
+            return t;
+        }();
+
+        return *tables;
+    }
+
+    const Tables& tables;
+    DecodeMode mode;
+    bool simplify;
+
+    static int print (char* buffer, size_t size, const char* format, ...) {
+        std::va_list args;
+        va_start (args, format);
+        const int length = std::vsnprintf (buffer, size, format, args);
+        va_end (args);
+        return length;
+    }
+
+    int formatConditionalBranch (const Instruction& instruction, char* buffer, size_t size) const {
+        static constexpr const char* conditions[2][4] = { { "ge", "le", "ne", "ns" }, { "lt", "gt", "eq", "so" } };
+        const uint32_t word = instruction.word;
+        const uint32_t bo = (word >> 21) & 31;
+        const uint32_t bi = (word >> 16) & 31;
+        const auto form = instruction.opcode->form;
+
+        const char* reg = form == Form::BranchToLR ? "lr" : form == Form::BranchToCTR ? "ctr" : "";
+        const char* link = word & 1 ? "l" : "";
+        const char* absolute = form == Form::BranchConditional && (word & 2) ? "a" : "";
+        const char* hint = "";
+        if ((bo & 0x14) != 0x14 && (bo & 1)) // The y bit flips the static prediction, which depends on the direction for bc
+            hint = form == Form::BranchConditional && (int16_t) (word & 0xFFFC) < 0 ? "-" : "+";
+
+        char name[24];
+        char operands[48] = "";
+        bool usesCR = false;
+        if ((bo & 0x14) == 0x14) // Branch always
+            print (name, sizeof (name), "b%s%s%s", reg, link, absolute);
+        else if ((bo & 0x1C) == 0x0C || (bo & 0x1C) == 0x04) { // Branch if the CR bit is set/clear
+            print (name, sizeof (name), "b%s%s%s%s%s", conditions[(bo >> 3) & 1][bi & 3], reg, link, absolute, hint);
+            usesCR = true;
+        } else if ((bo & 0x16) == 0x10 || (bo & 0x16) == 0x12) // Decrement CTR, branch if it's (not) 0
+            print (name, sizeof (name), "%s%s%s%s%s", bo & 2 ? "bdz" : "bdnz", reg, link, absolute, hint);
+        else { // Anything else, in raw form
+            print (name, sizeof (name), "bc%s%s%s", reg, link, absolute);
+            print (operands, sizeof (operands), "%u, %u", bo, bi);
+        }
+
+        if (usesCR && (bi >> 2))
+            print (operands, sizeof (operands), "cr%u", bi >> 2);
+
+        if (form != Form::BranchConditional)
+            return operands[0] ? print (buffer, size, "%s %s", name, operands) : print (buffer, size, "%s", name);
+
+        const auto target = (unsigned long long) instruction.getBranchTarget();
+        return operands[0] ? print (buffer, size, "%s %s, 0x%llX", name, operands, target) : print (buffer, size, "%s 0x%llX", name, target);
+    }
+
+public:
+    Decoder (DecodeMode decodeMode = DecodeMode::PairedSingles, bool simplifiedMnemonics = true)
+        : tables (getTables()), mode (decodeMode), simplify (simplifiedMnemonics) {}
+
+    // Decode a single word. "address" is where it runs from
+    Instruction decode (uint32_t word, uintptr_t address = 0) const {
+        uint32_t entry = tables.primary[mode == DecodeMode::AltiVec][word >> 26];
+        if (entry & extendedTable)
+            entry = tables.extended[entry & 0xFF][word & 0x7FF];
+
+        return { word, address, entry ? &opcodes[entry - 1] : nullptr };
+    }
+
+    // Streaming API: call "callback" with every instruction in [begin, end), in order. "address" is where "begin" runs from
+    template <typename Func>
+    void forEach (const uint32_t* begin, const uint32_t* end, Func&& callback, uintptr_t address = 0) const {
+        for (auto pointer = begin; pointer < end; pointer++, address += 4)
+            callback (decode (*pointer, address));
+    }
+
+    // Batch API: decode all of [begin, end) at once
+    std::vector <Instruction> decodeAll (const uint32_t* begin, const uint32_t* end, uintptr_t address = 0) const {
+        std::vector <Instruction> instructions;
+        instructions.reserve (end - begin);
+        forEach (begin, end, [&] (const Instruction& instruction) { instructions.push_back (instruction); }, address);
+        return instructions;
+    }
+
+    // Write an instruction as assembly text (eg "addi r3, r1, 8"). Returns the length, like snprintf
+    int format (const Instruction& instruction, char* buffer, size_t size) const {
+        const uint32_t word = instruction.word;
+        const auto opcode = instruction.opcode;
+        if (!opcode)
+            return print (buffer, size, ".long 0x%08X", word);
+
+        const uint32_t d = (word >> 21) & 31;
+        const uint32_t a = (word >> 16) & 31;
+        const uint32_t b = (word >> 11) & 31;
+        const uint32_t c = (word >> 6) & 31;
+        const int simm = (int16_t) word;
+        const uint32_t uimm = word & 0xFFFF;
+        const char* name = opcode->mnemonic;
+        const char* rc = ((opcode->flags & Rc) && (word & 1)) || ((opcode->flags & VectorRc) && (word & 0x400)) ? "." : "";
+
+        if (simplify) {
+            switch (opcode->match) {
+                case 0x60000000: if (word == 0x60000000) return print (buffer, size, "nop"); break;
+                case 0x38000000: if (a == 0) return print (buffer, size, "li r%u, %d", d, simm); break;
+                case 0x3C000000: if (a == 0) return print (buffer, size, "lis r%u, 0x%X", d, uimm); break;
+                case 0x7C000378: if (d == b) return print (buffer, size, "mr%s r%u, r%u", rc, a, d); break;
+                case 0x7C000120: if (((word >> 12) & 0xFF) == 0xFF) return print (buffer, size, "mtcr r%u", d); break;
+                case 0x7C0003A6: case 0x7C0002A6: { // Moves to/from XER, LR and CTR
+                    const uint32_t spr = a | (b << 5);
+                    const char* names[] = { nullptr, "xer", nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, "lr", "ctr" };
+                    if (spr < 10 && names[spr])
+                        return print (buffer, size, "%s%s r%u", opcode->match == 0x7C0003A6 ? "mt" : "mf", names[spr], d);
+                    break;
+                }
+                default: break;
+            }
+        }
+
+        switch (opcode->form) {
+            case Form::None: return print (buffer, size, "%s", name);
+            case Form::Branch: {
+                const char* link = word & 1 ? "l" : "";
+                return print (buffer, size, "b%s%s 0x%llX", link, word & 2 ? "a" : "", (unsigned long long) instruction.getBranchTarget());
+            }
+            case Form::BranchConditional: case Form::BranchToLR: case Form::BranchToCTR: return formatConditionalBranch (instruction, buffer, size);
+            case Form::Sync: return print (buffer, size, "%s", (d & 3) == 1 ? "lwsync" : "sync");
+
+            case Form::RD_RA_SIMM: return print (buffer, size, "%s r%u, r%u, %d", name, d, a, simm);
+            case Form::RA_RS_UIMM: return print (buffer, size, "%s r%u, r%u, 0x%X", name, a, d, uimm);
+            case Form::CRF_RA_SIMM: return print (buffer, size, "%s cr%u, r%u, %d", name, d >> 2, a, simm);
+            case Form::CRF_RA_UIMM: return print (buffer, size, "%s cr%u, r%u, 0x%X", name, d >> 2, a, uimm);
+            case Form::GPR_MEM: return print (buffer, size, "%s r%u, %d(r%u)", name, d, simm, a);
+            case Form::FPR_MEM: return print (buffer, size, "%s f%u, %d(r%u)", name, d, simm, a);
+            case Form::PSQ_MEM: return print (buffer, size, "%s f%u, %d(r%u), %u, %u", name, d, (int32_t) (word << 20) >> 20, a, (word >> 15) & 1, (word >> 12) & 7);
+
+            case Form::RD_RA_RB: return print (buffer, size, "%s%s r%u, r%u, r%u", name, rc, d, a, b);
+            case Form::RA_RS_RB: return print (buffer, size, "%s%s r%u, r%u, r%u", name, rc, a, d, b);
+            case Form::RD_RA: return print (buffer, size, "%s%s r%u, r%u", name, rc, d, a);
+            case Form::RA_RS: return print (buffer, size, "%s%s r%u, r%u", name, rc, a, d);
+            case Form::RA_RS_SH: return print (buffer, size, "%s%s r%u, r%u, %u", name, rc, a, d, b);
+            case Form::RD_RB: return print (buffer, size, "%s r%u, r%u", name, d, b);
+            case Form::RA_RB: return print (buffer, size, "%s r%u, r%u", name, a, b);
+            case Form::RB: return print (buffer, size, "%s r%u", name, b);
+            case Form::GPR_D: return print (buffer, size, "%s r%u", name, d);
+            case Form::CRF_RA_RB: return print (buffer, size, "%s cr%u, r%u, r%u", name, d >> 2, a, b);
+            case Form::ROTATE_IMM: return print (buffer, size, "%s%s r%u, r%u, %u, %u, %u", name, rc, a, d, b, c, (word >> 1) & 31);
+            case Form::ROTATE: return print (buffer, size, "%s%s r%u, r%u, r%u, %u, %u", name, rc, a, d, b, c, (word >> 1) & 31);
+            case Form::CRB3: return print (buffer, size, "%s %u, %u, %u", name, d, a, b);
+            case Form::MTCRF: return print (buffer, size, "%s 0x%02X, r%u", name, (word >> 12) & 0xFF, d);
+            case Form::MTSR: return print (buffer, size, "%s %u, r%u", name, a & 15, d);
+            case Form::MFSR: return print (buffer, size, "%s r%u, %u", name, d, a & 15);
+            case Form::MTSPR: return print (buffer, size, "%s %u, r%u", name, a | (b << 5), d);
+            case Form::MFSPR: return print (buffer, size, "%s r%u, %u", name, d, a | (b << 5));
+            case Form::DST: return print (buffer, size, "%s%s r%u, r%u, %u", name, d & 16 ? "t" : "", a, b, d & 3);
+            case Form::DSS: return d & 16 ? print (buffer, size, "dssall") : print (buffer, size, "%s %u", name, d & 3);
+
+            case Form::FD_FA_FB: return print (buffer, size, "%s%s f%u, f%u, f%u", name, rc, d, a, b);
+            case Form::FD_FA_FC: return print (buffer, size, "%s%s f%u, f%u, f%u", name, rc, d, a, c);
+            case Form::FD_FA_FC_FB: return print (buffer, size, "%s%s f%u, f%u, f%u, f%u", name, rc, d, a, c, b);
+            case Form::FD_FB: return print (buffer, size, "%s%s f%u, f%u", name, rc, d, b);
+            case Form::CRF_FA_FB: return print (buffer, size, "%s cr%u, f%u, f%u", name, d >> 2, a, b);
+            case Form::PSQ_INDEXED: return print (buffer, size, "%s f%u, r%u, r%u, %u, %u", name, d, a, b, (word >> 10) & 1, (word >> 7) & 7);
+
+            case Form::VD_VA_VB_VC: return print (buffer, size, "%s v%u, v%u, v%u, v%u", name, d, a, b, c);
+            case Form::VSLDOI: return print (buffer, size, "%s v%u, v%u, v%u, %u", name, d, a, b, c & 15);
+            case Form::VD_VA_VB: return print (buffer, size, "%s%s v%u, v%u, v%u", name, rc, d, a, b);
+            case Form::VD_VB: return print (buffer, size, "%s v%u, v%u", name, d, b);
+            case Form::VD_VB_UIMM: return print (buffer, size, "%s v%u, v%u, %u", name, d, b, a);
+            case Form::VD_SIMM: return print (buffer, size, "%s v%u, %d", name, d, (int32_t) (a << 27) >> 27);
+            case Form::VD: return print (buffer, size, "%s v%u", name, d);
+            case Form::VB: return print (buffer, size, "%s v%u", name, b);
+            case Form::VD_RA_RB: return print (buffer, size, "%s v%u, r%u, r%u", name, d, a, b);
+        }
+
+        return print (buffer, size, "%s", name);
+    }
+
+    std::string toString (const Instruction& instruction) const {
+        char buffer[96];
+        format (instruction, buffer, sizeof (buffer));
+        return buffer;
+    }
+
+    // A listing of [begin, end) with one "address: word  instruction" line per instruction
+    std::string disassemble (const uint32_t* begin, const uint32_t* end, uintptr_t address = 0) const {
+        std::string listing;
+        listing.reserve ((end - begin) * 48);
+        forEach (begin, end, [&] (const Instruction& instruction) {
+            char line[128];
+            const int prefix = print (line, sizeof (line), "%08llX: %08X  ", (unsigned long long) instruction.address, instruction.word);
+            format (instruction, line + prefix, sizeof (line) - prefix);
+            listing += line;
+            listing += '\n';
+        }, address);
+
+        return listing;
+    }
+};
+
+// What emitters have been spending their instructions and bytes on. Only collected when LUMA_STATS is 1, otherwise everything stays 0
+struct EmitterStats {
+    enum Category { Integer, Memory, Branch, Float, Vector, System, CategoryCount };
+
+    uint64_t instructions = 0;
+    uint64_t categories[CategoryCount] = {};
+    uint64_t opcodes[64] = {}; // By primary opcode
+    uint64_t liwShort = 0; // liw calls that fit in a single li or lis
+    uint64_t liwLong = 0; // liw calls that needed lis + ori
+    uint64_t labelFixups = 0; // Branches pointed at labels, patched when the labels get resolved
+    uint64_t branchPatches = 0; // Branch displacements written (labels, anchors, absolute targets, veneers, and buffer moves)
+    uint64_t reallocations = 0; // Times an AutoGrow buffer moved
+    uint64_t bytesCopied = 0; // Code copied by those moves
+    uint64_t blocks = 0; // Blocks finished with endBlock()
+    uint64_t blockBytes = 0;
+    uint32_t largestBlock = 0;
+    uint64_t blockSizes[16] = {}; // Histogram: bucket n counts blocks of 2^n to 2^(n+1) - 1 bytes, the last one everything bigger
+
+    static constexpr const char* categoryNames[CategoryCount] = { "Integer", "Memory", "Branch", "Float", "Vector", "System" };
+
+    static constexpr Category categorize (uint32_t instruction) {
+        const uint32_t opcode = instruction >> 26;
+        const uint32_t xo = (instruction >> 1) & 0x3FF;
+
+        switch (opcode) {
+            case 4: return Vector; // Paired singles or AltiVec
+            case 16: case 18: return Branch;
+            case 17: return System; // sc
+            case 19: return xo == 16 || xo == 528 ? Branch : System; // bclr/bcctr, or CR logic/isync/rfi
+            case 59: case 63: return Float;
+            case 31:
+                switch (xo) {
+                    case 20: case 23: case 55: case 87: case 119: case 150: case 151: case 183: case 215: case 247: // Loads/stores indexed
+                    case 279: case 311: case 343: case 375: case 407: case 439: case 534: case 535: case 567: case 599:
+                    case 631: case 662: case 663: case 695: case 727: case 759: case 790: case 918: case 983:
+                        return Memory;
+                    case 6: case 38: case 7: case 39: case 71: case 103: case 359: case 135: case 167: case 199: // AltiVec loads/stores/streams
+                    case 231: case 487: case 342: case 374: case 822:
+                        return Vector;
+                    case 19: case 83: case 144: case 146: case 210: case 242: case 339: case 467: case 595: case 659: // Special registers
+                    case 306: case 566: case 598: case 854: case 54: case 86: case 246: case 278: case 470: case 982: case 1014: // TLB, sync, caches
+                    case 4: case 512:
+                        return System;
+                    default: return Integer;
+                }
+            default: return opcode >= 32 && opcode <= 61 ? Memory : Integer; // D-form loads/stores, including FPU and quantized ones
+        }
+    }
+
+    void print() const {
+        printf ("%llu instructions\n", (unsigned long long) instructions);
+        for (int i = 0; i < CategoryCount; i++)
+            printf ("  %-8s %llu\n", categoryNames[i], (unsigned long long) categories[i]);
+
+        printf ("liw: %llu short, %llu long\n", (unsigned long long) liwShort, (unsigned long long) liwLong);
+        printf ("%llu label fixups, %llu branch patches\n", (unsigned long long) labelFixups, (unsigned long long) branchPatches);
+        printf ("%llu reallocations (%llu bytes copied)\n", (unsigned long long) reallocations, (unsigned long long) bytesCopied);
+        if (blocks)
+            printf ("%llu blocks, %llu bytes on average, %u bytes max\n", (unsigned long long) blocks,
+                    (unsigned long long) (blockBytes / blocks), largestBlock);
+    }
+};
+
+// GDB's JIT interface. GDB breaks on __jit_debug_register_code, and reads the in-memory symbol files linked from __jit_debug_descriptor whenever it gets called
+// Both need these exact names and C linkage. Being inline, they merge with the ones from any other JIT linked into the program
+extern "C" {
+struct jit_code_entry {
+    jit_code_entry* next_entry;
+    jit_code_entry* prev_entry;
+    const char* symfile_addr;
+    uint64_t symfile_size;
+};
+
+struct jit_descriptor {
+    uint32_t version;
+    uint32_t action_flag; // 0 = nothing, 1 = register relevant_entry, 2 = unregister it
+    jit_code_entry* relevant_entry;
+    jit_code_entry* first_entry;
+};
+
+[[gnu::noinline]] inline void __jit_debug_register_code() {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile ("" ::: "memory"); // Keep the call and the function from being optimized away
+#endif
+}
+
+inline jit_descriptor __jit_debug_descriptor = { 1, 0, nullptr, nullptr };
+}
+
+// Names for regions of emitted code, for profilers, debuggers and crash dumps
+// Every symbol is streamed out as soon as it's added: appended to a perf map (/tmp/perf-<pid>.map) and/or registered with GDB's JIT interface
+// Thread-safe, so compiler threads sharing a CodeCache can share a registry too
+class SymbolRegistry {
+public:
+    struct Symbol {
+        uintptr_t start; // Executable address
+        uintptr_t size;
+        std::string name;
+    };
+
+private:
+    struct Entry {
+        Symbol symbol;
+        std::vector <uint8_t> symbolFile; // The ELF GDB reads the symbol from
+        jit_code_entry gdbEntry {};
+        bool registeredWithGDB = false;
+    };
+
+    std::map <uintptr_t, Entry> entries; // By start address. Nodes never move, so GDB can keep pointers into them
+    std::mutex lock;
+    FILE* perfMap = nullptr;
+    bool gdb = false;
+
+    // Build a minimal ELF relocatable for the host holding a NOBITS .text at the symbol's address, and a symbol covering it
+    static std::vector <uint8_t> buildSymbolFile (const Symbol& symbol) {
+#if defined(__x86_64__) || defined(_M_X64)
+        constexpr uint16_t machine = 62;
+#elif defined(__i386__) || defined(_M_IX86)
+        constexpr uint16_t machine = 3;
+#elif defined(__aarch64__) || defined(_M_ARM64)
+        constexpr uint16_t machine = 183;
+#elif defined(__arm__) || defined(_M_ARM)
+        constexpr uint16_t machine = 40;
+#elif defined(__powerpc64__)
+        constexpr uint16_t machine = 21;
+#elif defined(__powerpc__) || defined(__ppc__) || defined(GEKKO)
+        constexpr uint16_t machine = 20;
+#else
+        constexpr uint16_t machine = 0;
+#endif
+        constexpr bool is64 = sizeof (void*) == 8;
+        constexpr uint32_t word = is64 ? 8 : 4; // Size of addresses and offsets
+        constexpr uint32_t headerSize = is64 ? 64 : 52;
+        constexpr uint32_t sectionHeaderSize = is64 ? 64 : 40;
+        constexpr uint32_t symbolSize = is64 ? 24 : 16;
+        const uint16_t endianTest = 1;
+        const bool littleEndian = *(const uint8_t*) &endianTest == 1;
+
+        const char sectionNames[] = "\0.text\0.symtab\0.strtab\0.shstrtab"; // Offsets 1, 7, 15, 23
+        const uint32_t sectionNamesSize = sizeof (sectionNames);
+        const uint32_t stringsOffset = headerSize + sectionNamesSize;
+        const uint32_t stringsSize = (uint32_t) symbol.name.size() + 2; // Leading empty string, then the name
+        const uint32_t symbolsOffset = (stringsOffset + stringsSize + 7) & ~7u;
+        const uint32_t sectionsOffset = symbolsOffset + 2 * symbolSize;
+
+        std::vector <uint8_t> file;
+        file.reserve (sectionsOffset + 5 * sectionHeaderSize);
+        const auto put = [&] (uint64_t value, uint32_t bytes) { // Native byte order, as GDB reads files for the host
+            for (uint32_t i = 0; i < bytes; i++)
+                file.push_back ((uint8_t) (value >> ((littleEndian ? i : bytes - 1 - i) * 8)));
+        };
+        const auto pad = [&] (uint32_t offset) { file.resize (offset, 0); };
+
+        // ELF header
+        const uint8_t ident[16] = { 0x7F, 'E', 'L', 'F', is64 ? 2 : 1, (uint8_t) (littleEndian ? 1 : 2), 1 };
+        file.insert (file.end(), ident, ident + 16);
+        put (1, 2); // ET_REL
+        put (machine, 2);
+        put (1, 4); // EV_CURRENT
+        put (0, word); // Entry point
+        put (0, word); // No program headers
+        put (sectionsOffset, word);
+        put (0, 4); // Flags
+        put (headerSize, 2);
+        put (0, 2);
+        put (0, 2);
+        put (sectionHeaderSize, 2);
+        put (5, 2); // Section count
+        put (4, 2); // .shstrtab
+
+        file.insert (file.end(), sectionNames, sectionNames + sectionNamesSize);
+        file.push_back (0);
+        file.insert (file.end(), symbol.name.begin(), symbol.name.end());
+        file.push_back (0);
+        pad (symbolsOffset);
+
+        // Symbols: the null one, then the function itself, relative to .text
+        const auto putSymbol = [&] (uint32_t name, uint8_t info, uint16_t section, uint64_t size) {
+            put (name, 4);
+            if (is64) {
+                file.push_back (info);
+                file.push_back (0);
+                put (section, 2);
+                put (0, 8);
+                put (size, 8);
+            } else {
+                put (0, 4);
+                put (size, 4);
+                file.push_back (info);
+                file.push_back (0);
+                put (section, 2);
+            }
+        };
+        putSymbol (0, 0, 0, 0);
+        putSymbol (1, 0x12, 1, symbol.size); // STB_GLOBAL, STT_FUNC
+
+        const auto putSection = [&] (uint32_t name, uint32_t type, uint64_t flags, uint64_t address, uint64_t offset, uint64_t size,
+                                     uint32_t link, uint32_t info, uint64_t align, uint64_t entrySize) {
+            put (name, 4);
+            put (type, 4);
+            put (flags, word);
+            put (address, word);
+            put (offset, word);
+            put (size, word);
+            put (link, 4);
+            put (info, 4);
+            put (align, word);
+            put (entrySize, word);
+        };
+        putSection (0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+        putSection (1, 8, 6, symbol.start, 0, symbol.size, 0, 0, 4, 0); // .text: SHT_NOBITS, SHF_ALLOC | SHF_EXECINSTR, at the code's address
+        putSection (7, 2, 0, 0, symbolsOffset, 2 * symbolSize, 3, 1, word, symbolSize); // .symtab, strings in section 3, first global is symbol 1
+        putSection (15, 3, 0, 0, stringsOffset, stringsSize, 0, 0, 1, 0); // .strtab
+        putSection (23, 3, 0, 0, headerSize, sectionNamesSize, 0, 0, 1, 0); // .shstrtab
+        return file;
+    }
+
+    void registerWithGDB (Entry& entry) {
+        entry.symbolFile = buildSymbolFile (entry.symbol);
+        entry.gdbEntry.symfile_addr = (const char*) entry.symbolFile.data();
+        entry.gdbEntry.symfile_size = entry.symbolFile.size();
+        entry.gdbEntry.prev_entry = nullptr;
+        entry.gdbEntry.next_entry = __jit_debug_descriptor.first_entry;
+        if (entry.gdbEntry.next_entry)
+            entry.gdbEntry.next_entry->prev_entry = &entry.gdbEntry;
+
+        __jit_debug_descriptor.first_entry = &entry.gdbEntry;
+        __jit_debug_descriptor.relevant_entry = &entry.gdbEntry;
+        __jit_debug_descriptor.action_flag = 1; // JIT_REGISTER_FN
+        __jit_debug_register_code();
+        entry.registeredWithGDB = true;
+    }
+
+    void unregisterFromGDB (Entry& entry) {
+        if (!entry.registeredWithGDB)
+            return;
+
+        auto& gdbEntry = entry.gdbEntry;
+        if (gdbEntry.prev_entry)
+            gdbEntry.prev_entry->next_entry = gdbEntry.next_entry;
+        else
+            __jit_debug_descriptor.first_entry = gdbEntry.next_entry;
+        if (gdbEntry.next_entry)
+            gdbEntry.next_entry->prev_entry = gdbEntry.prev_entry;
+
+        __jit_debug_descriptor.relevant_entry = &gdbEntry;
+        __jit_debug_descriptor.action_flag = 2; // JIT_UNREGISTER_FN
+        __jit_debug_register_code();
+        entry.registeredWithGDB = false;
+    }
+
+public:
+    SymbolRegistry() = default;
+    SymbolRegistry (const SymbolRegistry&) = delete;
+    SymbolRegistry& operator= (const SymbolRegistry&) = delete;
+
+    ~SymbolRegistry() {
+        for (auto& [start, entry] : entries)
+            unregisterFromGDB (entry);
+        if (perfMap)
+            std::fclose (perfMap);
+    }
+
+    // Append every symbol added from now on to a perf map. The default path is the one perf looks for, /tmp/perf-<pid>.map
+    // Symbols that were already added are written out first. Returns false if the file couldn't be opened
+    bool enablePerfMap (std::string path = "") {
+        std::lock_guard <std::mutex> guard (lock);
+        if (path.empty()) {
+#if defined(_WIN32)
+            path = "/tmp/perf-" + std::to_string (GetCurrentProcessId()) + ".map";
+#elif LUMA_HAS_VIRTUAL_MEMORY
+            path = "/tmp/perf-" + std::to_string ((long) getpid()) + ".map";
+#else
+            panic ("[SymbolRegistry] Fatal: No default perf map path on this platform\n");
+#endif
+        }
+
+        if (perfMap)
+            std::fclose (perfMap);
+        perfMap = std::fopen (path.c_str(), "a");
+        if (!perfMap)
+            return false;
+
+        for (const auto& [start, entry] : entries)
+            std::fprintf (perfMap, "%zx %zx %s\n", (size_t) start, (size_t) entry.symbol.size, entry.symbol.name.c_str());
+        std::fflush (perfMap);
+        return true;
+    }
+
+    // Register every symbol, past and future, with GDB's JIT interface
+    void enableGDB() {
+        std::lock_guard <std::mutex> guard (lock);
+        gdb = true;
+        for (auto& [start, entry] : entries)
+            if (!entry.registeredWithGDB)
+                registerWithGDB (entry);
+    }
+
+    // Name "size" bytes of code starting at the executable address "start". A symbol already starting there is replaced
+    void add (const void* start, uintptr_t size, std::string name) {
+        std::lock_guard <std::mutex> guard (lock);
+        const auto address = (uintptr_t) start;
+        const auto existing = entries.find (address);
+        if (existing != entries.end()) {
+            unregisterFromGDB (existing->second);
+            entries.erase (existing);
+        }
+
+        auto& entry = entries[address];
+        entry.symbol = { address, size, std::move (name) };
+        if (perfMap) { // perf keeps the most recent entry for an address, so nothing ever needs to be removed from the map
+            std::fprintf (perfMap, "%zx %zx %s\n", (size_t) address, (size_t) size, entry.symbol.name.c_str());
+            std::fflush (perfMap);
+        }
+
+        if (gdb)
+            registerWithGDB (entry);
+    }
+
+    // Drop the symbol starting at "start", eg because its code was evicted
+    void remove (const void* start) {
+        std::lock_guard <std::mutex> guard (lock);
+        const auto entry = entries.find ((uintptr_t) start);
+        if (entry != entries.end()) {
+            unregisterFromGDB (entry->second);
+            entries.erase (entry);
+        }
+    }
+
+    // Find the symbol containing an executable address, eg for crash dumps or to annotate a disassembly. Returns false if there's none
+    bool find (const void* address, Symbol& result) {
+        std::lock_guard <std::mutex> guard (lock);
+        auto entry = entries.upper_bound ((uintptr_t) address);
+        if (entry == entries.begin())
+            return false;
+
+        entry--;
+        if ((uintptr_t) address - entry->first >= entry->second.symbol.size)
+            return false;
+
+        result = entry->second.symbol;
+        return true;
+    }
+
+    size_t size() {
+        std::lock_guard <std::mutex> guard (lock);
+        return entries.size();
+    }
+};
+
+// Deduplicated constants for single-instruction loads: lwz for 32-bit immediates, lfs/lfd for floats, lvx for vectors
+// The pool is a fixed block of data memory that a pinned base register points into, so that all of it is reachable with 16-bit offsets
+// Load the base register with getBase() once (eg in the dispatcher), and share one pool between every block of a code cache
+// Adding constants is thread-safe, so emitters on different threads can share a pool too
+class LiteralPool {
+    struct alignas (16) Line { uint8_t bytes[16]; };
+
+    Line* storage;
+    uint32_t capacity; // In bytes, at most 64KB
+    uint32_t used = 0;
+    std::unordered_map <uint32_t, uint32_t> words; // Value -> offset from the start of the pool
+    std::unordered_map <uint64_t, uint32_t> doublewords;
+    std::map <std::array <uint32_t, 4>, uint32_t> vectors;
+    std::mutex lock; // Guards the maps and "used"
+
+    // Carve out "size" bytes aligned to "size" and copy "data" there. Returns UINT32_MAX if the pool is full
+    uint32_t allocate (const void* data, uint32_t size) {
+        const uint32_t offset = (used + size - 1) & ~(size - 1);
+        if (offset + size > capacity)
+            return UINT32_MAX;
+
+        std::memcpy ((uint8_t*) storage + offset, data, size);
+        used = offset + size;
+        return offset;
+    }
+
+    template <typename Map, typename Key>
+    bool find (Map& map, const Key& key, const void* data, uint32_t size, int16_t& displacement) {
+        std::lock_guard <std::mutex> guard (lock);
+        auto it = map.find (key);
+        if (it == map.end()) {
+            const auto offset = allocate (data, size);
+            if (offset == UINT32_MAX)
+                return false;
+            it = map.emplace (key, offset).first;
+        }
+
+        displacement = (int16_t) (it->second - 0x8000);
+        return true;
+    }
+
+public:
+    LiteralPool (uint32_t size = 64 * 1024) : capacity ((size + 15) & ~15u) {
+        if (size == 0 || capacity > 64 * 1024)
+            panic ("[LiteralPool] Fatal: Pool size must be between 1 byte and 64KB (got %u bytes)\n", size);
+
+        storage = new Line [capacity / 16];
+    }
+
+    ~LiteralPool() { delete[] storage; }
+
+    LiteralPool (const LiteralPool&) = delete;
+    LiteralPool& operator= (const LiteralPool&) = delete;
+
+    // What the base register should hold: 32KB into the pool, so that displacements cover all of it
+    void* getBase() { return (void*) ((uintptr_t) storage + 0x8000); }
+
+    // Find or add a constant, and get its displacement from the base register. Returns false if the pool is full
+    bool add (uint32_t value, int16_t& displacement) { return find (words, value, &value, 4, displacement); }
+    bool add (float value, int16_t& displacement) {
+        uint32_t bits;
+        std::memcpy (&bits, &value, 4);
+        return add (bits, displacement); // Floats share words with integers that have the same bits
+    }
+
+    bool add (double value, int16_t& displacement) {
+        uint64_t bits;
+        std::memcpy (&bits, &value, 8);
+        return find (doublewords, bits, &value, 8, displacement);
+    }
+
+    bool add (const std::array <uint32_t, 4>& value, int16_t& displacement) { return find (vectors, value, value.data(), 16, displacement); }
+
+    uint32_t getUsed() {
+        std::lock_guard <std::mutex> guard (lock);
+        return used;
+    }
+
+    uint32_t getCapacity() { return capacity; }
+    size_t getCount() {
+        std::lock_guard <std::mutex> guard (lock);
+        return words.size() + doublewords.size() + vectors.size();
+    }
+};
+
+// "byteOrder" is the byte order of the emitted code. Only NativeEndian (or the host's own order) can be executed in place
+template <GrowingMode growMode = FixedSize, ByteOrder byteOrder = NativeEndian>
+class PPCEmitter : public InstructionSet <PPCEmitter <growMode, byteOrder>> {
+    friend class InstructionSet <PPCEmitter>;
+
+    // Whether values have to be byteswapped on their way into the buffer, and words on their way out when they get patched
+    static constexpr bool swapBytes = byteOrder != NativeEndian && byteOrder != hostByteOrder;
+
+    template <typename T> // The unsigned type byteswap works on for a T
+    using Bits = std::conditional_t <sizeof (T) == 2, uint16_t, std::conditional_t <sizeof (T) == 4, uint32_t, uint64_t>>;
+
+    // Read and write words already in the buffer, converting between host and target byte order
+    static uint32_t loadWord (const uint32_t* address) {
+        if constexpr (swapBytes)
+            return byteswap (*address);
+        else
+            return *address;
+    }
+
+    static void storeWord (uint32_t* address, uint32_t word) {
+        if constexpr (swapBytes)
+            *address = byteswap (word);
+        else
+            *address = word;
+    }
+
+    // Bring "count" values of type T that were just copied to "start" in host order into target byte order
+    template <typename T>
+    static void swapInPlace (void* start, size_t count) {
+        if constexpr (swapBytes && sizeof (T) > 1) {
+            auto values = (Bits <T>*) start;
+            for (size_t i = 0; i < count; i++) // Kept as a plain loop so that it gets vectorized
+                values[i] = byteswap (values[i]);
+        }
+    }
+
+    uint32_t* code = nullptr; // Pointer to the code buffer
+    uint32_t* currentPointer = nullptr; // Pointer to the current address in the code buffer
+    uintptr_t reservedSize = 0; // The size reserved by the code buffer
+    uint32_t* bufferEnd = nullptr; // code + reservedSize, cached so that the capacity check in write is a single compare
+    uintptr_t autoGrowSize = 64 * 1024; // How much the code buffer will be grown if AutoGrow is on and it overflows (default = 64KB)
+    CodeArena* arena = nullptr; // The arena our buffer was allocated from, if any
+    intptr_t execOffset = 0; // Distance from the buffer we write to, to the address the code gets executed from
+    bool ownsBuffer = false; // Whether we allocated the buffer ourselves and should free it when AutoGrow replaces it
+    uint32_t committedSize = 0; // Everything before this offset has been flushed to the instruction cache by commit()
+    uint32_t dirtyStart = UINT32_MAX; // Lowest offset of already-committed code that has been patched since
+    uint32_t scopeDepth = 0; // How many EmitScopes are open. Their reservations already cover every write, so write skips the capacity check
+
+    // Relative branches to code outside of the buffer. Their displacements have to be re-encoded whenever the code is moved
+    struct ExternalBranch {
+        uint32_t offset; // Offset of the branch in the code buffer
+        void* target;
+    };
+    std::vector <ExternalBranch> externalBranches;
+
+    // Symbols and relocations for relocatable object output. Branches to addresses outside of the buffer become relocations too, from externalBranches
+    std::vector <ObjectSymbol> symbols;
+    std::vector <Relocation> relocations;
+
+    static constexpr size_t minTableCases = 4; // Fewer cases than this are cheaper as compares
+    static constexpr int64_t maxTableSparsity = 3; // A jump table may have at most this many entries per case
+
+    void compareCase (GPR value, int32_t constant, GPR scratch) {
+        if (constant >= INT16_MIN && constant <= INT16_MAX)
+            this->cmpi (cr0, value, (int16_t) constant);
+        else {
+            liw (scratch, (uint32_t) constant);
+            this->cmp (cr0, value, scratch);
+        }
+    }
+
+    // A run of switch cases that is handled as one: a single compare, or a jump table if the run is dense enough
+    struct CaseCluster {
+        const SwitchCase* cases;
+        size_t count;
+        bool isTable;
+    };
+
+    // Emit the jump table for a dense cluster. Values outside of it go to defaultLabel
+    void emitCaseTable (GPR value, const CaseCluster& cluster, Label defaultLabel, GPR scratch) {
+        const int64_t first = cluster.cases[0].value;
+        std::vector <Label> targets (cluster.cases[cluster.count - 1].value - first + 1, defaultLabel); // Gaps go to the default
+        for (size_t i = 0; i < cluster.count; i++)
+            targets[cluster.cases[i].value - first] = cluster.cases[i].target;
+
+        if (value != r0 && -first >= INT16_MIN && -first <= INT16_MAX) // Rebase the value so the table starts at 0
+            this->addi (r0, value, (int16_t) -first);
+        else {
+            liw (scratch, (uint32_t) -first);
+            this->add (r0, value, scratch);
+        }
+
+        switchTable (r0, targets, defaultLabel, scratch);
+    }
+
+    // Binary search over sorted clusters, down to a few compares and at most one table per leaf
+    void lowerClusters (GPR value, const CaseCluster* clusters, size_t count, Label defaultLabel, GPR scratch) {
+        size_t tables = 0;
+        for (size_t i = 0; i < count; i++)
+            tables += clusters[i].isTable;
+
+        if (count < minTableCases && tables <= 1) {
+            const CaseCluster* table = nullptr;
+            for (size_t i = 0; i < count; i++) {
+                if (clusters[i].isTable)
+                    table = &clusters[i];
+                else {
+                    compareCase (value, clusters[i].cases[0].value, scratch);
+                    beq (clusters[i].cases[0].target);
+                }
+            }
+
+            if (table)
+                emitCaseTable (value, *table, defaultLabel, scratch); // Its bounds check doubles as the jump to the default
+            else
+                b (defaultLabel);
+            return;
+        }
+
+        const auto middle = count / 2;
+        const auto lower = newLabel();
+        compareCase (value, clusters[middle].cases[0].value, scratch);
+        blt (lower);
+        lowerClusters (value, clusters + middle, count - middle, defaultLabel, scratch);
+
+        bind (lower);
+        lowerClusters (value, clusters, middle, defaultLabel, scratch);
+    }
+
+    // Slow paths waiting to be placed after the hot code, and the labels the hot code branches to them with
+    std::vector <std::pair <Label, std::function <void (PPCEmitter&)>>> coldPaths;
+
+    // Place the cold paths from index "first" on, including any they defer in turn, and drop them from the queue
+    void emitColdPaths (size_t first) {
+        for (size_t i = first; i < coldPaths.size(); i++) { // Cold paths can defer more cold paths, which go after them
+            auto path = std::move (coldPaths[i]);
+            bind (path.first);
+            path.second (*this);
+        }
+
+        coldPaths.resize (first);
+    }
+
+    // Jump table entries, holding the distance from their table to a label. Filled in by resolveLabels
+    struct TableEntry {
+        uint32_t offset; // Offset of the entry
+        uint32_t table; // Offset of the table the entry is relative to
+        uint32_t label;
+    };
+    std::vector <TableEntry> tableEntries;
+
+    // Re-point every load of an address inside the buffer (eg a jump table's) to where the buffer is now
+    void patchSectionRelocations() {
+        for (const auto& relocation : relocations) {
+            if (relocation.symbol != Relocation::section)
+                continue;
+
+            const auto pc = (uintptr_t) getExecutable (code) + relocation.offset;
+            uint32_t word = loadWord (code + relocation.offset / 4);
+            applyRelocation (&word, pc, (uintptr_t) getExecutable (code) + relocation.addend, relocation.type);
+            storeWord (code + relocation.offset / 4, word);
+            if (relocation.offset < committedSize && relocation.offset < dirtyStart)
+                dirtyStart = relocation.offset;
+        }
+    }
+
+    // Emit "instruction" so that the peephole optimizer can't merge or drop it, and record a relocation against it
+    void emitRelocated (uint32_t instruction, RelocationType type, SymbolRef symbol, int32_t addend) {
+        pinPosition();
+        this->emit (instruction);
+        relocations.push_back ({ (uint32_t) getCodeSize() - 4, type, symbol.id, addend });
+        pinPosition();
+    }
+
+    static constexpr uint32_t unboundLabel = UINT32_MAX;
+    std::vector <uint32_t> labelTargets; // Offset each label is bound to, indexed by label ID
+
+    // A branch to a label. Offsets are word-aligned, so the branch type is packed into the bottom bit, and whether it has a hint into
+    // the next one. Until the branch is patched, its y bit says which hint (set for Likely)
+    static constexpr uint32_t hintedFixup = 2;
+    static constexpr uint32_t yBit = 1 << 21; // Lowest bit of BO
+    struct Fixup {
+        uint32_t offsetAndType;
+        uint32_t label;
+    };
+    std::vector <Fixup> fixups;
+
+    // Branch relaxation. Conditional branches only reach +-32KB, so while relaxation is on we track the ones that aren't resolved yet
+    // Before the oldest of them would go out of range, we emit an island of veneers ("b target" stubs) it can be routed through
+    struct ShortBranch {
+        uint32_t offset; // Offset of the conditional branch
+        uint32_t veneer; // Offset of its veneer, or noVeneer
+        uintptr_t target; // Where it should branch to. An offset into the buffer if targetIsInternal, otherwise an absolute address
+        bool targetIsInternal;
+        bool targetKnown; // Resolved out of range before it got a veneer, so the next island has to provide one
+        bool done; // Patched to its final target
+    };
+
+    static constexpr uint32_t noVeneer = UINT32_MAX;
+    static constexpr uint32_t branch14Reach = 0x7FF8; // An island must start within this many bytes of a branch for its veneer to be reachable
+    static constexpr uint32_t islandSlack = 0x1000; // Islands are placed this early, as we only check for them at branches and labels
+    bool relaxBranches = false;
+    std::vector <ShortBranch> shortBranches; // Sorted by offset, as branches are appended in emission order
+    size_t firstUnveneered = 0; // Every entry before this one is done or has a veneer
+
+    void* targetPointer (const ShortBranch& branch) {
+        return branch.targetIsInternal ? (void*) (code + branch.target / 4) : (void*) branch.target;
+    }
+
+    // Emit an island if the oldest unresolved conditional branch is about to go out of range
+    void pollIslands() {
+        if (!relaxBranches)
+            return;
+
+        while (firstUnveneered < shortBranches.size() && (shortBranches[firstUnveneered].done || shortBranches[firstUnveneered].veneer != noVeneer))
+            firstUnveneered++;
+
+        if (firstUnveneered < shortBranches.size() && getCodeSize() + islandSlack >= shortBranches[firstUnveneered].offset + branch14Reach)
+            emitIsland();
+    }
+
+    bool fitsBranch14 (uint32_t offset, void* address) {
+        const bool isInternal = (uintptr_t) address - (uintptr_t) code < reservedSize;
+        const intptr_t disp = (intptr_t) address - ((intptr_t) code + offset + (isInternal ? 0 : execOffset));
+        return disp <= INT16_MAX && disp >= INT16_MIN;
+    }
+
+    // setLabel for conditional branches when relaxation is on: Go direct if we can, otherwise through a veneer
+    void resolveShortBranch (uint32_t offset, void* address, BranchHint hint) {
+        auto it = shortBranches.end() - (shortBranches.empty() ? 0 : 1); // The branch being resolved is usually the newest one
+        if (it == shortBranches.end() || it -> offset != offset) {
+            it = std::lower_bound (shortBranches.begin(), shortBranches.end(), offset, [](const ShortBranch& branch, uint32_t value) { return branch.offset < value; });
+            if (it == shortBranches.end() || it -> offset != offset) { // Emitted before relaxation was turned on
+                patchBranch (code + offset / 4, BranchType::Branch14, address, hint);
+                return;
+            }
+        }
+
+        auto& branch = *it;
+        if (fitsBranch14 (offset, address)) {
+            patchBranch (code + offset / 4, BranchType::Branch14, address, hint);
+            branch.done = true;
+        } else if (branch.veneer != noVeneer) {
+            patchBranch (code + branch.veneer / 4, BranchType::Branch24, address);
+            branch.done = true;
+        } else if ((uintptr_t) address > (uintptr_t) (code + offset / 4) && (uintptr_t) address <= (uintptr_t) currentPointer) {
+            panic ("[Emitter] Fatal: Conditional branch went out of range before an island was emitted. Call emitIsland() in long runs of straight-line code\n");
+        } else { // Remember the target, the next island will give the branch a veneer to it
+            branch.targetIsInternal = (uintptr_t) address - (uintptr_t) code < reservedSize;
+            branch.target = branch.targetIsInternal ? (uintptr_t) address - (uintptr_t) code : (uintptr_t) address;
+            branch.targetKnown = true;
+        }
+    }
+
+    // Make sure there's room for "bytes" more bytes of code, growing the buffer if AutoGrow is on
+    // Batch writers call this once up front and then use writeUnchecked
+    void ensureCapacity (uintptr_t bytes) {
+        if constexpr (growMode == AutoGrow || LUMA_CHECK_OVERFLOW) {
+            if (bytes > (uintptr_t) bufferEnd - (uintptr_t) currentPointer)
+                overflow (bytes);
+        }
+    }
+
+    // Called when the buffer doesn't have room for "bytes" more bytes
+    [[gnu::noinline]] void overflow (uintptr_t bytes) {
+        if constexpr (growMode == AutoGrow)
+            grow (bytes);
+        else
+            panic ("[Emitter] Fatal: Code buffer overflow (Using: %zu bytes, requested %zu more. Allocated: %zu bytes)\n", (size_t) getCodeSize(), (size_t) bytes, (size_t) reservedSize);
+    }
+
+    // Move the code to a buffer at least twice as big, so that growing stays O(1) amortized
+    // Labels and anchors are offsets, so only branches to code outside the buffer need to be fixed up
+    void grow (uintptr_t bytes) {
+        const auto currentSize = getCodeSize();
+        auto newSize = reservedSize + autoGrowSize;
+        if (newSize < reservedSize * 2)
+            newSize = reservedSize * 2;
+        while (newSize - currentSize < bytes)
+            newSize *= 2;
+
+        const auto newBuffer = arena ? arena -> allocate (newSize) : new uint32_t [newSize / 4];
+        if (!newBuffer)
+            panic ("[Emitter] Fatal: Failed to grow the code buffer to %zu bytes\n", (size_t) newSize);
+
+        if (currentSize != 0)
+            std::memcpy (newBuffer, code, currentSize); // copy over the code into the new buffer
+        if constexpr (LUMA_STATS) {
+            stats.reallocations++;
+            stats.bytesCopied += currentSize;
+        }
+        if (ownsBuffer)
+            delete[] code;
+
+        code = newBuffer;
+        currentPointer = (uint32_t*) ((uintptr_t) newBuffer + currentSize); // Restore currentPointer's relative position
+        reservedSize = newSize;
+        bufferEnd = (uint32_t*) ((uintptr_t) newBuffer + newSize);
+        ownsBuffer = arena == nullptr; // Arena memory is never freed individually
+        committedSize = 0; // The copy has never been flushed
+        dirtyStart = UINT32_MAX;
+
+        relinkExternalBranches();
+        patchSectionRelocations();
+    }
+
+    // Re-encode the branches out of the buffer after it moved. They're already recorded, so this can't go through patchBranch
+    void relinkExternalBranches() {
+        for (const auto& branch : externalBranches) {
+            const auto address = code + branch.offset / 4;
+            const auto word = encodeBranch24 ((uintptr_t) getExecutable (address), (uintptr_t) branch.target, loadWord (address) & 1);
+            if (word == 0)
+                panic ("[Emitter] Fatal: Branch to %p is out of range after moving the code buffer\n", branch.target);
+            storeWord (address, word);
+        }
+    }
+
+    // Generic write function.
+    // Used to implement write8, write16, write32, write64 and subsequently, db, dh, dw, and dd
+    template <typename T>
+    constexpr void write (T val) {
+        if constexpr (growMode == AutoGrow || LUMA_CHECK_OVERFLOW) {
+            if (scopeDepth == 0 && (uintptr_t) currentPointer + sizeof(T) > (uintptr_t) bufferEnd) [[unlikely]] // If the buffer will overflow, grow it (or panic for FixedSize)
+                overflow (sizeof(T));
+        }
+
+        writeUnchecked <T> (val);
+    }
+
+    // Write without checking for space. Only use after ensureCapacity
+    template <typename T>
+    constexpr void writeUnchecked (T val) {
+        if constexpr (swapBytes && sizeof(T) > 1) { // memcpy, as doublewords and floats can land on any word
+            Bits <T> bits;
+            std::memcpy (&bits, &val, sizeof(T));
+            bits = byteswap (bits);
+            std::memcpy (currentPointer, &bits, sizeof(T));
+        } else
+            std::memcpy (currentPointer, &val, sizeof(T));
+
+        currentPointer = (uint32_t*) ((uint8_t*) currentPointer + sizeof(T));
+    }
+
+    constexpr void write8 (uint8_t val) { write <uint8_t> (val); }
+    constexpr void write16 (uint16_t val) { write <uint16_t> (val); }
+    constexpr void write32 (uint32_t val) { write <uint32_t> (val); }
+    constexpr void write64 (uint64_t val) { write <uint64_t> (val); }
+
+    // Sink for every encoder in InstructionSet
+    constexpr void emitInstruction (uint32_t instruction) {
+        if (peephole) [[unlikely]] {
+            if (!peepholeFilter (instruction))
+                return;
+            lastCode = getCodeSize();
+        }
+
+        recordInstruction (instruction);
+        write32 (instruction);
+    }
+
+    LiteralPool* literals = nullptr;
+    GPR literalBase = r2;
+
+    // Displacement of a constant from the literal base register, for the loads that have no inline fallback
+    template <typename T>
+    int16_t literalOffset (const T& value) {
+        int16_t displacement;
+        if (!literals)
+            panic ("[Emitter] Fatal: loadLiteral called without a literal pool\n");
+        if (!literals->add (value, displacement))
+            panic ("[Emitter] Fatal: Literal pool is full\n");
+        return displacement;
+    }
+
+    // Instrumentation
+    EmitterStats stats;
+    void (*blockHook) (PPCEmitter& gen, void* userData) = nullptr; // Called by beginBlock, to emit eg profiling counters at block entry
+    void* blockHookData = nullptr;
+    uint32_t blockStart = 0;
+
+    constexpr void recordInstruction (uint32_t instruction) {
+        if constexpr (LUMA_STATS) {
+            stats.instructions++;
+            stats.opcodes[instruction >> 26]++;
+            stats.categories[EmitterStats::categorize (instruction)]++;
+        }
+    }
+
+    // Peephole optimizer. Instructions are looked at as they are emitted, together with the instruction right before them
+    // Redundant instructions are dropped and foldable pairs are merged into the earlier one, so nothing already emitted ever moves
+    bool peephole = false;
+    uint32_t peepholeFence = 0; // Code before this offset may be pointed at (anchors, labels, getCurr...) and is left alone
+    uint32_t pinnedOffset = UINT32_MAX; // The last position handed out. Whatever gets emitted there is kept, as it might get patched
+    uint32_t lastCode = UINT32_MAX; // Offset of the last instruction emitted, so that data is never mistaken for code
+
+    // Called whenever the current position is handed out or gets branched to
+    void pinPosition() {
+        peepholeFence = getCodeSize();
+        pinnedOffset = peepholeFence;
+    }
+
+    static constexpr bool isLoadImmediate (uint32_t instruction) { // li/lis: addi/addis with rA = 0
+        const auto opcode = instruction >> 26;
+        return (opcode == 14 || opcode == 15) && ((instruction >> 16) & 31) == 0;
+    }
+
+    // Returns false if the instruction should not be emitted
+    bool peepholeFilter (uint32_t instruction) {
+        const uint32_t size = getCodeSize();
+        if (size == pinnedOffset) // Something expects an instruction right here
+            return true;
+
+        const auto opcode = instruction >> 26;
+        const auto rD = (instruction >> 21) & 31;
+        const auto rA = (instruction >> 16) & 31;
+        const auto imm = instruction & 0xFFFF;
+
+        if ((instruction & 0xFC0007FF) == 0x7C000378 && rD == rA && rA == ((instruction >> 11) & 31)) // mr rX, rX
+            return false;
+        if (opcode == 24 && rD == rA && rD != 0 && imm == 0) // ori rX, rX, 0 (but not nop)
+            return false;
+        if (opcode == 14 && rD == rA && rA != 0 && imm == 0) // addi rX, rX, 0
+            return false;
+
+        if (lastCode + 4 != size || lastCode < peepholeFence)
+            return true;
+
+        const auto prevPointer = code + lastCode / 4;
+        const auto prev = loadWord (prevPointer);
+        const auto prevOpcode = prev >> 26;
+        const auto prevD = (prev >> 21) & 31;
+        const auto prevImm = (int16_t) (prev & 0xFFFF);
+
+        if (instruction == 0x60000000 && ((prevOpcode == 18 && !(prev & 1)) || prev == 0x4E800020 || prev == 0x4E800420)) // nop after b/blr/bctr
+            return false;
+
+        if (!isLoadImmediate (prev) || rD != prevD)
+            return true;
+
+        if (isLoadImmediate (instruction)) { // li/lis overwriting a li/lis to the same register
+            storeWord (prevPointer, instruction);
+            return false;
+        }
+
+        if (rA != rD || rA == 0)
+            return true;
+
+        if (prevOpcode == 14 && opcode == 14) { // li rX, a; addi rX, rX, b -> li rX, a + b
+            const int32_t value = prevImm + (int16_t) imm;
+            if (value < INT16_MIN || value > INT16_MAX)
+                return true;
+            storeWord (prevPointer, (prev & 0xFFFF0000) | (uint16_t) value);
+            return false;
+        }
+
+        if (prevOpcode == 15 && opcode == 15) { // lis rX, a; addis rX, rX, b -> lis rX, a + b
+            storeWord (prevPointer, (prev & 0xFFFF0000) | (uint16_t) (prevImm + imm));
+            return false;
+        }
+
+        if (prevOpcode == 14 && opcode == 24) { // li rX, a; ori rX, rX, b -> li rX, a | b
+            const int32_t value = prevImm | (int32_t) imm;
+            if (value > INT16_MAX)
+                return true;
+            storeWord (prevPointer, (prev & 0xFFFF0000) | (uint16_t) value);
+            return false;
+        }
+
+        return true;
+    }
+
+    // Automatic prologue/epilogue generation (beginFunction/endFunction)
+    bool inFunction = false;
+    uint32_t functionStart = 0; // Offset of the function body
+    uint32_t functionLocals = 0; // Bytes of stack the body asked for, at sp + 8
+    DecodeMode functionMode = DecodeMode::PairedSingles; // Which instruction set opcode 4 in the body belongs to
+    size_t functionColdPaths = 0; // Cold paths queued before the function started. The ones after are part of the function
+    Label functionExit;
+
+    // Registers and CR fields the body of a function overwrites. Only the non-volatile ones end up mattering
+    struct Clobbers {
+        uint32_t gprs = 0;
+        uint32_t fprs = 0;
+        uint32_t vrs = 0; // Only in DecodeMode::AltiVec
+        uint8_t crFields = 0; // Bit n = crn
+        bool lr = false; // Makes calls or writes LR, so LR has to be saved
+        bool vrsave = false; // Writes VRSAVE
+    };
+
+    // Conservatively figure out which registers an instruction writes. Unknown instructions are assumed to write nothing
+    static void scanClobbers (uint32_t instruction, Clobbers& clobbers, DecodeMode mode) {
+        const uint32_t opcode = instruction >> 26;
+        const uint32_t rD = (instruction >> 21) & 31;
+        const uint32_t rA = (instruction >> 16) & 31;
+        const uint32_t xo = (instruction >> 1) & 0x3FF;
+        const uint32_t crField = rD >> 2; // crfD, or the field that crbD lives in
+        const bool lk = instruction & 1;
+
+        switch (opcode) {
+            case 4:
+                if (mode == DecodeMode::AltiVec) {
+                    if ((instruction & 0x7FF) != 1604) clobbers.vrs |= 1u << rD; // Everything but mtvscr writes vD
+                    if ((instruction & 0x3F) == 6 && (instruction & 0x400)) clobbers.crFields |= 1 << 6; // Recording vector compares
+                    break;
+                }
+
+                // Paired singles
+                if (xo == 0 || xo == 32 || xo == 64 || xo == 96) clobbers.crFields |= 1 << crField; // ps_cmpu0/ps_cmpo0/ps_cmpu1/ps_cmpo1
+                else if ((xo & 0x3F) != 7 && (xo & 0x3F) != 39) clobbers.fprs |= 1u << rD; // Anything but psq_stx/psq_stux
+                if ((xo & 0x3F) == 38 || (xo & 0x3F) == 39) clobbers.gprs |= 1u << rA; // psq_lux/psq_stux
+                break;
+            case 7: case 8: case 12: case 13: case 14: case 15: // mulli, subfic, addic(.), addi, addis
+            case 32: case 34: case 40: case 42: // lwz, lbz, lhz, lha
+                clobbers.gprs |= 1u << rD; break;
+            case 33: case 35: case 41: case 43: // Update forms of the above
+                clobbers.gprs |= (1u << rD) | (1u << rA); break;
+            case 10: case 11: clobbers.crFields |= 1 << crField; break; // cmpli, cmpi
+            case 16: case 18: clobbers.lr |= lk; break; // bc, b
+            case 19:
+                if (xo == 16 || xo == 528) clobbers.lr |= lk; // bclr, bcctr
+                else if (xo == 0 || xo == 33 || xo == 129 || xo == 193 || xo == 225 || xo == 257 || xo == 289 || xo == 417 || xo == 449)
+                    clobbers.crFields |= 1 << crField; // mcrf and CR logical ops
+                break;
+            case 20: case 21: case 23: case 24: case 25: case 26: case 27: case 28: case 29: // Rotates and logical immediates write rA
+            case 37: case 39: case 45: case 53: case 55: case 61: // Store with update
+                clobbers.gprs |= 1u << rA; break;
+            case 46: clobbers.gprs |= ~((1u << rD) - 1); break; // lmw
+            case 48: case 50: case 56: clobbers.fprs |= 1u << rD; break; // lfs, lfd, psq_l
+            case 49: case 51: case 57: // lfsu, lfdu, psq_lu
+                clobbers.fprs |= 1u << rD;
+                clobbers.gprs |= 1u << rA;
+                break;
+            case 59: clobbers.fprs |= 1u << rD; break;
+            case 63:
+                if (xo == 0 || xo == 32 || xo == 64) clobbers.crFields |= 1 << crField; // fcmpu, fcmpo, mcrfs
+                else if (xo != 38 && xo != 70 && xo != 134 && xo != 711) clobbers.fprs |= 1u << rD; // Everything but mtfsb1, mtfsb0, mtfsfi, mtfsf
+                break;
+            case 31:
+                switch (xo) {
+                    case 0: case 32: case 512: clobbers.crFields |= 1 << crField; break; // cmp, cmpl, mcrxr
+                    case 144: // mtcrf
+                        for (int field = 0; field < 8; field++)
+                            if ((instruction >> 12) & (0x80 >> field)) clobbers.crFields |= 1 << field;
+                        break;
+                    case 467: // mtspr. The 2 halves of the SPR number are swapped
+                        clobbers.lr |= ((instruction >> 16) & 31) == 8 && ((instruction >> 11) & 31) == 0; // mtlr
+                        clobbers.vrsave |= mode == DecodeMode::AltiVec && ((instruction >> 16) & 31) == 0 && ((instruction >> 11) & 31) == 8; // mtvrsave
+                        break;
+                    case 7: case 39: case 71: case 103: case 359: case 6: case 38: // Vector loads and lvsl/lvsr
+                        if (mode == DecodeMode::AltiVec) clobbers.vrs |= 1u << rD;
+                        break;
+                    case 28: case 60: case 444: case 412: case 124: case 476: case 316: case 284: // Logical ops write rA
+                    case 24: case 536: case 792: case 824: case 26: case 954: case 922: // Shifts, cntlzw, extsb, extsh
+                    case 183: case 247: case 439: case 695: case 759: // Store with update indexed
+                        clobbers.gprs |= 1u << rA; break;
+                    case 55: case 119: case 311: case 375: // Load with update indexed
+                        clobbers.gprs |= (1u << rD) | (1u << rA); break;
+                    case 535: case 599: clobbers.fprs |= 1u << rD; break; // lfsx, lfdx
+                    case 567: case 631: // lfsux, lfdux
+                        clobbers.fprs |= 1u << rD;
+                        clobbers.gprs |= 1u << rA;
+                        break;
+                    // Stores, cache and sync operations, traps and moves to system registers don't write GPRs
+                    case 151: case 215: case 407: case 662: case 918: case 150: case 663: case 727: case 983: case 725: case 661:
+                    case 135: case 167: case 199: case 231: case 487:
+                    case 86: case 54: case 278: case 246: case 1014: case 982: case 470: case 598: case 854: case 4:
+                    case 146: case 210: case 242: case 306: case 566:
+                        break;
+                    default: clobbers.gprs |= 1u << rD; break; // Arithmetic, loads, moves from system registers
+                }
+                break;
+            default: break;
+        }
+    }
+
+    template <typename T>
+    void write (const T* array, int size) {
+        const auto bytes = (size_t) size * sizeof(T);
+        ensureCapacity (bytes); // Check for space once for the whole array, then copy it in one go
+        std::memcpy (currentPointer, array, bytes);
+        swapInPlace <T> (currentPointer, size);
+        currentPointer = (uint32_t*) ((uint8_t*) currentPointer + bytes);
+    }
+
+    // Write "count" copies of "value" with a single capacity check
+    void fillUnchecked (uint8_t value, size_t count) {
+        std::memset (currentPointer, value, count);
+        currentPointer = (uint32_t*) ((uint8_t*) currentPointer + count);
+    }
+
+    // Copy pre-encoded words into the buffer with a single capacity check and memcpy
+    void writeBlock (const void* data, size_t size) {
+        pollIslands();
+        ensureCapacity (size);
+        std::memcpy (currentPointer, data, size);
+        swapInPlace <uint32_t> (currentPointer, size / 4);
+        currentPointer = (uint32_t*) ((uint8_t*) currentPointer + size);
+    }
+
+    constexpr BranchLabel emitBranch14 (uint32_t opcode) {
+        pollIslands();
+        const uint32_t offset = getCodeSize();
+        recordInstruction (opcode);
+        write32 (opcode);
+        lastCode = offset;
+
+        if (relaxBranches)
+            shortBranches.push_back ({ offset, noVeneer, 0, false, false, false });
+        return { offset, BranchType::Branch14 };
+    }
+
+    // Patch the displacement of the branch at "instrAddress" so that it jumps to "address"
+    // Conditional branches with a hint get their y bit set if the prediction for their direction has to be flipped
+    void patchBranch (uint32_t* instrAddress, BranchType type, void* address, BranchHint hint = BranchHint::None) {
+        const auto offset = (uint32_t) ((uintptr_t) instrAddress - (uintptr_t) code);
+        if (offset < committedSize && offset < dirtyStart) // Patching code that was already committed, so it needs to be flushed again
+            dirtyStart = offset;
+        if constexpr (LUMA_STATS)
+            stats.branchPatches++;
+
+        const bool isInternal = (uintptr_t) address - (uintptr_t) code < reservedSize; // Branches inside the buffer are relative to the buffer we write to
+        const auto cia = (uintptr_t) instrAddress + (isInternal ? 0 : execOffset);
+        const intptr_t disp = (intptr_t) address - (intptr_t) cia; // Displacement of the jump in bytes
+
+        constexpr int32_t INT26_MIN = -0x2000000;
+        constexpr int32_t INT26_MAX = 0x1FFFFFF;
+
+        if (disp & 3)
+            panic ("[Fatal] Unaligned branch displacement\n");
+
+        const uint32_t instruction = loadWord (instrAddress);
+        switch (type) {
+            case BranchType::Branch14: {
+                uint32_t patched;
+                if (disp <= INT16_MAX && disp >= INT16_MIN) // Check if the displacement in words can be encoded in 14 bits in a relative branch
+                    patched = (instruction & ~0xFFFE) | (disp & 0xFFFC);
+                else if ((intptr_t) address <= INT16_MAX && (intptr_t) address >= INT16_MIN) // Check if the target address can be encoded in 14 bits in an absolute branch instead
+                    patched = (instruction & ~0xFFFE) | ((uintptr_t)address & 0xFFFC) | 2;
+                else
+                    panic ("Invalid label for 14-bit branch, displacement of %08X words exceeds possible range\n", disp >> 2);
+
+                if (hint != BranchHint::None) {
+                    const bool backward = (int16_t) (patched & 0xFFFC) < 0; // The static predictor goes by the sign of BD, for bca too
+                    patched = (patched & ~yBit) | ((hint == BranchHint::Likely) != backward ? yBit : 0);
+                }
+                storeWord (instrAddress, patched);
+                break;
+            }
+            
+            case BranchType::Branch24: {
+                if (disp >= INT26_MIN && disp <= INT26_MAX) { // Check if the displacement in words can be encoded in 24 bits in a relative branch
+                    storeWord (instrAddress, (instruction & ~0x3FFFFFE) | (disp & 0x3FFFFFC));
+
+                    // Remember relative branches out of the buffer, as moving the buffer (AutoGrow, or a code cache compacting it) breaks them
+                    if (!isInternal && (externalBranches.empty() || externalBranches.back().offset != offset))
+                        externalBranches.push_back ({ offset, address });
+                }
+                else if ((intptr_t) address >= INT26_MIN && (intptr_t) address <= INT26_MAX) // Check if the target address can be encoded in 24 bits in an absolute branch instead
+                    storeWord (instrAddress, (instruction & ~0x3FFFFFE) | ((uintptr_t)address & 0x3FFFFFC) | 2);
+                else
+                    panic ("Invalid label for 24-bit branch, displacement of %08X words exceeds possible range\n", disp >> 2);
+                break;
+            }
+        }
+    }
+
+    static constexpr uint32_t signExtend32 (uint32_t value, uint32_t startingSize) {
+        auto bitsToShift = 32 - startingSize;
+        return (uint32_t) ((int32_t)value << bitsToShift >> bitsToShift);
+    }
+
+    // Metaprogramming helpers for making a compile-time loop, used to implement the "repeat" directive
+    // Many thanks to https://github.com/fleroviux
+    template <typename T, T Begin,  class Func, T ...Is>
+    constexpr void static_for_impl( Func &&f, std::integer_sequence<T, Is...> ) {
+        ( f( std::integral_constant<T, Begin + Is>{ } ),... );
+    }
+
+    template <typename T, T Begin, T End, class Func >
+    constexpr void static_for( Func &&f ) {
+        static_for_impl <T, Begin>( std::forward<Func>(f), std::make_integer_sequence<T, End - Begin>{ } );
+    }
+
+public:
+    PPCEmitter (uintptr_t bufferSize = 64 * 1024) { // Make an emitter object with "bufferSize" bytes of executable memory
+        reservedSize = bufferSize;
+        if (bufferSize == 0) // If bufferSize = 0 then skip allocating memory, because the user (hopefully) wants to allocate it themselves
+            return;
+
+        if (bufferSize & 3)
+            panic ("[Emitter] Fatal: Buffer size is not word-aligned");
+
+        code = new uint32_t [bufferSize / 4]; // Note: On platforms where executable perms matter, use the CodeArena constructor instead
+        currentPointer = code;
+        bufferEnd = code + bufferSize / 4;
+        ownsBuffer = true;
+        
+        if (!code)
+            panic ("[Emitter] Fatal: Failed to allocate memory\n");
+    }
+
+    ~PPCEmitter() {
+        if (ownsBuffer)
+            delete[] code;
+    }
+
+    // Emitters own their buffer, so copying one would free it twice
+    PPCEmitter (const PPCEmitter&) = delete;
+    PPCEmitter& operator= (const PPCEmitter&) = delete;
+
+    // Make an emitter whose "bufferSize" byte code buffer lives in a CodeArena, instead of its own heap allocation
+    PPCEmitter (CodeArena& codeArena, uintptr_t bufferSize = 64 * 1024) {
+        if (bufferSize & 3)
+            panic ("[Emitter] Fatal: Buffer size is not word-aligned");
+
+        code = codeArena.allocate (bufferSize);
+        if (!code)
+            panic ("[Emitter] Fatal: Code arena is out of memory\n");
+
+        currentPointer = code;
+        reservedSize = bufferSize;
+        bufferEnd = code + bufferSize / 4;
+        arena = &codeArena;
+        execOffset = codeArena.getExecOffset();
+    }
+
+    // Make the emitted code executable and return the address it should be called at
+    // On ToggleProtection arenas the buffer is not writeable anymore until makeWritable() is called
+    uint32_t* finalize() {
+        emitColdCode();
+        resolveLabels();
+        if (relaxBranches)
+            emitIsland (true); // Veneers for branches that were resolved out of range since the last island
+        commit();
+        if (arena)
+            arena -> makeExecutable (code, getCodeSize());
+
+        return getExecutable (code);
+    }
+
+    uint32_t* makeExecutable() { return finalize(); }
+
+    // Flush everything emitted or patched since the last commit to the instruction cache and return the executable address of the new code
+    uint32_t* commit() {
+        const auto start = dirtyStart < committedSize ? dirtyStart : committedSize;
+        const auto newCode = code + committedSize / 4;
+
+        flushICache ((uint8_t*) code + start, currentPointer, execOffset);
+        committedSize = getCodeSize();
+        dirtyStart = UINT32_MAX;
+        pinPosition(); // Committed code is not rewritten
+        return getExecutable (newCode);
+    }
+
+    // Bytes flushed by the last commit, and the lowest offset below that patched since (UINT32_MAX if nothing was)
+    uint32_t getCommittedSize() { return committedSize; }
+    uint32_t getDirtyStart() { return dirtyStart; }
+
+    // Reopen a finalized buffer for writing
+    void makeWritable() {
+        if (arena)
+            arena -> makeWritable (code, reservedSize);
+    }
+
+    // Get the address a pointer into the code buffer will be executed at (Different from the pointer itself only for DualView arenas)
+    template <typename T>
+    T* getExecutable (T* pointer) {
+        return (T*) ((uintptr_t) pointer + execOffset);
+    }
+
+    uint32_t* getBuffer() { 
+        return code; 
+    }
+
+    void setBuffer (uint32_t* pointer, uintptr_t bufferSize) { // Note: This completely wrecks the JIT cache and should only be used before actually emitting code
+        if (ownsBuffer)
+            delete[] code;
+
+        code = pointer;
+        currentPointer = pointer;
+        reservedSize = bufferSize;
+        bufferEnd = (uint32_t*) ((uintptr_t) pointer + bufferSize);
+        arena = nullptr;
+        execOffset = 0;
+        ownsBuffer = false;
+        externalBranches.clear();
+        symbols.clear();
+        relocations.clear();
+        tableEntries.clear();
+        coldPaths.clear();
+        labelTargets.clear();
+        fixups.clear();
+        shortBranches.clear();
+        firstUnveneered = 0;
+        committedSize = 0;
+        dirtyStart = UINT32_MAX;
+        peepholeFence = 0;
+        pinnedOffset = UINT32_MAX;
+        lastCode = UINT32_MAX;
+
+        if (bufferSize & 3)
+            panic ("[Emitter] Fatal: Buffer size is not word-aligned");
+    }
+
+    // Same as above, for a buffer that lives in a code arena
+    void setBuffer (CodeArena& codeArena, uint32_t* pointer, uintptr_t bufferSize) {
+        setBuffer (pointer, bufferSize);
+        arena = &codeArena;
+        execOffset = codeArena.getExecOffset();
+    }
+
+    // Note: With AutoGrow, this pointer is invalidated when the buffer grows. Use getAnchor() for positions you want to branch back to
+    constexpr uint32_t* getCurr() { 
+        pinPosition();
+        return currentPointer; 
+    }
+
+    Anchor getAnchor() {
+        pinPosition();
+        return { (uint32_t) getCodeSize() };
+    }
+
+    uint32_t* getPointer (Anchor anchor) {
+        return code + anchor.offset / 4;
+    }
+
+    uintptr_t getCodeSize() {
+        return (uintptr_t) currentPointer - (uintptr_t) code;
+    }
+
+    // Relocations: every relative unconditional branch from this buffer to outside of it, and its target
+    const std::vector <ExternalBranch>& getExternalBranches() {
+        return externalBranches;
+    }
+
+    // Declare a symbol defined by another object, for the relocating branches, loads and data words below
+    SymbolRef importSymbol (const std::string& name) {
+        for (uint32_t i = 0; i < symbols.size(); i++)
+            if (symbols[i].name == name)
+                return { i };
+
+        symbols.push_back ({ name, 0, 0, false });
+        return { (uint32_t) symbols.size() - 1 };
+    }
+
+    // Export the code at "start" under "name", eg as a function other objects can call. An import of the same name becomes this symbol
+    SymbolRef exportSymbol (const std::string& name, Anchor start, uint32_t size = 0) {
+        const auto symbol = importSymbol (name);
+        if (symbols[symbol.id].defined)
+            panic ("[Emitter] Fatal: Symbol %s was exported twice\n", name.c_str());
+
+        symbols[symbol.id] = { name, start.offset, size, true };
+        return symbol;
+    }
+
+    // Branch (and link) to a symbol. The displacement is left to the linker
+    void b (SymbolRef symbol, int32_t addend = 0) {
+        setLabel (b(), symbol, addend);
+    }
+
+    void bl (SymbolRef symbol, int32_t addend = 0) {
+        setLabel (bl(), symbol, addend);
+    }
+
+    // Point a branch at a symbol, with an R_PPC_REL14 or R_PPC_REL24 relocation
+    void setLabel (BranchLabel label, SymbolRef symbol, int32_t addend = 0) {
+        if (relaxBranches && label.type == BranchType::Branch14) { // The linker takes care of it now, so no veneer is needed
+            for (auto& branch : shortBranches)
+                if (branch.offset == label.offset)
+                    branch.done = true;
+        }
+
+        relocations.push_back ({ label.offset, label.type == BranchType::Branch14 ? RelocationType::Rel14 : RelocationType::Rel24, symbol.id, addend });
+    }
+
+    // Load the address of a symbol: lis reg, symbol@ha; addi reg, reg, symbol@l
+    void liw (GPR reg, SymbolRef symbol, int32_t addend = 0) {
+        if (reg == r0)
+            panic ("[Emitter] Fatal: Can't load a symbol address into r0, as addi would read it as 0\n");
+
+        emitRelocated (enc.lis (reg, 0), RelocationType::Addr16Ha, symbol, addend);
+        emitRelocated (enc.addi (reg, reg, 0), RelocationType::Addr16Lo, symbol, addend);
+    }
+
+    // Emit a data word holding the address of a symbol, eg for jump tables
+    void dw (SymbolRef symbol, int32_t addend = 0) {
+        pinPosition();
+        write32 (0);
+        lastCode = UINT32_MAX;
+        relocations.push_back ({ (uint32_t) getCodeSize() - 4, RelocationType::Addr32, symbol.id, addend });
+    }
+
+    const std::vector <ObjectSymbol>& getSymbols() {
+        return symbols;
+    }
+
+    // Every relocation recorded so far, plus one per relative branch to an address outside of the buffer
+    std::vector <Relocation> getRelocations() {
+        auto result = relocations;
+        for (const auto& branch : externalBranches)
+            result.push_back ({ branch.offset, RelocationType::Rel24, Relocation::absolute, (int64_t) (intptr_t) branch.target });
+
+        std::sort (result.begin(), result.end(), [] (const Relocation& a, const Relocation& b) { return a.offset < b.offset; });
+        return result;
+    }
+
+    // Make sure the next "words" words can be emitted without the buffer overflowing or moving
+    // AutoGrow emitters grow at most once here, FixedSize emitters panic if the space isn't there
+    void reserve (uintptr_t words) {
+        if (relaxBranches && firstUnveneered < shortBranches.size() && getCodeSize() + words * 4 + islandSlack >= shortBranches[firstUnveneered].offset + branch14Reach)
+            emitIsland(); // An island in the middle of the reserved block would not fit in the reservation
+
+        if (words * 4 > (uintptr_t) bufferEnd - (uintptr_t) currentPointer) {
+            if constexpr (growMode == AutoGrow)
+                grow (words * 4);
+            else
+                overflow (words * 4);
+        }
+    }
+
+    // Used by EmitScope. While a scope is open, instructions are written without a capacity check, as the scope reserved room for them up front
+    void openScope() { scopeDepth++; }
+    void closeScope() { scopeDepth--; }
+
+    // Sets how much the buffer will be grown if autogrow is on and the buffer overflows
+    void setAutoGrowSize (uintptr_t size) {
+        autoGrowSize = size;
+    
+        if (size & 3)
+            panic ("[Emitter] Fatal: AutoGrow size is not word-aligned");
+    }
+
+    constexpr void db   (uint8_t val)  { write8 (val); } // Data byte
+    constexpr void dh   (uint16_t val) { write16 (val); } // Data halfword
+    constexpr void dw   (uint32_t val) { write32 (val); } // Data word
+    constexpr void dd   (uint64_t val) { write64 (val); } // Data doubleword
+    constexpr void df32 (float val )   { write <float> (val); } // Data float 32 (Single)
+    constexpr void df64 (double val)   { write <double> (val); } // Data float 64 (Double)
+
+    constexpr void db   (const uint8_t* arr, int size)  { write <uint8_t> (arr, size); } //  Data byte array
+    constexpr void dh   (const uint16_t* arr, int size) { write <uint16_t> (arr, size); } //  Data halfword array
+    constexpr void dw   (const uint32_t* arr, int size) { write <uint32_t> (arr, size); } //  Data word array
+    constexpr void dd   (const uint64_t* arr, int size) { write <uint64_t> (arr, size); } //  Data doubleword array
+    constexpr void df32 (const float* arr, int size)    { write <float> (arr, size); } //  Data float array
+    constexpr void df64 (const double* arr, int size)   { write <double> (arr, size); } //  Data double array
+
+    template <size_t N>
+    void dw (const std::array <uint32_t, N>& arr, size_t count = N) { // Copy the first "count" words of an array in one go
+        writeBlock (arr.data(), count * sizeof (uint32_t));
+    }
+
+    template <size_t N>
+    void dw (const CodeTemplate <N>& code) { writeBlock (code.data(), code.size() * sizeof (uint32_t)); } // Copy a prebuilt code template
+
+    // Copy a stencil into the buffer and fill in its holes, with the value for hole N at index N of "values"
+    void stamp (const Stencil& stencil, std::initializer_list <uint32_t> values) {
+        const auto size = stencil.size() * sizeof (uint32_t);
+        pollIslands();
+        ensureCapacity (size);
+        stencil.instantiate (currentPointer, values);
+        swapInPlace <uint32_t> (currentPointer, stencil.size());
+        currentPointer += stencil.size();
+    }
+
+    constexpr void ds (const char* str) { // Data string (null-terminated)
+        write <char> (str, (int) std::strlen (str) + 1); // Copy the null terminator too
+    }
+
+    void ds (std::string str) {
+        ds (str.c_str());
+    }
+
+    void align (int bytes) {
+        if (bytes == 1) 
+            return;
+        
+        else if (bytes < 1)
+            panic ("[Emitter] Fatal: Tried to align to a %d byte boundary", bytes);
+
+        const auto padding = (bytes - (uintptr_t) getCurr() % bytes) % bytes;
+        ensureCapacity (padding);
+        fillUnchecked (0, padding);
+    }
+
+    // Data bytes: "count" copies of "value"
+    void fill (uint8_t value, size_t count) {
+        ensureCapacity (count);
+        fillUnchecked (value, count);
+    }
+
+    // Emit "count" nops (ori r0, r0, 0), eg as padding to align a loop. Unlike nop(), these are never dropped by the peephole optimizer
+    void nops (size_t count) {
+        reserve (count); // Also places a veneer island first if one would be needed in the middle
+        const uint32_t nop = enc.nop();
+        const uint32_t word = swapBytes ? byteswap (nop) : nop;
+        auto pointer = currentPointer;
+        for (size_t i = 0; i < count; i++) // Simple enough to be vectorized
+            pointer[i] = word;
+
+        currentPointer += count;
+        lastCode = UINT32_MAX;
+        if constexpr (LUMA_STATS) {
+            stats.instructions += count;
+            stats.opcodes[nop >> 26] += count;
+            stats.categories[EmitterStats::categorize (nop)] += count;
+        }
+    }
+
+    template <size_t end, class Func>
+    constexpr void repeat (Func&& f) {
+        static_for_impl <size_t, 0>( std::forward<Func>(f), std::make_integer_sequence<size_t, end>{ } );
+    }
+
+    template <class Func>
+    constexpr void loop (GPR counter, size_t iterations, Func&& f) {
+        if (iterations == 0) return;                        // Do nothing if 0 iterations
+
+        this->liw (counter, iterations);                    // load iterations into counter register
+        this->mtctr (counter);                              // CTR counts the iterations down, so the body must leave it alone
+        const auto label = getAnchor();                     // Label for loop
+        f();
+        setLabel (bdnz(), label);                           // Decrement CTR and loop if not 0. Backward, so predicted taken
+    }
+
+    // Atomic read-modify-write sequences, built on lwarx/stwcx. retry loops. "address" holds the address of an aligned word
+    // Release semantics put a lwsync (sync for SeqCst) before the sequence, acquire semantics an isync after it
+    void atomicFence (MemoryOrder order, bool before) {
+        if (before && order == MemoryOrder::SeqCst)
+            this->sync();
+        else if (before && (order == MemoryOrder::Release || order == MemoryOrder::AcqRel))
+            this->lwsync();
+        else if (!before && (order == MemoryOrder::Acquire || order == MemoryOrder::AcqRel || order == MemoryOrder::SeqCst))
+            this->isync();
+    }
+
+    // result = *address; *address += value
+    void atomicFetchAdd (GPR result, GPR address, GPR value, GPR scratch, MemoryOrder order = MemoryOrder::SeqCst) {
+        atomicFence (order, true);
+        const auto retry = getAnchor();
+        this->lwarx (result, r0, address);
+        this->add (scratch, result, value);
+        this->stwcx (scratch, r0, address);
+        setLabel (bne(), retry); // Lost the reservation, try again
+        atomicFence (order, false);
+    }
+
+    // result = *address; *address = value
+    void atomicExchange (GPR result, GPR address, GPR value, MemoryOrder order = MemoryOrder::SeqCst) {
+        atomicFence (order, true);
+        const auto retry = getAnchor();
+        this->lwarx (result, r0, address);
+        this->stwcx (value, r0, address);
+        setLabel (bne(), retry);
+        atomicFence (order, false);
+    }
+
+    // result = *address; if (result == expected) *address = desired
+    // Afterwards cr0.eq is set if the exchange happened, so it can be followed by beq/bne
+    void atomicCompareExchange (GPR result, GPR address, GPR expected, GPR desired, MemoryOrder order = MemoryOrder::SeqCst) {
+        atomicFence (order, true);
+        const auto retry = getAnchor();
+        this->lwarx (result, r0, address);
+        this->cmpl (cr0, result, expected);
+        const auto fail = bne();
+        this->stwcx (desired, r0, address);
+        setLabel (bne(), retry);
+        setLabel (fail);
+        atomicFence (order, false);
+    }
+
+    // Spin until the word at "address" goes from 0 to 1
+    void spinLockAcquire (GPR address, GPR scratch) {
+        const auto retry = getAnchor();
+        this->lwarx (scratch, r0, address);
+        this->cmpli (cr0, scratch, 0);
+        setLabel (bne(), retry); // Taken, keep spinning
+        this->li (scratch, 1);
+        this->stwcx (scratch, r0, address);
+        setLabel (bne(), retry);
+        this->isync(); // Nothing in the critical section can execute before the lock is ours
+    }
+
+    void spinLockRelease (GPR address, GPR scratch) {
+        this->lwsync(); // Make the critical section's stores visible before the lock
+        this->li (scratch, 0);
+        this->stw (scratch, address, 0);
+    }
+
+    template <bool link>
+    BranchLabel bx() {
+        pollIslands();
+        const uint32_t offset = getCodeSize();
+        recordInstruction (0x48000000 | link);
+        write32 (0x48000000 | link);
+        lastCode = offset;
+        return { offset, BranchType::Branch24 };
+    }
+
+    BranchLabel b() {
+        return bx <false> ();
+    }
+
+    BranchLabel bl() {
+        return bx <true> ();
+    } 
+
+    template <bool link>
+    void bx (void* address) {
+        if ((uintptr_t) address & 3) // Check that address is aligned to a word boundary
+            panic ("[Emitter] Fatal: Unaligned branch displacement");
+
+        const auto label = bx <link> (); // Emit the branch, then point it to the target
+        patchBranch (code + label.offset / 4, BranchType::Branch24, address);
+    }
+
+    void b (void* address) {
+        bx <false> (address);
+    }
+
+    // Emit a block exit that jumps to "dispatcher" and can later be linked directly to another block
+    // If the dispatcher is out of range of a direct branch, the exit loads its address into "scratch" and goes through CTR instead
+    // Note: With AutoGrow, the stub is invalidated if the buffer moves, so get your stubs after you're done emitting the block
+    ExitStub emitLinkableExit (void* dispatcher, GPR scratch = r12) {
+        static_assert (!swapBytes, "Linkable exits are patched at runtime, so they need code in the host's byte order");
+        reserve (4);
+        const auto location = getCurr();
+
+        if (encodeBranch24 ((uintptr_t) location + execOffset, (uintptr_t) dispatcher))
+            b (dispatcher);
+        else {
+            this->lis (scratch, (uint32_t) (uintptr_t) dispatcher >> 16);
+            this->ori (scratch, scratch, (uint16_t) (uintptr_t) dispatcher);
+            this->mtctr (scratch);
+            this->bctr();
+        }
+
+        return ExitStub (location, execOffset, arena);
+    }
+    
+    void bl (void* address) {
+        bx <true> (address);
+    }
+
+    // Emit a conditional branch with a static prediction hint. Until its target is known, the y bit is what a forward branch would need
+    BranchLabel emitHintedBranch14 (uint32_t opcode, BranchHint hint) {
+        auto branch = emitBranch14 (opcode | (hint == BranchHint::Likely ? yBit : 0));
+        branch.hint = hint;
+        return branch;
+    }
+
+    // Branch if "cond" holds in CR field "field"
+    template <Cond cond, bool link>
+    BranchLabel bcx (CR field = cr0, BranchHint hint = BranchHint::None) {
+        constexpr bool shouldBitBeSet = (uint32_t) cond <= 3; // For conditions 0 (Lt), 1 (Gt), 2 (Eq) and 3 (SO), the bit in CR should be set. Otherwise it should be cleared
+        constexpr int bit = (uint32_t) cond & 3;
+
+        return emitHintedBranch14 (0x40800000 | (shouldBitBeSet << 24) | ((field * 4 + bit) << 16) | link, hint);
+    }
+
+    BranchLabel beq() { return bcx <Cond::Eq, false> (); } // Branch if equal
+    BranchLabel bne() { return bcx <Cond::Ne, false> (); } // Branch if not equal
+    BranchLabel blt() { return bcx <Cond::Lt, false> (); } // Branch if less than
+    BranchLabel bge() { return bcx <Cond::Ge, false> (); } // Branch if greater than or equal
+    BranchLabel ble() { return bcx <Cond::Le, false> (); } // Branch if less than or equal
+    BranchLabel bgt() { return bcx <Cond::Gt, false> (); } // Branch if greater than
+    BranchLabel bso() { return bcx <Cond::Os, false> (); } // Branch if overflow
+    BranchLabel bns() { return bcx <Cond::Oc, false> (); } // Branch if no overflow
+
+    BranchLabel beql() { return bcx <Cond::Eq, true> (); } // Branch if equal and link
+    BranchLabel bnel() { return bcx <Cond::Ne, true> (); } // Branch if not equal and link
+    BranchLabel bltl() { return bcx <Cond::Lt, true> (); } // Branch if less than and link
+    BranchLabel bgel() { return bcx <Cond::Ge, true> (); } // Branch if greater than or equal and link
+    BranchLabel blel() { return bcx <Cond::Le, true> (); } // Branch if less than or equal and link
+    BranchLabel bgtl() { return bcx <Cond::Gt, true> (); } // Branch if greater than and link
+    BranchLabel bsol() { return bcx <Cond::Os, true> (); } // Branch if overflow and link
+    BranchLabel bnsl() { return bcx <Cond::Oc, true> (); } // Branch if no overflow and link
+
+    // The same, testing any CR field and with an optional prediction hint, eg after cmpi (cr3, ...)
+    BranchLabel beq (CR field, BranchHint hint = BranchHint::None) { return bcx <Cond::Eq, false> (field, hint); }
+    BranchLabel bne (CR field, BranchHint hint = BranchHint::None) { return bcx <Cond::Ne, false> (field, hint); }
+    BranchLabel blt (CR field, BranchHint hint = BranchHint::None) { return bcx <Cond::Lt, false> (field, hint); }
+    BranchLabel bge (CR field, BranchHint hint = BranchHint::None) { return bcx <Cond::Ge, false> (field, hint); }
+    BranchLabel ble (CR field, BranchHint hint = BranchHint::None) { return bcx <Cond::Le, false> (field, hint); }
+    BranchLabel bgt (CR field, BranchHint hint = BranchHint::None) { return bcx <Cond::Gt, false> (field, hint); }
+    BranchLabel bso (CR field, BranchHint hint = BranchHint::None) { return bcx <Cond::Os, false> (field, hint); }
+    BranchLabel bns (CR field, BranchHint hint = BranchHint::None) { return bcx <Cond::Oc, false> (field, hint); }
+
+    // Decrement CTR, then branch if it's not 0 (bdnz) or if it is 0 (bdz). CR is left alone
+    BranchLabel bdnz (BranchHint hint = BranchHint::None) { return emitHintedBranch14 (0x42000000, hint); }
+    BranchLabel bdz (BranchHint hint = BranchHint::None) { return emitHintedBranch14 (0x42400000, hint); }
+
+    void setLabel (BranchLabel label) {
+        pollIslands();
+        pinPosition();
+        setLabel (label, currentPointer);
+    }
+
+    void setLabel (BranchLabel label, void* address) {
+        if (relaxBranches && label.type == BranchType::Branch14)
+            resolveShortBranch (label.offset, address, label.hint);
+        else
+            patchBranch (code + label.offset / 4, label.type, address, label.hint);
+    }
+
+    // Load constants through "pool", with "base" pinned to pool.getBase() (r2, the small data area/TOC pointer, by default)
+    // Pass nullptr to stop. The pool outlives blocks, so it's kept when the buffer changes
+    void setLiteralPool (LiteralPool* pool, GPR base = r2) {
+        literals = pool;
+        literalBase = base;
+    }
+
+    // Load a 32-bit constant in a single instruction: li/lis if it fits, a lwz from the literal pool otherwise
+    // Falls back to liw's lis + ori once the pool is full
+    void loadLiteral (GPR reg, uint32_t value) {
+        int16_t displacement;
+        if ((uint32_t) (value + 0x8000) < 0x10000 || (value & 0xFFFF) == 0 || !literals || !literals->add (value, displacement))
+            liw (reg, value);
+        else
+            this->lwz (reg, literalBase, displacement);
+    }
+
+    // Load float and double constants straight into an FPR, without going through a GPR and memory
+    void loadLiteral (FPR reg, float value) {
+        this->lfs (reg, literalBase, literalOffset (value));
+    }
+
+    void loadLiteral (FPR reg, double value) {
+        this->lfd (reg, literalBase, literalOffset (value));
+    }
+
+    // Load a vector constant. lvx only has an indexed form, so the displacement goes through "scratch"
+    void loadLiteral (VR reg, const std::array <uint32_t, 4>& value, GPR scratch = r12) {
+        this->li (scratch, literalOffset (value));
+        this->lvx (reg, literalBase, scratch);
+    }
+
+    // With the peephole optimizer on, no-op moves (mr rX, rX, ori rX, rX, 0, addi rX, rX, 0) and nops after unconditional branches are dropped,
+    // a li/lis overwritten by the next instruction is replaced by it, and li + addi, lis + addis and li + ori pairs are merged where possible
+    // Code that is pointed at through getCurr, anchors, labels or setLabel is never touched
+    void setPeephole (bool enabled) {
+        lastCode = UINT32_MAX; // Don't fold anything into code emitted before the optimizer was on
+        peephole = enabled;
+    }
+
+    using BlockHook = void (*) (PPCEmitter& gen, void* userData);
+
+    // Have "hook" called at the start of every block (see beginBlock), eg to emit a profiling counter with incrementCounter
+    void setBlockEntryHook (BlockHook hook, void* userData = nullptr) {
+        blockHook = hook;
+        blockHookData = userData;
+    }
+
+    // Emit "body" out of line, after the rest of the block, and get a label to branch to it with
+    // Slow paths (MMU misses, exception checks...) stay out of the hot code, so the common case falls through without taken branches
+    // The body is run with the emitter when the block ends (endBlock or finalize), and can branch back to labels in the hot code
+    // Cold paths queued inside a function are placed by endFunction instead, before the epilogue, so that what they clobber gets saved
+    template <typename Func>
+    Label cold (Func&& body) {
+        const auto label = newLabel();
+        coldPaths.push_back ({ label, std::function <void (PPCEmitter&)> (std::forward <Func> (body)) });
+        return label;
+    }
+
+    // Place every pending cold path here. endBlock and finalize do this for you, but it can be done earlier, eg to keep the cold code of a
+    // huge block within range of conditional branches
+    void emitColdCode() {
+        emitColdPaths (0);
+    }
+
+    // Mark the start of a block of translated code, and run the block entry hook if there is one
+    void beginBlock() {
+        blockStart = getCodeSize();
+        if (blockHook)
+            blockHook (*this, blockHookData);
+    }
+
+    // Mark the end of the current block and return its size in bytes, including whatever the entry hook emitted
+    uint32_t endBlock() {
+        emitColdCode();
+        const uint32_t size = getCodeSize() - blockStart;
+        if constexpr (LUMA_STATS) {
+            uint32_t bucket = 0;
+            while (bucket < 15 && (2u << bucket) <= size)
+                bucket++;
+
+            stats.blocks++;
+            stats.blockBytes += size;
+            stats.largestBlock = std::max (stats.largestBlock, size);
+            stats.blockSizes[bucket]++;
+        }
+
+        return size;
+    }
+
+    // Emit (*counter)++, using 2 scratch registers. The counter needs a 32-bit address
+    void incrementCounter (uint32_t* counter, GPR address = r11, GPR value = r12) {
+        const auto target = (uint32_t) (uintptr_t) counter;
+        this->lis (address, (target + 0x8000) >> 16); // + 0x8000 as the displacement below is signed
+        this->lwz (value, address, (int16_t) target);
+        this->addi (value, value, 1);
+        this->stw (value, address, (int16_t) target);
+    }
+
+    // Everything counted since the emitter was created or resetStats was called. All 0 unless LUMA_STATS is 1
+    const EmitterStats& getStats() { return stats; }
+    void resetStats() { stats = EmitterStats(); }
+
+    // Same as InstructionSet::liw, but keeps track of which form it picked
+    void liw (GPR reg, uint32_t imm) {
+        if constexpr (LUMA_STATS) {
+            if (imm <= 0x7FFF || imm >= 0xFFFF8000 || (imm & 0xFFFF) == 0)
+                stats.liwShort++;
+            else
+                stats.liwLong++;
+        }
+
+        InstructionSet <PPCEmitter>::liw (reg, imm);
+    }
+
+    // With relaxation on, conditional branches are emitted in their short form and transparently routed through a veneer
+    // if their target turns out to be out of range. Veneers are placed in islands, emitted at branches and labels as needed
+    void setBranchRelaxation (bool enabled) {
+        relaxBranches = enabled;
+    }
+
+    // Emit an island of veneers for all conditional branches that might go out of range, with a branch around it
+    // This happens automatically, but you can call it yourself in long runs of code without any branches or labels
+    void emitIsland (bool onlyKnownTargets = false) {
+        uint32_t count = 0;
+        for (auto i = firstUnveneered; i < shortBranches.size(); i++) {
+            const auto& branch = shortBranches[i];
+            count += !branch.done && branch.veneer == noVeneer && (branch.targetKnown || !onlyKnownTargets);
+        }
+
+        if (count == 0)
+            return;
+
+        const uint32_t skipOffset = getCodeSize();
+        recordInstruction (0x48000000);
+        write32 (0x48000000); // b over the island
+        for (auto i = firstUnveneered; i < shortBranches.size(); i++) {
+            auto& branch = shortBranches[i];
+            if (branch.done || branch.veneer != noVeneer || (onlyKnownTargets && !branch.targetKnown))
+                continue;
+
+            branch.veneer = getCodeSize();
+            recordInstruction (0x48000000);
+            write32 (0x48000000); // The veneer itself
+            patchBranch (code + branch.offset / 4, BranchType::Branch14, code + branch.veneer / 4);
+
+            if (branch.targetKnown) {
+                patchBranch (code + branch.veneer / 4, BranchType::Branch24, targetPointer (branch));
+                branch.done = true;
+            }
+        }
+
+        patchBranch (code + skipOffset / 4, BranchType::Branch24, currentPointer);
+        pinPosition();
+        if (!onlyKnownTargets)
+            firstUnveneered = shortBranches.size();
+    }
+
+    void setLabel (BranchLabel label, Anchor anchor) {
+        setLabel (label, getPointer (anchor));
+    }
+
+    // Point an already emitted branch to a label. The branch is patched when labels get resolved
+    void setLabel (BranchLabel branch, Label label) {
+        fixups.push_back ({ branch.offset | (uint32_t) branch.type | (branch.hint != BranchHint::None ? hintedFixup : 0), label.id });
+        if constexpr (LUMA_STATS)
+            stats.labelFixups++;
+    }
+
+    Label newLabel() {
+        labelTargets.push_back (unboundLabel);
+        return { (uint32_t) labelTargets.size() - 1 };
+    }
+
+    // Bind a label to the current position. A label can only be bound once
+    void bind (Label label) {
+        pollIslands();
+        if (labelTargets[label.id] != unboundLabel)
+            panic ("[Emitter] Fatal: Label %u bound twice\n", label.id);
+
+        labelTargets[label.id] = getCodeSize();
+        pinPosition();
+    }
+
+    bool isBound (Label label) {
+        return labelTargets[label.id] != unboundLabel;
+    }
+
+    uint32_t* getPointer (Label label) {
+        return code + labelTargets[label.id] / 4;
+    }
+
+    // Patch every branch that references a label, in one linear pass over the fixup table
+    void resolveLabels() {
+        for (const auto& fixup : fixups) {
+            const auto target = labelTargets[fixup.label];
+            if (target == unboundLabel)
+                panic ("[Emitter] Fatal: Branch to label %u, which was never bound\n", fixup.label);
+
+            const auto type = (BranchType) (fixup.offsetAndType & 1);
+            const auto offset = fixup.offsetAndType & ~3;
+            auto hint = BranchHint::None;
+            if (fixup.offsetAndType & hintedFixup)
+                hint = loadWord (code + offset / 4) & yBit ? BranchHint::Likely : BranchHint::Unlikely;
+            setLabel ({ offset, type, hint }, code + target / 4);
+        }
+
+        for (const auto& entry : tableEntries) {
+            const auto target = labelTargets[entry.label];
+            if (target == unboundLabel)
+                panic ("[Emitter] Fatal: Jump table entry for label %u, which was never bound\n", entry.label);
+
+            storeWord (code + entry.offset / 4, target - entry.table);
+            if (entry.offset < committedSize && entry.offset < dirtyStart)
+                dirtyStart = entry.offset;
+        }
+
+        fixups.clear();
+        tableEntries.clear();
+    }
+
+    void b (Label label) { setLabel (b(), label); }
+    void bl (Label label) { setLabel (bl(), label); }
+
+    template <Cond cond, bool link>
+    void bcx (Label label, CR field = cr0, BranchHint hint = BranchHint::None) {
+        setLabel (bcx <cond, link> (field, hint), label);
+    }
+
+    void beq (Label label) { bcx <Cond::Eq, false> (label); } // Branch to label if equal
+    void bne (Label label) { bcx <Cond::Ne, false> (label); } // Branch to label if not equal
+    void blt (Label label) { bcx <Cond::Lt, false> (label); } // Branch to label if less than
+    void bge (Label label) { bcx <Cond::Ge, false> (label); } // Branch to label if greater than or equal
+    void ble (Label label) { bcx <Cond::Le, false> (label); } // Branch to label if less than or equal
+    void bgt (Label label) { bcx <Cond::Gt, false> (label); } // Branch to label if greater than
+    void bso (Label label) { bcx <Cond::Os, false> (label); } // Branch to label if overflow
+    void bns (Label label) { bcx <Cond::Oc, false> (label); } // Branch to label if no overflow
+
+    void beql (Label label) { bcx <Cond::Eq, true> (label); } // Branch to label if equal and link
+    void bnel (Label label) { bcx <Cond::Ne, true> (label); } // Branch to label if not equal and link
+    void bltl (Label label) { bcx <Cond::Lt, true> (label); } // Branch to label if less than and link
+    void bgel (Label label) { bcx <Cond::Ge, true> (label); } // Branch to label if greater than or equal and link
+    void blel (Label label) { bcx <Cond::Le, true> (label); } // Branch to label if less than or equal and link
+    void bgtl (Label label) { bcx <Cond::Gt, true> (label); } // Branch to label if greater than and link
+    void bsol (Label label) { bcx <Cond::Os, true> (label); } // Branch to label if overflow and link
+    void bnsl (Label label) { bcx <Cond::Oc, true> (label); } // Branch to label if no overflow and link
+
+    void beq (CR field, Label label, BranchHint hint = BranchHint::None) { bcx <Cond::Eq, false> (label, field, hint); }
+    void bne (CR field, Label label, BranchHint hint = BranchHint::None) { bcx <Cond::Ne, false> (label, field, hint); }
+    void blt (CR field, Label label, BranchHint hint = BranchHint::None) { bcx <Cond::Lt, false> (label, field, hint); }
+    void bge (CR field, Label label, BranchHint hint = BranchHint::None) { bcx <Cond::Ge, false> (label, field, hint); }
+    void ble (CR field, Label label, BranchHint hint = BranchHint::None) { bcx <Cond::Le, false> (label, field, hint); }
+    void bgt (CR field, Label label, BranchHint hint = BranchHint::None) { bcx <Cond::Gt, false> (label, field, hint); }
+    void bso (CR field, Label label, BranchHint hint = BranchHint::None) { bcx <Cond::Os, false> (label, field, hint); }
+    void bns (CR field, Label label, BranchHint hint = BranchHint::None) { bcx <Cond::Oc, false> (label, field, hint); }
+
+    void bdnz (Label label, BranchHint hint = BranchHint::None) { setLabel (bdnz (hint), label); }
+    void bdz (Label label, BranchHint hint = BranchHint::None) { setLabel (bdz (hint), label); }
+
+    // Jump to targets[index], or to defaultLabel if index (unsigned) is out of bounds. Clobbers cr0, r0, CTR and "scratch"
+    // The table of targets follows the bctr, 16-byte aligned. Its entries are relative to the table, so only the lis/addi
+    // loading its address depends on where the code ends up: it's tracked as a relocation, and re-patched if AutoGrow moves the buffer
+    void switchTable (GPR index, const std::vector <Label>& targets, Label defaultLabel, GPR scratch = r12) {
+        if (scratch == r0 || scratch == index)
+            panic ("[Emitter] Fatal: switchTable needs a scratch register other than r0 and the index\n");
+        if (targets.empty()) {
+            b (defaultLabel);
+            return;
+        }
+
+        if (targets.size() <= UINT16_MAX)
+            this->cmpli (cr0, index, (uint16_t) targets.size());
+        else {
+            liw (scratch, (uint32_t) targets.size());
+            this->cmpl (cr0, index, scratch);
+        }
+        bge (defaultLabel);
+
+        const auto firstRelocation = relocations.size(); // Addends are filled in once we know where the table is
+        emitRelocated (enc.lis (scratch, 0), RelocationType::Addr16Ha, { Relocation::section }, 0);
+        emitRelocated (enc.addi (scratch, scratch, 0), RelocationType::Addr16Lo, { Relocation::section }, 0);
+        this->slwi (r0, index, 2);
+        this->lwzx (r0, scratch, r0);
+        this->add (scratch, scratch, r0);
+        this->mtctr (scratch);
+        this->bctr();
+
+        while ((uintptr_t) getExecutable (currentPointer) & 15)
+            write32 (0);
+        lastCode = UINT32_MAX;
+        pinPosition();
+
+        const auto table = (uint32_t) getCodeSize();
+        reserve (targets.size());
+        for (const auto& target : targets) {
+            tableEntries.push_back ({ (uint32_t) getCodeSize(), table, target.id });
+            write32 (0);
+        }
+
+        for (auto i = firstRelocation; i < firstRelocation + 2; i++)
+            relocations[i].addend = table;
+        patchSectionRelocations();
+    }
+
+    // Jump to the target of whichever case matches "value" (signed), or to defaultLabel if none do. Clobbers cr0, r0, CTR and "scratch"
+    // Dense runs of cases become jump tables, and the rest a binary search tree of compares
+    void switchCases (GPR value, std::vector <SwitchCase> cases, Label defaultLabel, GPR scratch = r12) {
+        if (scratch == r0 || scratch == value)
+            panic ("[Emitter] Fatal: switchCases needs a scratch register other than r0 and the value\n");
+
+        std::sort (cases.begin(), cases.end(), [] (const SwitchCase& a, const SwitchCase& b) { return a.value < b.value; });
+        for (size_t i = 1; i < cases.size(); i++)
+            if (cases[i].value == cases[i - 1].value)
+                panic ("[Emitter] Fatal: Duplicate switch case %d\n", cases[i].value);
+
+        // Split the cases into clusters, greedily making each jump table as long as it can be while staying dense
+        std::vector <CaseCluster> clusters;
+        for (size_t i = 0; i < cases.size(); ) {
+            size_t last = i;
+            for (size_t j = i + minTableCases - 1; j < cases.size(); j++)
+                if ((int64_t) cases[j].value - cases[i].value + 1 <= maxTableSparsity * (int64_t) (j - i + 1))
+                    last = j;
+
+            const bool isTable = last != i;
+            clusters.push_back ({ &cases[i], last - i + 1, isTable });
+            i = last + 1;
+        }
+
+        lowerClusters (value, clusters.data(), clusters.size(), defaultLabel, scratch);
+    }
+
+
+    // Start a function. The body follows right away, the prologue is emitted by endFunction once we know what the body clobbers
+    // "localSize" bytes of stack are available to the body at sp + 8. "mode" says whether opcode 4 in the body is AltiVec or paired singles
+    void beginFunction (uint32_t localSize = 0, DecodeMode mode = DecodeMode::PairedSingles) {
+        if (inFunction)
+            panic ("[Emitter] Fatal: beginFunction called inside of another function\n");
+
+        inFunction = true;
+        functionLocals = (localSize + 3) & ~3u;
+        functionMode = mode;
+        functionColdPaths = coldPaths.size();
+        functionExit = newLabel();
+        functionStart = getCodeSize();
+        pinPosition(); // The prologue branches here
+    }
+
+    // Return from the current function, through its epilogue
+    void returnFromFunction() {
+        setLabel (b(), functionExit);
+    }
+
+    // Finish the current function: emit the epilogue, then a prologue that saves only what the body actually clobbered
+    // LR is only saved in non-leaf functions, and the frame is skipped entirely when nothing needs it
+    // The prologue goes after the epilogue and ends with a branch to the body, so no space has to be set aside for it up front
+    // Its start is the function's entry point, which is returned. Functions without a frame are entered at the body directly
+    Anchor endFunction() {
+        if (!inFunction)
+            panic ("[Emitter] Fatal: endFunction called outside of a function\n");
+
+        // Cold paths of the function can clobber registers too, so they go in before the scan, with the body jumping over them
+        if (coldPaths.size() > functionColdPaths) {
+            returnFromFunction();
+            emitColdPaths (functionColdPaths);
+        }
+
+        Clobbers clobbers;
+        for (uint32_t offset = functionStart; offset < getCodeSize(); offset += 4)
+            scanClobbers (loadWord (code + offset / 4), clobbers, functionMode);
+
+        bind (functionExit);
+        inFunction = false;
+
+        const uint32_t gprs = clobbers.gprs & 0xFFFFC000; // r14-r31
+        const uint32_t fprs = clobbers.fprs & 0xFFFFC000; // f14-f31
+        const uint32_t vrs = clobbers.vrs & 0xFFF00000; // v20-v31
+        const bool saveVRSAVE = clobbers.vrsave;
+        uint8_t crMask = 0; // cr2-cr4, in mtcrf's field order (cr0 = 0x80)
+        for (int field = 2; field <= 4; field++)
+            if (clobbers.crFields & (1 << field))
+                crMask |= 0x80 >> field;
+
+        const bool saveLR = clobbers.lr;
+        int firstGPR = 32; // stmw saves everything from the lowest clobbered non-volatile up to r31
+        for (int reg = 31; reg >= 14; reg--)
+            if (gprs & (1u << reg))
+                firstGPR = reg;
+
+        uint32_t fprCount = 0;
+        for (auto mask = fprs; mask; mask &= mask - 1)
+            fprCount++;
+        uint32_t vrCount = 0;
+        for (auto mask = vrs; mask; mask &= mask - 1)
+            vrCount++;
+
+        // Frame layout, from the bottom up: back chain, LR save word for callees, locals, CR save word, VRSAVE save word,
+        // FPR save area, VR save area (16-byte aligned for stvx), GPR save area
+        const uint32_t crOffset = 8 + functionLocals;
+        const uint32_t vrsaveOffset = crOffset + (crMask ? 4 : 0);
+        const uint32_t fprOffset = (vrsaveOffset + (saveVRSAVE ? 4 : 0) + 7) & ~7u;
+        const uint32_t vrOffset = (fprOffset + fprCount * 8 + 15) & ~15u;
+        const uint32_t gprSize = (32 - firstGPR) * 4;
+        const uint32_t frameSize = (vrOffset + vrCount * 16 + gprSize + 15) & ~15u;
+        const uint32_t gprOffset = frameSize - gprSize;
+        const bool needsFrame = saveLR || crMask || fprs || vrs || saveVRSAVE || gprs || functionLocals;
+
+        if (frameSize > 0x7FF0)
+            panic ("[Emitter] Fatal: Stack frame too big (%u bytes)\n", frameSize);
+
+        // Epilogue
+        if (needsFrame) {
+            if (saveLR)
+                this->lwz (r0, sp, frameSize + 4);
+
+            auto vrSlot = vrOffset;
+            for (int reg = 20; reg < 32; reg++) {
+                if (vrs & (1u << reg)) {
+                    this->li (r12, vrSlot);
+                    this->lvx ((VR) reg, sp, r12);
+                    vrSlot += 16;
+                }
+            }
+
+            if (saveVRSAVE) {
+                this->lwz (r12, sp, vrsaveOffset);
+                this->mtspr (256, r12);
+            }
+            if (crMask) {
+                this->lwz (r12, sp, crOffset);
+                this->mtcrf (crMask, r12);
+            }
+
+            auto offset = fprOffset;
+            for (int reg = 14; reg < 32; reg++) {
+                if (fprs & (1u << reg)) {
+                    this->lfd ((FPR) reg, sp, offset);
+                    offset += 8;
+                }
+            }
+
+            if (gprs)
+                this->lmw ((GPR) firstGPR, sp, gprOffset);
+            this->addi (sp, sp, frameSize);
+            if (saveLR)
+                this->mtlr (r0);
+        }
+        this->blr();
+
+        if (!needsFrame)
+            return { functionStart };
+
+        // Prologue
+        const auto entry = getAnchor();
+        if (saveLR)
+            this->mflr (r0);
+        this->stwu (sp, sp, -(int16_t) frameSize);
+        if (saveLR)
+            this->stw (r0, sp, frameSize + 4); // LR goes in the caller's frame
+        if (crMask) {
+            this->mfcr (r12);
+            this->stw (r12, sp, crOffset);
+        }
+        if (saveVRSAVE) {
+            this->mfspr (r12, 256);
+            this->stw (r12, sp, vrsaveOffset);
+        }
+
+        auto vrSlot = vrOffset;
+        for (int reg = 20; reg < 32; reg++) {
+            if (vrs & (1u << reg)) {
+                this->li (r12, vrSlot);
+                this->stvx ((VR) reg, sp, r12);
+                vrSlot += 16;
+            }
+        }
+
+        auto offset = fprOffset;
+        for (int reg = 14; reg < 32; reg++) {
+            if (fprs & (1u << reg)) {
+                this->stfd ((FPR) reg, sp, offset);
+                offset += 8;
+            }
+        }
+
+        if (gprs)
+            this->stmw ((GPR) firstGPR, sp, gprOffset);
+        setLabel (b(), Anchor { functionStart });
+        return entry;
+    }
+
+    void dump (std::string path) {
+        const uint32_t size = getCodeSize();
+        std::ofstream file (path, std::ios::binary);
+        file.write ((const char*) code, size);
+        printf ("Dumped %u bytes\n", size);
+    }
+
+    // Build an ELF32 PowerPC relocatable object (ET_REL) out of the buffer, to link into a program at build time instead of emitting at runtime
+    // Exported symbols become global functions in .text, imports become undefined symbols, and every relocation goes to .rela.text
+    // Branches to labels inside the buffer are position-independent and need none. Uses the code's byte order, so a cross emitter
+    // (eg PPCEmitter <FixedSize, BigEndian> on x86) builds objects for its target
+    std::vector <uint8_t> buildObject() {
+        const bool littleEndian = (byteOrder == NativeEndian ? hostByteOrder : byteOrder) == LittleEndian;
+        const auto allRelocations = getRelocations();
+        const uint32_t textSize = (uint32_t) getCodeSize();
+
+        std::string strings (1, '\0'); // Symbol names
+        std::vector <uint32_t> nameOffsets;
+        for (const auto& symbol : symbols) {
+            nameOffsets.push_back ((uint32_t) strings.size());
+            strings += symbol.name;
+            strings += '\0';
+        }
+
+        const char sectionNames[] = "\0.text\0.rela.text\0.symtab\0.strtab\0.shstrtab"; // Offsets 1, 7, 18, 26, 34
+        const uint32_t textOffset = 64; // Past the 52 byte header, aligned for fetch
+        const uint32_t relocationsOffset = (textOffset + textSize + 3) & ~3u;
+        const uint32_t relocationsSize = (uint32_t) allRelocations.size() * 12;
+        const uint32_t symbolsOffset = relocationsOffset + relocationsSize;
+        const uint32_t symbolsSize = (uint32_t) (symbols.size() + 2) * 16; // The null symbol and the .text section symbol come first
+        const uint32_t stringsOffset = symbolsOffset + symbolsSize;
+        const uint32_t sectionNamesOffset = stringsOffset + (uint32_t) strings.size();
+        const uint32_t sectionsOffset = (sectionNamesOffset + sizeof (sectionNames) + 3) & ~3u;
+
+        std::vector <uint8_t> file;
+        file.reserve (sectionsOffset + 6 * 40);
+        const auto put = [&] (uint32_t value, uint32_t bytes) {
+            for (uint32_t i = 0; i < bytes; i++)
+                file.push_back ((uint8_t) (value >> ((littleEndian ? i : bytes - 1 - i) * 8)));
+        };
+
+        // ELF header
+        const uint8_t ident[16] = { 0x7F, 'E', 'L', 'F', 1, (uint8_t) (littleEndian ? 1 : 2), 1 };
+        file.insert (file.end(), ident, ident + 16);
+        put (1, 2); // ET_REL
+        put (20, 2); // EM_PPC
+        put (1, 4); // EV_CURRENT
+        put (0, 4); // Entry point
+        put (0, 4); // No program headers
+        put (sectionsOffset, 4);
+        put (0, 4); // Flags
+        put (52, 2); // Header size
+        put (0, 2);
+        put (0, 2);
+        put (40, 2); // Section header size
+        put (6, 2); // Section count
+        put (5, 2); // .shstrtab
+
+        file.resize (textOffset, 0);
+        file.insert (file.end(), (const uint8_t*) code, (const uint8_t*) code + textSize);
+        file.resize (relocationsOffset, 0);
+
+        for (const auto& relocation : allRelocations) {
+            const bool isHalf = relocation.type == RelocationType::Addr16Lo || relocation.type == RelocationType::Addr16Ha;
+            const uint32_t symbol = relocation.symbol == Relocation::absolute ? 0 : relocation.symbol == Relocation::section ? 1 : relocation.symbol + 2;
+            put (relocation.offset + (isHalf && !littleEndian ? 2 : 0), 4); // Half-word relocations point at the immediate itself
+            put ((symbol << 8) | (uint32_t) relocation.type, 4);
+            put ((uint32_t) relocation.addend, 4);
+        }
+
+        const auto putSymbol = [&] (uint32_t name, uint32_t value, uint32_t size, uint8_t info, uint16_t section) {
+            put (name, 4);
+            put (value, 4);
+            put (size, 4);
+            file.push_back (info);
+            file.push_back (0);
+            put (section, 2);
+        };
+        putSymbol (0, 0, 0, 0, 0);
+        putSymbol (0, 0, 0, 3, 1); // STB_LOCAL, STT_SECTION
+        for (uint32_t i = 0; i < symbols.size(); i++) {
+            const auto& symbol = symbols[i];
+            if (symbol.defined)
+                putSymbol (nameOffsets[i], symbol.offset, symbol.size, 0x12, 1); // STB_GLOBAL, STT_FUNC, in .text
+            else
+                putSymbol (nameOffsets[i], 0, 0, 0x10, 0); // STB_GLOBAL, STT_NOTYPE, undefined
+        }
+
+        file.insert (file.end(), strings.begin(), strings.end());
+        file.insert (file.end(), sectionNames, sectionNames + sizeof (sectionNames));
+        file.resize (sectionsOffset, 0);
+
+        const auto putSection = [&] (uint32_t name, uint32_t type, uint32_t flags, uint32_t offset, uint32_t size,
+                                     uint32_t link, uint32_t info, uint32_t align, uint32_t entrySize) {
+            put (name, 4);
+            put (type, 4);
+            put (flags, 4);
+            put (0, 4); // Address, assigned by the linker
+            put (offset, 4);
+            put (size, 4);
+            put (link, 4);
+            put (info, 4);
+            put (align, 4);
+            put (entrySize, 4);
+        };
+        putSection (0, 0, 0, 0, 0, 0, 0, 0, 0);
+        putSection (1, 1, 6, textOffset, textSize, 0, 0, 16, 0); // .text: SHT_PROGBITS, SHF_ALLOC | SHF_EXECINSTR
+        putSection (7, 4, 0x40, relocationsOffset, relocationsSize, 3, 1, 4, 12); // .rela.text: SHT_RELA, SHF_INFO_LINK, symbols in 3, applies to 1
+        putSection (18, 2, 0, symbolsOffset, symbolsSize, 4, 2, 4, 16); // .symtab: strings in 4, first global is symbol 2
+        putSection (26, 3, 0, stringsOffset, (uint32_t) strings.size(), 0, 0, 1, 0); // .strtab
+        putSection (34, 3, 0, sectionNamesOffset, sizeof (sectionNames), 0, 0, 1, 0); // .shstrtab
+        return file;
+    }
+
+    // Same as dump(), but as a relocatable object (see buildObject)
+    void writeObject (std::string path) {
+        const auto object = buildObject();
+        std::ofstream file (path, std::ios::binary);
+        file.write ((const char*) object.data(), object.size());
+        printf ("Wrote %zu byte object\n", object.size());
+    }
+
+    // Get a listing of everything emitted so far. Branch targets are shown at the address the code runs from
+    std::string disassemble (DecodeMode mode = DecodeMode::PairedSingles) {
+        if constexpr (swapBytes) { // The decoder works on host order words
+            std::vector <uint32_t> words (code, currentPointer);
+            swapInPlace <uint32_t> (words.data(), words.size());
+            return Decoder (mode).disassemble (words.data(), words.data() + words.size(), (uintptr_t) getExecutable (code));
+        } else
+            return Decoder (mode).disassemble (code, currentPointer, (uintptr_t) getExecutable (code));
+    }
+};
+// RAII helper that reserves room for a fixed amount of code, so a whole block is bounds-checked once instead of per instruction
+// Nothing emitted inside the scope can make an AutoGrow buffer move, so raw pointers into the scope stay valid until it ends
+// Writes inside the scope are unchecked, so emitting more than was reserved overruns the buffer. Debug builds assert on it when the scope ends
+template <typename Emitter>
+class EmitScope {
+    Emitter& gen;
+    uintptr_t start; // Code size when the scope was opened
+    uintptr_t words; // How many words were reserved
+
+public:
+    EmitScope (Emitter& emitter, uintptr_t reservedWords) : gen (emitter), words (reservedWords) {
+        gen.reserve (reservedWords);
+        gen.openScope();
+        start = gen.getCodeSize();
+    }
+
+    ~EmitScope() {
+        gen.closeScope();
+        assert (gen.getCodeSize() - start <= words * 4 && "[Emitter] Emitted more code than was reserved by an EmitScope");
+    }
+
+    EmitScope (const EmitScope&) = delete;
+    EmitScope& operator= (const EmitScope&) = delete;
+};
+
+// Register classes the allocator hands out
+enum class RegClass { GPR, FPR, VR };
+
+// A value that gets a physical register (or a stack slot) from a RegisterAllocator
+struct VirtualReg {
+    uint32_t id;
+};
+
+// Linear-scan register allocator layered on top of an emitter
+// Declare every value up front with the range of positions it is live in (eg guest instruction indices), then call allocate()
+// Values that are not live across a call get volatile registers first, then non-volatiles, which are handed out from r31/f31/v31 downwards
+// so that the prologue can save them with a single stmw. Values that don't fit in a register are spilled to a stack slot for their whole life
+template <typename Emitter>
+class RegisterAllocator {
+    struct Interval {
+        uint32_t start, end; // First and last position the value is live at
+        RegClass type;
+        bool crossesCall; // Needs a non-volatile register
+        int32_t reg = -1; // Physical register, or -1 if spilled
+        int32_t spillOffset = -1; // Offset of the spill slot from the stack pointer
+    };
+
+    Emitter& gen;
+    std::vector <Interval> intervals;
+    bool allocated = false;
+
+    // Per-class register pools as bitmasks
+    uint32_t volatiles[3] = {
+        0x000007F8, // r3-r10 (r0 can't be used as a base, r11/r12 are left free as scratch for spill code)
+        0x00003FFE, // f1-f13 (f0 is scratch)
+        0x000FFFFC  // v2-v19 (v0/v1 are scratch)
+    };
+    uint32_t nonVolatiles[3] = {
+        0xFFFFC000, // r14-r31
+        0xFFFFC000, // f14-f31
+        0xFFF00000  // v20-v31
+    };
+    uint32_t usedNonVolatiles[3] = { 0, 0, 0 }; // Which non-volatiles have to be saved in the prologue
+
+    uint32_t spillSize = 0; // Size of the spill area
+    uint32_t frameSize = 0;
+    static constexpr uint32_t frameHeader = 8; // Back chain + LR save word of the callee
+
+    static int lowestBit (uint32_t mask) {
+        for (int i = 0; i < 32; i++)
+            if (mask & (1u << i)) return i;
+        return -1;
+    }
+
+    static int highestBit (uint32_t mask) {
+        for (int i = 31; i >= 0; i--)
+            if (mask & (1u << i)) return i;
+        return -1;
+    }
+
+    static bool isNonVolatile (RegClass type, int reg) {
+        return reg >= (type == RegClass::VR ? 20 : 14);
+    }
+
+    static uint32_t slotSize (RegClass type) {
+        return type == RegClass::GPR ? 4 : type == RegClass::FPR ? 8 : 16;
+    }
+
+    Interval& get (VirtualReg value, RegClass type) {
+        if (!allocated)
+            panic ("[Emitter] Fatal: Tried to use a virtual register before calling allocate()\n");
+        if (value.id >= intervals.size() || intervals[value.id].type != type)
+            panic ("[Emitter] Fatal: Virtual register %u used as the wrong register class\n", value.id);
+        return intervals[value.id];
+    }
+
+    void spill (Interval& interval) {
+        const auto size = slotSize (interval.type);
+        spillSize = (spillSize + size - 1) & ~(size - 1); // Naturally align the slot
+        interval.reg = -1;
+        interval.spillOffset = spillSize; // Relative to the spill area for now
+        spillSize += size;
+    }
+
+    // Frame layout, from the bottom up: header, spill area, VR save area, FPR save area, GPR save area (stmw)
+    uint32_t gprSaveSize() const { const int r = lowestBit (usedNonVolatiles[0]); return r < 0 ? 0 : (32 - r) * 4; }
+    uint32_t fprSaveSize() const { return popcount (usedNonVolatiles[1]) * 8; }
+    uint32_t vrSaveSize() const { return popcount (usedNonVolatiles[2]) * 16; }
+
+    static uint32_t popcount (uint32_t mask) {
+        uint32_t count = 0;
+        for (; mask; mask &= mask - 1) count++;
+        return count;
+    }
+
+    uint32_t spillBase() const { return (frameHeader + 15) & ~15u; } // Keeps VR spill slots 16-byte aligned
+    uint32_t vrSaveBase() const { return vrSaveSize() ? (spillBase() + spillSize + 15) & ~15u : spillBase() + spillSize; }
+    uint32_t fprSaveBase() const { return (vrSaveBase() + vrSaveSize() + 7) & ~7u; }
+    uint32_t gprSaveBase() const { return frameSize - gprSaveSize(); }
+
+public:
+    RegisterAllocator (Emitter& emitter) : gen (emitter) {}
+
+    // Keep a register out of the pools, eg a parameter register that is still in use
+    template <typename Reg>
+    void exclude (RegClass type, Reg reg) {
+        volatiles[(int) type] &= ~(1u << reg);
+        nonVolatiles[(int) type] &= ~(1u << reg);
+    }
+
+    void exclude (GPR reg) { exclude (RegClass::GPR, reg); }
+    void exclude (FPR reg) { exclude (RegClass::FPR, reg); }
+    void exclude (VR reg) { exclude (RegClass::VR, reg); }
+
+    VirtualReg newValue (RegClass type, uint32_t start, uint32_t end, bool crossesCall = false) {
+        if (allocated)
+            panic ("[Emitter] Fatal: Tried to add a virtual register after allocation\n");
+        if (end < start)
+            panic ("[Emitter] Fatal: Virtual register dies before it is born (%u -> %u)\n", start, end);
+
+        intervals.push_back ({ start, end, type, crossesCall });
+        return { (uint32_t) intervals.size() - 1 };
+    }
+
+    VirtualReg newGPR (uint32_t start, uint32_t end, bool crossesCall = false) { return newValue (RegClass::GPR, start, end, crossesCall); }
+    VirtualReg newFPR (uint32_t start, uint32_t end, bool crossesCall = false) { return newValue (RegClass::FPR, start, end, crossesCall); }
+    VirtualReg newVR (uint32_t start, uint32_t end, bool crossesCall = false) { return newValue (RegClass::VR, start, end, crossesCall); }
+
+    // Assign a physical register or a spill slot to every value
+    void allocate() {
+        std::vector <uint32_t> order (intervals.size());
+        for (uint32_t i = 0; i < order.size(); i++)
+            order[i] = i;
+        std::stable_sort (order.begin(), order.end(), [&] (uint32_t a, uint32_t b) { return intervals[a].start < intervals[b].start; });
+
+        std::vector <uint32_t> active; // Intervals currently holding a register, sorted by end
+        uint32_t freeVolatile[3], freeNonVolatile[3];
+        std::copy (volatiles, volatiles + 3, freeVolatile);
+        std::copy (nonVolatiles, nonVolatiles + 3, freeNonVolatile);
+
+        for (const auto index : order) {
+            auto& current = intervals[index];
+            const int type = (int) current.type;
+
+            // Expire the intervals that ended before this one starts and give their registers back
+            while (!active.empty() && intervals[active.front()].end < current.start) {
+                const auto& old = intervals[active.front()];
+                auto& pool = isNonVolatile (old.type, old.reg) ? freeNonVolatile : freeVolatile;
+                pool[(int) old.type] |= 1u << old.reg;
+                active.erase (active.begin());
+            }
+
+            int reg = current.crossesCall ? -1 : lowestBit (freeVolatile[type]);
+            if (reg >= 0)
+                freeVolatile[type] &= ~(1u << reg);
+            else if ((reg = highestBit (freeNonVolatile[type])) >= 0)
+                freeNonVolatile[type] &= ~(1u << reg);
+            else { // Out of registers: spill whichever compatible value lives the longest
+                auto victim = active.end();
+                for (auto it = active.begin(); it != active.end(); it++) {
+                    const auto& other = intervals[*it];
+                    if (other.type == current.type && (!current.crossesCall || isNonVolatile (other.type, other.reg)))
+                        victim = it;
+                }
+
+                if (victim == active.end() || intervals[*victim].end <= current.end) {
+                    spill (current);
+                    continue;
+                }
+
+                reg = intervals[*victim].reg;
+                spill (intervals[*victim]);
+                active.erase (victim);
+            }
+
+            current.reg = reg;
+            if (isNonVolatile (current.type, reg))
+                usedNonVolatiles[type] |= 1u << reg;
+
+            const auto pos = std::upper_bound (active.begin(), active.end(), index, [&] (uint32_t a, uint32_t b) { return intervals[a].end < intervals[b].end; });
+            active.insert (pos, index);
+        }
+
+        // Lay out the frame: header, spill area, then the save areas, rounded to 16 bytes
+        frameSize = (fprSaveBase() + fprSaveSize() + gprSaveSize() + 15) & ~15u;
+        if (frameSize > 0x7FF0)
+            panic ("[Emitter] Fatal: Stack frame too big (%u bytes)\n", frameSize);
+        for (auto& interval : intervals)
+            if (interval.reg < 0)
+                interval.spillOffset += spillBase();
+
+        allocated = true;
+    }
+
+    bool isSpilled (VirtualReg value) { return intervals[value.id].reg < 0; }
+    int16_t getSpillOffset (VirtualReg value) { return (int16_t) intervals[value.id].spillOffset; } // Relative to sp after the prologue
+    uint32_t getFrameSize() { return frameSize; }
+    uint32_t getUsedNonVolatiles (RegClass type) { return usedNonVolatiles[(int) type]; }
+
+    // Physical register of a value that is not spilled
+    GPR gpr (VirtualReg value) { return (GPR) reg (value, RegClass::GPR); }
+    FPR fpr (VirtualReg value) { return (FPR) reg (value, RegClass::FPR); }
+    VR vr (VirtualReg value) { return (VR) reg (value, RegClass::VR); }
+
+    int reg (VirtualReg value, RegClass type) {
+        const auto& interval = get (value, type);
+        if (interval.reg < 0)
+            panic ("[Emitter] Fatal: Virtual register %u is spilled, use load/store\n", value.id);
+        return interval.reg;
+    }
+
+    // Get a register holding the value. Spilled values are reloaded into "scratch"
+    GPR load (VirtualReg value, GPR scratch) {
+        const auto& interval = get (value, RegClass::GPR);
+        if (interval.reg >= 0)
+            return (GPR) interval.reg;
+
+        gen.lwz (scratch, sp, interval.spillOffset);
+        return scratch;
+    }
+
+    FPR load (VirtualReg value, FPR scratch) {
+        const auto& interval = get (value, RegClass::FPR);
+        if (interval.reg >= 0)
+            return (FPR) interval.reg;
+
+        gen.lfd (scratch, sp, interval.spillOffset);
+        return scratch;
+    }
+
+    VR load (VirtualReg value, VR scratch, GPR index = r0) { // VR reloads need a GPR for the offset
+        const auto& interval = get (value, RegClass::VR);
+        if (interval.reg >= 0)
+            return (VR) interval.reg;
+
+        gen.li (index, interval.spillOffset);
+        gen.lvx (scratch, sp, index);
+        return scratch;
+    }
+
+    // Get the register to compute the value into. Call store() with it afterwards, which writes spilled values back to their slot
+    GPR def (VirtualReg value, GPR scratch) { const auto& interval = get (value, RegClass::GPR); return interval.reg >= 0 ? (GPR) interval.reg : scratch; }
+    FPR def (VirtualReg value, FPR scratch) { const auto& interval = get (value, RegClass::FPR); return interval.reg >= 0 ? (FPR) interval.reg : scratch; }
+    VR def (VirtualReg value, VR scratch) { const auto& interval = get (value, RegClass::VR); return interval.reg >= 0 ? (VR) interval.reg : scratch; }
+
+    void store (VirtualReg value, GPR src) {
+        const auto& interval = get (value, RegClass::GPR);
+        if (interval.reg < 0)
+            gen.stw (src, sp, interval.spillOffset);
+    }
+
+    void store (VirtualReg value, FPR src) {
+        const auto& interval = get (value, RegClass::FPR);
+        if (interval.reg < 0)
+            gen.stfd (src, sp, interval.spillOffset);
+    }
+
+    void store (VirtualReg value, VR src, GPR index = r0) {
+        const auto& interval = get (value, RegClass::VR);
+        if (interval.reg < 0) {
+            gen.li (index, interval.spillOffset);
+            gen.stvx (src, sp, index);
+        }
+    }
+
+    // Set up the stack frame and save the non-volatiles that were handed out. Emits nothing if the function needs no frame
+    // With saveLR, the link register is saved too (through r0), for functions that make calls
+    void emitPrologue (bool saveLR = false) {
+        if (!allocated)
+            panic ("[Emitter] Fatal: emitPrologue called before allocate()\n");
+        if (saveLR)
+            gen.mflr (r0);
+
+        const bool needsFrame = saveLR || spillSize || usedNonVolatiles[0] || usedNonVolatiles[1] || usedNonVolatiles[2];
+        if (!needsFrame)
+            return;
+
+        gen.stwu (sp, sp, -(int16_t) frameSize);
+        if (saveLR)
+            gen.stw (r0, sp, frameSize + 4); // The caller's LR save word
+
+        if (usedNonVolatiles[0])
+            gen.stmw ((GPR) lowestBit (usedNonVolatiles[0]), sp, gprSaveBase());
+
+        auto offset = fprSaveBase();
+        for (int reg = 14; reg < 32; reg++) {
+            if (usedNonVolatiles[1] & (1u << reg)) {
+                gen.stfd ((FPR) reg, sp, offset);
+                offset += 8;
+            }
+        }
+
+        offset = vrSaveBase();
+        for (int reg = 20; reg < 32; reg++) {
+            if (usedNonVolatiles[2] & (1u << reg)) {
+                gen.li (r0, offset);
+                gen.stvx ((VR) reg, sp, r0);
+                offset += 16;
+            }
+        }
+    }
+
+    // Restore everything the prologue saved and pop the frame. The return itself (blr) is left to the caller
+    void emitEpilogue (bool restoreLR = false) {
+        const bool needsFrame = restoreLR || spillSize || usedNonVolatiles[0] || usedNonVolatiles[1] || usedNonVolatiles[2];
+        if (!needsFrame)
+            return;
+
+        auto offset = vrSaveBase();
+        for (int reg = 20; reg < 32; reg++) {
+            if (usedNonVolatiles[2] & (1u << reg)) {
+                gen.li (r0, offset);
+                gen.lvx ((VR) reg, sp, r0);
+                offset += 16;
+            }
+        }
+
+        offset = fprSaveBase();
+        for (int reg = 14; reg < 32; reg++) {
+            if (usedNonVolatiles[1] & (1u << reg)) {
+                gen.lfd ((FPR) reg, sp, offset);
+                offset += 8;
+            }
+        }
+
+        if (usedNonVolatiles[0])
+            gen.lmw ((GPR) lowestBit (usedNonVolatiles[0]), sp, gprSaveBase());
+        if (restoreLR)
+            gen.lwz (r0, sp, frameSize + 4);
+
+        gen.addi (sp, sp, frameSize);
+        if (restoreLR)
+            gen.mtlr (r0);
+    }
+};
+
+// SIMD units the kernel builder can target
+enum class VectorUnit {
+    PairedSingles, // Gekko/Broadway/Espresso: pairs of floats in FPRs, with quantized loads/stores converting integer data
+    AltiVec // G4/G5: 16 byte vector registers
+};
+
+// Emits whole loops for common vector kernels (memcpy, saxpy, dot products, pixel conversions) for a count only known at runtime
+// AltiVec kernels run scalar until the destination is 16-byte aligned, realign the source with lvsl/vperm, and finish the last elements scalar
+// Paired single kernels need no head, except copies, which move doubles and only take the fast path if both sides are 8-byte aligned together
+// The body is unrolled (setUnroll), counted down in CTR, and prefetches its streams with dst (AltiVec) or dcbt (paired singles)
+// Pointers and counts are passed in GPRs, which the kernel uses up. Elements have to be naturally aligned
+// Kernels also clobber CTR, cr0, r0, r11, r12, f0, f5-f13 and v0-v15. Paired single kernels reprogram the builder's GQR (see setGQR)
+template <typename Emitter>
+class KernelBuilder {
+    enum class Op { Copy, Saxpy, DotProduct, U8ToS16, S16ToU8 };
+
+    // A kernel to emit. dest is the side that gets aligned, so for dot products it's simply the second array
+    struct Shape {
+        Op op;
+        GPR dest, src, count;
+        FPR scalar; // Saxpy's scale, or the dot product's result
+        uint32_t destSize, srcSize; // Element sizes in bytes
+    };
+
+    static constexpr uint32_t streamControl = 0x08080080; // dst: 8 blocks of 128 bytes (8 quadwords), 128 bytes apart
+    static constexpr int16_t prefetchDistance = 128; // How far ahead of the pointers paired single kernels touch the cache
+    static constexpr int16_t frameSize = 32; // Frame for moving values between register files
+    static constexpr int16_t scratchSlot = 16; // 16-byte aligned, as the stack pointer always is
+
+    static constexpr VR perm = v0; // Source realignment permute
+    static constexpr VR splat = v1; // Saxpy's scale, or zero for widening
+    VR previous = v2, next = v3; // The last 2 source quadwords. They trade places after every load instead of getting copied
+
+    Emitter& gen;
+    VectorUnit unit;
+    uint32_t unroll = 4;
+    bool prefetch = true;
+    GQR gqr = gqr7;
+
+    static uint32_t log2 (uint32_t value) {
+        uint32_t result = 0;
+        while (value > 1) {
+            value >>= 1;
+            result++;
+        }
+        return result;
+    }
+
+    void emitKernel (const Shape& shape) {
+        for (const auto reg : { shape.dest, shape.src, shape.count })
+            if (reg == r0 || reg == sp || reg == r11 || reg == r12)
+                panic ("[Emitter] Fatal: Kernel pointers and counts can't be in r0, r1, r11 or r12\n");
+        if (shape.dest == shape.src || shape.dest == shape.count || shape.src == shape.count)
+            panic ("[Emitter] Fatal: Kernel pointers and counts have to be in different registers\n");
+        if ((shape.op == Op::Saxpy || shape.op == Op::DotProduct) && (shape.scalar == f0 || (shape.scalar >= f5 && shape.scalar <= f13)))
+            panic ("[Emitter] Fatal: Kernel scalars can't be in f0 or f5-f13\n");
+
+        const bool needsFrame = shape.op == Op::DotProduct || (shape.op == Op::Saxpy && unit == VectorUnit::AltiVec);
+        if (needsFrame)
+            gen.stwu (sp, sp, -frameSize);
+        if (shape.op == Op::DotProduct) { // There's no FPR immediate, so 0.0 comes from the stack
+            gen.li (r0, 0);
+            gen.stw (r0, sp, scratchSlot);
+            gen.lfs (shape.scalar, sp, scratchSlot);
+        }
+
+        const auto tail = gen.newLabel();
+        if (unit == VectorUnit::AltiVec)
+            emitAltiVecBody (shape, tail);
+        else
+            emitPairedBody (shape, tail);
+
+        gen.bind (tail);
+        scalarLoop (shape, shape.count);
+        if (needsFrame)
+            gen.addi (sp, sp, frameSize);
+    }
+
+    // One element, the slow way. Uses r0, r12, f0 and f13
+    void scalarElement (const Shape& shape) {
+        switch (shape.op) {
+            case Op::Copy:
+                gen.lbz (r0, shape.src, 0);
+                gen.stb (r0, shape.dest, 0);
+                break;
+            case Op::Saxpy:
+                gen.lfs (f0, shape.src, 0);
+                gen.lfs (f13, shape.dest, 0);
+                gen.fmadds (f13, shape.scalar, f0, f13);
+                gen.stfs (f13, shape.dest, 0);
+                break;
+            case Op::DotProduct:
+                gen.lfs (f0, shape.src, 0);
+                gen.lfs (f13, shape.dest, 0);
+                gen.fmadds (shape.scalar, f0, f13, shape.scalar);
+                break;
+            case Op::U8ToS16:
+                gen.lbz (r0, shape.src, 0);
+                gen.sth (r0, shape.dest, 0);
+                break;
+            case Op::S16ToU8: // Sign extend, then clamp to 0-255 without branches
+                gen.lhz (r0, shape.src, 0);
+                gen.slwi (r0, r0, 16);
+                gen.srawi (r0, r0, 16);
+                gen.srawi (r12, r0, 31); // All ones if negative
+                gen.andc (r0, r0, r12);
+                gen.subfic (r12, r0, 255);
+                gen.srawi (r12, r12, 31); // All ones if above 255, and the byte store only keeps the 0xFF
+                gen.or_ (r0, r0, r12);
+                gen.stb (r0, shape.dest, 0);
+                break;
+        }
+    }
+
+    // Process "n" elements one at a time
+    void scalarLoop (const Shape& shape, GPR n) {
+        const auto done = gen.newLabel();
+        gen.cmpli (cr0, n, 0);
+        gen.beq (done);
+        gen.mtctr (n);
+
+        const auto top = gen.getAnchor();
+        scalarElement (shape);
+        gen.addi (shape.src, shape.src, shape.srcSize);
+        gen.addi (shape.dest, shape.dest, shape.destSize);
+        gen.setLabel (gen.bdnz(), top);
+        gen.bind (done);
+    }
+
+    // Run the scalar loop until dest is aligned to "alignment" bytes, or the elements run out
+    void alignHead (const Shape& shape, uint32_t alignment) {
+        const auto clamped = gen.newLabel();
+        gen.subfic (r11, shape.dest, 0); // Bytes to the boundary: -dest mod alignment
+        gen.clrlwi (r11, r11, 32 - log2 (alignment));
+        if (shape.destSize > 1)
+            gen.srwi (r11, r11, log2 (shape.destSize));
+        gen.cmpl (cr0, r11, shape.count);
+        gen.ble (clamped);
+        gen.mr (r11, shape.count);
+        gen.bind (clamped);
+
+        gen.sub (shape.count, shape.count, r11);
+        scalarLoop (shape, r11);
+    }
+
+    // Split the count into body iterations, which go in CTR, and the elements left for the tail. Skips to the tail if there are no iterations
+    void splitCount (const Shape& shape, uint32_t perIteration, Label tail) {
+        gen.srwi (r11, shape.count, log2 (perIteration));
+        gen.clrlwi (shape.count, shape.count, 32 - log2 (perIteration));
+        gen.cmpli (cr0, r11, 0);
+        gen.beq (tail);
+        gen.mtctr (r11);
+    }
+
+    // Load the next 16 source bytes into "dest"
+    void loadSource (VR dest, GPR src) {
+        gen.lvx (next, r0, src);
+        gen.addi (src, src, 16);
+        gen.vperm (dest, previous, next, perm);
+        std::swap (previous, next);
+    }
+
+    // 16 bytes of the narrower side. Uses v4-v7 for source data, v8-v11 for destination data and v12-v15 as dot product accumulators
+    void vectorStep (const Shape& shape, uint32_t step) {
+        const auto x = (VR) (v4 + step);
+        const auto y = (VR) (v8 + step);
+        const auto sum = (VR) (v12 + step);
+
+        switch (shape.op) {
+            case Op::Copy:
+                loadSource (x, shape.src);
+                gen.stvx (x, r0, shape.dest);
+                break;
+            case Op::Saxpy:
+                loadSource (x, shape.src);
+                gen.lvx (y, r0, shape.dest);
+                gen.vmaddfp (y, x, y, splat); // x * scale + y
+                gen.stvx (y, r0, shape.dest);
+                break;
+            case Op::DotProduct:
+                loadSource (x, shape.src);
+                gen.lvx (y, r0, shape.dest);
+                gen.vmaddfp (sum, x, sum, y); // x * y + sum
+                break;
+            case Op::U8ToS16: // Merging with zero bytes zero-extends
+                loadSource (x, shape.src);
+                gen.vmrghb (y, splat, x);
+                gen.vmrglb (x, splat, x);
+                gen.stvx (y, r0, shape.dest);
+                gen.stvx (x, shape.dest, r11);
+                break;
+            case Op::S16ToU8:
+                loadSource (x, shape.src);
+                loadSource (y, shape.src);
+                gen.vpkshus (x, x, y);
+                gen.stvx (x, r0, shape.dest);
+                break;
+        }
+
+        gen.addi (shape.dest, shape.dest, shape.op == Op::U8ToS16 ? 32 : 16);
+    }
+
+    void emitAltiVecBody (const Shape& shape, Label tail) {
+        alignHead (shape, 16);
+        splitCount (shape, 16 / std::min (shape.srcSize, shape.destSize) * unroll, tail);
+
+        // The realignment permute comes from src - 1 and is then bumped by 1, so that an aligned source takes all of the second quadword
+        // Loads can then be done at src + 15, which never touches a quadword past the end of the data
+        gen.addi (r12, shape.src, -1);
+        gen.lvsl (perm, r0, r12);
+        gen.vspltisb (splat, 1);
+        gen.vaddubm (perm, perm, splat);
+        gen.lvx (previous, r0, shape.src);
+        gen.addi (shape.src, shape.src, 15);
+
+        if (shape.op == Op::Saxpy) { // Splat the scale through the stack
+            gen.stfs (shape.scalar, sp, scratchSlot);
+            gen.li (r12, scratchSlot);
+            gen.lvewx (splat, sp, r12);
+            gen.vspltw (splat, splat, 0); // The slot is 16-byte aligned, so the word lands in element 0
+        } else if (shape.op == Op::U8ToS16) {
+            gen.vspltisb (splat, 0);
+            gen.li (r11, 16); // Offset of the second half of the widened data
+        } else if (shape.op == Op::DotProduct) {
+            for (uint32_t step = 0; step < unroll; step++)
+                gen.vxor ((VR) (v12 + step), (VR) (v12 + step), (VR) (v12 + step));
+        }
+
+        if (prefetch)
+            gen.liw (r12, streamControl);
+
+        const auto top = gen.getAnchor();
+        if (prefetch) { // The streams are restarted at the current pointers every iteration, so they stay ahead of the loop
+            gen.dst (0, shape.src, r12);
+            if (shape.op == Op::DotProduct)
+                gen.dst (1, shape.dest, r12);
+            else
+                gen.dstst (1, shape.dest, r12);
+        }
+
+        const auto first = previous;
+        for (uint32_t step = 0; step < unroll; step++)
+            vectorStep (shape, step);
+        if (previous != first) { // An odd number of loads, so the last one has to end up where the next iteration expects it
+            gen.vor (first, previous, previous);
+            std::swap (previous, next);
+        }
+        gen.setLabel (gen.bdnz(), top);
+
+        if (prefetch) {
+            gen.dss (0);
+            gen.dss (1);
+        }
+        gen.addi (shape.src, shape.src, -15);
+
+        if (shape.op == Op::DotProduct) { // Add the accumulators up, then the 4 lanes of what's left
+            for (uint32_t step = 1; step < unroll; step++)
+                gen.vaddfp (v12, v12, (VR) (v12 + step));
+            gen.vsldoi (v13, v12, v12, 8);
+            gen.vaddfp (v12, v12, v13);
+            gen.vsldoi (v13, v12, v12, 4);
+            gen.vaddfp (v12, v12, v13);
+            gen.li (r12, scratchSlot);
+            gen.stvewx (v12, sp, r12);
+            gen.lfs (f0, sp, scratchSlot);
+            gen.fadds (shape.scalar, shape.scalar, f0);
+        }
+    }
+
+    // A pair of elements (or a double for copies) at "step" pairs into the iteration. Uses f6-f9 for source data, f10-f13 for destination data,
+    // f0 for the scale and f0/f5 as dot product accumulators
+    void pairedStep (const Shape& shape, uint32_t step) {
+        const auto x = (FPR) (f6 + step);
+        const auto y = (FPR) (f10 + step);
+        const auto sum = step & 1 ? f5 : f0;
+        const auto srcOffset = (int16_t) (step * 2 * shape.srcSize);
+        const auto destOffset = (int16_t) (step * 2 * shape.destSize);
+
+        switch (shape.op) {
+            case Op::Copy: // lfd/stfd don't convert anything, so any bit pattern makes it through
+                gen.lfd (x, shape.src, step * 8);
+                gen.stfd (x, shape.dest, step * 8);
+                break;
+            case Op::Saxpy:
+                gen.psq_l (x, shape.src, srcOffset, false, gqr);
+                gen.psq_l (y, shape.dest, destOffset, false, gqr);
+                gen.ps_madd (y, x, f0, y); // x * scale + y
+                gen.psq_st (y, shape.dest, destOffset, false, gqr);
+                break;
+            case Op::DotProduct:
+                gen.psq_l (x, shape.src, srcOffset, false, gqr);
+                gen.psq_l (y, shape.dest, destOffset, false, gqr);
+                gen.ps_madd (sum, x, y, sum);
+                break;
+            case Op::U8ToS16:
+            case Op::S16ToU8: // The GQR converts on the way in and saturates on the way out
+                gen.psq_l (x, shape.src, srcOffset, false, gqr);
+                gen.psq_st (x, shape.dest, destOffset, false, gqr);
+                break;
+        }
+    }
+
+    void emitPairedBody (const Shape& shape, Label tail) {
+        if (shape.op == Op::Copy) {
+            alignHead (shape, 8);
+            gen.xor_ (r12, shape.src, shape.dest);
+            gen.andi (r12, r12, 7);
+            gen.bne (tail); // The source can't be aligned as well, so it's bytes all the way
+        } else {
+            const uint32_t quantization = shape.op == Op::U8ToS16 ? makeGQR (QuantType::U8, 0, QuantType::S16, 0)
+                                        : shape.op == Op::S16ToU8 ? makeGQR (QuantType::S16, 0, QuantType::U8, 0)
+                                        : makeGQR (QuantType::Float, 0, QuantType::Float, 0);
+            gen.setGQR (gqr, quantization, r12);
+        }
+
+        const uint32_t perStep = shape.op == Op::Copy ? 8 : 2;
+        splitCount (shape, perStep * unroll, tail);
+        if (shape.op == Op::Saxpy)
+            gen.ps_merge00 (f0, shape.scalar, shape.scalar);
+        else if (shape.op == Op::DotProduct) { // The result is still 0.0 here
+            gen.ps_merge00 (f0, shape.scalar, shape.scalar);
+            gen.ps_merge00 (f5, shape.scalar, shape.scalar);
+        }
+        if (prefetch)
+            gen.li (r12, prefetchDistance);
+
+        const auto top = gen.getAnchor();
+        if (prefetch) {
+            gen.dcbt (shape.src, r12);
+            if (shape.op == Op::DotProduct)
+                gen.dcbt (shape.dest, r12);
+            else
+                gen.dcbtst (shape.dest, r12);
+        }
+
+        for (uint32_t step = 0; step < unroll; step++)
+            pairedStep (shape, step);
+        gen.addi (shape.src, shape.src, perStep * unroll * shape.srcSize);
+        gen.addi (shape.dest, shape.dest, perStep * unroll * shape.destSize);
+        gen.setLabel (gen.bdnz(), top);
+
+        if (shape.op == Op::DotProduct) {
+            gen.ps_add (f0, f0, f5);
+            gen.ps_sum0 (f0, f0, f0, f0); // ps0 + ps1
+            gen.fadds (shape.scalar, shape.scalar, f0);
+        }
+    }
+
+public:
+    KernelBuilder (Emitter& emitter, VectorUnit vectorUnit) : gen (emitter), unit (vectorUnit) {}
+
+    // How many vector steps (16 bytes of AltiVec data, or 1 pair of paired single data) the body does per iteration: 1, 2 or 4
+    void setUnroll (uint32_t steps) {
+        if (steps != 1 && steps != 2 && steps != 4)
+            panic ("[Emitter] Fatal: Kernels can only be unrolled 1, 2 or 4 times, not %u\n", steps);
+        unroll = steps;
+    }
+
+    // Turn the prefetches in the body off, eg for data that's known to be in the cache already
+    void setPrefetch (bool enabled) {
+        prefetch = enabled;
+    }
+
+    // The GQR paired single kernels set up for their loads and stores
+    void setGQR (GQR reg) {
+        gqr = reg;
+    }
+
+    // memcpy: copy "bytes" bytes from src to dest. The buffers can't overlap
+    void copy (GPR dest, GPR src, GPR bytes) {
+        emitKernel ({ Op::Copy, dest, src, bytes, f0, 1, 1 });
+    }
+
+    // y[i] = scale * x[i] + y[i] for "count" floats
+    void saxpy (GPR y, GPR x, FPR scale, GPR count) {
+        emitKernel ({ Op::Saxpy, y, x, count, scale, 4, 4 });
+    }
+
+    // result = the sum of x[i] * y[i] for "count" floats. The vector body accumulates in several lanes, so the rounding differs from a scalar loop
+    void dotProduct (FPR result, GPR x, GPR y, GPR count) {
+        emitKernel ({ Op::DotProduct, y, x, count, result, 4, 4 });
+    }
+
+    // Widen "count" unsigned bytes (eg pixels) to signed halfwords
+    void u8ToS16 (GPR dest, GPR src, GPR count) {
+        emitKernel ({ Op::U8ToS16, dest, src, count, f0, 2, 1 });
+    }
+
+    // Narrow "count" signed halfwords to unsigned bytes, saturating to 0-255
+    void s16ToU8 (GPR dest, GPR src, GPR count) {
+        emitKernel ({ Op::S16ToU8, dest, src, count, f0, 1, 2 });
+    }
+};
+
+// A code cache shared by several compiler threads
+// Every thread gets its own Writer, which takes chunks of the arena with an atomic bump and emits blocks into them without any locking
+// Blocks all stay in one contiguous reservation, so direct branches between blocks compiled on different threads usually stay in range
+class CodeCache {
+    CodeArena arena;
+    uintptr_t chunkSize;
+    SymbolRegistry* symbols = nullptr;
+
+public:
+    CodeCache (uintptr_t size = 32 * 1024 * 1024, uintptr_t chunk = 256 * 1024, ArenaMode mode = ArenaMode::DualView) : arena (size, mode), chunkSize (chunk) {}
+
+    CodeArena& getArena() { return arena; }
+    uintptr_t getChunkSize() { return chunkSize; }
+
+    // Name every block as it's published, for profilers and debuggers. Pass nullptr to stop
+    void setSymbolRegistry (SymbolRegistry* registry) { symbols = registry; }
+
+    // Per-thread emission region. Not thread-safe itself: create one per compiler thread
+    class Writer {
+        CodeCache& cache;
+        PPCEmitter <FixedSize> gen { 0 };
+        uint32_t* cursor = nullptr; // Where the next block goes
+        uint32_t* chunkEnd = nullptr;
+        bool emitting = false;
+
+    public:
+        Writer (CodeCache& codeCache) : cache (codeCache) {}
+
+        Writer (const Writer&) = delete;
+        Writer& operator= (const Writer&) = delete;
+
+        // The emitter blocks get compiled with, eg to set a block entry hook or read its stats
+        PPCEmitter <FixedSize>& getEmitter() { return gen; }
+
+        // Start a block of at most "maxSize" bytes, and get the emitter to compile it with
+        // Grabs a new chunk if the current one can't fit it. Returns nullptr if the cache is full
+        PPCEmitter <FixedSize>* begin (uintptr_t maxSize = 16 * 1024) {
+            if (emitting)
+                panic ("[CodeCache] Fatal: begin called twice without publishing the block\n");
+
+            maxSize = (maxSize + 3) & ~3;
+            if (!cursor || (uintptr_t) chunkEnd - (uintptr_t) cursor < maxSize) {
+                const auto size = std::max (cache.chunkSize, maxSize);
+                cursor = cache.arena.allocate (size);
+                if (!cursor)
+                    return nullptr;
+                chunkEnd = cursor + size / 4;
+            }
+
+            gen.setBuffer (cache.arena, cursor, (uintptr_t) chunkEnd - (uintptr_t) cursor);
+            gen.beginBlock();
+            emitting = true;
+            return &gen;
+        }
+
+        // Finish the current block: resolve its labels, flush it to the icache and return the address to run it at
+        // The release fence makes the code visible to whichever thread gets handed the pointer. On PowerPC, that
+        // thread should still run an isync before jumping to code it didn't compile itself
+        // With a symbol registry, the block is registered as "name", or as luma_code_<address> if there's none
+        void* publish (const char* name = nullptr) {
+            if (!emitting)
+                panic ("[CodeCache] Fatal: publish called without a block in progress\n");
+
+            gen.endBlock();
+            const auto entry = gen.finalize();
+            if (cache.symbols) {
+                char generated[32];
+                if (!name) {
+                    std::snprintf (generated, sizeof (generated), "luma_code_%zx", (size_t) entry);
+                    name = generated;
+                }
+                cache.symbols->add (entry, gen.getCodeSize(), name);
+            }
+
+            cursor = gen.getCurr();
+            if (cache.arena.getMode() == ArenaMode::ToggleProtection) { // The block's pages are read-only now, so the next one starts on a fresh page
+                const auto pageSize = cache.arena.getPageSize();
+                cursor = (uint32_t*) std::min (((uintptr_t) cursor + pageSize - 1) & ~(pageSize - 1), (uintptr_t) chunkEnd);
+            } else
+                cursor = (uint32_t*) (((uintptr_t) cursor + 15) & ~15); // Keep blocks 16-byte aligned for fetch
+
+            emitting = false;
+            std::atomic_thread_fence (std::memory_order_release);
+            return entry;
+        }
+    };
+};
+
+enum class EvictionPolicy {
+    FIFO, // Recycling a generation throws away every block in it
+    LRU // Blocks that were looked up since the last generation switch survive, and get compacted to the start of their generation
+};
+
+// A single-threaded block cache for long-running dynarecs, that reclaims space instead of flushing everything
+// The cache is split into generations that are filled one after another. When it wraps around, the oldest generation is recycled:
+// its blocks are evicted (or compacted, with LRU), and every direct link into an evicted block is undone first
+class BlockCache {
+public:
+    struct Link {
+        uint64_t block; // Key of the block the exit belongs to
+        uint32_t exit; // Index of the exit in that block
+    };
+
+    struct Block {
+        uint32_t* code; // Writeable view of the block
+        uint32_t size; // In bytes
+        uint32_t generation;
+        uint64_t lastUse; // Value of the generation clock when the block was last looked up
+        std::vector <std::pair <uint32_t, void*>> relocations; // Relative branches out of the block: offset and target
+        std::vector <Relocation> addressLoads; // Loads of addresses inside the block, eg of jump tables
+        std::vector <ExitStub> exits;
+        std::vector <uint64_t> exitTargets; // The block each exit is linked to, or noTarget
+        std::vector <Link> incoming; // Exits of other blocks that are linked to this one
+    };
+
+    static constexpr uint64_t noTarget = UINT64_MAX;
+
+private:
+    CodeArena arena;
+    uint32_t* base = nullptr;
+    uintptr_t generationSize;
+    EvictionPolicy policy;
+    std::vector <std::vector <uint64_t>> generations; // Keys of the blocks in every generation, in address order
+    std::unordered_map <uint64_t, Block> blocks;
+    uint32_t current = 0; // Generation blocks are being emitted into
+    uint32_t* cursor = nullptr;
+    uint32_t* generationEnd = nullptr;
+    uint64_t clock = 0; // Ticks every time we move on to a new generation
+
+    PPCEmitter <FixedSize> gen { 0 };
+    bool emitting = false;
+    uint64_t pendingKey = 0;
+    std::vector <ExitStub> pendingExits;
+
+    uint64_t evictedBlocks = 0;
+    uint64_t compactedBlocks = 0;
+    SymbolRegistry* symbols = nullptr;
+
+    uint32_t* generationStart (uint32_t generation) { return base + generation * generationSize / 4; }
+    void* toExecutable (uint32_t* pointer) { return arena.toExecutable (pointer); }
+
+    static uint32_t* alignBlock (uint32_t* pointer) { return (uint32_t*) (((uintptr_t) pointer + 15) & ~(uintptr_t) 15); }
+
+    void addSymbol (uint64_t key, const Block& block) {
+        char name[32];
+        std::snprintf (name, sizeof (name), "luma_block_%llx", (unsigned long long) key);
+        symbols->add (toExecutable (block.code), block.size, name);
+    }
+
+    void unlinkExit (uint64_t key, uint32_t exit) {
+        auto& block = blocks.at (key);
+        const auto target = block.exitTargets[exit];
+        if (target == noTarget)
+            return;
+
+        block.exits[exit].unlink();
+        block.exitTargets[exit] = noTarget;
+
+        auto& incoming = blocks.at (target).incoming;
+        for (auto it = incoming.begin(); it != incoming.end(); it++) {
+            if (it->block == key && it->exit == exit) {
+                incoming.erase (it);
+                break;
+            }
+        }
+    }
+
+    // Remove a block, after making every exit that jumps to it go back to the dispatcher
+    void evict (uint64_t key) {
+        auto& block = blocks.at (key);
+        while (!block.incoming.empty()) {
+            const auto link = block.incoming.back();
+            unlinkExit (link.block, link.exit);
+        }
+
+        for (uint32_t i = 0; i < block.exits.size(); i++)
+            unlinkExit (key, i);
+
+        if (symbols)
+            symbols->remove (toExecutable (block.code));
+        blocks.erase (key);
+        evictedBlocks++;
+    }
+
+    // Slide a block down to "destination", re-encoding its relative branches out of the block and fixing up every link into and out of it
+    // Returns false (and leaves the block alone) if one of its branches would go out of range
+    bool move (uint64_t key, uint32_t* destination) {
+        auto& block = blocks.at (key);
+        if (destination == block.code)
+            return true;
+
+        const auto newExec = (uintptr_t) toExecutable (destination);
+        for (const auto& [offset, target] : block.relocations)
+            if (!encodeBranch24 (newExec + offset, (uintptr_t) target))
+                return false;
+
+        std::vector <uint64_t> targets = block.exitTargets;
+        for (uint32_t i = 0; i < block.exits.size(); i++) { // Exits go back to their original dispatcher jumps before their words get relocated
+            if (block.exitTargets[i] != noTarget) {
+                block.exits[i].unlink();
+                block.exitTargets[i] = noTarget;
+            }
+        }
+
+        std::memmove (destination, block.code, block.size);
+        for (const auto& [offset, target] : block.relocations)
+            destination[offset / 4] = encodeBranch24 (newExec + offset, (uintptr_t) target, destination[offset / 4] & 1);
+        for (const auto& load : block.addressLoads)
+            applyRelocation (destination + load.offset / 4, newExec + load.offset, newExec + load.addend, load.type);
+
+        for (auto& exit : block.exits)
+            exit = ExitStub (destination + (exit.getLocation() - block.code), arena.getExecOffset(), &arena);
+        if (symbols)
+            symbols->remove (toExecutable (block.code));
+        block.code = destination;
+        if (symbols)
+            addSymbol (key, block);
+        flushICache (destination, destination + block.size / 4, arena.getExecOffset());
+
+        for (uint32_t i = 0; i < block.exits.size(); i++) { // Relink our exits, as long as their targets stay in range
+            if (targets[i] == noTarget)
+                continue;
+
+            auto& incoming = blocks.at (targets[i]).incoming;
+            if (block.exits[i].link (toExecutable (blocks.at (targets[i]).code)))
+                block.exitTargets[i] = targets[i];
+            else
+                incoming.erase (std::find_if (incoming.begin(), incoming.end(), [&] (const Link& link) { return link.block == key && link.exit == i; }));
+        }
+
+        for (uint32_t i = 0; i < block.incoming.size(); ) { // Point everything that was linked to us to our new address
+            const auto link = block.incoming[i];
+            if (link.block == key) { // Our own exits were handled above
+                i++;
+                continue;
+            }
+
+            auto& from = blocks.at (link.block);
+            if (from.exits[link.exit].link (toExecutable (destination)))
+                i++;
+            else { // Out of range now, go through the dispatcher instead
+                from.exits[link.exit].unlink();
+                from.exitTargets[link.exit] = noTarget;
+                block.incoming.erase (block.incoming.begin() + i);
+            }
+        }
+
+        compactedBlocks++;
+        return true;
+    }
+
+    // Reuse a generation: evict its blocks, or compact the ones that were used recently
+    void recycle (uint32_t generation, bool evictEverything) {
+        cursor = generationStart (generation);
+        generationEnd = cursor + generationSize / 4;
+
+        std::vector <uint64_t> survivors;
+        for (const auto key : generations[generation]) {
+            const auto& block = blocks.at (key);
+            const bool hot = policy == EvictionPolicy::LRU && !evictEverything && block.lastUse + 1 >= clock;
+
+            if (hot && move (key, cursor)) {
+                survivors.push_back (key);
+                cursor = alignBlock (cursor + block.size / 4);
+            } else
+                evict (key);
+        }
+
+        generations[generation] = std::move (survivors);
+    }
+
+    // Move on to the next generation with at least "size" bytes free
+    void nextGeneration (uintptr_t size) {
+        for (uint32_t tries = 0; tries <= generations.size(); tries++) {
+            clock++;
+            current = (current + 1) % generations.size();
+            recycle (current, tries == generations.size()); // If everything is hot, fall back to FIFO
+
+            if ((uintptr_t) generationEnd - (uintptr_t) cursor >= size)
+                return;
+        }
+    }
+
+public:
+    BlockCache (uintptr_t size = 32 * 1024 * 1024, uint32_t generationCount = 8, EvictionPolicy evictionPolicy = EvictionPolicy::FIFO)
+        : arena (size, ArenaMode::DualView), policy (evictionPolicy), generations (generationCount) {
+        if (generationCount == 0)
+            panic ("[BlockCache] Fatal: A block cache needs at least 1 generation\n");
+
+        generationSize = (arena.getCapacity() / generationCount) & ~(uintptr_t) 15;
+        base = arena.allocate (generationSize * generationCount);
+        cursor = base;
+        generationEnd = base + generationSize / 4;
+    }
+
+    BlockCache (const BlockCache&) = delete;
+    BlockCache& operator= (const BlockCache&) = delete;
+
+    // Start compiling the block for "key", which may be at most "maxSize" bytes. An older block for the same key is evicted
+    PPCEmitter <FixedSize>* begin (uint64_t key, uintptr_t maxSize = 16 * 1024) {
+        if (emitting)
+            panic ("[BlockCache] Fatal: begin called twice without publishing the block\n");
+        if (maxSize > generationSize)
+            panic ("[BlockCache] Fatal: Block size (%zu bytes) is bigger than a generation\n", (size_t) maxSize);
+
+        invalidate (key);
+
+        maxSize = (maxSize + 3) & ~(uintptr_t) 3;
+        if ((uintptr_t) generationEnd - (uintptr_t) cursor < maxSize)
+            nextGeneration (maxSize);
+
+        gen.setBuffer (arena, cursor, (uintptr_t) generationEnd - (uintptr_t) cursor);
+        gen.beginBlock();
+        emitting = true;
+        pendingKey = key;
+        pendingExits.clear();
+        return &gen;
+    }
+
+    // Emit a linkable exit in the block being compiled, and return its index for link()
+    uint32_t emitExit (void* dispatcher, GPR scratch = r12) {
+        pendingExits.push_back (gen.emitLinkableExit (dispatcher, scratch));
+        return (uint32_t) pendingExits.size() - 1;
+    }
+
+    // Finish the block being compiled and return the address to run it at
+    void* publish() {
+        if (!emitting)
+            panic ("[BlockCache] Fatal: publish called without a block in progress\n");
+
+        gen.endBlock();
+        const auto entry = gen.finalize();
+        auto& block = blocks[pendingKey];
+        block.code = gen.getBuffer();
+        block.size = (uint32_t) gen.getCodeSize();
+        block.generation = current;
+        block.lastUse = clock;
+        for (const auto& branch : gen.getExternalBranches())
+            block.relocations.push_back ({ branch.offset, branch.target });
+        for (const auto& relocation : gen.getRelocations())
+            if (relocation.symbol == Relocation::section)
+                block.addressLoads.push_back (relocation);
+        block.exits = std::move (pendingExits);
+        block.exitTargets.assign (block.exits.size(), noTarget);
+        if (symbols)
+            addSymbol (pendingKey, block);
+
+        generations[current].push_back (pendingKey);
+        cursor = alignBlock (gen.getCurr());
+        emitting = false;
+        return entry;
+    }
+
+    // Find the block for "key". Returns nullptr if it was never compiled or got evicted
+    void* lookup (uint64_t key) {
+        const auto it = blocks.find (key);
+        if (it == blocks.end())
+            return nullptr;
+
+        it->second.lastUse = clock;
+        return toExecutable (it->second.code);
+    }
+
+    // Link exit "exit" of block "from" directly to block "to". Returns false if either is missing or the target is out of range
+    bool link (uint64_t from, uint32_t exit, uint64_t to) {
+        if (!blocks.count (from) || !blocks.count (to) || exit >= blocks.at (from).exits.size())
+            return false;
+
+        unlinkExit (from, exit);
+        auto& block = blocks.at (from);
+        if (!block.exits[exit].link (toExecutable (blocks.at (to).code)))
+            return false;
+
+        block.exitTargets[exit] = to;
+        blocks.at (to).incoming.push_back ({ from, exit });
+        return true;
+    }
+
+    // Throw away a block, eg because the guest code it was compiled from was overwritten. Its space is reclaimed with its generation
+    void invalidate (uint64_t key) {
+        if (!blocks.count (key))
+            return;
+
+        auto& keys = generations[blocks.at (key).generation];
+        keys.erase (std::remove (keys.begin(), keys.end(), key), keys.end());
+        evict (key);
+    }
+
+    const Block* getBlock (uint64_t key) {
+        const auto it = blocks.find (key);
+        return it == blocks.end() ? nullptr : &it->second;
+    }
+
+    // Name every block as luma_block_<key> while it's cached, for profilers and debuggers. Pass nullptr to stop
+    // Evicted blocks are removed from the registry, and compacted ones are re-added at their new address
+    void setSymbolRegistry (SymbolRegistry* registry) { symbols = registry; }
+
+    PPCEmitter <FixedSize>& getEmitter() { return gen; } // Eg to set a block entry hook or read its stats
+    size_t getBlockCount() { return blocks.size(); }
+    uint64_t getEvictedBlocks() { return evictedBlocks; }
+    uint64_t getCompactedBlocks() { return compactedBlocks; }
+    uintptr_t getGenerationSize() { return generationSize; }
+    CodeArena& getArena() { return arena; }
+};
+// Ahead-of-time code cache: blocks saved to disk together with their relocations, and loaded back by only applying those
+// Blocks must have their labels resolved, as branches inside a block are position-independent and aren't saved. Imported symbols
+// (see importSymbol) are looked up by name at load time, which is how blocks should refer to runtime helpers whose address changes between runs
+// The file is in host byte order, and tagged with a version, so that stale or foreign caches get rejected instead of run
+// Blocks come from native emitters. Code emitted for a target of the other byte order (see ByteOrder) is shipped with buildObject instead
+class CodeImage {
+public:
+    static constexpr uint32_t version = 1;
+    static constexpr uint32_t local = Relocation::section; // Relocation symbol for targets inside the same block: the addend is the offset in the block
+
+    struct Block {
+        uint64_t key; // Eg the guest address the block was compiled from
+        uint64_t sourceHash; // Hash of what the block was compiled from, so stale blocks can be skipped
+        uint64_t codeHash; // Hash of the unrelocated code, checked at load time
+        uint32_t offset; // In the code section
+        uint32_t size;
+        uint32_t firstRelocation;
+        uint32_t relocationCount;
+    };
+
+    // Look up the address of an imported symbol at load time. Returning nullptr fails the load
+    using Resolver = void* (*) (const char* name, void* userData);
+
+    // 64-bit FNV-1a, eg for hashing the guest code a block was compiled from
+    static uint64_t hash (const void* data, size_t size) {
+        auto bytes = (const uint8_t*) data;
+        uint64_t result = 0xCBF29CE484222325;
+        for (size_t i = 0; i < size; i++)
+            result = (result ^ bytes[i]) * 0x100000001B3;
+        return result;
+    }
+
+private:
+    struct Header {
+        char magic[4]; // "LUMA"
+        uint32_t version;
+        uint8_t littleEndian;
+        uint8_t pointerSize;
+        uint16_t reserved;
+        uint32_t blockCount;
+        uint32_t relocationCount;
+        uint32_t importCount;
+        uint32_t stringsSize; // Import names, null-terminated one after the other
+        uint64_t codeOffset; // Page-aligned, so the code section could be mapped directly
+        uint64_t codeSize;
+    };
+
+    struct SavedRelocation {
+        uint32_t offset; // In the block
+        uint32_t symbol; // Index of an import, local, or Relocation::absolute
+        uint32_t type;
+        uint32_t reserved;
+        int64_t addend;
+    };
+
+    static constexpr uintptr_t codeAlignment = 4096;
+
+    std::vector <Block> blocks;
+    std::vector <SavedRelocation> relocations;
+    std::vector <std::string> imports;
+    std::vector <uint32_t> code;
+    std::unordered_map <uint64_t, uint32_t> index; // Key -> block
+    uint32_t* loadedCode = nullptr; // Writeable view of the loaded code section
+    void* loadedExec = nullptr;
+
+    uint32_t importIndex (const std::string& name) {
+        for (uint32_t i = 0; i < imports.size(); i++)
+            if (imports[i] == name)
+                return i;
+
+        imports.push_back (name);
+        return (uint32_t) imports.size() - 1;
+    }
+
+    // Map a file read-only, or read it in on platforms without virtual memory
+    struct MappedFile {
+        const uint8_t* data = nullptr;
+        uintptr_t size = 0;
+#if defined(_WIN32)
+        HANDLE file = INVALID_HANDLE_VALUE;
+        HANDLE mapping = nullptr;
+#elif !LUMA_HAS_VIRTUAL_MEMORY
+        std::vector <uint8_t> contents;
+#endif
+
+        MappedFile (const std::string& path) {
+#if defined(_WIN32)
+            file = CreateFileA (path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+            LARGE_INTEGER fileSize;
+            if (file == INVALID_HANDLE_VALUE || !GetFileSizeEx (file, &fileSize) || fileSize.QuadPart == 0)
+                return;
+
+            mapping = CreateFileMappingA (file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (mapping) {
+                data = (const uint8_t*) MapViewOfFile (mapping, FILE_MAP_READ, 0, 0, 0);
+                size = data ? (uintptr_t) fileSize.QuadPart : 0;
+            }
+#elif LUMA_HAS_VIRTUAL_MEMORY
+            const int fd = open (path.c_str(), O_RDONLY);
+            if (fd < 0)
+                return;
+
+            const auto fileSize = lseek (fd, 0, SEEK_END);
+            if (fileSize > 0) {
+                void* mem = mmap (nullptr, (size_t) fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (mem != MAP_FAILED) {
+                    data = (const uint8_t*) mem;
+                    size = (uintptr_t) fileSize;
+                }
+            }
+            close (fd); // The mapping keeps the file alive
+#else
+            std::ifstream file (path, std::ios::binary);
+            contents.assign (std::istreambuf_iterator <char> (file), std::istreambuf_iterator <char>());
+            data = contents.data();
+            size = contents.size();
+#endif
+        }
+
+        ~MappedFile() {
+#if defined(_WIN32)
+            if (data)
+                UnmapViewOfFile (data);
+            if (mapping)
+                CloseHandle (mapping);
+            if (file != INVALID_HANDLE_VALUE)
+                CloseHandle (file);
+#elif LUMA_HAS_VIRTUAL_MEMORY
+            if (data)
+                munmap ((void*) data, size);
+#endif
+        }
+    };
+
+public:
+    // Add a finished block. Pending labels are resolved first. Every relocation the emitter recorded is kept:
+    // imports by name, exported symbols of the same emitter as local targets, and branches to absolute addresses as they are
+    template <GrowingMode mode>
+    void addBlock (uint64_t key, uint64_t sourceHash, PPCEmitter <mode>& gen) {
+        if (loadedCode)
+            panic ("[CodeImage] Fatal: Can't add blocks to a loaded image\n");
+        if (index.count (key))
+            panic ("[CodeImage] Fatal: Block %llx was added twice\n", (unsigned long long) key);
+
+        gen.resolveLabels();
+        const auto size = (uint32_t) gen.getCodeSize();
+        const auto offset = (uint32_t) code.size() * 4;
+        const auto& symbols = gen.getSymbols();
+
+        Block block { key, sourceHash, hash (gen.getBuffer(), size), offset, size, (uint32_t) relocations.size(), 0 };
+        for (const auto& relocation : gen.getRelocations()) {
+            SavedRelocation saved { relocation.offset, relocation.symbol, (uint32_t) relocation.type, 0, relocation.addend };
+            if (relocation.symbol != Relocation::absolute && relocation.symbol != Relocation::section) {
+                const auto& symbol = symbols[relocation.symbol];
+                if (symbol.defined) {
+                    saved.symbol = local;
+                    saved.addend += symbol.offset;
+                } else
+                    saved.symbol = importIndex (symbol.name);
+            }
+
+            relocations.push_back (saved);
+            block.relocationCount++;
+        }
+
+        code.insert (code.end(), gen.getBuffer(), gen.getBuffer() + size / 4);
+        while (code.size() & 3) // Keep blocks 16-byte aligned for fetch
+            code.push_back (0);
+
+        index[key] = (uint32_t) blocks.size();
+        blocks.push_back (block);
+    }
+
+    // Write the image out. Returns false if the file couldn't be written
+    bool save (const std::string& path) {
+        std::string strings;
+        for (const auto& name : imports) {
+            strings += name;
+            strings += '\0';
+        }
+
+        const uint16_t endianTest = 1;
+        Header header;
+        std::memset (&header, 0, sizeof (header));
+        std::memcpy (header.magic, "LUMA", 4);
+        header.version = version;
+        header.littleEndian = *(const uint8_t*) &endianTest;
+        header.pointerSize = sizeof (void*);
+        header.blockCount = (uint32_t) blocks.size();
+        header.relocationCount = (uint32_t) relocations.size();
+        header.importCount = (uint32_t) imports.size();
+        header.stringsSize = (uint32_t) strings.size();
+        const auto metadataSize = sizeof (Header) + blocks.size() * sizeof (Block) + relocations.size() * sizeof (SavedRelocation) + strings.size();
+        header.codeOffset = (metadataSize + codeAlignment - 1) & ~(codeAlignment - 1);
+        header.codeSize = code.size() * 4;
+
+        std::ofstream file (path, std::ios::binary);
+        file.write ((const char*) &header, sizeof (header));
+        file.write ((const char*) blocks.data(), blocks.size() * sizeof (Block));
+        file.write ((const char*) relocations.data(), relocations.size() * sizeof (SavedRelocation));
+        file.write (strings.data(), strings.size());
+        file.write (std::string (header.codeOffset - metadataSize, '\0').data(), header.codeOffset - metadataSize);
+        file.write ((const char*) code.data(), header.codeSize);
+        return (bool) file;
+    }
+
+    // Map an image, copy its code into "arena" and apply its relocations there. The code is flushed and made executable
+    // Returns false, and leaves the image empty, if the file is missing, corrupt, from another version or host, if an import can't be
+    // resolved, or if a branch ends up out of range. Hashes of the code are checked too, unless "verify" is false
+    bool load (const std::string& path, CodeArena& arena, Resolver resolve = nullptr, void* userData = nullptr, bool verify = true) {
+        if (loadedCode)
+            panic ("[CodeImage] Fatal: Image loaded twice\n");
+
+        clear();
+        const MappedFile file (path);
+        Header header;
+        const uint16_t endianTest = 1;
+        if (file.size < sizeof (Header))
+            return false;
+
+        std::memcpy (&header, file.data, sizeof (Header));
+        const auto metadataSize = sizeof (Header) + (uint64_t) header.blockCount * sizeof (Block) +
+                                  (uint64_t) header.relocationCount * sizeof (SavedRelocation) + header.stringsSize;
+        if (std::memcmp (header.magic, "LUMA", 4) != 0 || header.version != version || header.littleEndian != *(const uint8_t*) &endianTest ||
+            header.pointerSize != sizeof (void*) || metadataSize > header.codeOffset || header.codeOffset + header.codeSize > file.size || (header.codeSize & 3))
+            return false;
+
+        auto cursor = file.data + sizeof (Header);
+        blocks.resize (header.blockCount);
+        std::memcpy (blocks.data(), cursor, blocks.size() * sizeof (Block));
+        cursor += blocks.size() * sizeof (Block);
+        relocations.resize (header.relocationCount);
+        std::memcpy (relocations.data(), cursor, relocations.size() * sizeof (SavedRelocation));
+        cursor += relocations.size() * sizeof (SavedRelocation);
+
+        for (auto name = (const char*) cursor, end = name + header.stringsSize; name < end; name += imports.back().size() + 1)
+            imports.push_back (std::string (name, std::find (name, end, '\0')));
+        if (imports.size() != header.importCount) {
+            clear();
+            return false;
+        }
+
+        const auto* image = file.data + header.codeOffset;
+        for (const auto& block : blocks) {
+            if ((uint64_t) block.offset + block.size > header.codeSize || (block.offset & 3) || (uint64_t) block.firstRelocation + block.relocationCount > relocations.size() ||
+                (verify && hash (image + block.offset, block.size) != block.codeHash)) {
+                clear();
+                return false;
+            }
+        }
+
+        std::vector <void*> addresses (imports.size());
+        for (uint32_t i = 0; i < imports.size(); i++) {
+            addresses[i] = resolve ? resolve (imports[i].c_str(), userData) : nullptr;
+            if (!addresses[i]) {
+                clear();
+                return false;
+            }
+        }
+
+        if (header.codeSize == 0)
+            return true;
+
+        loadedCode = arena.allocate (header.codeSize);
+        if (!loadedCode) {
+            clear();
+            return false;
+        }
+
+        std::memcpy (loadedCode, image, header.codeSize);
+        loadedExec = arena.toExecutable (loadedCode);
+        for (uint32_t i = 0; i < blocks.size(); i++) {
+            const auto& block = blocks[i];
+            const auto blockExec = (uintptr_t) loadedExec + block.offset;
+
+            for (uint32_t j = 0; j < block.relocationCount; j++) {
+                const auto& relocation = relocations[block.firstRelocation + j];
+                const bool isImport = relocation.symbol != local && relocation.symbol != Relocation::absolute;
+                if ((uint64_t) relocation.offset + 4 > block.size || (relocation.offset & 3) || (isImport && relocation.symbol >= addresses.size())) {
+                    clear();
+                    return false;
+                }
+
+                uintptr_t target = (uintptr_t) relocation.addend;
+                if (relocation.symbol == local)
+                    target += blockExec;
+                else if (isImport)
+                    target += (uintptr_t) addresses[relocation.symbol];
+
+                if (!applyRelocation (loadedCode + (block.offset + relocation.offset) / 4, blockExec + relocation.offset, target, (RelocationType) relocation.type)) {
+                    clear();
+                    return false;
+                }
+            }
+
+            index[block.key] = i;
+        }
+
+        arena.makeExecutable (loadedCode, header.codeSize);
+        flushICache (loadedCode, loadedCode + header.codeSize / 4, arena.getExecOffset());
+        return true;
+    }
+
+    // Find a loaded block. Returns nullptr if there's none for "key", or if it was compiled from something with a different hash
+    void* lookup (uint64_t key, uint64_t sourceHash) {
+        const auto it = index.find (key);
+        if (!loadedExec || it == index.end() || blocks[it->second].sourceHash != sourceHash)
+            return nullptr;
+
+        return (uint8_t*) loadedExec + blocks[it->second].offset;
+    }
+
+    // Forget every block. Code that was already loaded stays in its arena
+    void clear() {
+        blocks.clear();
+        relocations.clear();
+        imports.clear();
+        code.clear();
+        index.clear();
+        loadedCode = nullptr;
+        loadedExec = nullptr;
+    }
+
+    const std::vector <Block>& getBlocks() { return blocks; }
+    const std::vector <std::string>& getImports() { return imports; }
+};
+
 } // End Namespace Luma
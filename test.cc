@@ -1,10 +1,12 @@
 // This is a program made to check the emitter for regressions by the CI
 // Horrible code will ensue
 #define RUNNING_IN_CI 1
+#define LUMA_STATS 1 // Count everything, so the stats can be checked too
 #include <iostream>
 #include <iterator>
 #include <vector>
 #include <string>
+#include <thread>
 #include "luma.hpp"
 using namespace Luma;
 
@@ -37,7 +39,1081 @@ static std::vector <uint8_t> loadBinary(std::string directory) {
     return vec;
 }
 
+// Check that emitters backed by a code arena see their code through the executable view once finalized
+static bool testCodeArena (ArenaMode mode) {
+    CodeArena arena (1024 * 1024, mode);
+    PPCEmitter <FixedSize> gen1 (arena, 4096);
+    PPCEmitter <FixedSize> gen2 (arena, 4096);
+
+    gen1.li (r3, 42);
+    gen1.blr();
+    gen2.li (r3, 69);
+    gen2.blr();
+
+    const auto block1 = gen1.finalize();
+    const auto block2 = gen2.finalize();
+    return block1[0] == 0x3860002A && block1[1] == 0x4E800020 && block2[0] == 0x38600045 && block2 != block1;
+}
+
+// Check that labels and anchors survive AutoGrow moving the code buffer around
+static bool testAutoGrow() {
+    PPCEmitter <AutoGrow> gen (64);
+    const auto forward = gen.beq();
+    const auto anchor = gen.getAnchor();
+
+    gen.repeat <100> ([&](auto) { gen.nop(); }); // Grow the buffer a couple of times
+    gen.setLabel (forward);
+    const auto backward = gen.b();
+    gen.setLabel (backward, anchor);
+
+    const auto buffer = gen.getBuffer();
+    if (buffer[0] != (0x41820000 | 404) || buffer[101] != (0x48000000 | (-400 & 0x3FFFFFC)))
+        return false;
+
+    EmitScope scope (gen, 4096); // Everything in the scope should fit without the buffer moving again
+    const auto scopeBuffer = gen.getBuffer();
+    for (int i = 0; i < 4096; i++)
+        gen.nop();
+
+    return gen.getBuffer() == scopeBuffer;
+}
+
+// Check that calls out of the buffer are re-encoded, and recorded only once, when AutoGrow moves the code
+static bool testAutoGrowExternal() {
+    CodeArena arena (1024 * 1024);
+    PPCEmitter <AutoGrow> gen (arena, 64);
+    const auto helper = (uintptr_t) arena.toExecutable (arena.getBase()) + 512 * 1024; // Never actually run
+
+    gen.setLabel (gen.bl(), (void*) helper);
+    gen.setLabel (gen.b(), (void*) helper);
+    gen.repeat <100> ([&](auto) { gen.nop(); }); // Grow the buffer a couple of times
+    gen.blr();
+
+    const auto buffer = gen.getBuffer();
+    const auto exec = (uintptr_t) gen.getExecutable (buffer);
+    return buffer[0] == (0x48000001 | ((helper - exec) & 0x3FFFFFC)) && buffer[1] == (0x48000000 | ((helper - exec - 4) & 0x3FFFFFC));
+}
+
+// Check that commit() flushes only new code, plus committed code that got patched since the last commit
+static bool testCommit() {
+    PPCEmitter <FixedSize> gen (4096);
+    const auto forward = gen.b();
+    gen.repeat <3> ([&](auto) { gen.nop(); });
+    const auto first = gen.commit();
+    if (first != gen.getBuffer() || gen.getCommittedSize() != 16 || gen.getDirtyStart() != UINT32_MAX)
+        return false;
+
+    gen.nop();
+    gen.setLabel (forward); // Patches the committed branch
+    if (gen.getDirtyStart() != 0 || gen.getCommittedSize() != 16)
+        return false;
+
+    const auto second = gen.commit();
+    return second == gen.getBuffer() + 4 && gen.getCommittedSize() == 20 && gen.getDirtyStart() == UINT32_MAX &&
+           gen.getBuffer()[0] == (0x48000000 | 20);
+}
+
+// Check that forward labels can be shared by many branches and get resolved in one go
+static bool testLabels() {
+    PPCEmitter <FixedSize> gen (4096);
+    const auto exit = gen.newLabel();
+
+    gen.beq (exit);
+    gen.bne (exit);
+    gen.b (exit);
+    gen.nop();
+    gen.bind (exit);
+    gen.blr();
+    gen.resolveLabels();
+
+    const auto buffer = gen.getBuffer();
+    return buffer[0] == 0x41820010 && buffer[1] == 0x4082000C && buffer[2] == 0x48000008;
+}
+
+// Check that conditional branches going out of range get routed through a veneer
+static bool testBranchRelaxation() {
+    PPCEmitter <FixedSize> gen (128 * 1024);
+    gen.setBranchRelaxation (true);
+
+    const auto branch = gen.beq();
+    const auto near = gen.bne();
+    gen.setLabel (near); // In range, should be patched directly
+
+    for (int i = 0; i < 16384; i++) { // 64KB of code, with a label every now and then where islands can go
+        if ((i & 255) == 0)
+            gen.bind (gen.newLabel());
+        gen.nop();
+    }
+
+    gen.setLabel (branch);
+    const auto buffer = gen.getBuffer();
+    const auto target = gen.getCodeSize();
+    const auto veneer = (buffer[0] & 0xFFFC) / 4; // The beq should now point to a veneer, which branches to the real target
+
+    return (buffer[0] & 0xFFFF0000) == 0x41820000 && buffer[1] == 0x40820004
+        && buffer[veneer] == (0x48000000 | ((target - veneer * 4) & 0x3FFFFFC));
+}
+
+// Check that block exits can be linked to other blocks and unlinked again
+static bool testBlockLinking() {
+    CodeArena arena (1024 * 1024, ArenaMode::DualView);
+    PPCEmitter <FixedSize> dispatcher (arena, 4096);
+    PPCEmitter <FixedSize> block1 (arena, 4096);
+    PPCEmitter <FixedSize> block2 (arena, 4096);
+
+    dispatcher.blr();
+    const auto dispatcherCode = dispatcher.finalize();
+    block1.nop();
+    auto exit = block1.emitLinkableExit (dispatcherCode);
+    block1.finalize();
+    block2.blr();
+    const auto block2Code = block2.finalize();
+
+    const auto exitCode = arena.toExecutable (exit.getLocation());
+    const auto original = *exitCode;
+    if (!exit.link (block2Code) || *exitCode != (0x48000000 | (((uintptr_t) block2Code - (uintptr_t) exitCode) & 0x3FFFFFC)))
+        return false;
+
+    exit.unlink();
+    return *exitCode == original && original == (0x48000000 | (((uintptr_t) dispatcherCode - (uintptr_t) exitCode) & 0x3FFFFFC));
+}
+
+// Check that instructions can be encoded at compile time and copied into an emitter as a block
+static constexpr auto thunk = makeTemplate <4> ([] (auto& c) { c.li (r3, 0); c.liw (r4, 0x12345678); c.blr(); });
+static_assert (enc.addi (r3, r1, 4) == 0x38610004 && enc.add <true> (r3, r4, r5) == 0x7C642A15);
+static_assert (thunk.size() == 4 && thunk[0] == 0x38600000);
+
+static bool testCodeTemplates() {
+    PPCEmitter <FixedSize> gen;
+    gen.dw (thunk);
+    gen.dw (thunk.array(), 1);
+
+    PPCEmitter <FixedSize> reference;
+    reference.li (r3, 0);
+    reference.liw (r4, 0x12345678);
+    reference.blr();
+    reference.li (r3, 0);
+
+    return gen.getCodeSize() == reference.getCodeSize() && std::memcmp (gen.getBuffer(), reference.getBuffer(), gen.getCodeSize()) == 0;
+}
+
+// Check that stamping a stencil gives the same code as encoding every instruction
+static bool testStencils() {
+    Stencil load;
+    load.lwz (r0, r0, 0); // rD = [rA + offset]
+    load.hole (0, Stencil::RD);
+    load.hole (1, Stencil::RA);
+    load.hole (2, Stencil::Imm16);
+    load.rlwinm (r0, r0, 0, 0, 31); // rotlwi rD, rD, SH: rotate the loaded value by a shift amount that's also a hole
+    load.hole (0, Stencil::RD);
+    load.hole (0, Stencil::RA);
+    load.hole (3, Stencil::SH);
+
+    PPCEmitter <FixedSize> gen;
+    gen.stamp (load, { r3, r4, 0x10, 8 });
+    gen.stamp (load, { r31, sp, (uint16_t) -4, 24 });
+
+    PPCEmitter <FixedSize> reference;
+    reference.lwz (r3, r4, 0x10);
+    reference.rlwinm (r3, r3, 8, 0, 31);
+    reference.lwz (r31, sp, -4);
+    reference.rlwinm (r31, r31, 24, 0, 31);
+
+    return gen.getCodeSize() == reference.getCodeSize() && std::memcmp (gen.getBuffer(), reference.getBuffer(), gen.getCodeSize()) == 0;
+}
+
+// Check that the peephole optimizer folds redundant code, but leaves code that is pointed at alone
+static bool testPeephole() {
+    PPCEmitter <FixedSize> gen;
+    gen.setPeephole (true);
+    gen.mr (r3, r3); // Dropped
+    gen.li (r4, 1); // Overwritten by the lis below
+    gen.lis (r4, 0x1234);
+    gen.addis (r4, r4, 1); // Merged into lis r4, 0x1235
+    gen.li (r5, 0x10);
+    gen.addi (r5, r5, 0x20); // Merged into li r5, 0x30
+    gen.li (r6, 0);
+    gen.ori (r6, r6, 0x7000); // Merged into li r6, 0x7000
+    gen.liu (r7, 0x8000); // Can't be merged
+    gen.li (r8, 1);
+    const auto loop = gen.getAnchor();
+    gen.addi (r8, r8, 1); // Branched to, so it can't be merged into the li
+    gen.setLabel (gen.bne(), loop);
+    gen.blr();
+    gen.nop(); // Dropped
+
+    PPCEmitter <FixedSize> reference;
+    reference.lis (r4, 0x1235);
+    reference.li (r5, 0x30);
+    reference.li (r6, 0x7000);
+    reference.liu (r7, 0x8000);
+    reference.li (r8, 1);
+    const auto referenceLoop = reference.getAnchor();
+    reference.addi (r8, r8, 1);
+    reference.setLabel (reference.bne(), referenceLoop);
+    reference.blr();
+
+    return gen.getCodeSize() == reference.getCodeSize() && std::memcmp (gen.getBuffer(), reference.getBuffer(), gen.getCodeSize()) == 0;
+}
+
+// Check register assignment, spilling and the prologue the allocator emits
+static bool testRegisterAllocator() {
+    PPCEmitter <FixedSize> gen;
+    RegisterAllocator <PPCEmitter <FixedSize>> allocator (gen);
+
+    const auto longLived = allocator.newGPR (0, 100); // Spilled once the registers run out, as it lives the longest
+    const auto acrossCall = allocator.newGPR (0, 10, true);
+    std::vector <VirtualReg> values;
+    for (int i = 0; i < 25; i++) // 25 values + 2 above = 27 values for 26 allocatable GPRs
+        values.push_back (allocator.newGPR (1, 10));
+    const auto late = allocator.newGPR (11, 20); // Reuses a register freed by the values above
+    allocator.allocate();
+
+    if (allocator.gpr (acrossCall) != r31 || !allocator.isSpilled (longLived) || allocator.isSpilled (late) || allocator.gpr (late) != r3)
+        return false;
+
+    allocator.emitPrologue();
+    const auto scratch = allocator.load (longLived, r11);
+    allocator.emitEpilogue();
+
+    // r14-r31 are all used, so they get saved with one stmw. The frame is the 16 byte header, the spill slot padded to 8 bytes,
+    // then the 72 byte GPR save area
+    const uint32_t frameSize = 16 + 8 + 18 * 4;
+    PPCEmitter <FixedSize> reference;
+    reference.stwu (sp, sp, -(int16_t) frameSize);
+    reference.stmw (r14, sp, frameSize - 18 * 4);
+    reference.lwz (r11, sp, 16);
+    reference.lmw (r14, sp, frameSize - 18 * 4);
+    reference.addi (sp, sp, frameSize);
+
+    return scratch == r11 && allocator.getFrameSize() == frameSize && gen.getCodeSize() == reference.getCodeSize() &&
+           std::memcmp (gen.getBuffer(), reference.getBuffer(), gen.getCodeSize()) == 0;
+}
+
+// Check that functions only save what their body clobbers
+static bool testFunctions() {
+    PPCEmitter <FixedSize> gen;
+
+    gen.beginFunction(); // Leaf that only touches volatiles: no prologue, and the epilogue is just a blr
+    gen.addi (r3, r3, 1);
+    const auto leaf = gen.endFunction();
+    if (gen.getPointer (leaf)[0] != enc.addi (r3, r3, 1) || gen.getPointer (leaf)[1] != enc.blr())
+        return false;
+
+    const auto body = gen.getAnchor();
+    gen.beginFunction();
+    gen.mr (r30, r3);
+    gen.cmpi (cr2, r30, 0);
+    gen.bl (gen.getBuffer()); // Calls something, so LR has to be saved
+    gen.returnFromFunction();
+    gen.li (r3, 0);
+    const auto function = gen.endFunction();
+    gen.finalize();
+
+    // Frame: back chain + LR word, CR save word, padding, then r30-r31 at the top
+    // The body comes first, then the epilogue, then the prologue, which jumps back to the body
+    PPCEmitter <FixedSize> reference;
+    reference.lwz (r0, sp, 36);
+    reference.lwz (r12, sp, 8);
+    reference.mtcrf (0x20, r12);
+    reference.lmw (r30, sp, 24);
+    reference.addi (sp, sp, 32);
+    reference.mtlr (r0);
+    reference.blr();
+    const auto epilogueSize = reference.getCodeSize();
+    reference.mflr (r0);
+    reference.stwu (sp, sp, -32);
+    reference.stw (r0, sp, 36);
+    reference.mfcr (r12);
+    reference.stw (r12, sp, 8);
+    reference.stmw (r30, sp, 24);
+    const auto prologueSize = reference.getCodeSize() - epilogueSize;
+
+    const auto entry = gen.getPointer (function);
+    const auto epilogue = gen.getPointer (body) + 5; // Skip the body
+    if (entry != epilogue + epilogueSize / 4 || std::memcmp (epilogue, reference.getBuffer(), reference.getCodeSize()) != 0 ||
+        entry[prologueSize / 4] != (0x48000000 | (-(int32_t) (epilogueSize + prologueSize + 20) & 0x3FFFFFC)) || // Back to the body
+        epilogue[-2] != (0x48000000 | 8)) // The early return jumps over the li, to the epilogue
+        return false;
+
+    // AltiVec shares opcode 4 with paired singles. Scanned as AltiVec, vaddfp clobbers v21 rather than f21, and VRSAVE gets saved too
+    PPCEmitter <FixedSize> vector;
+    vector.beginFunction (0, DecodeMode::AltiVec);
+    vector.vaddfp (v21, v1, v2);
+    vector.mtspr (256, r3);
+    const auto vectorEntry = vector.endFunction();
+
+    PPCEmitter <FixedSize> vectorReference;
+    vectorReference.vaddfp (v21, v1, v2);
+    vectorReference.mtspr (256, r3);
+    vectorReference.li (r12, 16);
+    vectorReference.lvx (v21, sp, r12);
+    vectorReference.lwz (r12, sp, 8);
+    vectorReference.mtspr (256, r12);
+    vectorReference.addi (sp, sp, 32);
+    vectorReference.blr();
+    vectorReference.stwu (sp, sp, -32);
+    vectorReference.mfspr (r12, 256);
+    vectorReference.stw (r12, sp, 8);
+    vectorReference.li (r12, 16);
+    vectorReference.stvx (v21, sp, r12);
+    vectorReference.setLabel (vectorReference.b(), Anchor { 0 });
+    return vectorEntry.offset == 32 && vector.getCodeSize() == vectorReference.getCodeSize() &&
+           std::memcmp (vector.getBuffer(), vectorReference.getBuffer(), vector.getCodeSize()) == 0;
+}
+
+// Check the quantized paired single encodings against known words
+static_assert (enc.psq_l (f1, r3, 8, false, gqr2) == 0xE0232008 && enc.psq_stu (f0, r4, -8, true, gqr7) == 0xF404FFF8);
+static_assert (enc.psq_l (f1, r3, -2048, false, gqr0) == 0xE0230800 && enc.psq_st (f1, r3, 2047, false, gqr0) == 0xF02307FF); // Edges of the 12-bit offset
+static_assert (enc.psq_lx (f2, r3, r4, false, gqr1) == 0x1043208C && enc.psq_stux (f2, r3, r4, true, gqr0) == 0x1043244E);
+static_assert (enc.mtgqr (gqr2, r3) == 0x7C72E3A6 && enc.mfgqr (r3, gqr0) == 0x7C70E2A6);
+static_assert (makeGQR (QuantType::U8, 0, QuantType::S16, 8) == 0x00040807);
+
+// Check that atomic sequences are emitted as lwarx/stwcx. loops with the right fences
+static bool testAtomics() {
+    PPCEmitter <FixedSize> gen;
+    gen.atomicFetchAdd (r3, r4, r5, r6, MemoryOrder::AcqRel);
+    gen.atomicCompareExchange (r3, r4, r5, r6, MemoryOrder::Relaxed);
+
+    const uint32_t expected[] = {
+        0x7C2004AC, // lwsync
+        0x7C602028, // lwarx r3, 0, r4
+        0x7CC32A14, // add r6, r3, r5
+        0x7CC0212D, // stwcx. r6, 0, r4
+        0x4082FFF4, // bne- -12
+        0x4C00012C, // isync
+        0x7C602028, // lwarx r3, 0, r4
+        0x7C032840, // cmplw r3, r5
+        0x4082000C, // bne- +12
+        0x7CC0212D, // stwcx. r6, 0, r4
+        0x4082FFF0, // bne- -16
+    };
+
+    return gen.getCodeSize() == sizeof (expected) && std::memcmp (gen.getBuffer(), expected, sizeof (expected)) == 0;
+}
+
+// Check that the block entry hook runs first, and that the statistics count what was emitted
+static bool testStats() {
+    static uint32_t counter = 0;
+    PPCEmitter <AutoGrow> gen (16); // Small enough to have to grow
+    gen.setBlockEntryHook ([] (PPCEmitter <AutoGrow>& g, void*) { g.incrementCounter (&counter); });
+
+    gen.beginBlock();
+    gen.liw (r3, 5); // li
+    gen.liw (r4, 0x12340000); // lis
+    gen.liw (r5, 0x12345678); // lis + ori
+    gen.add (r3, r4, r5);
+    gen.lwz (r6, r1, 8);
+    gen.fadd (f1, f2, f3);
+    const auto label = gen.newLabel();
+    gen.beq (label);
+    gen.bind (label);
+    const auto size = gen.endBlock();
+    gen.finalize();
+
+    // The hook's counter increment comes first
+    const auto code = gen.getBuffer();
+    const auto address = (uint32_t) (uintptr_t) &counter;
+    if (code[0] != enc.lis (r11, (address + 0x8000) >> 16) || code[1] != enc.lwz (r12, r11, (int16_t) address) ||
+        code[2] != enc.addi (r12, r12, 1) || code[3] != enc.stw (r12, r11, (int16_t) address))
+        return false;
+
+    const auto& stats = gen.getStats();
+    return size == 12 * 4 && stats.instructions == 12 && stats.liwShort == 2 && stats.liwLong == 1 &&
+           stats.categories[EmitterStats::Memory] == 3 && stats.categories[EmitterStats::Float] == 1 &&
+           stats.categories[EmitterStats::Branch] == 1 && stats.opcodes[15] == 3 && stats.labelFixups == 1 &&
+           stats.reallocations > 0 && stats.blocks == 1 && stats.largestBlock == size && stats.blockSizes[5] == 1;
+}
+
+// Check that decoded words print as the instructions they were encoded from, in both decode modes
+static bool testDecoder() {
+    const std::pair <uint32_t, const char*> cases[] = {
+        { enc.addi (r3, r1, 4), "addi r3, r1, 4" },
+        { enc.li (r4, -2), "li r4, -2" },
+        { enc.nop(), "nop" },
+        { enc.mr (r3, r4), "mr r3, r4" },
+        { enc.add <true> (r3, r4, r5), "add. r3, r4, r5" },
+        { enc.lwz (r3, r1, -8), "lwz r3, -8(r1)" },
+        { enc.rlwinm (r3, r4, 3, 0, 28), "rlwinm r3, r4, 3, 0, 28" },
+        { enc.cmpi (cr1, r3, 5), "cmpi cr1, r3, 5" },
+        { enc.mtctr (r12), "mtctr r12" },
+        { enc.fmadd (f1, f2, f3, f4), "fmadd f1, f2, f3, f4" },
+        { enc.ps_merge00 (f1, f2, f3), "ps_merge00 f1, f2, f3" },
+        { enc.psq_l (f1, r3, -8, true, gqr2), "psq_l f1, -8(r3), 1, 2" },
+        { enc.stwcx (r3, r4, r5), "stwcx. r3, r4, r5" },
+        { enc.lwsync(), "lwsync" },
+        { enc.dcbz_l (r3, r4), "dcbz_l r3, r4" },
+        { enc.lvx (v1, r3, r4), "lvx v1, r3, r4" },
+        { enc.bctrl(), "bctrl" },
+        { 0, ".long 0x00000000" }
+    };
+
+    const Decoder decoder;
+    for (const auto& [word, text] : cases)
+        if (decoder.toString (decoder.decode (word)) != text)
+            return false;
+
+    const Decoder altivec (DecodeMode::AltiVec);
+    if (altivec.toString (altivec.decode (enc.vperm (v1, v2, v3, v4))) != "vperm v1, v2, v3, v4" ||
+        altivec.toString (altivec.decode (enc.vcmpequb <true> (v1, v2, v3))) != "vcmpequb. v1, v2, v3")
+        return false;
+
+    // Stream over an emitter's buffer, and check branches resolve to where they were pointed
+    PPCEmitter <FixedSize> gen (4096);
+    const auto target = gen.newLabel();
+    gen.beq (target);
+    gen.li (r3, 1);
+    gen.bind (target);
+    gen.blr();
+    gen.finalize();
+
+    uint32_t count = 0;
+    decoder.forEach (gen.getBuffer(), gen.getCurr(), [&] (const Decoder::Instruction& instruction) {
+        if (instruction.isValid())
+            count++;
+    });
+
+    const auto instructions = decoder.decodeAll (gen.getBuffer(), gen.getCurr(), 0x1000);
+    return count == 3 && instructions.size() == 3 && instructions[0].getBranchTarget() == 0x1008 &&
+           decoder.toString (instructions[0]) == "beq 0x1008" && decoder.toString (instructions[2]) == "blr";
+}
+
+// Check that recycling a generation evicts cold blocks, compacts hot ones and relinks the exits pointing at them
+static bool testBlockCache() {
+    BlockCache cache (64 * 1024, 4, EvictionPolicy::LRU);
+    auto& arena = cache.getArena();
+    const auto execBase = (uintptr_t) arena.toExecutable (arena.getBase());
+    const auto dispatcherOf = [] (BlockCache& target) { // Right past the target's arena, so every exit reaches it with a b. Never actually run
+        auto& targetArena = target.getArena();
+        return (void*) ((uintptr_t) targetArena.toExecutable (targetArena.getBase()) + targetArena.getCapacity());
+    };
+    const auto dispatcher = dispatcherOf (cache);
+
+    const auto compileIn = [&] (BlockCache& target, uint64_t key) { // 1000 nops and an exit, so 4 blocks fit in a generation
+        auto gen = target.begin (key, 4096);
+        for (int i = 0; i < 1000; i++)
+            gen->nop();
+        target.emitExit (dispatcherOf (target));
+        return target.publish();
+    };
+    const auto compile = [&] (uint64_t key) { return compileIn (cache, key); };
+
+    for (uint64_t key = 0; key < 16; key++)
+        compile (key);
+
+    // Generation 0 holds blocks 0 to 3. Link 1 -> 2, and 4 (in generation 1) -> 1
+    if (!cache.link (1, 0, 2) || !cache.link (4, 0, 1))
+        return false;
+
+    cache.lookup (1); // Block 1 is hot, so it survives when generation 0 gets recycled
+    const auto block16 = compile (16);
+
+    if (cache.lookup (0) || cache.lookup (2) || cache.lookup (3) || cache.getEvictedBlocks() != 3 || cache.getCompactedBlocks() != 1)
+        return false;
+
+    // Block 1 slid down to the start of the cache, and its exit went back to the dispatcher since block 2 is gone
+    const auto block1 = cache.getBlock (1);
+    if (cache.lookup (1) != (void*) execBase || block1->code != (uint32_t*) arena.getBase() || block1->code[0] != enc.nop() ||
+        block1->code[1000] != encodeBranch24 (execBase + 4000, (uintptr_t) dispatcher) || block16 != (void*) (execBase + 4016))
+        return false;
+
+    // Block 4's exit follows block 1 to its new address
+    const auto block4 = cache.getBlock (4);
+    const auto exit4 = (uintptr_t) arena.toExecutable (block4->code + 1000);
+    if (block4->code[1000] != encodeBranch24 (exit4, execBase) || block4->exitTargets[0] != 1 || cache.getBlockCount() != 14)
+        return false;
+
+    // FIFO recycles the whole generation even if a block in it is hot, and the exits into it go back to the dispatcher
+    BlockCache fifo (64 * 1024, 4, EvictionPolicy::FIFO);
+    auto& fifoArena = fifo.getArena();
+    const auto fifoBase = (uintptr_t) fifoArena.toExecutable (fifoArena.getBase());
+    for (uint64_t key = 0; key < 16; key++)
+        compileIn (fifo, key);
+    if (!fifo.link (4, 0, 1))
+        return false;
+
+    fifo.lookup (1);
+    const auto fifo16 = compileIn (fifo, 16);
+    const auto fifo4 = fifo.getBlock (4);
+    const auto fifoExit4 = (uintptr_t) fifoArena.toExecutable (fifo4->code + 1000);
+    return !fifo.lookup (1) && fifo.getEvictedBlocks() == 4 && fifo.getCompactedBlocks() == 0 && fifo16 == (void*) fifoBase &&
+           fifo4->code[1000] == encodeBranch24 (fifoExit4, (uintptr_t) dispatcherOf (fifo)) && fifo.getBlockCount() == 13;
+}
+
+// Check branches on other CR fields, the y bit picked for each hint and direction, and the CTR branches
+static bool testBranchHints() {
+    PPCEmitter <FixedSize> gen (4096);
+    const auto top = gen.getAnchor();
+    const auto skip = gen.newLabel();
+    gen.cmpi (cr3, r3, 0);
+    gen.beq (cr3, skip, BranchHint::Likely); // Forward and likely: y set
+    gen.blt (cr7, skip, BranchHint::Unlikely); // Forward and unlikely: what the predictor does anyway
+    gen.setLabel (gen.bne (cr1, BranchHint::Likely), top); // Backward and likely: also the default
+    gen.setLabel (gen.bgt (cr0, BranchHint::Unlikely), top); // Backward and unlikely: y set
+    gen.bdnz (skip);
+    gen.bind (skip);
+    gen.setLabel (gen.bdz (BranchHint::Likely));
+    gen.resolveLabels();
+
+    const auto code = gen.getBuffer();
+    return code[0] == enc.cmpi (cr3, r3, 0) && code[1] == 0x41AE0014 && code[2] == 0x419C0010 && code[3] == 0x4086FFF4 &&
+           code[4] == 0x41A1FFF0 && code[5] == 0x42000004 && code[6] == 0x42600004 && gen.disassemble().find ("beq+ cr3") != std::string::npos;
+}
+
+// Check that a cross emitter produces the native emitter's code with every value byteswapped, including patched branches, merged immediates and data
+static bool testByteOrder() {
+    constexpr auto foreignOrder = hostByteOrder == LittleEndian ? BigEndian : LittleEndian;
+    PPCEmitter <FixedSize> native (4096);
+    PPCEmitter <FixedSize, foreignOrder> cross (4096);
+
+    const auto emit = [] (auto& gen) {
+        gen.setPeephole (true);
+        gen.beginFunction();
+        const auto skip = gen.newLabel();
+        gen.li (r3, 1);
+        gen.addi (r3, r3, 2); // Merged into the li
+        gen.cmpi (cr0, r3, 3);
+        gen.beq (skip);
+        gen.addi (r31, r31, 1);
+        gen.bind (skip);
+        gen.setLabel (gen.bne(), gen.getAnchor());
+        gen.returnFromFunction();
+        gen.endFunction();
+        gen.nops (2);
+        const auto dataOffset = gen.getCodeSize();
+        const uint16_t halves[] = { 0x1234, 0x5678 };
+        gen.dh (halves, 2);
+        gen.df64 (1.5);
+        gen.resolveLabels();
+        return dataOffset;
+    };
+    const auto dataOffset = emit (native);
+    if (emit (cross) != dataOffset || native.getCodeSize() != cross.getCodeSize())
+        return false;
+
+    const auto nativeWords = native.getBuffer();
+    const auto crossWords = cross.getBuffer();
+    for (uint32_t i = 0; i < dataOffset / 4; i++)
+        if (crossWords[i] != byteswap (nativeWords[i]))
+            return false;
+
+    const auto data = (const uint8_t*) (crossWords + dataOffset / 4); // Data is swapped value by value, not word by word
+    const bool bigEndian = foreignOrder == BigEndian;
+    uint64_t doubleBits;
+    std::memcpy (&doubleBits, data + 4, 8);
+    const double half = 1.5;
+    uint64_t expected;
+    std::memcpy (&expected, &half, 8);
+    return data[0] == (bigEndian ? 0x12 : 0x34) && data[3] == (bigEndian ? 0x78 : 0x56) && doubleBits == byteswap (expected) &&
+           cross.disassemble().find ("li r3, 3") != std::string::npos &&
+           cross.buildObject()[5] == (foreignOrder == LittleEndian ? 1 : 2) && native.buildObject()[5] == (hostByteOrder == LittleEndian ? 1 : 2);
+}
+
+// Check the bulk data paths, and that align pads up to the boundary instead of by the remainder
+static bool testBulkWrites() {
+    PPCEmitter <FixedSize> gen (4096);
+    gen.setPeephole (true);
+    gen.b();
+    gen.nops (3); // Kept, even though the peephole drops nops after unconditional branches
+    gen.db (0xAA);
+    gen.align (16); // 1 byte past a 16-byte boundary, so 15 bytes of padding
+    const auto aligned = gen.getCodeSize();
+    gen.fill (0x5A, 5);
+    const uint32_t words[] = { 1, 2, 3 };
+    gen.align (4);
+    gen.dw (words, 3);
+    gen.ds ("ok");
+
+    const auto code = gen.getBuffer();
+    const auto bytes = (uint8_t*) code;
+    return code[1] == enc.nop() && code[3] == enc.nop() && bytes[16] == 0xAA && aligned == 32 && bytes[31] == 0 &&
+           bytes[32] == 0x5A && bytes[36] == 0x5A && bytes[37] == 0 && code[10] == 1 && code[12] == 3 && std::strcmp ((char*) &code[13], "ok") == 0 &&
+           gen.getCodeSize() == 55;
+}
+
+// Check that kernels are built out of the right unit's instructions, unrolled and prefetched as asked
+static bool testKernels() {
+    const auto count = [] (PPCEmitter <FixedSize>& gen, DecodeMode mode, const char* mnemonic) {
+        int result = 0;
+        const Decoder decoder (mode);
+        decoder.forEach (gen.getBuffer(), gen.getCurr(), [&] (const Decoder::Instruction& instruction) {
+            const auto text = decoder.toString (instruction); // Simplified mnemonics, eg bdnz
+            result += text.compare (0, text.find (' '), mnemonic) == 0;
+        });
+        return result;
+    };
+
+    PPCEmitter <FixedSize> altivec (4096);
+    KernelBuilder <PPCEmitter <FixedSize>> vectors (altivec, VectorUnit::AltiVec);
+    vectors.copy (r3, r4, r5);
+    altivec.finalize();
+    if (count (altivec, DecodeMode::AltiVec, "vperm") != 4 || count (altivec, DecodeMode::AltiVec, "stvx") != 4 ||
+        count (altivec, DecodeMode::AltiVec, "lvsl") != 1 || count (altivec, DecodeMode::AltiVec, "dst") != 1 ||
+        count (altivec, DecodeMode::AltiVec, "dss") != 2 || count (altivec, DecodeMode::AltiVec, "bdnz") != 3) // Head, body and tail
+        return false;
+
+    PPCEmitter <FixedSize> paired (4096);
+    KernelBuilder <PPCEmitter <FixedSize>> pairs (paired, VectorUnit::PairedSingles);
+    pairs.setUnroll (2);
+    pairs.setPrefetch (false);
+    pairs.setGQR (gqr5);
+    pairs.saxpy (r3, r4, f1, r5);
+    paired.finalize();
+    return count (paired, DecodeMode::PairedSingles, "ps_madd") == 2 && count (paired, DecodeMode::PairedSingles, "psq_st") == 2 &&
+           count (paired, DecodeMode::PairedSingles, "dcbt") == 0 && count (paired, DecodeMode::PairedSingles, "bdnz") == 2 &&
+           paired.getBuffer()[0] == enc.li (r12, 0) && paired.getBuffer()[1] == enc.mtgqr (gqr5, r12); // gqr5 = plain floats
+}
+
+// Check that cold paths end up after the hot code, and can branch back into it
+static bool testColdCode() {
+    PPCEmitter <FixedSize> gen (4096);
+    gen.beginBlock();
+    const auto resume = gen.newLabel();
+    gen.cmpi (cr0, r3, 0);
+    gen.beq (gen.cold ([resume] (PPCEmitter <FixedSize>& g) {
+        g.li (r3, 1);
+        g.bne (g.cold ([] (PPCEmitter <FixedSize>& inner) { inner.sc(); })); // Deferred again, so it goes after this one
+        g.b (resume);
+    }));
+    gen.bind (resume);
+    gen.blr();
+
+    const auto size = gen.endBlock();
+    gen.finalize();
+    const auto code = gen.getBuffer();
+    if (size != 7 * 4 || code[1] != 0x41820008 || code[2] != enc.blr() || code[3] != enc.li (r3, 1) || code[4] != 0x40820008 ||
+        code[5] != 0x4BFFFFF4 || code[6] != enc.sc())
+        return false;
+
+    // A function's cold paths are part of it, so the r14 and LR they clobber get saved even though the hot code never touches them
+    PPCEmitter <FixedSize> function (4096);
+    function.beginFunction();
+    function.cmpi (cr0, r3, 0);
+    function.beq (function.cold ([] (PPCEmitter <FixedSize>& g) {
+        g.li (r14, 1);
+        g.bl ((void*) 0);
+        g.returnFromFunction();
+    }));
+    const auto entry = function.endFunction();
+    function.resolveLabels();
+    const auto words = function.getBuffer();
+    return entry.offset == 11 * 4 && words[2] == 0x48000010 && words[3] == enc.li (r14, 1) && words[entry.offset / 4] == enc.mflr (r0) &&
+           words[entry.offset / 4 + 3] == enc.stmw (r14, sp, 24); // The hot code jumps over the cold path to the epilogue
+}
+
+// Check jump table layout, and that the table's address follows the buffer when AutoGrow moves it
+static bool testSwitch() {
+    PPCEmitter <AutoGrow> gen (256);
+    const auto fallback = gen.newLabel();
+    std::vector <Label> targets;
+    for (int i = 0; i < 3; i++)
+        targets.push_back (gen.newLabel());
+
+    gen.switchTable (r3, targets, fallback);
+    const auto tableAddress = [&] (uint32_t lisOffset) { // What the lis/addi pair at "lisOffset" loads
+        const auto code = gen.getBuffer();
+        return (uint32_t) (((code[lisOffset / 4] & 0xFFFF) << 16) + (int16_t) code[lisOffset / 4 + 1]);
+    };
+
+    const auto table = gen.getRelocations()[0].addend;
+    for (const auto target : targets) {
+        gen.bind (target);
+        gen.blr();
+    }
+    gen.bind (fallback);
+    for (int i = 0; i < 200; i++) // Grow the buffer
+        gen.nop();
+    gen.finalize();
+
+    const auto code = gen.getBuffer();
+    if ((table & 15) != 0 || code[0] != enc.cmpli (cr0, r3, 3) || tableAddress (8) != (uint32_t) (uintptr_t) (code + table / 4) ||
+        code[table / 4] != 12 || code[table / 4 + 2] != 20 || code[6] != enc.add (r12, r12, r0) || code[8] != enc.bctr())
+        return false;
+
+    // 8 dense cases get a table, and each outlier a compare
+    PPCEmitter <FixedSize> sparse (4096);
+    const auto label = sparse.newLabel();
+    std::vector <SwitchCase> cases;
+    for (int32_t value : { 10, 11, 12, 13, 14, 15, 16, 17, 5000, -100000 })
+        cases.push_back ({ value, label });
+
+    sparse.switchCases (r4, cases, label);
+    sparse.bind (label);
+    sparse.finalize();
+
+    uint32_t tables = 0, compares = 0;
+    Decoder().forEach (sparse.getBuffer(), sparse.getCurr(), [&] (const Decoder::Instruction& instruction) {
+        tables += instruction.word == enc.bctr();
+        compares += instruction.getMnemonic() == std::string ("cmpi") || instruction.getMnemonic() == std::string ("cmp");
+    });
+
+    return tables == 1 && compares == 2;
+}
+
+// Check that constants are deduplicated into the literal pool and loaded with one instruction each
+static bool testLiteralPool() {
+    LiteralPool pool (1024);
+    PPCEmitter <FixedSize> gen (4096);
+    gen.setLiteralPool (&pool, r13);
+
+    gen.loadLiteral (r3, 0x12345678);
+    gen.loadLiteral (r4, 0x12345678); // Same slot as the one above
+    gen.loadLiteral (r5, 100); // Fits in li, so it stays out of the pool
+    gen.loadLiteral (f1, 1.5f);
+    gen.loadLiteral (f2, 2.25);
+    gen.loadLiteral (v1, { 1, 2, 3, 4 });
+
+    const auto code = gen.getBuffer();
+    const auto base = (uint8_t*) pool.getBase();
+    const auto word = [&] (int16_t displacement) { uint32_t value; std::memcpy (&value, base + displacement, 4); return value; };
+    const auto wordDisplacement = (int16_t) code[0];
+    const auto floatDisplacement = (int16_t) code[3];
+    const auto doubleDisplacement = (int16_t) code[4];
+    const auto vectorDisplacement = (int16_t) code[5];
+
+    double loadedDouble;
+    std::memcpy (&loadedDouble, base + doubleDisplacement, 8);
+    if (gen.getCodeSize() != 7 * 4 || pool.getCount() != 4 || code[0] != enc.lwz (r3, r13, wordDisplacement) ||
+        code[1] != enc.lwz (r4, r13, wordDisplacement) || code[2] != enc.li (r5, 100) || code[3] != enc.lfs (f1, r13, floatDisplacement) ||
+        code[4] != enc.lfd (f2, r13, doubleDisplacement) || code[6] != enc.lvx (v1, r13, r12) || word (wordDisplacement) != 0x12345678 ||
+        word (floatDisplacement) != 0x3FC00000 || loadedDouble != 2.25 || (doubleDisplacement & 7) != 0 || (vectorDisplacement & 15) != 0 ||
+        word (vectorDisplacement + 12) != 4)
+        return false;
+
+    // Threads adding the same constants at once still get one slot per constant
+    LiteralPool shared (4096);
+    std::vector <std::thread> threads;
+    bool consistent[4] = {};
+    for (int i = 0; i < 4; i++) {
+        threads.emplace_back ([&shared, &consistent, i] {
+            consistent[i] = true;
+            for (uint32_t n = 0; n < 512; n++) {
+                const uint32_t value = 0xDEAD0000 | n;
+                int16_t displacement;
+                if (!shared.add (value, displacement) || std::memcmp ((uint8_t*) shared.getBase() + displacement, &value, 4) != 0)
+                    consistent[i] = false;
+            }
+        });
+    }
+
+    for (auto& thread : threads)
+        thread.join();
+    return shared.getCount() == 512 && shared.getUsed() == 2048 && consistent[0] && consistent[1] && consistent[2] && consistent[3];
+}
+
+// Check that an image loads somewhere else with only its relocations applied, and that broken images are rejected
+static bool testCodeImage() {
+    const std::string path = "/tmp/luma-test-" + std::to_string ((long) getpid()) + ".image";
+    const uint32_t guest[] = { 0x12345678, 0x9ABCDEF0 };
+    CodeImage image;
+
+    for (uint64_t key = 0; key < 2; key++) {
+        PPCEmitter <FixedSize> gen (4096);
+        const auto helper = gen.importSymbol ("helper");
+        const auto loop = gen.newLabel();
+        gen.bind (loop);
+        gen.bl (helper);
+        gen.liw (r4, helper, 16);
+        gen.bne (loop);
+        const auto tail = gen.exportSymbol ("tail", gen.getAnchor());
+        gen.blr();
+        gen.b (tail);
+        gen.setLabel (gen.beql(), helper);
+        image.addBlock (key, CodeImage::hash (&guest[key], 4), gen);
+    }
+
+    if (!image.save (path))
+        return false;
+
+    CodeArena arena (64 * 1024, ArenaMode::DualView);
+    CodeImage loaded;
+    const auto resolve = [] (const char* name, void* userData) -> void* {
+        return std::string (name) == "helper" ? userData : nullptr;
+    };
+
+    const auto helperAddress = (uint8_t*) arena.toExecutable (arena.getBase()) + 32 * 1024; // Never actually run
+    const bool unresolved = CodeImage().load (path, arena, nullptr); // "helper" can't be found without a resolver
+    const bool ok = loaded.load (path, arena, resolve, helperAddress);
+
+    // A truncated image, one whose code doesn't match its hashes, and a missing one are all rejected
+    std::ifstream saved (path, std::ios::binary);
+    std::string bytes ((std::istreambuf_iterator <char> (saved)), std::istreambuf_iterator <char>());
+    const auto loadBroken = [&] (const std::string& contents) {
+        std::ofstream (path, std::ios::binary | std::ios::trunc) << contents;
+        return CodeImage().load (path, arena, resolve, helperAddress);
+    };
+    const bool truncated = loadBroken (bytes.substr (0, bytes.size() - 4));
+    const uint32_t bne = 0x4082FFF4; // Only in the code, which is saved in host order
+    bytes[bytes.find (std::string ((const char*) &bne, 4))] ^= 1;
+    const bool corrupted = loadBroken (bytes);
+    std::remove (path.c_str());
+    if (unresolved || !ok || truncated || corrupted || CodeImage().load (path, arena, resolve, helperAddress) ||
+        loaded.getBlocks().size() != 2 || loaded.getImports().size() != 1)
+        return false;
+
+    // A stale hash finds nothing
+    if (loaded.lookup (1, CodeImage::hash (&guest[0], 4)) || !loaded.lookup (0, CodeImage::hash (&guest[0], 4)))
+        return false;
+
+    const auto code = (uint32_t*) loaded.lookup (1, CodeImage::hash (&guest[1], 4));
+    const auto words = code - arena.getExecOffset() / 4;
+    const auto exec = (uintptr_t) code;
+    const auto helper = (uintptr_t) helperAddress + 16;
+    return words[0] == encodeBranch24 (exec, (uintptr_t) helperAddress, true) && words[1] == enc.lis (r4, (helper + 0x8000) >> 16) &&
+           words[2] == enc.addi (r4, r4, (int16_t) helper) && words[3] == 0x4082FFF4 && // bne -12, untouched
+           words[5] == encodeBranch24 (exec + 20, exec + 16) && words[6] == (0x41820001 | (((uintptr_t) helperAddress - (exec + 24)) & 0xFFFC));
+}
+
+// Check that relocating branches, address loads and data words end up in the object's relocation table
+static bool testObject() {
+    PPCEmitter <FixedSize> gen (4096);
+    const auto callee = gen.importSymbol ("callee");
+    const auto table = gen.importSymbol ("table");
+    const auto start = gen.getAnchor();
+
+    gen.bl (callee);
+    gen.liw (r3, table, 8);
+    gen.setLabel (gen.beq(), callee);
+    gen.blr();
+    gen.exportSymbol ("stub", start, gen.getCodeSize());
+    gen.dw (table, 4);
+
+    const auto relocations = gen.getRelocations();
+    if (relocations.size() != 5 || relocations[0].type != RelocationType::Rel24 || relocations[1].type != RelocationType::Addr16Ha ||
+        relocations[2].type != RelocationType::Addr16Lo || relocations[2].addend != 8 || relocations[3].type != RelocationType::Rel14 ||
+        relocations[4].offset != 20 || relocations[4].type != RelocationType::Addr32 || gen.getBuffer()[1] != enc.lis (r3, 0))
+        return false;
+
+    const auto object = gen.buildObject();
+    const auto read32 = [&] (uint32_t offset) { uint32_t value; std::memcpy (&value, &object[offset], 4); return value; };
+    const uint32_t sections = read32 (32);
+    const uint32_t rela = sections + 2 * 40; // .rela.text
+    const uint32_t relaOffset = read32 (rela + 16);
+
+    // The second entry is the lis, against symbol 3 ("table", after the null and section symbols)
+    return object.size() > 64 && std::memcmp (object.data(), "\x7F" "ELF", 4) == 0 && object[4] == 1 && read32 (rela + 20) == 5 * 12 &&
+           read32 (relaOffset + 16) == ((3 << 8) | 6) && read32 (relaOffset + 20) == 8 && std::memcmp (&object[64], gen.getBuffer(), 24) == 0;
+}
+
+// Check that published blocks show up in the perf map and the GDB JIT interface, and leave GDB when removed
+static bool testSymbols() {
+    const std::string path = "/tmp/luma-test-" + std::to_string ((long) getpid()) + ".map";
+    std::remove (path.c_str());
+
+    CodeCache cache (1024 * 1024, 16 * 1024);
+    SymbolRegistry symbols;
+    cache.setSymbolRegistry (&symbols);
+    if (!symbols.enablePerfMap (path))
+        return false;
+    symbols.enableGDB();
+
+    CodeCache::Writer writer (cache);
+    void* entries[2];
+    for (int i = 0; i < 2; i++) {
+        auto gen = writer.begin (64);
+        gen->li (r3, i);
+        gen->blr();
+        entries[i] = writer.publish (i == 0 ? "first" : nullptr);
+    }
+
+    // Every block is appended to the map as it's published
+    char expected[128];
+    std::snprintf (expected, sizeof (expected), "%zx 8 first\n%zx 8 luma_code_%zx\n", (size_t) entries[0], (size_t) entries[1], (size_t) entries[1]);
+    std::ifstream file (path);
+    const std::string contents ((std::istreambuf_iterator <char> (file)), std::istreambuf_iterator <char>());
+    std::remove (path.c_str());
+    if (contents != expected)
+        return false;
+
+    SymbolRegistry::Symbol symbol;
+    if (!symbols.find ((uint8_t*) entries[0] + 4, symbol) || symbol.name != "first" || symbols.find ((uint8_t*) entries[0] + 8, symbol))
+        return false;
+
+    // Both blocks are registered with GDB, newest first, as in-memory ELF files
+    const auto entry = __jit_debug_descriptor.first_entry;
+    if (!entry || !entry->next_entry || entry->next_entry->next_entry || std::memcmp (entry->symfile_addr, "\x7F" "ELF", 4) != 0)
+        return false;
+
+    const auto older = entry->next_entry; // "entry" is freed along with the block
+    symbols.remove (entries[1]);
+    if (symbols.size() != 1 || __jit_debug_descriptor.first_entry != older || __jit_debug_descriptor.action_flag != 2)
+        return false;
+
+    // The removed block's addresses no longer resolve, while the other block's still do
+    return !symbols.find (entries[1], symbol) && symbols.find (entries[0], symbol) && symbol.name == "first";
+}
+
+// Check that several threads can compile into one code cache at once without stepping on each other
+static bool testCodeCache() {
+    constexpr int threadCount = 4;
+    constexpr int blocksPerThread = 200;
+    CodeCache cache (4 * 1024 * 1024, 16 * 1024);
+    std::vector <uint32_t*> blocks[threadCount];
+    std::vector <std::thread> threads;
+
+    for (int t = 0; t < threadCount; t++) {
+        threads.emplace_back ([&cache, &blocks, t] {
+            CodeCache::Writer writer (cache);
+            for (int i = 0; i < blocksPerThread; i++) {
+                auto gen = writer.begin (64);
+                gen->li (r3, t * blocksPerThread + i);
+                gen->blr();
+                blocks[t].push_back ((uint32_t*) writer.publish());
+            }
+        });
+    }
+
+    for (auto& thread : threads)
+        thread.join();
+
+    for (int t = 0; t < threadCount; t++) {
+        for (int i = 0; i < blocksPerThread; i++) {
+            const auto code = blocks[t][i];
+            if (!cache.getArena().contains ((uint8_t*) code - cache.getArena().getExecOffset()) ||
+                code[0] != enc.li (r3, t * blocksPerThread + i) || code[1] != enc.blr())
+                return false;
+        }
+    }
+
+    return true;
+}
+
 int main() {
+    if (!testBranchHints()) {
+        printf ("Test failure. CR field branches or branch hints are encoded wrong\n");
+        return -1;
+    }
+
+    if (!testByteOrder()) {
+        printf ("Test failure. Cross-endian emission did not match the byteswapped native code\n");
+        return -1;
+    }
+
+    if (!testKernels()) {
+        printf ("Test failure. Vector kernels are built wrong\n");
+        return -1;
+    }
+
+    if (!testBulkWrites()) {
+        printf ("Test failure. Bulk writes or alignment are wrong\n");
+        return -1;
+    }
+
+    if (!testColdCode()) {
+        printf ("Test failure. Cold paths were placed or linked incorrectly\n");
+        return -1;
+    }
+
+    if (!testSwitch()) {
+        printf ("Test failure. Switch lowering or jump tables are wrong\n");
+        return -1;
+    }
+
+    if (!testLiteralPool()) {
+        printf ("Test failure. Literal pool loads or deduplication are wrong\n");
+        return -1;
+    }
+
+    if (!testCodeImage()) {
+        printf ("Test failure. Code image was saved or relocated incorrectly\n");
+        return -1;
+    }
+
+    if (!testObject()) {
+        printf ("Test failure. Relocatable object output is wrong\n");
+        return -1;
+    }
+
+    if (!testSymbols()) {
+        printf ("Test failure. Symbols were exported incorrectly\n");
+        return -1;
+    }
+
+    if (!testStats()) {
+        printf ("Test failure. Emission statistics or block hooks are wrong\n");
+        return -1;
+    }
+
+    if (!testDecoder()) {
+        printf ("Test failure. Instructions were decoded incorrectly\n");
+        return -1;
+    }
+
+    if (!testBlockCache()) {
+        printf ("Test failure. Block cache eviction or compaction broke the code\n");
+        return -1;
+    }
+
+    if (!testCodeCache()) {
+        printf ("Test failure. Blocks compiled on different threads were corrupted\n");
+        return -1;
+    }
+
+    if (!testAtomics()) {
+        printf ("Test failure. Atomic sequences were emitted incorrectly\n");
+        return -1;
+    }
+
+    if (!testFunctions()) {
+        printf ("Test failure. Function prologue/epilogue saved the wrong registers\n");
+        return -1;
+    }
+
+    if (!testRegisterAllocator()) {
+        printf ("Test failure. Register allocator produced the wrong assignment or frame\n");
+        return -1;
+    }
+
+    if (!testPeephole()) {
+        printf ("Test failure. Peephole optimizer produced the wrong code\n");
+        return -1;
+    }
+
+    if (!testStencils()) {
+        printf ("Test failure. Stamped stencils do not match the encoded instructions\n");
+        return -1;
+    }
+
+    if (!testCodeTemplates()) {
+        printf ("Test failure. Code templates do not match the emitted code\n");
+        return -1;
+    }
+
+    if (!testBlockLinking()) {
+        printf ("Test failure. Block exits were not linked correctly\n");
+        return -1;
+    }
+
+    if (!testBranchRelaxation()) {
+        printf ("Test failure. Out of range conditional branch was not relaxed\n");
+        return -1;
+    }
+
+    if (!testLabels()) {
+        printf ("Test failure. Symbolic labels were resolved incorrectly\n");
+        return -1;
+    }
+
+    if (!testCommit()) {
+        printf ("Test failure. commit() lost track of patched committed code\n");
+        return -1;
+    }
+
+    if (!testAutoGrow()) {
+        printf ("Test failure. AutoGrow broke pending labels\n");
+        return -1;
+    }
+
+    if (!testAutoGrowExternal()) {
+        printf ("Test failure. AutoGrow broke calls out of the code buffer\n");
+        return -1;
+    }
+
+    if (!testCodeArena (ArenaMode::ToggleProtection) || !testCodeArena (ArenaMode::DualView)) {
+        printf ("Test failure. Code arena does not expose the emitted code\n");
+        return -1;
+    }
+
     ExtendedEmitter gen;
 
     const auto label1 = gen.beq();